@@ -7,6 +7,12 @@
 
 namespace fly
 {
+  /**
+  * Calls the update function with the interpolated progress every frame until the duration has elapsed, then the
+  * component removes itself. The update function is called by the AnimationSystem, which declares write access to
+  * Animation, Transform and Light. Other systems may run concurrently, so the update function may only modify
+  * these components. Any other state it touches has to be synchronized by the caller.
+  */
   class Animation : public Component
   {
   public:
@@ -52,12 +58,20 @@ namespace fly
     float getTimeEnd();
     std::function<void(float)>& getUpdateFunction();
     std::shared_ptr<Interpolator> getInterpolator();
+    /**
+    * Update functions of thread safe animations are called concurrently with those of other thread safe
+    * animations, which requires that they only touch components of their own entity. Off by default,
+    * update functions of other animations are called one after another.
+    */
+    void setThreadSafe(bool thread_safe);
+    bool isThreadSafe() const;
   private:
     float _duration;
     float _timeStart;
     float _timeEnd;
     std::function<void(float)> _updateFunction;
     std::shared_ptr<Interpolator> _interpolator;
+    bool _threadSafe = false;
   };
 }
 
@@ -2,7 +2,7 @@
 #define ANIMATIONSYSTEM_H
 
 #include <memory>
-#include <set>
+#include <vector>
 #include "System.h"
 
 namespace fly
@@ -16,7 +16,10 @@ namespace fly
     virtual void onComponentsChanged(Entity* entity) override;
     virtual void update(float time, float delta_time) override;
   private:
-    std::set<Entity*> _entities;
+    std::vector<Entity*> _entities;
+    std::vector<char> _finished;
+    std::vector<size_t> _threadSafe;
+    std::vector<size_t> _serial;
   };
 }
 
@@ -6,6 +6,7 @@
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 #include <vector>
+#include <string>
 
 namespace fly
 {
@@ -18,6 +19,11 @@ namespace fly
     AssimpImporter();
     virtual ~AssimpImporter() = default;
     virtual std::shared_ptr<Model> loadModel(const std::string& path) override;
+    /**
+    * Loads the models concurrently on the shared thread pool, each with its own Assimp importer. The result is in the
+    * order of paths, models that fail to load are nullptr.
+    */
+    std::vector<std::shared_ptr<Model>> loadModels(const std::vector<std::string>& paths);
 
   private:
     std::shared_ptr<Mesh> processMesh(aiMesh* mesh, const std::vector<std::shared_ptr<Material>>& materials);
@@ -0,0 +1,92 @@
+#ifndef CDLODQUADTREE_H
+#define CDLODQUADTREE_H
+
+#include <MinMaxPyramid.h>
+#include <math/FlyMath.h>
+#include <glm/glm.hpp>
+#include <vector>
+#include <memory>
+
+namespace fly
+{
+  /**
+  * Continuous distance-dependent LOD selection (CDLOD) over the implicit quadtree of a MinMaxPyramid. Every LOD
+  * covers a distance range around the camera, twice as large as the range of the next finer LOD. A node is
+  * drawn with its own LOD unless part of it lies within the range of the finer LOD, in which case its children are
+  * selected instead. All selected nodes are drawn with the same grid mesh of getGridResolution()^2 cells scaled
+  * to the node size. Vertices are morphed towards the next coarser LOD between the morph start and end distance
+  * of their node, so switching LOD doesn't pop. The selection only depends on its inputs and is deterministic.
+  */
+  class CDLODQuadtree
+  {
+  public:
+    struct Settings
+    {
+      /**
+      * Size of the nodes of LOD 0, equals the grid resolution.
+      */
+      int _leafSize = 32;
+      unsigned _numLods = 6;
+      /**
+      * Range of LOD 0, the range of LOD i is _lod0Range * 2^i.
+      */
+      float _lod0Range = 128.f;
+      /**
+      * Fraction of a LOD's range after which its vertices start morphing to the next coarser LOD.
+      */
+      float _morphStartRatio = 0.66f;
+    };
+    /**
+    * Per instance data of a selected node.
+    */
+    struct Node
+    {
+      glm::ivec2 _pos;
+      int _size;
+      unsigned _lod;
+      float _minHeight;
+      float _maxHeight;
+      /**
+      * Morph distances, float max for the coarsest LOD which doesn't morph.
+      */
+      float _morphStart;
+      float _morphEnd;
+    };
+    /**
+    * The quadtree shares the pyramid, so it stays valid if the terrain replaces its heightmap.
+    */
+    CDLODQuadtree(const std::shared_ptr<const MinMaxPyramid>& pyramid);
+    CDLODQuadtree(const std::shared_ptr<const MinMaxPyramid>& pyramid, const Settings& settings);
+    /**
+    * Selects the nodes for a camera position in the space of the heightmap. Nodes outside of the frustum given by
+    * mvp are skipped. The returned buffer is reused by the next call.
+    */
+    const std::vector<Node>& select(const Vec3f& cam_pos, const Mat4f& mvp);
+    /**
+    * Variant without frustum culling, e.g. to compare the selection with reference node counts.
+    */
+    const std::vector<Node>& select(const Vec3f& cam_pos);
+    float getRange(unsigned lod) const;
+    float getMorphStart(unsigned lod) const;
+    int getGridResolution() const;
+    const Settings& getSettings() const;
+  private:
+    std::shared_ptr<const MinMaxPyramid> _pyramid;
+    Settings _settings;
+    std::vector<float> _ranges;
+    std::vector<float> _morphStarts;
+    std::vector<Node> _selection;
+    /**
+    * Returns false if the node is beyond the range of its LOD, the parent then covers it.
+    */
+    bool selectNode(const glm::ivec2& pos, unsigned lod, const Vec3f& cam_pos, const Mat4f* mvp);
+    void selectRoots(const Vec3f& cam_pos, const Mat4f* mvp);
+    /**
+    * Appends a node unless it is outside of the frustum, nodes smaller than the node size of their LOD are
+    * quarters of a node and drawn with the corresponding quarter of the grid.
+    */
+    void addNode(const glm::ivec2& pos, int size, unsigned lod, const Mat4f* mvp);
+  };
+}
+
+#endif
@@ -0,0 +1,108 @@
+#ifndef COMPRESSEDHEIGHTMAP_H
+#define COMPRESSEDHEIGHTMAP_H
+
+#include <glm/glm.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace fly
+{
+  /**
+  * Heightmap split into square tiles whose heights are quantized to 16 bit relative to the tile minimum, with a
+  * step of the tile's height range / 65535 or 2 * max_error, whichever is larger. If all differences between
+  * horizontally adjacent quantized heights of a tile fit into 8 bit, the tile stores the first height of each row
+  * and 8 bit deltas instead. Random access decodes at most one row of a tile, bulk decode works tile by tile.
+  */
+  class CompressedHeightMap
+  {
+  public:
+    static const uint32_t VERSION = 2;
+    struct Header
+    {
+      char _magic[4];
+      uint32_t _version;
+      uint32_t _width;
+      uint32_t _height;
+      uint32_t _tileSize;
+      uint32_t _padding;
+      uint64_t _dataSize;
+    };
+    enum class Encoding : uint32_t
+    {
+      Raw16,
+      Delta8
+    };
+    struct TileInfo
+    {
+      float _min;
+      float _step;
+      /**
+      * Byte offset of the tile data, a multiple of two.
+      */
+      uint64_t _offset;
+      Encoding _encoding;
+      uint32_t _padding;
+    };
+    /**
+    * Compresses the tiles in parallel. row_stride is the distance between two rows of the heightmap in floats.
+    * Throws std::invalid_argument if tile_size, width or height is not positive.
+    */
+    CompressedHeightMap(const float* heights, int width, int height, size_t row_stride, int tile_size = 32, float max_error = 0.f);
+    /**
+    * Returns false on failure.
+    */
+    bool save(const std::string& path) const;
+    /**
+    * Returns nullptr if the file can't be mapped, is truncated, was written by an incompatible version or a tile
+    * lies outside of the data.
+    */
+    static std::unique_ptr<CompressedHeightMap> load(const std::string& path);
+    /**
+    * Decoded height of texel (x, z), coordinates are clamped to the heightmap.
+    */
+    float getHeight(int x, int z) const;
+    /**
+    * Decodes the texels [pos, pos + size) into dst, clamped to the heightmap. row_stride is the distance between
+    * two rows of dst in floats.
+    */
+    void decode(const glm::ivec2& pos, const glm::ivec2& size, float* dst, size_t row_stride) const;
+    /**
+    * Decodes the whole heightmap, tiles are processed in parallel.
+    */
+    std::vector<float> decode() const;
+    const glm::ivec2& getSize() const;
+    int getTileSize() const;
+    const TileInfo& getTileInfo(int tile_x, int tile_z) const;
+    /**
+    * Size of the tile infos and the encoded heights in bytes.
+    */
+    size_t getMemorySize() const;
+    /**
+    * Size of the encoded heights of a tile with extent texels in bytes.
+    */
+    static size_t getEncodedSize(Encoding encoding, const glm::ivec2& extent);
+  private:
+    CompressedHeightMap() = default;
+    glm::ivec2 _size = glm::ivec2(0);
+    int _tileSize = 0;
+    glm::ivec2 _numTiles = glm::ivec2(0);
+    /**
+    * Row major, tile (x, z) is at z * number of tiles in x + x.
+    */
+    std::vector<TileInfo> _tiles;
+    std::vector<uint8_t> _data;
+    /**
+    * Texels of a tile in x and z direction, tiles at the border may be smaller.
+    */
+    glm::ivec2 getTileExtent(int tile_x, int tile_z) const;
+    /**
+    * Decodes row z of a tile up to and including texel x_end.
+    */
+    void decodeRow(const TileInfo& info, const glm::ivec2& extent, int z, int x_end, float* dst) const;
+  };
+}
+
+#endif
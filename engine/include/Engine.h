@@ -3,23 +3,34 @@
 
 #include <Leakcheck.h>
 #include <memory>
-#include <set>
+#include <vector>
 #include <EntityManager.h>
+#include <SystemScheduler.h>
 
 namespace fly
 {
   class System;
+  class TransformSystem;
 
   class Engine
   {
   public:
     Engine();
+    /**
+    * Systems are updated in the order they were added unless they declared disjoint component access,
+    * in which case they run in parallel. The engine registers a TransformSystem on construction, systems
+    * that declare write access to Transform are scheduled before it and everything else after it, so the
+    * renderers see the world matrices of the current frame.
+    */
     void addSystem(const std::shared_ptr<System>& system);
     void update(float time, float delta_time);
     EntityManager* getEntityManager() const;
+    const std::vector<SystemScheduler::SystemTiming>& getSystemTimings() const;
   private:
     std::unique_ptr<EntityManager> _em = std::unique_ptr<EntityManager>(new EntityManager());;
-    std::set<std::shared_ptr<System>> _systems;
+    std::vector<std::shared_ptr<System>> _systems;
+    std::shared_ptr<TransformSystem> _transformSystem;
+    std::unique_ptr<SystemScheduler> _scheduler;
   };
 }
 
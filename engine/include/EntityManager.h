@@ -4,6 +4,10 @@
 #include <memory>
 #include <set>
 #include <map>
+#include <typeindex>
+#include <mutex>
+#include <atomic>
+#include <vector>
 
 namespace fly
 {
@@ -14,13 +18,34 @@ namespace fly
   {
   public:
     EntityManager() = default;
+    ~EntityManager();
     std::shared_ptr<Entity> createEntity();
     void removeEntity(Entity* entity);
+    std::vector<Entity*> getEntities() const;
     void addListener(const std::weak_ptr<System>& listener);
-    void notifyListeners(Entity* entity);
+    /**
+    * Notifies the listeners that a component of the given type was added, replaced or removed.
+    */
+    void notifyListeners(Entity* entity, const std::type_index& changed_type);
+    /**
+    * Called by the entity destructor with the types of its remaining components, listeners are notified
+    * immediately because the entity is gone afterwards.
+    */
+    void notifyListenersDestroyed(Entity* entity, const std::set<std::type_index>& changed_types);
+    /**
+    * While deferred, notifyListeners() is thread safe and only records the change. The listeners are notified
+    * once per entity with all changed types in endDeferredNotifications(), on the calling thread.
+    */
+    void beginDeferredNotifications();
+    void endDeferredNotifications();
   private:
     std::map<Entity*, std::shared_ptr<Entity>> _entities;
     std::set<std::weak_ptr<System>, std::owner_less<std::weak_ptr<System>>> _listeners;
+    std::atomic<bool> _deferred{ false };
+    std::mutex _deferredMutex;
+    std::vector<Entity*> _deferredEntities;
+    std::map<Entity*, std::set<std::type_index>> _deferredChanges;
+    void notifyListenersImmediately(Entity* entity, const std::set<std::type_index>& changed_types);
  };
 }
 
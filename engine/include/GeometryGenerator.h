@@ -3,7 +3,6 @@
 
 #include <math/FlyMath.h>
 #include <vector>
-#include <map>
 #include <array>
 
 namespace fly
@@ -21,16 +20,26 @@ namespace fly
       West = 8u
     };
     void generateGrid(int size, std::vector<glm::vec2>& vertices, std::vector<unsigned>& indices);
-    std::vector<unsigned> getCubeLineIndices() const;
+    /**
+    * Corners of the cube [-1, 1]^2 x [z_near, 1], e.g. the NDC cube with z_near = -1 for OpenGL and z_near = 0 for DirectX.
+    */
+    static constexpr std::array<Vec3f, 8> getCubeVertices(float z_near = -1.f)
+    {
+      return { Vec3f(-1.f, -1.f, z_near), Vec3f(1.f, -1.f, z_near), Vec3f(-1.f, 1.f, z_near), Vec3f(-1.f, -1.f, 1.f),
+        Vec3f(1.f, 1.f, z_near), Vec3f(-1.f, 1.f, 1.f), Vec3f(1.f, -1.f, 1.f), Vec3f(1.f, 1.f, 1.f) };
+    }
+    /**
+    * Line list of the 12 cube edges, indexing the corners returned by getCubeVertices().
+    */
+    static constexpr std::array<unsigned, 24> getCubeLineIndices()
+    {
+      return { 0, 1, 1, 6, 6, 3, 3, 0,   0, 2, 2, 4, 4, 1,   2, 5, 5, 7, 7, 4,   7, 6, 5, 3 };
+    }
     struct IndexBufferInfo
     {
       unsigned _numIndices;
       unsigned _offset;
     };
-    void generateGeoMipMap(int size, int tile_size, unsigned num_lods, std::vector<glm::vec2>& vertices, std::vector<unsigned>& indices, 
-      std::map<unsigned, std::map<unsigned, IndexBufferInfo>>& index_offsets);
-  private:
-    std::vector<unsigned> genGMMIndices(int size, unsigned lod, unsigned flag);
   };
 }
 
@@ -1,6 +1,7 @@
 #ifndef LEVELOFDETAIL_H
 #define LEVELOFDETAIL_H
 
+#include <MeshSimplifier.h>
 #include <memory>
 #include <vector>
 
@@ -13,6 +14,12 @@ namespace fly
     LevelOfDetail() = default;
     virtual ~LevelOfDetail() = default;
     std::vector<std::shared_ptr<Model>> generateLODsWithDetailCulling(const std::shared_ptr<Model>& model, unsigned lods = 3);
+    /**
+    * One lod per entry of triangle_ratios (e.g. { 0.5f, 0.25f, 0.125f }) in addition to the model itself, every
+    * mesh is simplified to the given fraction of its triangles. Materials are shared with the source model.
+    */
+    std::vector<std::shared_ptr<Model>> generateLODsWithSimplification(const std::shared_ptr<Model>& model, const std::vector<float>& triangle_ratios,
+      const MeshSimplifier::Settings& settings);
   private:
   };
 }
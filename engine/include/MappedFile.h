@@ -0,0 +1,36 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <string>
+#include <cstddef>
+
+namespace fly
+{
+  /**
+  * Read only memory mapping of a whole file. Pages are loaded lazily by the OS on first access.
+  */
+  class MappedFile
+  {
+  public:
+    MappedFile(const std::string& path);
+    MappedFile(const MappedFile& other) = delete;
+    MappedFile& operator=(const MappedFile& other) = delete;
+    ~MappedFile();
+    /**
+    * Returns nullptr if the file couldn't be mapped.
+    */
+    const unsigned char* getData() const;
+    size_t getSize() const;
+  private:
+    const unsigned char* _data = nullptr;
+    size_t _size = 0;
+#ifdef _WIN32
+    void* _file;
+    void* _mapping = nullptr;
+#else
+    int _file;
+#endif
+  };
+}
+
+#endif
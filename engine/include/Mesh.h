@@ -6,6 +6,7 @@
 #include <memory>
 #include <functional>
 #include "Vertex.h"
+#include <VertexFormat.h>
 #include <AABB.h>
 
 namespace fly
@@ -17,6 +18,11 @@ namespace fly
   public:
     Mesh();
     Mesh(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices, unsigned int material_index);
+    Mesh(std::vector<Vertex>&& vertices, std::vector<unsigned int>&& indices, unsigned int material_index);
+    /**
+    * Copies the geometry from raw arrays, e.g. a memory mapped file, and takes the precomputed local aabb.
+    */
+    Mesh(const Vertex* vertices, size_t num_vertices, const unsigned int* indices, size_t num_indices, unsigned int material_index, const AABB& aabb);
 
     const std::vector<Vertex>& getVertices() const;
     const std::vector<unsigned int>& getIndices() const;
@@ -27,6 +33,12 @@ namespace fly
     void setMaterialIndex(unsigned material_index);
     void setMaterial(const std::shared_ptr<Material>& material);
     const std::shared_ptr<Material>& getMaterial() const;
+    /**
+    * Layout the vertices are uploaded to the GPU with, a combination of VertexFormatFlag values. Must be set before
+    * the mesh is first rendered: the renderer caches the uploaded geometry per mesh and doesn't see later changes.
+    */
+    void setVertexFormat(unsigned format);
+    unsigned getVertexFormat() const;
 
   private:
     std::vector<Vertex> _vertices;
@@ -34,6 +46,8 @@ namespace fly
     unsigned int _materialIndex;
     std::shared_ptr<Material> _material;
     std::unique_ptr<AABB> _aabb;
+    unsigned _vertexFormat = VF_FULL;
+    void computeAABB();
 
   };
 }
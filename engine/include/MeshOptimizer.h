@@ -0,0 +1,57 @@
+#ifndef MESHOPTIMIZER_H
+#define MESHOPTIMIZER_H
+
+#include <Vertex.h>
+#include <vector>
+#include <cstddef>
+
+namespace fly
+{
+  class Mesh;
+
+  /**
+  * Reorders triangle lists for the GPU: triangles for the post transform vertex cache, clusters of triangles
+  * against overdraw and vertices for fetch locality. All passes keep the set of triangles and their winding.
+  */
+  class MeshOptimizer
+  {
+  public:
+    /**
+    * Simulated FIFO cache of the post transform vertex cache.
+    */
+    struct CacheStats
+    {
+      /**
+      * Average cache miss ratio, transformed vertices per triangle. 0.5 is the optimum for large grids, 3 the worst case.
+      */
+      float _acmr;
+      /**
+      * Average transform to vertex ratio, transformed vertices per referenced vertex. 1 is the optimum.
+      */
+      float _atvr;
+    };
+    static CacheStats analyzeVertexCache(const std::vector<unsigned>& indices, size_t num_vertices, unsigned cache_size = 16);
+    /**
+    * Tipsify (Sander et al. 2007): fans around the current vertex and continues with the vertex that stays the
+    * longest in the cache, linear in the number of indices.
+    */
+    static void optimizeVertexCache(std::vector<unsigned>& indices, size_t num_vertices, unsigned cache_size = 16);
+    /**
+    * Splits the triangle order into clusters at triangles whose vertices all miss the cache and sorts the clusters
+    * so that outward facing ones, which are likely to occlude the others, are drawn first. Expects an order
+    * optimized by optimizeVertexCache(), the cache efficiency inside the clusters is preserved.
+    */
+    static void optimizeOverdraw(std::vector<unsigned>& indices, const std::vector<Vertex>& vertices, unsigned cache_size = 16);
+    /**
+    * Reorders the vertices by their first use in the index buffer and removes unreferenced vertices. Returns the
+    * remap table from the old to the new vertex index, unreferenced vertices map to ~0u.
+    */
+    static std::vector<unsigned> optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<unsigned>& indices);
+    /**
+    * Runs all passes on the mesh, before and after receive the statistics if not nullptr.
+    */
+    static void optimize(Mesh& mesh, unsigned cache_size = 16, CacheStats* before = nullptr, CacheStats* after = nullptr);
+  };
+}
+
+#endif
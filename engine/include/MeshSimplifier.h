@@ -0,0 +1,58 @@
+#ifndef MESHSIMPLIFIER_H
+#define MESHSIMPLIFIER_H
+
+#include <Vertex.h>
+#include <memory>
+#include <vector>
+#include <limits>
+#include <cstddef>
+
+namespace fly
+{
+  class Mesh;
+
+  /**
+  * Quadric error metric simplification (Garland and Heckbert 1997) with half edge collapses: a vertex is moved
+  * onto a neighbor, so the remaining vertices keep their attributes and the vertex buffer can be shared with the
+  * original mesh. Each pass collapses the cheapest independent edges, collapses that would flip or fold a triangle
+  * are skipped. Duplicated vertices with equal attributes are welded. On UV or normal seams, where two vertices share
+  * a position, both move together along the seam so that it doesn't tear apart; positions shared by more than two
+  * different vertices are locked.
+  */
+  class MeshSimplifier
+  {
+  public:
+    struct Settings
+    {
+      /**
+      * Weights of the squared normal and uv differences of a collapse, scaled by the squared edge length so that
+      * they are comparable to the geometric error.
+      */
+      float _normalWeight = 0.5f;
+      float _uvWeight = 1.f;
+      /**
+      * Keeps the vertices on open borders, otherwise borders are preserved by constraint planes perpendicular to them.
+      * Locking them keeps meshes made of many small open pieces like leaf cards from being reduced.
+      */
+      bool _lockBorders = false;
+      /**
+      * Collapses with a larger error are not performed. The error of a collapse is the square root of its cost, the
+      * quadric error plus the weighted normal and uv differences.
+      */
+      float _maxError = std::numeric_limits<float>::max();
+    };
+    /**
+    * Returns an index buffer with at most target_num_indices indices if the error bound allows it, referencing
+    * the same vertices. error receives the largest error of the performed collapses if not nullptr.
+    */
+    static std::vector<unsigned> simplify(const std::vector<Vertex>& vertices, const std::vector<unsigned>& indices, size_t target_num_indices,
+      const Settings& settings, float* error = nullptr);
+    /**
+    * Simplified copy of the mesh with about ratio times its triangles, unreferenced vertices are removed and the
+    * result is optimized with MeshOptimizer. The material is shared with the source mesh.
+    */
+    static std::shared_ptr<Mesh> simplify(const Mesh& mesh, float ratio, const Settings& settings, float* error = nullptr);
+  };
+}
+
+#endif
@@ -0,0 +1,70 @@
+#ifndef MINMAXPYRAMID_H
+#define MINMAXPYRAMID_H
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <cstddef>
+
+namespace fly
+{
+  /**
+  * Mip chain of the minimum and maximum heights of a heightmap. Cell (x, z) of level l covers the texels
+  * [x * 2^l, (x + 1) * 2^l] x [z * 2^l, (z + 1) * 2^l] inclusive, clamped to the heightmap, so a quadtree node
+  * of size 2^l at position p has the bounds of cell p / 2^l. Each level has half the cells of the previous one,
+  * the last level consists of a single cell covering the whole heightmap. Level 0 isn't stored but computed
+  * from the heightmap, which therefore has to outlive the pyramid.
+  */
+  class MinMaxPyramid
+  {
+  public:
+    struct MinMax
+    {
+      float _min;
+      float _max;
+    };
+    /**
+    * Builds all levels bottom-up, the rows of each level are processed in parallel. row_stride is the
+    * distance between two rows of the heightmap in floats.
+    */
+    MinMaxPyramid(const float* heights, int width, int height, size_t row_stride);
+    unsigned getNumLevels() const;
+    /**
+    * Number of cells of the level in x and z direction.
+    */
+    const glm::ivec2& getLevelSize(unsigned level) const;
+    /**
+    * Bounds of a single cell, the cell coordinates are clamped to the level.
+    */
+    MinMax getMinMax(unsigned level, int x, int z) const;
+    /**
+    * Bounds of the texels [pos, pos + size] inclusive, e.g. the footprint of a terrain node. O(1) for nodes whose
+    * size is a power of two and whose position is a multiple of their size, otherwise at most 3 x 3 cells are combined.
+    */
+    MinMax getMinMax(const glm::ivec2& pos, int size) const;
+    /**
+    * First intersection of the ray origin + t * dir, t in [0, max_t], with the heightmap in the xz plane, texel (x, z)
+    * at (x, height, z). Cells are split into two triangles like the terrain tiles. The traversal descends from the
+    * coarsest level and visits the children of a cell front to back, skipping those whose bounds the ray misses.
+    */
+    bool intersectRay(const glm::vec3& origin, const glm::vec3& dir, float max_t, float& t) const;
+  private:
+    const float* _heights;
+    size_t _rowStride;
+    /**
+    * Levels 1 to n - 1, one after another.
+    */
+    std::vector<MinMax> _cells;
+    std::vector<size_t> _levelOffsets;
+    std::vector<glm::ivec2> _levelSizes;
+    /**
+    * The ray is known to enter the bounds of the cell before t, which is updated on a closer hit.
+    */
+    bool intersectCell(unsigned level, int x, int z, const glm::vec3& origin, const glm::vec3& dir, float& t) const;
+    /**
+    * Entry distance of the ray into the bounds of a cell, false if it misses them before max_t.
+    */
+    bool intersectCellBounds(unsigned level, int x, int z, const glm::vec3& origin, const glm::vec3& dir, float max_t, float& t_entry) const;
+  };
+}
+
+#endif
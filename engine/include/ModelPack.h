@@ -0,0 +1,131 @@
+#ifndef MODELPACK_H
+#define MODELPACK_H
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <math/FlyMath.h>
+
+namespace fly
+{
+  class Model;
+  class MappedFile;
+  struct Vertex;
+
+  /**
+  * Binary pack of a model and its LOD chain as written by the asset cooker: vertex and index blobs, materials and
+  * the aabbs of the meshes. Meshes and materials shared between LODs are stored once. Like SceneSnapshot, all
+  * sections are arrays of plain structs addressed by file offsets, every blob starts at a 16 byte boundary so it
+  * can be uploaded straight from the mapping.
+  */
+  class ModelPack
+  {
+  public:
+    static const uint32_t VERSION = 1;
+    /**
+    * Writes the LOD chain, lods[0] is the full detail model. Returns false on failure.
+    */
+    static bool save(const std::string& path, const std::vector<std::shared_ptr<Model>>& lods);
+    /**
+    * Returns nullptr if the file can't be mapped, is truncated or was written by an incompatible version.
+    */
+    static std::unique_ptr<ModelPack> load(const std::string& path);
+    ~ModelPack();
+    unsigned getNumLods() const;
+    /**
+    * Creates the models of all LODs, which share their meshes and materials like the models that were saved.
+    */
+    std::vector<std::shared_ptr<Model>> createModels() const;
+
+    struct Header
+    {
+      char _magic[4];
+      uint32_t _version;
+      uint32_t _vertexSize;
+      uint32_t _numLods;
+      uint32_t _numMeshes;
+      uint32_t _numMaterials;
+      uint32_t _numRefs;
+      uint32_t _padding;
+      uint64_t _lodsOffset;
+      uint64_t _meshesOffset;
+      uint64_t _materialsOffset;
+      uint64_t _refsOffset;
+      uint64_t _fileSize;
+    };
+    struct StringRef
+    {
+      uint64_t _offset;
+      uint64_t _length;
+    };
+    /**
+    * Meshes and materials of a LOD as ranges of the reference section, which holds indices into the mesh and
+    * material sections. The meshes are in the order of Model::getMeshes(), the materials in the order of
+    * Model::getMaterials().
+    */
+    struct LodRecord
+    {
+      uint32_t _firstMeshRef;
+      uint32_t _numMeshes;
+      uint32_t _firstMaterialRef;
+      uint32_t _numMaterials;
+    };
+    struct MeshRecord
+    {
+      uint64_t _verticesOffset;
+      uint64_t _indicesOffset;
+      uint32_t _numVertices;
+      uint32_t _numIndices;
+      uint32_t _materialIndex;
+      uint32_t _material; // Index into the material section, NO_INDEX if none
+      Vec3f _aabbMin;
+      Vec3f _aabbMax;
+    };
+    struct MaterialRecord
+    {
+      StringRef _diffusePath;
+      StringRef _normalPath;
+      StringRef _opacityPath;
+      StringRef _heightPath;
+      Vec3f _diffuseColor;
+      float _specularExponent;
+      float _windStrength;
+      float _windFrequency;
+      float _ka;
+      float _kd;
+      float _ks;
+      float _parallaxHeightScale;
+      float _parallaxMinSteps;
+      float _parallaxMaxSteps;
+      float _parallaxBinarySearchSteps;
+      uint32_t _flags;
+    };
+    enum : uint32_t
+    {
+      NO_INDEX = 0xffffffff,
+      MATERIAL_WIND_X = 1, MATERIAL_WIND_Z = 2, MATERIAL_REFLECTIVE = 4
+    };
+    /**
+    * Direct access to the mapped geometry, e.g. to upload it without copying it into Mesh objects first.
+    */
+    const MeshRecord* getMeshRecords() const;
+    unsigned getNumMeshRecords() const;
+    const Vertex* getVertices(const MeshRecord& mesh) const;
+    const unsigned* getIndices(const MeshRecord& mesh) const;
+  private:
+    ModelPack(std::unique_ptr<MappedFile>&& file);
+    bool fixup();
+    template<typename T>
+    bool resolve(uint64_t offset, uint64_t count, const T*& ptr) const;
+    std::string getString(const StringRef& str) const;
+    std::unique_ptr<MappedFile> _file;
+    const Header* _header;
+    const LodRecord* _lods;
+    const MeshRecord* _meshes;
+    const MaterialRecord* _materials;
+    const uint32_t* _refs;
+  };
+}
+
+#endif
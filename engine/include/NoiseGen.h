@@ -2,21 +2,76 @@
 #define NOISE_GEN_H
 
 #include <vector>
+#include <array>
+#include <cstdint>
 #include <glm/glm.hpp>
+#include <math/FlyMath.h>
 
 namespace fly
 {
   class NoiseGen
   {
   public:
+    /**
+    * Fractal sum of octaves: sum_i amplitude * gain^i * noise(pos * frequency * lacunarity^i). Ridged noise
+    * sums 1 - |noise| instead.
+    */
+    struct FBmParams
+    {
+      unsigned _octaves = 8;
+      float _frequency = 1.f;
+      float _amplitude = 1.f;
+      float _gain = 0.5f;
+      float _lacunarity = 2.f;
+      bool _ridged = false;
+    };
     NoiseGen(int grid_size = 16, bool make_tileable = true);
     virtual ~NoiseGen();
-    float getPerlin(const glm::vec2& pos);
+    float getPerlin(const glm::vec2& pos) const;
+    float getFBm(const glm::vec2& pos, const FBmParams& params) const;
+    /**
+    * Evaluates fBm on a width x height grid, the sample (x, y) is taken at origin + (x, y) * step. Returns the image
+    * in row major order. Rows are distributed over the shared thread pool and four samples of a row are evaluated at once.
+    * Coordinates must be non-negative.
+    */
+    std::vector<float> getFBm(unsigned width, unsigned height, const FBmParams& params, const Vec2f& origin = Vec2f(0.f), float step = 1.f) const;
   private:
     int _gridWidth;
     std::vector<glm::vec2> _gradientVectors;
-    float dotGridGradient(const glm::ivec2& grid_pos, const glm::vec2& pos);
-    glm::vec2 smoothstep(const glm::vec2& t);
+    float dotGridGradient(const glm::ivec2& grid_pos, const glm::vec2& pos) const;
+    glm::vec2 smoothstep(const glm::vec2& t) const;
+    void accumulateRow(float y, float x_begin, float step, unsigned width, float frequency, float amplitude, bool ridged, float* row) const;
+  };
+
+  /**
+  * Seeded lattice noise that hashes grid coordinates through a permutation table instead of storing a gradient per
+  * grid point. The footprint is fixed and the noise repeats every 256 units. The tables are built with an integer
+  * generator and the evaluation only uses float additions and multiplications, so a given seed yields identical
+  * values on every platform, as long as the compiler does not contract multiply-adds (default with MSVC, GCC and
+  * Clang need -ffp-contract=off). All functions return values in about [-1, 1].
+  */
+  class HashNoiseGen
+  {
+  public:
+    HashNoiseGen(uint32_t seed = 0);
+    virtual ~HashNoiseGen() = default;
+    float getPerlin(const Vec2f& pos) const;
+    float getPerlin(const Vec3f& pos) const;
+    float getSimplex(const Vec2f& pos) const;
+    float getSimplex(const Vec3f& pos) const;
+    float getValue(const Vec2f& pos) const;
+    float getValue(const Vec3f& pos) const;
+    uint32_t getSeed() const;
+  private:
+    uint32_t _seed;
+    /**
+    * Permutation of 0..255 stored twice, so that _perm[_perm[x] + y] needs no wrap around.
+    */
+    std::array<uint8_t, 512> _perm;
+    std::array<uint8_t, 512> _permMod12;
+    std::array<float, 256> _values;
+    inline unsigned hash(int x, int y) const { return _perm[_perm[x & 255] + (y & 255)]; }
+    inline unsigned hash(int x, int y, int z) const { return _perm[_perm[_perm[x & 255] + (y & 255)] + (z & 255)]; }
   };
 }
 
@@ -3,6 +3,7 @@
 
 #include <array>
 #include <math/FlyMath.h>
+#include <math/FastMath.h>
 #include <AABB.h>
 #include <memory>
 #include <sstream>
@@ -172,7 +173,7 @@ namespace fly
             }
           }
           float error = (_aabbWorld.getMax() - _aabbWorld.getMin()).length() / (cam_pos - _aabbWorld.center()).length();
-          error = pow(error, detail_culling_params._errorExponent);
+          error = fastmath::pow(error, detail_culling_params._errorExponent);
           if (error > detail_culling_params._errorThreshold) {
             for (const auto& c : _children) {
               if (c) {
@@ -0,0 +1,98 @@
+#ifndef PARALLELFOR_H
+#define PARALLELFOR_H
+
+#include <ThreadPool.h>
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <vector>
+
+namespace fly
+{
+  /**
+  * Number of elements per task if no grain size is specified: a few chunks per thread so that
+  * uneven workloads can be balanced by work stealing.
+  */
+  inline size_t defaultGrainSize(size_t num_elements, const ThreadPool& pool = ThreadPool::getShared())
+  {
+    return (std::max)(num_elements / (pool.getConcurrency() * 4), size_t(1));
+  }
+  /**
+  * Calls func(chunk_begin, chunk_end) for consecutive chunks of [begin, end) with at most grain_size elements.
+  * Chunks are processed concurrently, a grain size of 0 selects defaultGrainSize().
+  */
+  template<typename Func>
+  void parallelForChunks(size_t begin, size_t end, const Func& func, size_t grain_size = 0, ThreadPool& pool = ThreadPool::getShared())
+  {
+    if (end <= begin) {
+      return;
+    }
+    if (!grain_size) {
+      grain_size = defaultGrainSize(end - begin, pool);
+    }
+    if (end - begin <= grain_size || !pool.getNumWorkers()) {
+      func(begin, end);
+      return;
+    }
+    ThreadPool::TaskGroup group;
+    for (size_t i = begin + grain_size; i < end; i += grain_size) {
+      size_t chunk_end = (std::min)(i + grain_size, end);
+      pool.submit(group, [&func, i, chunk_end]() {
+        func(i, chunk_end);
+      });
+    }
+    func(begin, (std::min)(begin + grain_size, end)); // The calling thread takes the first chunk itself
+    pool.wait(group);
+  }
+  /**
+  * Calls func(i) for each i in [begin, end).
+  */
+  template<typename Func>
+  void parallelFor(size_t begin, size_t end, const Func& func, size_t grain_size = 0, ThreadPool& pool = ThreadPool::getShared())
+  {
+    parallelForChunks(begin, end, [&func](size_t chunk_begin, size_t chunk_end) {
+      for (size_t i = chunk_begin; i < chunk_end; i++) {
+        func(i);
+      }
+    }, grain_size, pool);
+  }
+  /**
+  * Calls func(element) for each element of a random access container, e.g. a vector of components.
+  */
+  template<typename Container, typename Func>
+  void parallelForEach(Container& container, const Func& func, size_t grain_size = 0, ThreadPool& pool = ThreadPool::getShared())
+  {
+    auto first = std::begin(container);
+    parallelFor(0, static_cast<size_t>(std::distance(first, std::end(container))), [&func, &first](size_t i) {
+      func(first[i]);
+    }, grain_size, pool);
+  }
+  /**
+  * Accumulates func(i, partial) over [begin, end) and merges the partial results with combine(result, partial).
+  * Chunk boundaries only depend on the grain size and partial results are combined in index order, the result
+  * is therefore identical across runs and machines, also for floating point types.
+  */
+  template<typename T, typename Func, typename Combine>
+  T parallelReduce(size_t begin, size_t end, const T& identity, const Func& func, const Combine& combine, size_t grain_size = 1024, ThreadPool& pool = ThreadPool::getShared())
+  {
+    if (end <= begin) {
+      return identity;
+    }
+    grain_size = (std::max)(grain_size, size_t(1));
+    std::vector<T> partials((end - begin + grain_size - 1) / grain_size, identity);
+    parallelFor(0, partials.size(), [&](size_t chunk) {
+      size_t chunk_begin = begin + chunk * grain_size;
+      size_t chunk_end = (std::min)(chunk_begin + grain_size, end);
+      for (size_t i = chunk_begin; i < chunk_end; i++) {
+        func(i, partials[chunk]);
+      }
+    }, 1, pool);
+    T result = identity;
+    for (const auto& p : partials) {
+      combine(result, p);
+    }
+    return result;
+  }
+}
+
+#endif
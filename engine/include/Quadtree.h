@@ -7,9 +7,26 @@
 #include <memory>
 #include <sstream>
 #include <Settings.h>
+#include <vector>
 
 namespace fly
 {
+  /**
+  * Pointer free representation of a quadtree node, used to store a built tree on disk.
+  * Child indices are -1 for absent children, the elements of a node are given as a range into a separate element array.
+  */
+  struct QuadtreeFlatNode
+  {
+    Vec2f _min;
+    Vec2f _max;
+    Vec3f _aabbMin;
+    Vec3f _aabbMax;
+    float _largestElementAABBWorldSize;
+    int _children[4];
+    unsigned _firstElement;
+    unsigned _numElements;
+  };
+
   template<typename T>
   class Quadtree
   {
@@ -26,6 +43,19 @@ namespace fly
         _largestElementAABBWorldSize(0.f)
       {
       }
+      Node(const QuadtreeFlatNode* nodes, unsigned index, const TPtr* elements) :
+        _min(nodes[index]._min),
+        _max(nodes[index]._max),
+        _aabbWorld(nodes[index]._aabbMin, nodes[index]._aabbMax),
+        _largestElementAABBWorldSize(nodes[index]._largestElementAABBWorldSize),
+        _elements(elements + nodes[index]._firstElement, elements + nodes[index]._firstElement + nodes[index]._numElements)
+      {
+        for (unsigned i = 0; i < 4; i++) {
+          if (nodes[index]._children[i] >= 0) {
+            _children[i] = std::make_unique<Node>(nodes, nodes[index]._children[i], elements);
+          }
+        }
+      }
       inline const Vec2f& getMin() const { return _min; }
       inline const Vec2f& getMax() const { return _max; }
       inline Vec2f getSize() const { return _max - _min; }
@@ -214,6 +244,23 @@ namespace fly
           }
         }
       }
+      /**
+      * Appends the subtree in depth first order, returns the index of this node.
+      */
+      int flatten(std::vector<QuadtreeFlatNode>& nodes, std::vector<TPtr>& elements) const
+      {
+        int index = static_cast<int>(nodes.size());
+        nodes.push_back({ _min, _max, _aabbWorld.getMin(), _aabbWorld.getMax(), _largestElementAABBWorldSize, { -1, -1, -1, -1 },
+          static_cast<unsigned>(elements.size()), static_cast<unsigned>(_elements.size()) });
+        elements.insert(elements.end(), _elements.begin(), _elements.end());
+        for (unsigned i = 0; i < 4; i++) {
+          if (_children[i]) {
+            int child = _children[i]->flatten(nodes, elements);
+            nodes[index]._children[i] = child;
+          }
+        }
+        return index;
+      }
       bool removeElement(const TPtr& element)
       {
         for (unsigned i = 0; i < _elements.size(); i++) {
@@ -253,6 +300,17 @@ namespace fly
       _root = std::make_unique<Node>(min.xz(), max.xz());
       _root->setAABBWorld(AABB(min, max));
     }
+    /**
+    * Restores a tree that was flattened with flatten(), the first node is the root.
+    */
+    Quadtree(const QuadtreeFlatNode* nodes, const TPtr* elements) :
+      _root(std::make_unique<Node>(nodes, 0, elements))
+    {
+    }
+    void flatten(std::vector<QuadtreeFlatNode>& nodes, std::vector<TPtr>& elements) const
+    {
+      _root->flatten(nodes, elements);
+    }
     void insert(const TPtr& element)
     {
       if (_root->getAABBWorld()->contains(*element->getAABBWorld())) {
@@ -0,0 +1,144 @@
+#ifndef SCENESNAPSHOT_H
+#define SCENESNAPSHOT_H
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <math/FlyMath.h>
+#include <WindParamsLocal.h>
+#include <Quadtree.h>
+
+namespace fly
+{
+  class Entity;
+  class EntityManager;
+  class MappedFile;
+
+  /**
+  * Binary snapshot of the static part of a scene: meshes, materials, entities with their transforms,
+  * world aabbs and the spatial index built over them. All sections are arrays of plain structs addressed
+  * by file offsets, so loading a snapshot boils down to mapping the file and turning offsets into pointers.
+  */
+  class SceneSnapshot
+  {
+  public:
+    static const uint32_t VERSION = 2;
+    /**
+    * Writes all entities of the entity manager that own a StaticMeshRenderable. Returns false on failure.
+    */
+    static bool save(const std::string& path, const EntityManager& em);
+    /**
+    * Returns nullptr if the file can't be mapped, is truncated or was written by an incompatible version.
+    */
+    static std::unique_ptr<SceneSnapshot> load(const std::string& path);
+    ~SceneSnapshot();
+    /**
+    * Creates the stored entities, the returned vector is in file order.
+    */
+    std::vector<std::shared_ptr<Entity>> instantiate(EntityManager& em) const;
+    /**
+    * Spatial index over the stored entities, see Quadtree::flatten(). The elements are returned as
+    * entities of a previous instantiate() call.
+    */
+    const QuadtreeFlatNode* getSpatialIndexNodes() const;
+    unsigned getNumSpatialIndexNodes() const;
+    std::vector<Entity*> getSpatialIndexElements(const std::vector<std::shared_ptr<Entity>>& entities) const;
+    unsigned getNumEntities() const;
+
+    struct Header
+    {
+      char _magic[4];
+      uint32_t _version;
+      uint32_t _vertexSize;
+      /**
+      * Sizes of the records, which contain SIMD aligned vectors and matrices and differ with FLY_NO_SIMD.
+      */
+      uint32_t _meshRecordSize;
+      uint32_t _materialRecordSize;
+      uint32_t _entityRecordSize;
+      uint32_t _nodeSize;
+      uint32_t _numMeshes;
+      uint32_t _numMaterials;
+      uint32_t _numEntities;
+      uint32_t _numNodes;
+      uint32_t _numNodeElements;
+      uint64_t _meshesOffset;
+      uint64_t _materialsOffset;
+      uint64_t _entitiesOffset;
+      uint64_t _nodesOffset;
+      uint64_t _nodeElementsOffset;
+      uint64_t _fileSize;
+    };
+    struct StringRef
+    {
+      uint64_t _offset;
+      uint64_t _length;
+    };
+    struct MeshRecord
+    {
+      uint64_t _verticesOffset;
+      uint64_t _indicesOffset;
+      uint32_t _numVertices;
+      uint32_t _numIndices;
+      uint32_t _materialIndex;
+      uint32_t _material; // Index into the material section, NO_INDEX if none
+      Vec3f _aabbMin;
+      Vec3f _aabbMax;
+    };
+    struct MaterialRecord
+    {
+      StringRef _diffusePath;
+      StringRef _normalPath;
+      StringRef _opacityPath;
+      StringRef _heightPath;
+      Vec3f _diffuseColor;
+      float _specularExponent;
+      float _windStrength;
+      float _windFrequency;
+      float _ka;
+      float _kd;
+      float _ks;
+      float _parallaxHeightScale;
+      float _parallaxMinSteps;
+      float _parallaxMaxSteps;
+      float _parallaxBinarySearchSteps;
+      uint32_t _flags;
+    };
+    struct EntityRecord
+    {
+      Mat4f _modelMatrix;
+      Mat3f _modelMatrixInverse;
+      Vec3f _aabbMin;
+      Vec3f _aabbMax;
+      Vec3f _translation;
+      Vec3f _scale;
+      Vec3f _degrees;
+      WindParamsLocal _windParams;
+      uint32_t _mesh;
+      uint32_t _material;
+      uint32_t _flags;
+    };
+    enum : uint32_t
+    {
+      NO_INDEX = 0xffffffff,
+      MATERIAL_WIND_X = 1, MATERIAL_WIND_Z = 2, MATERIAL_REFLECTIVE = 4,
+      ENTITY_TRANSFORM = 1, ENTITY_WIND = 2
+    };
+  private:
+    SceneSnapshot(std::unique_ptr<MappedFile>&& file);
+    bool fixup();
+    template<typename T>
+    bool resolve(uint64_t offset, uint64_t count, const T*& ptr) const;
+    std::string getString(const StringRef& str) const;
+    std::unique_ptr<MappedFile> _file;
+    const Header* _header;
+    const MeshRecord* _meshes;
+    const MaterialRecord* _materials;
+    const EntityRecord* _entities;
+    const QuadtreeFlatNode* _nodes;
+    const uint32_t* _nodeElements;
+  };
+}
+
+#endif
@@ -19,6 +19,17 @@ namespace fly
   public:
     StaticMeshRenderable(const std::shared_ptr<Mesh>& mesh, const std::shared_ptr<Material>& material, 
       const Mat4f& model_matrix, bool has_wind, const Vec3f& aabb_offset = Vec3f(0.f));
+    /**
+    * Uses the cached world and normal matrix of the transform, see Transform::updateWorldMatrix() for transforms
+    * with a parent that weren't updated by the engine yet.
+    */
+    StaticMeshRenderable(const std::shared_ptr<Mesh>& mesh, const std::shared_ptr<Material>& material,
+      const Transform& transform, bool has_wind, const Vec3f& aabb_offset = Vec3f(0.f));
+    /**
+    * Takes the precomputed inverse model matrix and world aabb instead of transforming all vertices.
+    */
+    StaticMeshRenderable(const std::shared_ptr<Mesh>& mesh, const std::shared_ptr<Material>& material,
+      const Mat4f& model_matrix, const Mat3f& model_matrix_inverse, const AABB& aabb_world, bool has_wind);
     AABB* getAABBWorld() const;
     const std::shared_ptr<Mesh>& getMesh() const;
     const std::shared_ptr<Material>& getMaterial() const;
@@ -36,6 +47,7 @@ namespace fly
     std::unique_ptr<AABB> _aabbWorld;
     bool _hasWind;
     WindParamsLocal _windParams;
+    void computeAABBWorld(const Vec3f& aabb_offset);
   };
 }
 
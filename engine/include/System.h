@@ -2,6 +2,10 @@
 #define SYSTEM_H
 
 #include <memory>
+#include <set>
+#include <string>
+#include <typeindex>
+#include <Component.h>
 
 namespace fly
 {
@@ -14,7 +18,40 @@ namespace fly
     virtual ~System();
 
     virtual void onComponentsChanged(Entity* entity) = 0;
+    /**
+    * Called with the component types that were added, replaced or removed. Systems that can apply
+    * partial updates override this one, the default forwards to onComponentsChanged(entity).
+    */
+    virtual void onComponentTypesChanged(Entity* entity, const std::set<std::type_index>& changed_types);
     virtual void update(float time, float delta_time) = 0;
+    /**
+    * Class name without namespaces, used for the scheduler timings.
+    */
+    virtual std::string getName() const;
+    /**
+    * Component types that are accessed during update(). Systems that don't declare any access are
+    * assumed to touch everything, they never run concurrently with other systems.
+    */
+    bool declaresAccess() const;
+    const std::set<std::type_index>& getReads() const;
+    const std::set<std::type_index>& getWrites() const;
+    bool conflictsWith(const System& other) const;
+  protected:
+    template<typename T>
+    void reads()
+    {
+      static_assert(std::is_base_of<Component, T>::value, "T must be derived from Component");
+      _reads.insert(std::type_index(typeid(T)));
+    }
+    template<typename T>
+    void writes()
+    {
+      static_assert(std::is_base_of<Component, T>::value, "T must be derived from Component");
+      _writes.insert(std::type_index(typeid(T)));
+    }
+  private:
+    std::set<std::type_index> _reads;
+    std::set<std::type_index> _writes;
   };
 }
 
@@ -0,0 +1,53 @@
+#ifndef SYSTEMSCHEDULER_H
+#define SYSTEMSCHEDULER_H
+
+#include <atomic>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace fly
+{
+  class System;
+  class ThreadPool;
+
+  /**
+  * Runs the systems of a frame as a dependency graph. Two systems conflict if one of them writes a component
+  * type the other one reads or writes, conflicting systems are executed in the order they were added.
+  * Everything else runs concurrently on the thread pool. Systems without declared access run exclusively
+  * on the thread that calls update(), since the renderers need the thread that owns the graphics context.
+  */
+  class SystemScheduler
+  {
+  public:
+    struct SystemTiming
+    {
+      std::string _name;
+      unsigned _microSeconds;
+    };
+    SystemScheduler(ThreadPool& pool);
+    void setSystems(const std::vector<std::shared_ptr<System>>& systems);
+    void update(float time, float delta_time);
+    /**
+    * Execution times of the last update, in the order the systems were added.
+    */
+    const std::vector<SystemTiming>& getTimings() const;
+    friend std::ostream& operator<<(std::ostream& os, const SystemScheduler& scheduler);
+  private:
+    struct Node
+    {
+      std::shared_ptr<System> _system;
+      std::vector<unsigned> _successors;
+      unsigned _numPredecessors = 0;
+      bool _exclusive;
+    };
+    ThreadPool& _pool;
+    std::vector<Node> _nodes;
+    std::vector<SystemTiming> _timings;
+    std::unique_ptr<std::atomic<unsigned>[]> _remaining;
+    std::atomic<unsigned> _numFinished;
+  };
+}
+
+#endif
@@ -8,13 +8,20 @@
 #include <vector>
 #include <map>
 #include <array>
+#include <limits>
+#include <cstdint>
 #include <AABB.h>
 #include <Light.h>
+#include <MinMaxPyramid.h>
+#include <TerrainIndexPool.h>
+#include <ThreadPool.h>
 
 namespace fly
 {
   class Model;
   class Mesh;
+  class TerrainPager;
+  class CompressedHeightMap;
 
   class Terrain : public Component
   {
@@ -29,10 +36,46 @@ namespace fly
     Terrain(int tile_size, const WindParams& wind_params = WindParams(glm::vec2(1.f), 2.5f, 0.05f), float wind_strength = 1.f, float grass_height = 0.23f, const glm::vec3& grass_color = glm::vec3(83.f, 124.f, 59.f) / 255.f, const glm::vec3& terrain_col = glm::vec3(94.f, 82.f, 66.f) / 255.f);
     std::string& getDetailsNormalMap();
     float getHeight(int x, int z);
+    /**
+    * Bilinear interpolation of the heights around (x, z), positions outside of the terrain are clamped to its border.
+    */
+    float sampleHeight(float x, float z);
+    /**
+    * Normal of the bilinearly interpolated height field from central differences one texel apart.
+    */
+    glm::vec3 sampleNormal(float x, float z);
+    /**
+    * Samples the heights at num_positions positions in parallel, e.g. to place objects. With a pager the resident
+    * pages must not change meanwhile.
+    */
+    void sampleHeights(const glm::vec2* positions, size_t num_positions, float* heights);
+    /**
+    * Intersects the ray origin + t * dir, t in [0, max_t], with the terrain in model space, e.g. for picking and
+    * line of sight. Empty space is skipped with the min/max pyramid, false if the ray misses or there is no pyramid,
+    * which is the case with a pager.
+    */
+    bool rayCast(const glm::vec3& origin, const glm::vec3& dir, float max_t, glm::vec3& hit) const;
     cv::Mat& getSplatMap();
     cv::Mat& getHeightMap();
     int getTileSize();
-    void getTilesForRendering(std::map<int, std::map<int, int>>& lods, const glm::vec3& cam_pos_model_space, const glm::mat4& mvp);
+    struct RenderTile
+    {
+      glm::ivec2 _pos;
+      int _lod;
+      /**
+      * Combination of GeometryGenerator::SkirtFlag for the neighbors with a coarser LOD, see TerrainIndexPool.
+      */
+      unsigned _mask;
+    };
+    /**
+    * Selects the LOD of each tile such that its projected height error stays below the maximum screen space error
+    * and neighboring tiles differ by at most one LOD, then returns the tiles intersecting the frustum. pixels_per_unit
+    * is the projected size of one unit at distance one, i.e. viewport height * 0.5 * projection[1][1]. The returned
+    * buffer is reused by the next call.
+    */
+    const std::vector<RenderTile>& getTilesForRendering(const glm::vec3& cam_pos_model_space, const Mat4f& mvp, float pixels_per_unit);
+    void setMaxScreenSpaceError(float pixels);
+    float getMaxScreenSpaceError() const;
 
     struct TreeNode
     {
@@ -53,29 +96,47 @@ namespace fly
       TreeNode* _northWest = nullptr;
       TreeNode* _northEast = nullptr;
       int _lod = 0;
-      AABB* _aabb;
+      AABB* _aabb = nullptr;
     };
 
     void addTree(const glm::mat4& transform, float scale);
     void addCloudBillboard(const glm::vec3& pos, float scale);
+    /**
+    * Rules for scatterTrees(). Candidates lie on a jittered grid with a cell size of _minDistance and carry a
+    * random priority, a candidate is dropped if a candidate closer than _minDistance has a higher priority.
+    */
+    struct ScatterRules
+    {
+      float _minDistance = 8.f;
+      /**
+      * Probability that a candidate which passed the distance test is placed.
+      */
+      float _density = 1.f;
+      float _minHeight = std::numeric_limits<float>::lowest();
+      float _maxHeight = std::numeric_limits<float>::max();
+      /**
+      * Steepest slope in radians, measured from the horizontal.
+      */
+      float _maxSlope = glm::radians(90.f);
+      float _minScale = 0.4f;
+      float _maxScale = 0.65f;
+      /**
+      * Added to the terrain height, e.g. to sink the trunks into the ground.
+      */
+      float _heightOffset = -0.5f;
+    };
+    /**
+    * Places trees with a random scale and rotation around the y axis following the rules. The leaf nodes of the
+    * quadtree are processed in parallel and the trees are then appended to the ancestors, without descending from
+    * the root per tree. Each candidate only depends on the seed and its grid cell, so the result is identical
+    * for any number of threads. Returns the number of placed trees, requires a heightmap.
+    */
+    size_t scatterTrees(const ScatterRules& rules, uint32_t seed, ThreadPool& pool = ThreadPool::getShared());
 
-    std::vector<glm::vec2> getTileVertices();
-    std::vector<unsigned> getTileIndices(int lod);
-    std::vector<unsigned> getTileIndicesNorth(int lod);
-    std::vector<unsigned> getTileIndicesSouth(int lod);
-    std::vector<unsigned> getTileIndicesWest(int lod);
-    std::vector<unsigned> getTileIndicesEast(int lod);
-    std::vector<unsigned> getTileIndicesNorthSouth(int lod);
-    std::vector<unsigned> getTileIndicesEastWest(int lod);
-    std::vector<unsigned> getTileIndicesNorthEast(int lod);
-    std::vector<unsigned> getTileIndicesNorthWest(int lod);
-    std::vector<unsigned> getTileIndicesSouthWest(int lod);
-    std::vector<unsigned> getTileIndicesSouthEast(int lod);
-    std::vector<unsigned> getTileIndicesNorthEastSouth(int lod);
-    std::vector<unsigned> gettileIndicesEastSouthWest(int lod);
-    std::vector<unsigned> getTileIndicesSouthWestNorth(int lod);
-    std::vector<unsigned> getTileIndicesWestNorthEast(int lod);
-    std::vector<unsigned> getTileIndicesNorthWestSouthEast(int lod);
+    /**
+    * Tile vertices and index buffers for all LODs and neighbor masks, built on first use.
+    */
+    const TerrainIndexPool& getIndexPool();
     int getMaxLOD();
 
     void setHeightMap(const cv::Mat& height_map);
@@ -93,27 +154,62 @@ namespace fly
     void getTreeNodesForRendering(const glm::vec3& cam_pos_model_space, std::vector<TreeNode*>& nodes, const Mat4f& mvp, DirectionalLight* dl, const Mat4f& light_mvp = Mat4f());
     struct Tile
     {
-      Tile(const glm::ivec2& pos, Terrain* g);
+      Tile(const glm::ivec2& pos, int size, int num_lods, const MinMaxPyramid& pyramid);
       glm::vec2 center() const;
-      bool isVisible(const glm::mat4& mvp) const;
       glm::ivec2 _pos;
       int _size;
-      std::array<glm::vec3, 8> _aabb;
+      AABB _aabb;
+      /**
+      * Upper bound of the height error of each LOD: vertices skipped by LOD l lie inside cells of size 2^l
+      * whose corners are kept, the error is at most the largest height range of these cells.
+      */
+      std::vector<float> _lodErrors;
     };
+    /**
+    * Builds the dense tile grid, requires a heightmap.
+    */
     void generateTiles();
-    std::map<int, std::map<int, Tile>> _tiles;
+    /**
+    * Row major, tile (x, z) is at z * number of tiles in x + x.
+    */
+    std::vector<Tile> _tiles;
     float getGrassHeight();
     WindParams& getWindParams();
+    /**
+    * Computes the bounds of all quadtree nodes from the min/max pyramid of the heightmap.
+    */
     void build();
+    /**
+    * Min/max height pyramid of the heightmap, e.g. for ray casts and horizon queries. nullptr before setHeightMap().
+    * The pyramid keeps its heightmap alive, so holders of it are unaffected by a later setHeightMap().
+    */
+    const std::shared_ptr<const MinMaxPyramid>& getMinMaxPyramid() const;
+    /**
+    * Streams the heightmap and the quadtree from a page file instead of the heightmap set with setHeightMap().
+    * Call TerrainPager::update() with the camera position to load pages. The renderers skip paged terrains, they
+    * still need the whole heightmap.
+    */
+    void setPager(const std::shared_ptr<TerrainPager>& pager);
+    const std::shared_ptr<TerrainPager>& getPager() const;
+    /**
+    * Answers getHeight() and the sample functions from a compressed heightmap instead of the heightmap set with
+    * setHeightMap(), e.g. for large worlds that are only queried. A pager takes precedence.
+    * Memory only shrinks for terrains that are queried but not rendered: the quadtree pyramid, the tiles and the
+    * GPU textures are built from the float heightmap, which is kept if one was set.
+    */
+    void setCompressedHeightMap(const std::shared_ptr<const CompressedHeightMap>& height_map);
+    const std::shared_ptr<const CompressedHeightMap>& getCompressedHeightMap() const;
 
   private:
     glm::vec2 _min, _max;
     void getAllNodes(TreeNode* node, std::vector<TreeNode*>& nodes);
     void getTreeNodesForRendering(TreeNode* node, const glm::vec3& cam_pos_model_space, std::vector<TreeNode*>& nodes, const glm::mat4& mvp, DirectionalLight* dl, const Mat4f& light_mvps);
-    std::map<int, std::map<int, unsigned>> _indexMap;
 
     int _tileSize;
-    glm::ivec2 _maxTile = glm::ivec2(0, 0);
+    glm::ivec2 _numTiles = glm::ivec2(0, 0);
+    std::vector<int> _tileLods;
+    std::vector<RenderTile> _renderTiles;
+    float _maxScreenSpaceError = 4.f;
 
     int _maxLOD = 5;
 
@@ -135,18 +231,37 @@ namespace fly
     std::shared_ptr<Model> _leavesModel;
 
     std::unique_ptr<TreeNode> _rootNode;
+    std::shared_ptr<const MinMaxPyramid> _minMaxPyramid;
+    std::shared_ptr<TerrainPager> _pager;
+    std::shared_ptr<const CompressedHeightMap> _compressedHeightMap;
 
 
     float _grassHeight;
 
-    std::vector<unsigned int> getIndices(int lod, const glm::uvec2& low_offs, const glm::uvec2& up_offs);
-    std::vector<unsigned> skirtNorth(int lod);
-    std::vector<unsigned> skirtEast(int lod);
-    std::vector<unsigned> skirtWest(int lod);
-    std::vector<unsigned> skirtSouth(int lod);
+    std::unique_ptr<TerrainIndexPool> _indexPool;
 
-    int stepFromLOD(int lod);
+    static constexpr int stepFromLOD(int lod)
+    {
+      return 1 << lod;
+    }
+    /**
+    * LOD of the last selection, default_lod for tiles outside of the terrain.
+    */
+    inline int getTileLod(int x, int z, int default_lod) const
+    {
+      return x >= 0 && z >= 0 && x < _numTiles.x && z < _numTiles.y ? _tileLods[z * _numTiles.x + x] : default_lod;
+    }
     void buildQuadtree(TreeNode* node);
+    void getLeafNodes(TreeNode* node, std::vector<TreeNode*>& leaves);
+    struct ScatteredTrees
+    {
+      std::vector<glm::mat4> _transforms;
+      std::vector<float> _scales;
+    };
+    /**
+    * Appends the scattered trees of each leaf, in the order of getLeafNodes(), to the leaf and its ancestors.
+    */
+    void appendScatteredTrees(TreeNode* node, std::vector<ScatteredTrees>::const_iterator& leaf);
 
   };
 }
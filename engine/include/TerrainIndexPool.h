@@ -0,0 +1,66 @@
+#ifndef TERRAININDEXPOOL_H
+#define TERRAININDEXPOOL_H
+
+#include <GeometryGenerator.h>
+#include <glm/glm.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+#include <cstdint>
+
+namespace fly
+{
+  /**
+  * Index buffers of a geomipmapped terrain tile for all combinations of LOD and neighbor mask, stored one after
+  * another in a single index vector. The mask is a combination of GeometryGenerator::SkirtFlag, a set bit means
+  * the neighbor on that side has a coarser LOD and the edge is stitched to its vertices. All permutations index
+  * the same (tile size + 1)^2 grid vertices, which are stored row by row.
+  */
+  class TerrainIndexPool
+  {
+  public:
+    static const uint32_t VERSION = 1;
+    static const unsigned NUM_MASKS = 16;
+    struct Header
+    {
+      char _magic[4];
+      uint32_t _version;
+      uint32_t _tileSize;
+      uint32_t _numLods;
+      uint32_t _numIndices;
+      uint32_t _padding;
+    };
+    /**
+    * Builds all permutations. The interior triangles are emitted in stripes that fit into a post transform
+    * vertex cache with cache_size entries, the stitched edges follow the interior.
+    */
+    TerrainIndexPool(int tile_size, unsigned num_lods, unsigned cache_size = 16);
+    /**
+    * Returns false on failure.
+    */
+    bool save(const std::string& path) const;
+    /**
+    * Returns nullptr if the file can't be mapped, is truncated or was written by an incompatible version.
+    */
+    static std::unique_ptr<TerrainIndexPool> load(const std::string& path);
+    const std::vector<glm::vec2>& getVertices() const;
+    const std::vector<unsigned>& getIndices() const;
+    inline const GeometryGenerator::IndexBufferInfo& getInfo(unsigned lod, unsigned mask) const { return _infos[lod * NUM_MASKS + mask]; }
+    int getTileSize() const;
+    unsigned getNumLods() const;
+  private:
+    TerrainIndexPool() = default;
+    int _tileSize = 0;
+    unsigned _numLods = 0;
+    std::vector<glm::vec2> _vertices;
+    std::vector<unsigned> _indices;
+    /**
+    * Indexed by lod * NUM_MASKS + mask.
+    */
+    std::vector<GeometryGenerator::IndexBufferInfo> _infos;
+    void generateVertices();
+    void generateIndices(unsigned lod, unsigned mask, unsigned cache_size);
+  };
+}
+
+#endif
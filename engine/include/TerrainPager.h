@@ -0,0 +1,128 @@
+#ifndef TERRAINPAGER_H
+#define TERRAINPAGER_H
+
+#include <Terrain.h>
+#include <ThreadPool.h>
+#include <memory>
+#include <string>
+#include <vector>
+#include <list>
+#include <map>
+#include <unordered_map>
+#include <functional>
+#include <cstdint>
+
+namespace fly
+{
+  class MappedFile;
+
+  /**
+  * Heightmap split into square pages that are streamed from disk, for terrains that don't fit into memory.
+  * The page file stores the pages one after another, each with (page size + 1)^2 heights so that neighboring
+  * pages share their border texels. Pages around the camera are loaded asynchronously on a thread pool, the
+  * quadtree of a page gets its min/max heights from a MinMaxPyramid built by the loading task as well. The number
+  * of resident pages is limited, the least recently used pages outside of the load radius are evicted first.
+  * Paged terrains serve height queries and node selection, the renderers don't draw them yet.
+  */
+  class TerrainPager
+  {
+  public:
+    static const uint32_t VERSION = 1;
+    struct Header
+    {
+      char _magic[4];
+      uint32_t _version;
+      uint32_t _pageSize;
+      uint32_t _numPagesX;
+      uint32_t _numPagesZ;
+      uint32_t _width;
+      uint32_t _height;
+      uint32_t _padding;
+    };
+    struct Page
+    {
+      glm::ivec2 _index;
+      /**
+      * Row major (page size + 1)^2 heights, starting at the texel _index * page size.
+      */
+      std::vector<float> _heights;
+      std::unique_ptr<Terrain::TreeNode> _rootNode;
+    };
+    /**
+    * Writes a page file for a width x height heightmap, height_func(x, z) is called once per texel and page, so the
+    * whole heightmap never needs to be in memory. page_size must be a power of two, so that the quadtree of a page
+    * can be halved down to the minimum node size. Returns false on failure.
+    */
+    static bool save(const std::string& path, unsigned width, unsigned height, unsigned page_size, const std::function<float(int, int)>& height_func);
+    static bool save(const std::string& path, const cv::Mat& height_map, unsigned page_size);
+    /**
+    * Returns nullptr if the file can't be mapped, is truncated or was written by an incompatible version, or if
+    * the (2 * load_radius + 1)^2 pages around the camera don't fit into max_resident_pages. Pages are loaded by tasks
+    * of pool, which must outlive the pager.
+    */
+    static std::unique_ptr<TerrainPager> load(const std::string& path, size_t max_resident_pages = 64, int load_radius = 2, int min_node_size = 32,
+      ThreadPool& pool = ThreadPool::getShared());
+    ~TerrainPager();
+    /**
+    * Integrates finished loads, requests the pages within the load radius around the camera, nearest first,
+    * and evicts pages above the budget. Call once per frame. Returns true if pages were loaded or evicted, pointers
+    * to the nodes of evicted pages are invalid afterwards.
+    */
+    bool update(const glm::vec3& cam_pos_model_space);
+    /**
+    * Returns nullptr if the page isn't resident.
+    */
+    const Page* getPage(int page_x, int page_z);
+    /**
+    * Height at texel (x, z) clamped to the terrain, default_height if the page isn't resident.
+    */
+    float getHeight(int x, int z, float default_height = 0.f);
+    void getResidentPages(std::vector<const Page*>& pages) const;
+    unsigned getPageSize() const;
+    glm::ivec2 getNumPages() const;
+    glm::ivec2 getSize() const;
+    size_t getNumPendingLoads() const;
+    /**
+    * Number of pages that are loaded at the same time, at least one.
+    */
+    void setMaxPendingLoads(unsigned max_pending_loads);
+    unsigned getMaxPendingLoads() const;
+  private:
+    struct Entry
+    {
+      std::unique_ptr<Page> _page;
+      std::list<unsigned>::iterator _lruPos;
+    };
+    struct PendingLoad
+    {
+      std::unique_ptr<ThreadPool::TaskGroup> _group;
+      /**
+      * Written by the loading task, valid once the group is done.
+      */
+      std::unique_ptr<Page> _page;
+    };
+    TerrainPager(std::unique_ptr<MappedFile>&& file, size_t max_resident_pages, int load_radius, int min_node_size, ThreadPool& pool);
+    std::unique_ptr<MappedFile> _file;
+    const Header* _header = nullptr;
+    size_t _maxResidentPages;
+    int _loadRadius;
+    int _minNodeSize;
+    ThreadPool& _pool;
+    unsigned _maxPendingLoads = 4;
+    std::unordered_map<unsigned, Entry> _pages;
+    /**
+    * Keys of the resident pages, most recently used first.
+    */
+    std::list<unsigned> _lru;
+    /**
+    * The destructor waits for the running loads, which read the mapping.
+    */
+    std::map<unsigned, PendingLoad> _pendingLoads;
+    std::unique_ptr<Page> loadPage(const glm::ivec2& index) const;
+    void buildNode(Terrain::TreeNode* node, const glm::ivec2& page_origin, const MinMaxPyramid& pyramid) const;
+    bool isInLoadRadius(unsigned key, const glm::ivec2& cam_page) const;
+    inline unsigned key(int page_x, int page_z) const { return page_z * _header->_numPagesX + page_x; }
+  };
+}
+
+#endif
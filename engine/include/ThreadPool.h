@@ -0,0 +1,86 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace fly
+{
+  /**
+  * Work stealing thread pool. Every worker owns a task queue, it takes work from the back of its own queue
+  * and steals from the front of the other queues once it runs dry. Threads that wait for a task group help
+  * executing pending tasks instead of blocking, therefore tasks may safely submit and wait for other tasks.
+  */
+  class ThreadPool
+  {
+  public:
+    /**
+    * Keeps track of a set of submitted tasks, see wait().
+    */
+    class TaskGroup
+    {
+    public:
+      TaskGroup() = default;
+      TaskGroup(const TaskGroup& other) = delete;
+      TaskGroup& operator=(const TaskGroup& other) = delete;
+      inline bool done() const { return _pending.load(std::memory_order_acquire) == 0; }
+    private:
+      friend class ThreadPool;
+      std::atomic<unsigned> _pending = { 0 };
+    };
+    ThreadPool(unsigned num_workers = defaultNumWorkers());
+    ThreadPool(const ThreadPool& other) = delete;
+    ThreadPool& operator=(const ThreadPool& other) = delete;
+    ~ThreadPool();
+    void submit(TaskGroup& group, const std::function<void()>& task);
+    /**
+    * Returns once all tasks of the group have finished. The calling thread executes pending tasks while waiting.
+    */
+    void wait(TaskGroup& group);
+    /**
+    * Executes one pending task on the calling thread, returns false if there was nothing to do.
+    */
+    bool tryRunPendingTask();
+    unsigned getNumWorkers() const;
+    /**
+    * Number of threads that execute tasks while someone waits for them, i.e. the workers plus the waiting thread.
+    */
+    unsigned getConcurrency() const;
+    /**
+    * Process wide pool shared by the engine systems and the parallel algorithms.
+    */
+    static ThreadPool& getShared();
+    static unsigned defaultNumWorkers();
+  private:
+    struct Task
+    {
+      std::function<void()> _func;
+      TaskGroup* _group;
+    };
+    struct Queue
+    {
+      std::mutex _mutex;
+      std::deque<Task> _tasks;
+    };
+    std::vector<std::unique_ptr<Queue>> _queues;
+    std::vector<std::thread> _workers;
+    std::mutex _sleepMutex;
+    std::condition_variable _wakeUp;
+    std::atomic<unsigned> _numQueued = { 0 };
+    std::atomic<unsigned> _nextQueue = { 0 };
+    bool _stop = false;
+    void workerLoop(unsigned index);
+    bool popTask(unsigned index, Task& task);
+    bool stealTask(unsigned index, Task& task);
+    void execute(Task& task);
+    int currentWorkerIndex() const;
+  };
+}
+
+#endif
@@ -3,6 +3,7 @@
 
 #include <math/FlyMath.h>
 #include "Component.h"
+#include <memory>
 
 namespace fly
 {
@@ -10,6 +11,9 @@ namespace fly
   {
   public:
     Transform(const Vec3f& translation = Vec3f(0.f), const Vec3f& scale = Vec3f(1.f), const Vec3f& degrees = Vec3f(0.f));
+    /**
+    * Local transformation: translation * rotation x * rotation z * rotation y * scale
+    */
     Mat4f getModelMatrix() const;
     void setTranslation(const Vec3f& translation);
     void setScale(const Vec3f& scale);
@@ -17,12 +21,38 @@ namespace fly
     const Vec3f& getTranslation() const;
     const Vec3f& getScale() const;
     const Vec3f& getDegrees() const;
+    /**
+    * The world matrix of a transform with a parent is parent world matrix * local matrix.
+    */
+    void setParent(const std::shared_ptr<Transform>& parent);
+    const std::shared_ptr<Transform>& getParent() const;
+    /**
+    * Cached world matrix and the inverse of its upper 3x3 part, which is what the renderers expect for normals.
+    * The TransformSystem of the engine updates them once per frame before the systems without declared component
+    * access, i.e. the renderers, run. These are plain lookups and safe to call from systems running in parallel.
+    */
+    const Mat4f& getWorldMatrix() const;
+    const Mat3f& getNormalMatrix() const;
+    /**
+    * Brings the cached matrices of this transform and its ancestors up to date immediately, for code that runs
+    * outside of Engine::update(), e.g. while a scene is set up. Not thread safe.
+    */
+    void updateWorldMatrix();
   private:
+    friend class TransformSystem;
     Vec3f _translation;
     Vec3f _scale;
     Vec3f _degrees;
-
-
+    std::shared_ptr<Transform> _parent;
+    Mat4f _worldMatrix;
+    Mat3f _normalMatrix;
+    bool _dirty = true;
+    unsigned _version = 0;
+    unsigned _parentVersion = 0;
+    /**
+    * Recomputes the cached matrices if needed, assuming the parent is already up to date.
+    */
+    void updateFromParent();
   };
 }
 
@@ -0,0 +1,36 @@
+#ifndef TRANSFORMSYSTEM_H
+#define TRANSFORMSYSTEM_H
+
+#include <System.h>
+#include <map>
+#include <memory>
+#include <vector>
+
+namespace fly
+{
+  class Transform;
+
+  /**
+  * Keeps the world matrices of all transforms up to date. Transforms are stored sorted by their depth in the
+  * hierarchy, so a single pass over the array sees every parent before its children. Only transforms that changed
+  * or whose parent changed are recomputed, transforms of the same depth are processed in parallel.
+  */
+  class TransformSystem : public System
+  {
+  public:
+    TransformSystem();
+    virtual ~TransformSystem() = default;
+    virtual void onComponentsChanged(Entity* entity) override;
+    virtual void update(float time, float delta_time) override;
+  private:
+    std::map<Entity*, std::shared_ptr<Transform>> _transforms;
+    std::vector<std::shared_ptr<Transform>> _sorted;
+    std::vector<Transform*> _sortedParents;
+    // Index ranges of the transforms with the same depth, level i spans [_levels[i], _levels[i + 1])
+    std::vector<size_t> _levels;
+    bool _sortingDirty = true;
+    void sort();
+  };
+}
+
+#endif
@@ -0,0 +1,56 @@
+#ifndef VERTEXFORMAT_H
+#define VERTEXFORMAT_H
+
+#include <Vertex.h>
+#include <vector>
+#include <cstdint>
+
+namespace fly
+{
+  class AABB;
+
+  /**
+  * Vertex layouts a mesh can be uploaded to the GPU with, the CPU side copy of the mesh always uses Vertex.
+  * VF_COMPACT stores octahedral normals and tangents, the bitangent is reconstructed from cross(normal, tangent) and a sign.
+  * VF_UNORM_UV and VF_QUANTIZED_POSITION refine the compact layout and have no effect without it.
+  */
+  enum VertexFormatFlag : unsigned
+  {
+    VF_FULL = 0, // Vertex, 56 bytes
+    VF_COMPACT = 1, // CompactVertex, 24 bytes, half float uvs
+    VF_UNORM_UV = 2, // 16 bit unsigned normalized uvs instead of half floats, only valid if all uvs are in [0, 1]
+    VF_QUANTIZED_POSITION = 4 // QuantizedVertex, 20 bytes, positions are 16 bit unsigned normalized relative to the mesh AABB
+  };
+
+  struct CompactVertex
+  {
+    Vec3f _position;
+    int16_t _normal[2]; // Octahedral, 16 bit signed normalized
+    uint32_t _tangent; // Octahedral in x and y, bitangent sign in w, layout of GL_INT_2_10_10_10_REV
+    uint16_t _uv[2]; // Half floats or 16 bit unsigned normalized
+  };
+
+  struct QuantizedVertex
+  {
+    uint16_t _position[4]; // w is padding
+    int16_t _normal[2];
+    uint32_t _tangent;
+    uint16_t _uv[2];
+  };
+
+  /**
+  * Size in bytes of a single vertex in the given format.
+  */
+  size_t vertexSize(unsigned format);
+  /**
+  * Converts the vertices to the given format, aabb is the local bounding box of the vertices and is used for position quantization.
+  */
+  std::vector<uint8_t> encodeVertices(const std::vector<Vertex>& vertices, unsigned format, const AABB& aabb);
+  Vertex decodeVertex(const uint8_t* data, unsigned format, const AABB& aabb);
+  /**
+  * Transforms quantized positions in [0, 1]^3 back to the local space of the mesh.
+  */
+  Mat4f dequantizationMatrix(const AABB& aabb);
+}
+
+#endif
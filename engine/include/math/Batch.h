@@ -0,0 +1,178 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <math/FlyMath.h>
+#include <cstddef>
+#include <limits>
+
+namespace fly
+{
+  /**
+  * Batch kernels on arrays of three component points. Points are read with a byte stride, so interleaved vertex
+  * data can be passed directly, e.g. &vertices[0]._position with sizeof(Vertex). The SIMD paths gather four points
+  * at a time and transpose them to SoA form (x x x x, y y y y, z z z z) in registers.
+  */
+  namespace batch
+  {
+    inline const Vec3f& at(const Vec3f* points, size_t stride, size_t i)
+    {
+      return *reinterpret_cast<const Vec3f*>(reinterpret_cast<const char*>(points) + i * stride);
+    }
+#ifdef FLY_SSE
+    inline void load4(const Vec3f* points, size_t stride, size_t i, __m128& x, __m128& y, __m128& z)
+    {
+      __m128 a = simd::load3(at(points, stride, i).ptr());
+      __m128 b = simd::load3(at(points, stride, i + 1).ptr());
+      __m128 c = simd::load3(at(points, stride, i + 2).ptr());
+      __m128 d = simd::load3(at(points, stride, i + 3).ptr());
+      _MM_TRANSPOSE4_PS(a, b, c, d);
+      x = a;
+      y = b;
+      z = c;
+    }
+    /**
+    * Transforms four points in SoA form by the affine part of the column major matrix m (w is assumed to be 1).
+    */
+    inline void transform4(const float* m, __m128 x, __m128 y, __m128 z, __m128& x_out, __m128& y_out, __m128& z_out)
+    {
+      x_out = simd::madd(_mm_set1_ps(m[8]), z, simd::madd(_mm_set1_ps(m[4]), y, simd::madd(_mm_set1_ps(m[0]), x, _mm_set1_ps(m[12]))));
+      y_out = simd::madd(_mm_set1_ps(m[9]), z, simd::madd(_mm_set1_ps(m[5]), y, simd::madd(_mm_set1_ps(m[1]), x, _mm_set1_ps(m[13]))));
+      z_out = simd::madd(_mm_set1_ps(m[10]), z, simd::madd(_mm_set1_ps(m[6]), y, simd::madd(_mm_set1_ps(m[2]), x, _mm_set1_ps(m[14]))));
+    }
+    inline float hmin(__m128 v)
+    {
+      v = _mm_min_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+      return _mm_cvtss_f32(_mm_min_ps(v, _mm_movehl_ps(v, v)));
+    }
+    inline float hmax(__m128 v)
+    {
+      v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+      return _mm_cvtss_f32(_mm_max_ps(v, _mm_movehl_ps(v, v)));
+    }
+#endif
+  }
+
+  /**
+  * Writes m * (p, 1) for count points to the tightly packed array result. result may alias points if the stride is sizeof(Vec3f).
+  */
+  inline void transformPoints(const Mat4f& m, const Vec3f* points, size_t count, size_t stride, Vec3f* result)
+  {
+    size_t i = 0;
+#ifdef FLY_SSE
+    for (; i + 4 <= count; i += 4) {
+      __m128 x, y, z;
+      batch::load4(points, stride, i, x, y, z);
+      batch::transform4(m.ptr(), x, y, z, x, y, z);
+      __m128 w = _mm_setzero_ps();
+      _MM_TRANSPOSE4_PS(x, y, z, w);
+      simd::store3(&result[i][0], x);
+      simd::store3(&result[i + 1][0], y);
+      simd::store3(&result[i + 2][0], z);
+      simd::store3(&result[i + 3][0], w);
+    }
+#endif
+    for (; i < count; i++) {
+      result[i] = (m * Vec4f(batch::at(points, stride, i), 1.f)).xyz();
+    }
+  }
+
+  /**
+  * Extends bb_min and bb_max by count points. Like (std::min)(bb_min, p) the box keeps its value if a coordinate
+  * of a point is NaN or compares equal, e.g. -0 against 0, so the SIMD and scalar paths agree.
+  */
+  inline void minMaxReduce(const Vec3f* points, size_t count, size_t stride, Vec3f& bb_min, Vec3f& bb_max)
+  {
+    size_t i = 0;
+#ifdef FLY_SSE
+    __m128 acc_min = simd::load3(bb_min.ptr());
+    __m128 acc_max = simd::load3(bb_max.ptr());
+    for (; i < count; i++) {
+      __m128 p = simd::load3(batch::at(points, stride, i).ptr());
+      acc_min = _mm_min_ps(p, acc_min);
+      acc_max = _mm_max_ps(p, acc_max);
+    }
+    simd::store3(&bb_min[0], acc_min);
+    simd::store3(&bb_max[0], acc_max);
+#endif
+    for (; i < count; i++) {
+      bb_min = minimum(bb_min, batch::at(points, stride, i));
+      bb_max = maximum(bb_max, batch::at(points, stride, i));
+    }
+  }
+
+  /**
+  * Extends bb_min and bb_max by the count points transformed by m, without storing the transformed points. NaN
+  * coordinates are skipped like in the overload above, only the sign of a zero extreme may depend on the SIMD width.
+  */
+  inline void minMaxReduce(const Mat4f& m, const Vec3f* points, size_t count, size_t stride, Vec3f& bb_min, Vec3f& bb_max)
+  {
+    size_t i = 0;
+#ifdef FLY_SSE
+    __m128 min_x = _mm_set1_ps(bb_min[0]), min_y = _mm_set1_ps(bb_min[1]), min_z = _mm_set1_ps(bb_min[2]);
+    __m128 max_x = _mm_set1_ps(bb_max[0]), max_y = _mm_set1_ps(bb_max[1]), max_z = _mm_set1_ps(bb_max[2]);
+    for (; i + 4 <= count; i += 4) {
+      __m128 x, y, z;
+      batch::load4(points, stride, i, x, y, z);
+      batch::transform4(m.ptr(), x, y, z, x, y, z);
+      min_x = _mm_min_ps(x, min_x);
+      min_y = _mm_min_ps(y, min_y);
+      min_z = _mm_min_ps(z, min_z);
+      max_x = _mm_max_ps(x, max_x);
+      max_y = _mm_max_ps(y, max_y);
+      max_z = _mm_max_ps(z, max_z);
+    }
+    bb_min = Vec3f(batch::hmin(min_x), batch::hmin(min_y), batch::hmin(min_z));
+    bb_max = Vec3f(batch::hmax(max_x), batch::hmax(max_y), batch::hmax(max_z));
+#endif
+    for (; i < count; i++) {
+      auto p = (m * Vec4f(batch::at(points, stride, i), 1.f)).xyz();
+      bb_min = minimum(bb_min, p);
+      bb_max = maximum(bb_max, p);
+    }
+  }
+
+  /**
+  * Transforms count boxes given by their min and max corners by the affine matrix m and writes the enclosing boxes
+  * to min_out and max_out, which may alias the inputs. Uses Arvo's method: the center is transformed as a point and
+  * the new half extent is |linear part| * half extent, which yields the same box as transforming all 8 corners.
+  */
+  inline void transformAABBs(const Mat4f& m, const Vec3f* mins, const Vec3f* maxs, size_t count, Vec3f* min_out, Vec3f* max_out)
+  {
+#ifdef FLY_SSE
+    __m128 half = _mm_set1_ps(0.5f);
+    __m128 sign_mask = _mm_set1_ps(-0.f);
+    __m128 abs_col[3];
+    for (unsigned j = 0; j < 3; j++) {
+      abs_col[j] = _mm_andnot_ps(sign_mask, simd::load4(&m[j][0]));
+    }
+    for (size_t i = 0; i < count; i++) {
+      __m128 bb_min = simd::load3(mins[i].ptr());
+      __m128 bb_max = simd::load3(maxs[i].ptr());
+      __m128 center = _mm_mul_ps(_mm_add_ps(bb_min, bb_max), half);
+      __m128 extent = _mm_mul_ps(_mm_sub_ps(bb_max, bb_min), half);
+      center = simd::transform(m.ptr(), _mm_add_ps(center, _mm_set_ps(1.f, 0.f, 0.f, 0.f)));
+      __m128 e = _mm_mul_ps(abs_col[0], _mm_shuffle_ps(extent, extent, _MM_SHUFFLE(0, 0, 0, 0)));
+      e = simd::madd(abs_col[1], _mm_shuffle_ps(extent, extent, _MM_SHUFFLE(1, 1, 1, 1)), e);
+      e = simd::madd(abs_col[2], _mm_shuffle_ps(extent, extent, _MM_SHUFFLE(2, 2, 2, 2)), e);
+      simd::store3(&min_out[i][0], _mm_sub_ps(center, e));
+      simd::store3(&max_out[i][0], _mm_add_ps(center, e));
+    }
+#else
+    for (size_t i = 0; i < count; i++) {
+      Vec3f center = (mins[i] + maxs[i]) * 0.5f;
+      Vec3f extent = (maxs[i] - mins[i]) * 0.5f;
+      Vec3f center_out = (m * Vec4f(center, 1.f)).xyz();
+      Vec3f extent_out(0.f);
+      for (unsigned j = 0; j < 3; j++) {
+        for (unsigned k = 0; k < 3; k++) {
+          extent_out[k] += std::abs(m[j][k]) * extent[j];
+        }
+      }
+      min_out[i] = center_out - extent_out;
+      max_out[i] = center_out + extent_out;
+    }
+#endif
+  }
+}
+
+#endif
@@ -0,0 +1,259 @@
+#ifndef FASTMATH_H
+#define FASTMATH_H
+
+#include <math/SIMD.h>
+#include <cstring>
+#include <cstdint>
+#include <cstddef>
+
+namespace fly
+{
+  /**
+  * Polynomial approximations of transcendental functions for bulk evaluation on the CPU, e.g. procedural generation
+  * and culling. Scalar and SIMD versions use the same reduction and polynomials (Cephes), the SIMD versions evaluate
+  * four values at once. Measured maximum errors:
+  * sin, cos: absolute error < 1e-7 for |x| <= 8192, accuracy degrades for larger arguments.
+  * exp2: relative error < 1e-7, inputs are clamped to [-126, 127].
+  * log2: absolute error < 1e-7 for x in [0.5, 2], relative error < 1e-7 elsewhere. x must be positive and normal.
+  * rsqrt: relative error < 3e-7 with SSE, < 5e-6 for the scalar fallback. x must be positive and normal, 0 yields NaN.
+  * pow: computed as exp2(y * log2(x)), x must be positive.
+  */
+  namespace fastmath
+  {
+    namespace detail
+    {
+      // pi / 2 split in three parts for Cody-Waite range reduction
+      static const float pio2_1 = 1.5703125f;
+      static const float pio2_2 = 4.837512969970703125e-4f;
+      static const float pio2_3 = 7.54978995489188216e-8f;
+      static const float two_over_pi = 0.636619772367581343f;
+      static const float log2e_minus_1 = 0.44269504088896340736f;
+      static const float sqrt2 = 1.41421356237309504880f;
+
+      inline float sinPoly(float r, float r2)
+      {
+        return ((-1.9515295891e-4f * r2 + 8.3321608736e-3f) * r2 - 1.6666654611e-1f) * r2 * r + r;
+      }
+      inline float cosPoly(float r2)
+      {
+        return ((2.443315711809948e-5f * r2 - 1.388731625493765e-3f) * r2 + 4.166664568298827e-2f) * r2 * r2 - 0.5f * r2 + 1.f;
+      }
+      /**
+      * sin(x) for quadrant_offset 0, cos(x) for quadrant_offset 1.
+      */
+      inline float sinCos(float x, int quadrant_offset)
+      {
+        float q = x * two_over_pi;
+        int j = static_cast<int>(q >= 0.f ? q + 0.5f : q - 0.5f);
+        float jf = static_cast<float>(j);
+        float r = ((x - jf * pio2_1) - jf * pio2_2) - jf * pio2_3;
+        float r2 = r * r;
+        j += quadrant_offset;
+        float ret = j & 1 ? cosPoly(r2) : sinPoly(r, r2);
+        return j & 2 ? -ret : ret;
+      }
+    }
+
+    inline float sin(float x)
+    {
+      return detail::sinCos(x, 0);
+    }
+
+    inline float cos(float x)
+    {
+      return detail::sinCos(x, 1);
+    }
+
+    inline float exp2(float x)
+    {
+      x = (std::min)((std::max)(x, -126.f), 127.f);
+      int i = static_cast<int>(x >= 0.f ? x + 0.5f : x - 0.5f);
+      float f = x - static_cast<float>(i);
+      float p = (((((1.535336188319500e-4f * f + 1.339887440266574e-3f) * f + 9.618437357674640e-3f) * f
+        + 5.550332471162809e-2f) * f + 2.402264791363012e-1f) * f + 6.931472028550421e-1f) * f + 1.f;
+      uint32_t bits = static_cast<uint32_t>(i + 127) << 23;
+      float scale;
+      std::memcpy(&scale, &bits, sizeof scale);
+      return p * scale;
+    }
+
+    inline float log2(float x)
+    {
+      uint32_t bits;
+      std::memcpy(&bits, &x, sizeof bits);
+      int e = static_cast<int>(bits >> 23) - 127;
+      bits = (bits & 0x7fffff) | 0x3f800000;
+      float m;
+      std::memcpy(&m, &bits, sizeof m);
+      if (m > detail::sqrt2) {
+        m *= 0.5f;
+        e++;
+      }
+      float t = m - 1.f;
+      float t2 = t * t;
+      float p = ((((((((7.0376836292e-2f * t - 1.1514610310e-1f) * t + 1.1676998740e-1f) * t - 1.2420140846e-1f) * t
+        + 1.4249322787e-1f) * t - 1.6668057665e-1f) * t + 2.0000714765e-1f) * t - 2.4999993993e-1f) * t + 3.3333331174e-1f) * t * t2;
+      p -= 0.5f * t2;
+      // ln(m) = t + p, multiplied by log2(e) = 1 + log2e_minus_1 for extra precision
+      return p * detail::log2e_minus_1 + t * detail::log2e_minus_1 + p + t + static_cast<float>(e);
+    }
+
+    inline float pow(float x, float y)
+    {
+      return exp2(y * log2(x));
+    }
+
+    inline float rsqrt(float x)
+    {
+#ifdef FLY_SSE
+      float y = _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(x)));
+      return y * (1.5f - 0.5f * x * y * y);
+#else
+      uint32_t bits;
+      std::memcpy(&bits, &x, sizeof bits);
+      bits = 0x5f375a86 - (bits >> 1);
+      float y;
+      std::memcpy(&y, &bits, sizeof y);
+      y = y * (1.5f - 0.5f * x * y * y);
+      return y * (1.5f - 0.5f * x * y * y);
+#endif
+    }
+
+#ifdef FLY_SSE
+    namespace detail
+    {
+      inline __m128 select(__m128 mask, __m128 a, __m128 b)
+      {
+        return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+      }
+      inline __m128 sinCos(__m128 x, int quadrant_offset)
+      {
+        __m128i j = _mm_cvtps_epi32(_mm_mul_ps(x, _mm_set1_ps(two_over_pi)));
+        __m128 jf = _mm_cvtepi32_ps(j);
+        __m128 r = simd::madd(jf, _mm_set1_ps(-pio2_1), x);
+        r = simd::madd(jf, _mm_set1_ps(-pio2_2), r);
+        r = simd::madd(jf, _mm_set1_ps(-pio2_3), r);
+        __m128 r2 = _mm_mul_ps(r, r);
+        __m128 s = simd::madd(_mm_set1_ps(-1.9515295891e-4f), r2, _mm_set1_ps(8.3321608736e-3f));
+        s = simd::madd(s, r2, _mm_set1_ps(-1.6666654611e-1f));
+        s = simd::madd(_mm_mul_ps(s, r2), r, r);
+        __m128 c = simd::madd(_mm_set1_ps(2.443315711809948e-5f), r2, _mm_set1_ps(-1.388731625493765e-3f));
+        c = simd::madd(c, r2, _mm_set1_ps(4.166664568298827e-2f));
+        c = simd::madd(_mm_mul_ps(c, r2), r2, simd::madd(_mm_set1_ps(-0.5f), r2, _mm_set1_ps(1.f)));
+        j = _mm_add_epi32(j, _mm_set1_epi32(quadrant_offset));
+        __m128 use_cos = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(j, _mm_set1_epi32(1)), _mm_set1_epi32(1)));
+        __m128 sign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(j, _mm_set1_epi32(2)), 30));
+        return _mm_xor_ps(select(use_cos, c, s), sign);
+      }
+    }
+
+    inline __m128 sin(__m128 x)
+    {
+      return detail::sinCos(x, 0);
+    }
+
+    inline __m128 cos(__m128 x)
+    {
+      return detail::sinCos(x, 1);
+    }
+
+    inline __m128 exp2(__m128 x)
+    {
+      x = _mm_min_ps(_mm_max_ps(x, _mm_set1_ps(-126.f)), _mm_set1_ps(127.f));
+      __m128i i = _mm_cvtps_epi32(x);
+      __m128 f = _mm_sub_ps(x, _mm_cvtepi32_ps(i));
+      __m128 p = simd::madd(_mm_set1_ps(1.535336188319500e-4f), f, _mm_set1_ps(1.339887440266574e-3f));
+      p = simd::madd(p, f, _mm_set1_ps(9.618437357674640e-3f));
+      p = simd::madd(p, f, _mm_set1_ps(5.550332471162809e-2f));
+      p = simd::madd(p, f, _mm_set1_ps(2.402264791363012e-1f));
+      p = simd::madd(p, f, _mm_set1_ps(6.931472028550421e-1f));
+      p = simd::madd(p, f, _mm_set1_ps(1.f));
+      return _mm_mul_ps(p, _mm_castsi128_ps(_mm_slli_epi32(_mm_add_epi32(i, _mm_set1_epi32(127)), 23)));
+    }
+
+    inline __m128 log2(__m128 x)
+    {
+      __m128i bits = _mm_castps_si128(x);
+      __m128i e = _mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(127));
+      __m128 m = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x7fffff)), _mm_set1_epi32(0x3f800000)));
+      __m128 mask = _mm_cmpgt_ps(m, _mm_set1_ps(detail::sqrt2));
+      m = detail::select(mask, _mm_mul_ps(m, _mm_set1_ps(0.5f)), m);
+      e = _mm_sub_epi32(e, _mm_castps_si128(mask)); // mask is -1 where m was halved
+      __m128 t = _mm_sub_ps(m, _mm_set1_ps(1.f));
+      __m128 t2 = _mm_mul_ps(t, t);
+      __m128 p = simd::madd(_mm_set1_ps(7.0376836292e-2f), t, _mm_set1_ps(-1.1514610310e-1f));
+      p = simd::madd(p, t, _mm_set1_ps(1.1676998740e-1f));
+      p = simd::madd(p, t, _mm_set1_ps(-1.2420140846e-1f));
+      p = simd::madd(p, t, _mm_set1_ps(1.4249322787e-1f));
+      p = simd::madd(p, t, _mm_set1_ps(-1.6668057665e-1f));
+      p = simd::madd(p, t, _mm_set1_ps(2.0000714765e-1f));
+      p = simd::madd(p, t, _mm_set1_ps(-2.4999993993e-1f));
+      p = simd::madd(p, t, _mm_set1_ps(3.3333331174e-1f));
+      p = _mm_mul_ps(_mm_mul_ps(p, t), t2);
+      p = simd::madd(_mm_set1_ps(-0.5f), t2, p);
+      __m128 log2e_minus_1 = _mm_set1_ps(detail::log2e_minus_1);
+      __m128 ret = simd::madd(t, log2e_minus_1, _mm_mul_ps(p, log2e_minus_1));
+      return _mm_add_ps(_mm_add_ps(_mm_add_ps(ret, p), t), _mm_cvtepi32_ps(e));
+    }
+
+    inline __m128 pow(__m128 x, __m128 y)
+    {
+      return exp2(_mm_mul_ps(y, log2(x)));
+    }
+
+    inline __m128 rsqrt(__m128 x)
+    {
+      __m128 y = _mm_rsqrt_ps(x);
+      __m128 y_half_x = _mm_mul_ps(_mm_mul_ps(x, _mm_set1_ps(0.5f)), y);
+      return _mm_mul_ps(y, simd::madd(_mm_mul_ps(y_half_x, _mm_set1_ps(-1.f)), y, _mm_set1_ps(1.5f)));
+    }
+#endif
+
+    namespace detail
+    {
+      template<typename Scalar>
+      inline void apply(const float* x, float* result, size_t begin, size_t count, Scalar scalar)
+      {
+        for (size_t i = begin; i < count; i++) {
+          result[i] = scalar(x[i]);
+        }
+      }
+#ifdef FLY_SSE
+      template<typename Scalar, typename Packet>
+      inline void apply(const float* x, float* result, size_t count, Scalar scalar, Packet packet)
+      {
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4) {
+          _mm_storeu_ps(result + i, packet(_mm_loadu_ps(x + i)));
+        }
+        apply(x, result, i, count, scalar);
+      }
+#endif
+    }
+
+    /**
+    * Bulk versions, result may alias x.
+    */
+#ifdef FLY_SSE
+#define FLY_FASTMATH_BULK(name) \
+    inline void name(const float* x, float* result, size_t count) \
+    { \
+      detail::apply(x, result, count, [](float v) { return name(v); }, [](__m128 v) { return name(v); }); \
+    }
+#else
+#define FLY_FASTMATH_BULK(name) \
+    inline void name(const float* x, float* result, size_t count) \
+    { \
+      detail::apply(x, result, 0, count, [](float v) { return name(v); }); \
+    }
+#endif
+    FLY_FASTMATH_BULK(sin)
+    FLY_FASTMATH_BULK(cos)
+    FLY_FASTMATH_BULK(exp2)
+    FLY_FASTMATH_BULK(log2)
+    FLY_FASTMATH_BULK(rsqrt)
+#undef FLY_FASTMATH_BULK
+  }
+}
+
+#endif
@@ -14,13 +14,19 @@ namespace fly
     * Constructors
     */
     Matrix() = default;
-    Matrix(const std::initializer_list<Vector<Rows, T>>& columns)
+    constexpr Matrix(const std::initializer_list<Vector<Rows, T>>& columns) : _cols{}
     {
-      std::memcpy(_cols, columns.begin(), sizeof *this);
+      for (unsigned i = 0; i < Cols; i++) {
+        _cols[i] = columns.begin()[i];
+      }
     }
-    Matrix(const T* ptr)
+    constexpr Matrix(const T* ptr) : _cols{}
     {
-      std::memcpy(_cols, ptr, sizeof *this);
+      for (unsigned i = 0; i < Cols; i++) {
+        for (unsigned j = 0; j < Rows; j++) {
+          _cols[i][j] = ptr[i * Rows + j];
+        }
+      }
     }
     /**
     * Copy constructor
@@ -33,50 +39,54 @@ namespace fly
     /**
     * Member access
     */
-    inline Vector<Rows, T>& operator [] (unsigned col)
+    constexpr Vector<Rows, T>& operator [] (unsigned col)
     {
       return _cols[col];
     }
-    inline const Vector<Rows, T>& operator [] (unsigned col) const
+    constexpr const Vector<Rows, T>& operator [] (unsigned col) const
     {
       return _cols[col];
     }
-    inline Vector<Cols, T> row(unsigned row) const
+    constexpr Vector<Cols, T> row(unsigned row) const
     {
-      Vector<Cols, T> vec;
+      Vector<Cols, T> vec{};
       for (unsigned i = 0; i < Cols; i++) {
         vec[i] = _cols[i][row];
       }
       return vec;
     }
-    inline const T* ptr() const
+    constexpr const T* ptr() const
     {
       return &_cols[0][0];
     }
     /**
-    * Matrix multiplication
+    * Matrix multiplication. MatrixOps walks the columns through ptr(), which is not allowed during constant
+    * evaluation, so that is done column by column in the same order.
     */
     template<unsigned N>
-    inline Matrix<Rows, N, T> operator * (const Matrix<Cols, N, T>& b) const
+    constexpr Matrix<Rows, N, T> operator * (const Matrix<Cols, N, T>& b) const
     {
-      T temp[Rows * N];
-      for (unsigned row_idx = 0; row_idx < Rows; row_idx++) {
-        auto row_vec = row(row_idx);
-        for (unsigned col_idx = 0; col_idx < N; col_idx++) {
-          temp[col_idx * Rows + row_idx] = dot(row_vec, b[col_idx]);
+      Matrix<Rows, N, T> result{};
+      if (isConstantEvaluated()) {
+        for (unsigned j = 0; j < N; j++) {
+          result[j] = mulColumn(b[j]);
         }
       }
-      return Matrix<Rows, N, T>(temp);
+      else {
+        MatrixOps<Rows, Cols, N, T>::mul(ptr(), b.ptr(), &result[0][0]);
+      }
+      return result;
     }
     /**
     * Matrix/vector multiplication
     */
-    inline Vector<Rows, T> operator * (const Vector<Rows, T>& vec) const
+    constexpr Vector<Rows, T> operator * (const Vector<Cols, T>& vec) const
     {
-      Vector<Rows, T> result;
-      for (unsigned i = 0; i < Rows; i++) {
-        result[i] = dot(row(i), vec);
+      if (isConstantEvaluated()) {
+        return mulColumn(vec);
       }
+      Vector<Rows, T> result{};
+      MatrixOps<Rows, Cols, 1, T>::mul(ptr(), vec.ptr(), &result[0]);
       return result;
     }
     /**
@@ -95,7 +105,7 @@ namespace fly
     /**
     * Comparison operators
     */
-    inline bool operator != (const Matrix& b)
+    constexpr bool operator != (const Matrix& b) const
     {
       for (unsigned i = 0; i < Rows; i++) {
         for (unsigned j = 0; j < Cols; j++) {
@@ -129,6 +139,19 @@ namespace fly
     }
   private:
     Vector<Rows, T> _cols[Cols];
+    constexpr Vector<Rows, T> mulColumn(const Vector<Cols, T>& vec) const
+    {
+      Vector<Rows, T> result{};
+      for (unsigned i = 0; i < Rows; i++) {
+        result[i] = _cols[0][i] * vec[0];
+      }
+      for (unsigned k = 1; k < Cols; k++) {
+        for (unsigned i = 0; i < Rows; i++) {
+          result[i] += _cols[k][i] * vec[k];
+        }
+      }
+      return result;
+    }
   };
 }
 
@@ -5,6 +5,7 @@
 #include <initializer_list>
 #include <cstring>
 #include <ostream>
+#include <math/SIMD.h>
 
 namespace fly
 {
@@ -16,14 +17,14 @@ namespace fly
     * Constructors
     */
     Vector() = default;
-    Vector(const T& value)
+    constexpr Vector(const T& value) : _data{}
     {
       for (unsigned i = 0; i < Dim; i++) {
         _data[i] = value;
       }
     }
     template<typename ...Args>
-    Vector(Args... args) : _data{args...}
+    constexpr Vector(Args... args) : _data{args...}
     {
     }
     /**
@@ -31,22 +32,28 @@ namespace fly
     */
     Vector(const Vector& other) = default;
     template<typename T1>
-    Vector(const Vector<Dim, T1>& other)
+    constexpr Vector(const Vector<Dim, T1>& other) : _data{}
     {
       for (unsigned i = 0; i < Dim; i++) {
         _data[i] = static_cast<T>(other[i]);
       }
     }
-    Vector(const Vector<Dim - 1, T>& other, T scalar)
+    constexpr Vector(const Vector<Dim - 1, T>& other, T scalar) : _data{}
     {
-      std::memcpy(_data, &other[0], sizeof(other));
+      for (unsigned i = 0; i < Dim - 1; i++) {
+        _data[i] = other[i];
+      }
       _data[Dim - 1] = scalar;
     }
     template<unsigned Dim1>
-    Vector(const Vector<Dim1, T>& v1, const Vector<Dim - Dim1, T>& v2)
+    constexpr Vector(const Vector<Dim1, T>& v1, const Vector<Dim - Dim1, T>& v2) : _data{}
     {
-      std::memcpy(_data, &v1[0], sizeof(v1));
-      std::memcpy(_data + Dim1, &v2[0], sizeof(v2));
+      for (unsigned i = 0; i < Dim1; i++) {
+        _data[i] = v1[i];
+      }
+      for (unsigned i = Dim1; i < Dim; i++) {
+        _data[i] = v2[i - Dim1];
+      }
     }
     /**
     * Destructor
@@ -55,95 +62,80 @@ namespace fly
     /**
     * Member access
     */
-    inline T& operator [] (unsigned index)
+    constexpr T& operator [] (unsigned index)
     {
       return _data[index];
     }
-    inline const T& operator [] (unsigned index) const
+    constexpr const T& operator [] (unsigned index) const
     {
       return _data[index];
     }
-    inline const T* ptr() const
+    constexpr const T* ptr() const
     {
       return _data;
     }
     template<unsigned D = Dim>
-    inline typename std::enable_if<D >= 4, Vector<3, T>>::type xyz() const
+    constexpr typename std::enable_if<D >= 4, Vector<3, T>>::type xyz() const
     {
       return Vector<3, T>(_data[0], _data[1], _data[2]);
     }
     template<unsigned D = Dim>
-    inline typename std::enable_if<D >= 3, Vector<2, T>>::type xz() const
+    constexpr typename std::enable_if<D >= 3, Vector<2, T>>::type xz() const
     {
       return Vector<2, T>(_data[0], _data[2]);
     }
     /**
-    * Vector/vector calculations
+    * Vector/vector calculations. The SIMD specializations of VectorOps (Vec3f and Vec4f) fall back to the scalar
+    * path during constant evaluation if the compiler provides FLY_HAS_CONSTANT_EVALUATED.
     */
-    inline Vector operator + (const Vector& b) const
+    constexpr Vector operator + (const Vector& b) const
     {
-      Vector result;
-      for (unsigned i = 0; i < Dim; i++) {
-        result[i] = _data[i] + b[i];
-      }
+      Vector result{};
+      VectorOps<Dim, T>::add(_data, b._data, result._data);
       return result;
     }
-    inline Vector operator - (const Vector& b) const
+    constexpr Vector operator - (const Vector& b) const
     {
-      Vector result;
-      for (unsigned i = 0; i < Dim; i++) {
-        result[i] = _data[i] - b[i];
-      }
+      Vector result{};
+      VectorOps<Dim, T>::sub(_data, b._data, result._data);
       return result;
     }
-    inline Vector operator * (const Vector& b) const
+    constexpr Vector operator * (const Vector& b) const
     {
-      Vector result;
-      for (unsigned i = 0; i < Dim; i++) {
-        result[i] = _data[i] * b[i];
-      }
+      Vector result{};
+      VectorOps<Dim, T>::mul(_data, b._data, result._data);
       return result;
     }
-    inline Vector operator / (const Vector& b) const
+    constexpr Vector operator / (const Vector& b) const
     {
-      Vector result;
-      for (unsigned i = 0; i < Dim; i++) {
-        result[i] = _data[i] / b[i];
-      }
+      Vector result{};
+      VectorOps<Dim, T>::div(_data, b._data, result._data);
       return result;
     }
-    inline Vector& operator += (const Vector& b)
+    constexpr Vector& operator += (const Vector& b)
     {
-      for (unsigned i = 0; i < Dim; i++) {
-        _data[i] += b[i];
-      }
+      VectorOps<Dim, T>::add(_data, b._data, _data);
       return *this;
     }
-    inline Vector& operator -= (const Vector& b)
+    constexpr Vector& operator -= (const Vector& b)
     {
-      for (unsigned i = 0; i < Dim; i++) {
-        _data[i] -= b[i];
-      }
+      VectorOps<Dim, T>::sub(_data, b._data, _data);
       return *this;
     }
-    inline Vector& operator *= (const Vector& b)
+    constexpr Vector& operator *= (const Vector& b)
     {
-      for (unsigned i = 0; i < Dim; i++) {
-        _data[i] *= b[i];
-      }
+      VectorOps<Dim, T>::mul(_data, b._data, _data);
       return *this;
     }
-    inline Vector& operator /= (const Vector& b)
+    constexpr Vector& operator /= (const Vector& b)
     {
-      for (unsigned i = 0; i < Dim; i++) {
-        _data[i] /= b[i];
-      }
+      VectorOps<Dim, T>::div(_data, b._data, _data);
       return *this;
     }
     /**
     * Comparison operators
     */
-    inline bool operator < (const Vector& b) const
+    constexpr bool operator < (const Vector& b) const
     {
       for (unsigned i = 0; i < Dim; i++) {
         if (!(_data[i] < b[i])) {
@@ -152,7 +144,7 @@ namespace fly
       }
       return true;
     }
-    inline bool operator > (const Vector& b) const
+    constexpr bool operator > (const Vector& b) const
     {
       for (unsigned i = 0; i < Dim; i++) {
         if (!(_data[i] > b[i])) {
@@ -161,7 +153,7 @@ namespace fly
       }
       return true;
     }
-    inline bool operator <= (const Vector& b) const
+    constexpr bool operator <= (const Vector& b) const
     {
       for (unsigned i = 0; i < Dim; i++) {
         if (!(_data[i] <= b[i])) {
@@ -170,7 +162,7 @@ namespace fly
       }
       return true;
     }
-    inline bool operator >= (const Vector& b) const
+    constexpr bool operator >= (const Vector& b) const
     {
       for (unsigned i = 0; i < Dim; i++) {
         if (!(_data[i] >= b[i])) {
@@ -203,10 +195,12 @@ namespace fly
     * Change in dimension
     */
     template<unsigned N>
-    inline operator Vector<N, T>() const
+    constexpr operator Vector<N, T>() const
     {
-      Vector<N, T> ret;
-      std::memcpy(&ret[0], _data, std::min(sizeof ret, sizeof *this));
+      Vector<N, T> ret{};
+      for (unsigned i = 0; i < (N < Dim ? N : Dim); i++) {
+        ret[i] = _data[i];
+      }
       return ret;
     }
     /**
@@ -5,38 +5,45 @@
 #include <math/FlyMatrix.h>
 #include <math/Meta.h>
 #include <algorithm>
+#include <cmath>
 #include <glm/glm.hpp>
 
 namespace fly
 {
   template<unsigned Dim, typename T>
-  inline T dot(const Vector<Dim, T>& a, const Vector<Dim, T>& b)
+  constexpr T dot(const Vector<Dim, T>& a, const Vector<Dim, T>& b)
   {
     return ComputeDot<Dim, T, Dim - 1>::call(a, b);
   }
+#ifdef FLY_SSE
+  FLY_SIMD_CONSTEXPR float dot(const Vector<4, float>& a, const Vector<4, float>& b)
+  {
+    return isConstantEvaluated() ? ComputeDot<4, float, 3>::call(a, b) : VectorOps<4, float>::dot(a.ptr(), b.ptr());
+  }
+  FLY_SIMD_CONSTEXPR float dot(const Vector<3, float>& a, const Vector<3, float>& b)
+  {
+    return isConstantEvaluated() ? ComputeDot<3, float, 2>::call(a, b) : VectorOps<3, float>::dot(a.ptr(), b.ptr());
+  }
+#endif
 
   template<unsigned Dim, typename T>
-  inline Vector<Dim, T> minimum(const Vector<Dim, T>& a, const Vector<Dim, T>& b)
+  constexpr Vector<Dim, T> minimum(const Vector<Dim, T>& a, const Vector<Dim, T>& b)
   {
-    Vector<Dim, T> result;
-    for (unsigned i = 0; i < Dim; i++) {
-      result[i] = (std::min)(a[i], b[i]);
-    }
+    Vector<Dim, T> result{};
+    VectorOps<Dim, T>::min(a.ptr(), b.ptr(), &result[0]);
     return result;
   }
 
   template<unsigned Dim, typename T>
-  inline Vector<Dim, T> maximum(const Vector<Dim, T>& a, const Vector<Dim, T>& b)
+  constexpr Vector<Dim, T> maximum(const Vector<Dim, T>& a, const Vector<Dim, T>& b)
   {
-    Vector<Dim, T> result;
-    for (unsigned i = 0; i < Dim; i++) {
-      result[i] = (std::max)(a[i], b[i]);
-    }
+    Vector<Dim, T> result{};
+    VectorOps<Dim, T>::max(a.ptr(), b.ptr(), &result[0]);
     return result;
   }
 
   template<unsigned Dim, typename T>
-  inline Vector<Dim, T> clamp(const Vector<Dim, T>& a, const Vector<Dim, T>& min_val, const Vector<Dim, T>& max_val)
+  constexpr Vector<Dim, T> clamp(const Vector<Dim, T>& a, const Vector<Dim, T>& min_val, const Vector<Dim, T>& max_val)
   {
     return minimum(max_val, maximum(min_val, a));
   }
@@ -83,9 +90,9 @@ namespace fly
   }
 
   template<unsigned Dim, typename T>
-  inline Matrix<Dim, Dim, T> identity()
+  constexpr Matrix<Dim, Dim, T> identity()
   {
-    Matrix<Dim, Dim, T> ret;
+    Matrix<Dim, Dim, T> ret{};
     for (unsigned i = 0; i < Dim; i++) {
       for (unsigned j = 0; j < Dim; j++) {
         ret[i][j] = i == j ? static_cast<T>(1) : static_cast<T>(0);
@@ -95,7 +102,7 @@ namespace fly
   }
 
   template<unsigned Dim, typename T>
-  inline Matrix<Dim, Dim, T> translate(const Vector<Dim - 1, T>& t)
+  constexpr Matrix<Dim, Dim, T> translate(const Vector<Dim - 1, T>& t)
   {
     auto ret = identity<Dim, T>();
     for (unsigned i = 0; i < Dim - 1; i++) {
@@ -105,7 +112,7 @@ namespace fly
   }
 
   template<unsigned Dim, typename T>
-  inline Matrix<Dim, Dim, T> scale(const Vector<Dim - 1, T>& s)
+  constexpr Matrix<Dim, Dim, T> scale(const Vector<Dim - 1, T>& s)
   {
     auto ret = identity<Dim, T>();
     for (unsigned i = 0; i < Dim - 1; i++) {
@@ -114,10 +121,201 @@ namespace fly
     return ret;
   }
 
+  template<typename T>
+  constexpr Vector<3, T> cross(const Vector<3, T>& a, const Vector<3, T>& b)
+  {
+    return Vector<3, T>(a[1] * b[2] - a[2] * b[1], a[2] * b[0] - a[0] * b[2], a[0] * b[1] - a[1] * b[0]);
+  }
+
+  template<typename T>
+  constexpr T radians(T degrees)
+  {
+    return degrees * static_cast<T>(0.01745329251994329576923690768489);
+  }
+
+  /**
+  * Upper left (Dim - 1) x (Dim - 1) part of a matrix, e.g. the linear part of an affine transform.
+  */
+  template<unsigned Dim, typename T>
+  constexpr Matrix<Dim - 1, Dim - 1, T> upperLeft(const Matrix<Dim, Dim, T>& mat)
+  {
+    Matrix<Dim - 1, Dim - 1, T> ret{};
+    for (unsigned i = 0; i < Dim - 1; i++) {
+      for (unsigned j = 0; j < Dim - 1; j++) {
+        ret[i][j] = mat[i][j];
+      }
+    }
+    return ret;
+  }
+
+  /**
+  * General inverse using Gauss-Jordan elimination with partial pivoting. 3x3 and 4x4 matrices have closed form overloads.
+  */
   template<unsigned Dim, typename T>
   inline Matrix<Dim, Dim, T> inverse(const Matrix<Dim, Dim, T>& mat)
   {
-    return glm::inverse(glm::mat<Dim, Dim, T>(mat));
+    auto a = mat;
+    auto ret = identity<Dim, T>();
+    for (unsigned col = 0; col < Dim; col++) {
+      unsigned pivot = col;
+      for (unsigned row = col + 1; row < Dim; row++) {
+        if (std::abs(a[col][row]) > std::abs(a[col][pivot])) {
+          pivot = row;
+        }
+      }
+      for (unsigned j = 0; j < Dim; j++) {
+        std::swap(a[j][col], a[j][pivot]);
+        std::swap(ret[j][col], ret[j][pivot]);
+      }
+      T pivot_inv = static_cast<T>(1) / a[col][col];
+      for (unsigned j = 0; j < Dim; j++) {
+        a[j][col] *= pivot_inv;
+        ret[j][col] *= pivot_inv;
+      }
+      for (unsigned row = 0; row < Dim; row++) {
+        if (row != col) {
+          T factor = a[col][row];
+          for (unsigned j = 0; j < Dim; j++) {
+            a[j][row] -= factor * a[j][col];
+            ret[j][row] -= factor * ret[j][col];
+          }
+        }
+      }
+    }
+    return ret;
+  }
+
+  template<typename T>
+  inline Matrix<3, 3, T> inverse(const Matrix<3, 3, T>& mat)
+  {
+    // The rows of the inverse are the cross products of the columns divided by the determinant.
+    Vector<3, T> rows[3] = { cross(mat[1], mat[2]), cross(mat[2], mat[0]), cross(mat[0], mat[1]) };
+    T det_inv = static_cast<T>(1) / dot(mat[0], rows[0]);
+    Matrix<3, 3, T> ret;
+    for (unsigned i = 0; i < 3; i++) {
+      for (unsigned j = 0; j < 3; j++) {
+        ret[j][i] = rows[i][j] * det_inv;
+      }
+    }
+    return ret;
+  }
+
+  template<typename T>
+  inline Matrix<4, 4, T> inverse(const Matrix<4, 4, T>& m)
+  {
+    // Cofactor expansion based on the 2x2 sub determinants of the first two and the last two columns.
+    T s0 = m[0][0] * m[1][1] - m[1][0] * m[0][1];
+    T s1 = m[0][0] * m[1][2] - m[1][0] * m[0][2];
+    T s2 = m[0][0] * m[1][3] - m[1][0] * m[0][3];
+    T s3 = m[0][1] * m[1][2] - m[1][1] * m[0][2];
+    T s4 = m[0][1] * m[1][3] - m[1][1] * m[0][3];
+    T s5 = m[0][2] * m[1][3] - m[1][2] * m[0][3];
+    T c5 = m[2][2] * m[3][3] - m[3][2] * m[2][3];
+    T c4 = m[2][1] * m[3][3] - m[3][1] * m[2][3];
+    T c3 = m[2][1] * m[3][2] - m[3][1] * m[2][2];
+    T c2 = m[2][0] * m[3][3] - m[3][0] * m[2][3];
+    T c1 = m[2][0] * m[3][2] - m[3][0] * m[2][2];
+    T c0 = m[2][0] * m[3][1] - m[3][0] * m[2][1];
+    T det_inv = static_cast<T>(1) / (s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0);
+    Matrix<4, 4, T> ret;
+    ret[0][0] = (m[1][1] * c5 - m[1][2] * c4 + m[1][3] * c3) * det_inv;
+    ret[0][1] = (-m[0][1] * c5 + m[0][2] * c4 - m[0][3] * c3) * det_inv;
+    ret[0][2] = (m[3][1] * s5 - m[3][2] * s4 + m[3][3] * s3) * det_inv;
+    ret[0][3] = (-m[2][1] * s5 + m[2][2] * s4 - m[2][3] * s3) * det_inv;
+    ret[1][0] = (-m[1][0] * c5 + m[1][2] * c2 - m[1][3] * c1) * det_inv;
+    ret[1][1] = (m[0][0] * c5 - m[0][2] * c2 + m[0][3] * c1) * det_inv;
+    ret[1][2] = (-m[3][0] * s5 + m[3][2] * s2 - m[3][3] * s1) * det_inv;
+    ret[1][3] = (m[2][0] * s5 - m[2][2] * s2 + m[2][3] * s1) * det_inv;
+    ret[2][0] = (m[1][0] * c4 - m[1][1] * c2 + m[1][3] * c0) * det_inv;
+    ret[2][1] = (-m[0][0] * c4 + m[0][1] * c2 - m[0][3] * c0) * det_inv;
+    ret[2][2] = (m[3][0] * s4 - m[3][1] * s2 + m[3][3] * s0) * det_inv;
+    ret[2][3] = (-m[2][0] * s4 + m[2][1] * s2 - m[2][3] * s0) * det_inv;
+    ret[3][0] = (-m[1][0] * c3 + m[1][1] * c1 - m[1][2] * c0) * det_inv;
+    ret[3][1] = (m[0][0] * c3 - m[0][1] * c1 + m[0][2] * c0) * det_inv;
+    ret[3][2] = (-m[3][0] * s3 + m[3][1] * s1 - m[3][2] * s0) * det_inv;
+    ret[3][3] = (m[2][0] * s3 - m[2][1] * s1 + m[2][2] * s0) * det_inv;
+    return ret;
+  }
+#ifdef FLY_SSE
+  inline Matrix<4, 4, float> inverse(const Matrix<4, 4, float>& mat)
+  {
+    Matrix<4, 4, float> ret;
+    simd::inverse4x4(mat.ptr(), &ret[0][0]);
+    return ret;
+  }
+#endif
+
+  /**
+  * Inverse of a matrix whose last row is (0 0 0 1), such as model and view matrices.
+  * Only the linear part is inverted, the translation is rotated back: (L t)^-1 = (L^-1 -L^-1 t)
+  */
+  template<typename T>
+  inline Matrix<4, 4, T> inverseAffine(const Matrix<4, 4, T>& mat)
+  {
+    // Same cross product form as the 3x3 inverse, the rows of L^-1 are used directly for the translation.
+    Vector<3, T> c0 = mat[0].xyz(), c1 = mat[1].xyz(), c2 = mat[2].xyz(), t = mat[3].xyz();
+    Vector<3, T> r0 = cross(c1, c2), r1 = cross(c2, c0), r2 = cross(c0, c1);
+    T det_inv = static_cast<T>(1) / dot(c0, r0);
+    r0 *= det_inv;
+    r1 *= det_inv;
+    r2 *= det_inv;
+    return Matrix<4, 4, T>({ Vector<4, T>(r0[0], r1[0], r2[0], static_cast<T>(0)), Vector<4, T>(r0[1], r1[1], r2[1], static_cast<T>(0)),
+      Vector<4, T>(r0[2], r1[2], r2[2], static_cast<T>(0)), Vector<4, T>(-dot(r0, t), -dot(r1, t), -dot(r2, t), static_cast<T>(1)) });
+  }
+
+  /**
+  * Right handed view matrix looking from eye to target.
+  */
+  template<typename T>
+  inline Matrix<4, 4, T> lookAt(const Vector<3, T>& eye, const Vector<3, T>& target, const Vector<3, T>& up)
+  {
+    auto f = normalize(target - eye);
+    auto s = normalize(cross(f, up));
+    auto u = cross(s, f);
+    return Matrix<4, 4, T>({ Vector<4, T>(s[0], u[0], -f[0], static_cast<T>(0)), Vector<4, T>(s[1], u[1], -f[1], static_cast<T>(0)),
+      Vector<4, T>(s[2], u[2], -f[2], static_cast<T>(0)), Vector<4, T>(-dot(s, eye), -dot(u, eye), dot(f, eye), static_cast<T>(1)) });
+  }
+
+  /**
+  * Right handed projection matrices. ZO maps the depth range to [0, 1] (DirectX), NO maps it to [-1, 1] (OpenGL).
+  * The field of view is the vertical angle in radians.
+  */
+  template<typename T>
+  inline Matrix<4, 4, T> perspectiveZO(T fov_y, T aspect_ratio, T z_near, T z_far)
+  {
+    T f = static_cast<T>(1) / std::tan(fov_y * static_cast<T>(0.5));
+    return Matrix<4, 4, T>({ Vector<4, T>(f / aspect_ratio, static_cast<T>(0), static_cast<T>(0), static_cast<T>(0)),
+      Vector<4, T>(static_cast<T>(0), f, static_cast<T>(0), static_cast<T>(0)),
+      Vector<4, T>(static_cast<T>(0), static_cast<T>(0), z_far / (z_near - z_far), static_cast<T>(-1)),
+      Vector<4, T>(static_cast<T>(0), static_cast<T>(0), -(z_far * z_near) / (z_far - z_near), static_cast<T>(0)) });
+  }
+
+  template<typename T>
+  inline Matrix<4, 4, T> perspectiveNO(T fov_y, T aspect_ratio, T z_near, T z_far)
+  {
+    T f = static_cast<T>(1) / std::tan(fov_y * static_cast<T>(0.5));
+    return Matrix<4, 4, T>({ Vector<4, T>(f / aspect_ratio, static_cast<T>(0), static_cast<T>(0), static_cast<T>(0)),
+      Vector<4, T>(static_cast<T>(0), f, static_cast<T>(0), static_cast<T>(0)),
+      Vector<4, T>(static_cast<T>(0), static_cast<T>(0), -(z_far + z_near) / (z_far - z_near), static_cast<T>(-1)),
+      Vector<4, T>(static_cast<T>(0), static_cast<T>(0), -(static_cast<T>(2) * z_far * z_near) / (z_far - z_near), static_cast<T>(0)) });
+  }
+
+  template<typename T>
+  constexpr Matrix<4, 4, T> orthoZO(T left, T right, T bottom, T top, T z_near, T z_far)
+  {
+    return Matrix<4, 4, T>({ Vector<4, T>(static_cast<T>(2) / (right - left), static_cast<T>(0), static_cast<T>(0), static_cast<T>(0)),
+      Vector<4, T>(static_cast<T>(0), static_cast<T>(2) / (top - bottom), static_cast<T>(0), static_cast<T>(0)),
+      Vector<4, T>(static_cast<T>(0), static_cast<T>(0), static_cast<T>(-1) / (z_far - z_near), static_cast<T>(0)),
+      Vector<4, T>(-(right + left) / (right - left), -(top + bottom) / (top - bottom), -z_near / (z_far - z_near), static_cast<T>(1)) });
+  }
+
+  template<typename T>
+  constexpr Matrix<4, 4, T> orthoNO(T left, T right, T bottom, T top, T z_near, T z_far)
+  {
+    return Matrix<4, 4, T>({ Vector<4, T>(static_cast<T>(2) / (right - left), static_cast<T>(0), static_cast<T>(0), static_cast<T>(0)),
+      Vector<4, T>(static_cast<T>(0), static_cast<T>(2) / (top - bottom), static_cast<T>(0), static_cast<T>(0)),
+      Vector<4, T>(static_cast<T>(0), static_cast<T>(0), static_cast<T>(-2) / (z_far - z_near), static_cast<T>(0)),
+      Vector<4, T>(-(right + left) / (right - left), -(top + bottom) / (top - bottom), -(z_far + z_near) / (z_far - z_near), static_cast<T>(1)) });
   }
 }
 
@@ -12,7 +12,7 @@ namespace fly
   template<unsigned Dim, typename T, unsigned index>
   struct ComputeDot
   {
-    static inline T call(const Vector<Dim, T>& a, const Vector<Dim, T>& b)
+    static constexpr T call(const Vector<Dim, T>& a, const Vector<Dim, T>& b)
     {
       return a[index] * b[index] + ComputeDot<Dim, T, index - 1>::call(a, b);
     }
@@ -21,7 +21,7 @@ namespace fly
   template<unsigned Dim, typename T>
   struct ComputeDot<Dim, T, 0>
   {
-    static inline T call(const Vector<Dim, T>& a, const Vector<Dim, T>& b)
+    static constexpr T call(const Vector<Dim, T>& a, const Vector<Dim, T>& b)
     {
       return a[0] * b[0];
     }
@@ -0,0 +1,131 @@
+#ifndef PACKING_H
+#define PACKING_H
+
+#include <math/FlyMath.h>
+#include <cstring>
+#include <cstdint>
+
+namespace fly
+{
+  /**
+  * Octahedral encoding of a unit vector to [-1, 1]^2. The vector is projected onto the octahedron |x| + |y| + |z| = 1,
+  * the lower hemisphere is folded over the diagonals.
+  */
+  inline Vec2f octEncode(const Vec3f& n)
+  {
+    float l1 = std::abs(n[0]) + std::abs(n[1]) + std::abs(n[2]);
+    if (l1 == 0.f) {
+      return Vec2f(0.f);
+    }
+    Vec2f p(n[0] / l1, n[1] / l1);
+    if (n[2] < 0.f) {
+      return Vec2f((1.f - std::abs(p[1])) * (p[0] >= 0.f ? 1.f : -1.f), (1.f - std::abs(p[0])) * (p[1] >= 0.f ? 1.f : -1.f));
+    }
+    return p;
+  }
+
+  inline Vec3f octDecode(const Vec2f& e)
+  {
+    Vec3f n(e[0], e[1], 1.f - std::abs(e[0]) - std::abs(e[1]));
+    float t = (std::max)(-n[2], 0.f);
+    n[0] += n[0] >= 0.f ? -t : t;
+    n[1] += n[1] >= 0.f ? -t : t;
+    return normalize(n);
+  }
+
+  inline int16_t packSnorm16(float value)
+  {
+    return static_cast<int16_t>(std::round((std::min)((std::max)(value, -1.f), 1.f) * 32767.f));
+  }
+
+  inline float unpackSnorm16(int16_t value)
+  {
+    return (std::max)(value / 32767.f, -1.f);
+  }
+
+  inline uint16_t packUnorm16(float value)
+  {
+    return static_cast<uint16_t>(std::round((std::min)((std::max)(value, 0.f), 1.f) * 65535.f));
+  }
+
+  inline float unpackUnorm16(uint16_t value)
+  {
+    return value / 65535.f;
+  }
+
+  /**
+  * Signed normalized x, y, z with 10 bits each and w with 2 bits, matches GL_INT_2_10_10_10_REV.
+  */
+  inline uint32_t packSnorm2101010(const Vec4f& v)
+  {
+    auto pack = [](float value, float max_val, uint32_t mask) {
+      return static_cast<uint32_t>(static_cast<int32_t>(std::round((std::min)((std::max)(value, -1.f), 1.f) * max_val))) & mask;
+    };
+    return pack(v[0], 511.f, 0x3ff) | (pack(v[1], 511.f, 0x3ff) << 10) | (pack(v[2], 511.f, 0x3ff) << 20) | (pack(v[3], 1.f, 0x3) << 30);
+  }
+
+  inline Vec4f unpackSnorm2101010(uint32_t value)
+  {
+    auto unpack = [](uint32_t bits, unsigned num_bits, float max_val) {
+      int32_t i = static_cast<int32_t>(bits << (32 - num_bits)) >> (32 - num_bits); // Sign extension
+      return (std::max)(i / max_val, -1.f);
+    };
+    return Vec4f(unpack(value & 0x3ff, 10, 511.f), unpack((value >> 10) & 0x3ff, 10, 511.f), unpack((value >> 20) & 0x3ff, 10, 511.f), unpack(value >> 30, 2, 1.f));
+  }
+
+  /**
+  * IEEE 754 half precision conversion with round to nearest even. Values too large for half precision become infinity.
+  */
+  inline uint16_t floatToHalf(float value)
+  {
+    uint32_t f;
+    std::memcpy(&f, &value, sizeof f);
+    uint32_t sign = f & 0x80000000u;
+    f ^= sign;
+    uint16_t ret;
+    if (f >= (127u + 16u) << 23) { // Inf or NaN
+      ret = f > 255u << 23 ? 0x7e00 : 0x7c00;
+    }
+    else if (f < 113u << 23) { // Subnormal or zero, the float addition does the rounding
+      uint32_t magic_bits = ((127u - 15u) + (23u - 10u) + 1u) << 23;
+      float magic, f_float;
+      std::memcpy(&magic, &magic_bits, sizeof magic);
+      std::memcpy(&f_float, &f, sizeof f);
+      f_float += magic;
+      std::memcpy(&f, &f_float, sizeof f);
+      ret = static_cast<uint16_t>(f - magic_bits);
+    }
+    else {
+      uint32_t mantissa_odd = (f >> 13) & 1;
+      f += (static_cast<uint32_t>(15 - 127) << 23) + 0xfff + mantissa_odd;
+      ret = static_cast<uint16_t>(f >> 13);
+    }
+    return ret | static_cast<uint16_t>(sign >> 16);
+  }
+
+  inline float halfToFloat(uint16_t value)
+  {
+    const uint32_t shifted_exp = 0x7c00u << 13;
+    uint32_t f = (value & 0x7fffu) << 13;
+    uint32_t exp = shifted_exp & f;
+    f += (127u - 15u) << 23;
+    if (exp == shifted_exp) { // Inf or NaN
+      f += (128u - 16u) << 23;
+    }
+    else if (exp == 0) { // Zero or subnormal, renormalize
+      uint32_t magic_bits = 113u << 23;
+      float magic, f_float;
+      f += 1u << 23;
+      std::memcpy(&magic, &magic_bits, sizeof magic);
+      std::memcpy(&f_float, &f, sizeof f);
+      f_float -= magic;
+      std::memcpy(&f, &f_float, sizeof f);
+    }
+    f |= static_cast<uint32_t>(value & 0x8000u) << 16;
+    float ret;
+    std::memcpy(&ret, &f, sizeof ret);
+    return ret;
+  }
+}
+
+#endif
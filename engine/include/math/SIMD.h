@@ -0,0 +1,335 @@
+#ifndef SIMD_H
+#define SIMD_H
+
+#include <algorithm>
+
+/**
+* SSE is used if the target supports it, which is always the case for x64. AVX and FMA are picked up if enabled
+* via compiler flags (/arch:AVX2, -mavx2 -mfma). Define FLY_NO_SIMD to force the scalar code paths.
+*/
+#if !defined(FLY_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define FLY_SSE 1
+#include <immintrin.h>
+#if defined(__AVX__)
+#define FLY_AVX 1
+#endif
+#if defined(__FMA__) || defined(__AVX2__)
+#define FLY_FMA 1
+#endif
+#endif
+
+/**
+* C++14 has no std::is_constant_evaluated, but the builtin behind it is available in all language modes of
+* GCC 9, Clang 9 and MSVC 19.25 onwards. The SIMD paths are constant expressions only if it is available.
+*/
+#if defined(__has_builtin)
+#if __has_builtin(__builtin_is_constant_evaluated)
+#define FLY_HAS_CONSTANT_EVALUATED 1
+#endif
+#elif (defined(__GNUC__) && __GNUC__ >= 9) || (defined(_MSC_VER) && _MSC_VER >= 1925)
+#define FLY_HAS_CONSTANT_EVALUATED 1
+#endif
+#ifdef FLY_HAS_CONSTANT_EVALUATED
+#define FLY_SIMD_CONSTEXPR constexpr
+#else
+#define FLY_SIMD_CONSTEXPR inline
+#endif
+
+namespace fly
+{
+  /**
+  * True during constant evaluation, where the SIMD paths fall back to the scalar ones. Always false if the
+  * compiler can't tell.
+  */
+  constexpr bool isConstantEvaluated()
+  {
+#ifdef FLY_HAS_CONSTANT_EVALUATED
+    return __builtin_is_constant_evaluated();
+#else
+    return false;
+#endif
+  }
+
+  /**
+  * Component wise vector operations on raw arrays. The results may alias the inputs.
+  */
+  template<unsigned Dim, typename T>
+  struct ScalarVectorOps
+  {
+    static constexpr void add(const T* a, const T* b, T* result)
+    {
+      for (unsigned i = 0; i < Dim; i++) {
+        result[i] = a[i] + b[i];
+      }
+    }
+    static constexpr void sub(const T* a, const T* b, T* result)
+    {
+      for (unsigned i = 0; i < Dim; i++) {
+        result[i] = a[i] - b[i];
+      }
+    }
+    static constexpr void mul(const T* a, const T* b, T* result)
+    {
+      for (unsigned i = 0; i < Dim; i++) {
+        result[i] = a[i] * b[i];
+      }
+    }
+    static constexpr void div(const T* a, const T* b, T* result)
+    {
+      for (unsigned i = 0; i < Dim; i++) {
+        result[i] = a[i] / b[i];
+      }
+    }
+    static constexpr void min(const T* a, const T* b, T* result)
+    {
+      for (unsigned i = 0; i < Dim; i++) {
+        result[i] = (std::min)(a[i], b[i]);
+      }
+    }
+    static constexpr void max(const T* a, const T* b, T* result)
+    {
+      for (unsigned i = 0; i < Dim; i++) {
+        result[i] = (std::max)(a[i], b[i]);
+      }
+    }
+  };
+
+  /**
+  * Scalar unless specialized with intrinsics below. The specializations are constexpr with FLY_HAS_CONSTANT_EVALUATED
+  * and use ScalarVectorOps during constant evaluation.
+  */
+  template<unsigned Dim, typename T>
+  struct VectorOps : ScalarVectorOps<Dim, T>
+  {
+  };
+
+  /**
+  * Product of a column major Rows x Cols matrix and a column major Cols x N matrix. A vector is a Cols x 1 matrix.
+  * The result must not alias the inputs.
+  */
+  template<unsigned Rows, unsigned Cols, unsigned N, typename T>
+  struct MatrixOps
+  {
+    static constexpr void mul(const T* a, const T* b, T* result)
+    {
+      for (unsigned j = 0; j < N; j++) {
+        for (unsigned i = 0; i < Rows; i++) {
+          result[j * Rows + i] = a[i] * b[j * Cols];
+        }
+        for (unsigned k = 1; k < Cols; k++) {
+          for (unsigned i = 0; i < Rows; i++) {
+            result[j * Rows + i] += a[k * Rows + i] * b[j * Cols + k];
+          }
+        }
+      }
+    }
+  };
+
+#ifdef FLY_SSE
+  namespace simd
+  {
+    inline __m128 load4(const float* ptr)
+    {
+      return _mm_loadu_ps(ptr);
+    }
+    inline void store4(float* ptr, __m128 v)
+    {
+      _mm_storeu_ps(ptr, v);
+    }
+    /**
+    * Three component vectors are padded with zero in registers only, the memory layout stays tightly packed.
+    */
+    inline __m128 load3(const float* ptr)
+    {
+      return _mm_movelh_ps(_mm_castsi128_ps(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(ptr))), _mm_load_ss(ptr + 2));
+    }
+    inline void store3(float* ptr, __m128 v)
+    {
+      _mm_storel_epi64(reinterpret_cast<__m128i*>(ptr), _mm_castps_si128(v));
+      _mm_store_ss(ptr + 2, _mm_movehl_ps(v, v));
+    }
+    inline __m128 madd(__m128 a, __m128 b, __m128 c)
+    {
+#ifdef FLY_FMA
+      return _mm_fmadd_ps(a, b, c);
+#else
+      return _mm_add_ps(_mm_mul_ps(a, b), c);
+#endif
+    }
+    inline float hsum(__m128 v)
+    {
+      __m128 shuf = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1));
+      __m128 sums = _mm_add_ps(v, shuf);
+      shuf = _mm_movehl_ps(shuf, sums);
+      return _mm_cvtss_f32(_mm_add_ss(sums, shuf));
+    }
+    template<int mask>
+    inline float dot(__m128 a, __m128 b)
+    {
+#ifdef FLY_AVX
+      return _mm_cvtss_f32(_mm_dp_ps(a, b, mask));
+#else
+      return hsum(_mm_mul_ps(a, b));
+#endif
+    }
+    /**
+    * Column major 4x4 matrix times the 4 component vector v.
+    */
+    inline __m128 transform(const float* m, __m128 v)
+    {
+      __m128 r = _mm_mul_ps(load4(m), _mm_shuffle_ps(v, v, _MM_SHUFFLE(0, 0, 0, 0)));
+      r = madd(load4(m + 4), _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 1, 1, 1)), r);
+      r = madd(load4(m + 8), _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 2, 2, 2)), r);
+      return madd(load4(m + 12), _mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 3, 3, 3)), r);
+    }
+    template<int x, int y, int z, int w>
+    inline __m128 swizzle(__m128 v)
+    {
+      return _mm_shuffle_ps(v, v, _MM_SHUFFLE(w, z, y, x));
+    }
+    template<int x, int y, int z, int w>
+    inline __m128 shuffle(__m128 a, __m128 b)
+    {
+      return _mm_shuffle_ps(a, b, _MM_SHUFFLE(w, z, y, x));
+    }
+    /**
+    * 2x2 matrix products on matrices stored in a single register, # denotes the adjugate.
+    */
+    inline __m128 mat2Mul(__m128 a, __m128 b) // a * b
+    {
+      return _mm_add_ps(_mm_mul_ps(a, swizzle<0, 3, 0, 3>(b)), _mm_mul_ps(swizzle<1, 0, 3, 2>(a), swizzle<2, 1, 2, 1>(b)));
+    }
+    inline __m128 mat2AdjMul(__m128 a, __m128 b) // a# * b
+    {
+      return _mm_sub_ps(_mm_mul_ps(swizzle<3, 3, 0, 0>(a), b), _mm_mul_ps(swizzle<1, 1, 2, 2>(a), swizzle<2, 3, 0, 1>(b)));
+    }
+    inline __m128 mat2MulAdj(__m128 a, __m128 b) // a * b#
+    {
+      return _mm_sub_ps(_mm_mul_ps(a, swizzle<3, 0, 3, 0>(b)), _mm_mul_ps(swizzle<1, 0, 3, 2>(a), swizzle<2, 1, 2, 1>(b)));
+    }
+    /**
+    * Inverse of a 4x4 matrix using the block wise formula on its 2x2 sub matrices. Works for row and column major
+    * storage alike because inverse(transpose(m)) = transpose(inverse(m)). The result must not alias the input.
+    */
+    inline void inverse4x4(const float* m, float* result)
+    {
+      __m128 c0 = load4(m), c1 = load4(m + 4), c2 = load4(m + 8), c3 = load4(m + 12);
+      __m128 a = _mm_movelh_ps(c0, c1);
+      __m128 b = _mm_movehl_ps(c1, c0);
+      __m128 c = _mm_movelh_ps(c2, c3);
+      __m128 d = _mm_movehl_ps(c3, c2);
+      // Determinants of the sub matrices as (|a| |b| |c| |d|)
+      __m128 det_sub = _mm_sub_ps(_mm_mul_ps(shuffle<0, 2, 0, 2>(c0, c2), shuffle<1, 3, 1, 3>(c1, c3)),
+        _mm_mul_ps(shuffle<1, 3, 1, 3>(c0, c2), shuffle<0, 2, 0, 2>(c1, c3)));
+      __m128 det_a = swizzle<0, 0, 0, 0>(det_sub);
+      __m128 det_b = swizzle<1, 1, 1, 1>(det_sub);
+      __m128 det_c = swizzle<2, 2, 2, 2>(det_sub);
+      __m128 det_d = swizzle<3, 3, 3, 3>(det_sub);
+      __m128 d_c = mat2AdjMul(d, c);
+      __m128 a_b = mat2AdjMul(a, b);
+      __m128 x = _mm_sub_ps(_mm_mul_ps(det_d, a), mat2Mul(b, d_c));
+      __m128 w = _mm_sub_ps(_mm_mul_ps(det_a, d), mat2Mul(c, a_b));
+      __m128 y = _mm_sub_ps(_mm_mul_ps(det_b, c), mat2MulAdj(d, a_b));
+      __m128 z = _mm_sub_ps(_mm_mul_ps(det_c, b), mat2MulAdj(a, d_c));
+      // |m| = |a| * |d| + |b| * |c| - tr(a#b * d#c)
+      __m128 tr = _mm_mul_ps(a_b, swizzle<0, 2, 1, 3>(d_c));
+      tr = _mm_add_ps(tr, swizzle<1, 0, 3, 2>(tr));
+      tr = _mm_add_ps(tr, swizzle<2, 3, 0, 1>(tr));
+      __m128 det = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(det_a, det_d), _mm_mul_ps(det_b, det_c)), tr);
+      __m128 det_inv = _mm_div_ps(_mm_setr_ps(1.f, -1.f, -1.f, 1.f), det);
+      x = _mm_mul_ps(x, det_inv);
+      y = _mm_mul_ps(y, det_inv);
+      z = _mm_mul_ps(z, det_inv);
+      w = _mm_mul_ps(w, det_inv);
+      store4(result, shuffle<3, 1, 3, 1>(x, y));
+      store4(result + 4, shuffle<2, 0, 2, 0>(x, y));
+      store4(result + 8, shuffle<3, 1, 3, 1>(z, w));
+      store4(result + 12, shuffle<2, 0, 2, 0>(z, w));
+    }
+  }
+
+  template<>
+  struct VectorOps<4, float>
+  {
+    static FLY_SIMD_CONSTEXPR void add(const float* a, const float* b, float* result)
+    {
+      isConstantEvaluated() ? ScalarVectorOps<4, float>::add(a, b, result) : simd::store4(result, _mm_add_ps(simd::load4(a), simd::load4(b)));
+    }
+    static FLY_SIMD_CONSTEXPR void sub(const float* a, const float* b, float* result)
+    {
+      isConstantEvaluated() ? ScalarVectorOps<4, float>::sub(a, b, result) : simd::store4(result, _mm_sub_ps(simd::load4(a), simd::load4(b)));
+    }
+    static FLY_SIMD_CONSTEXPR void mul(const float* a, const float* b, float* result)
+    {
+      isConstantEvaluated() ? ScalarVectorOps<4, float>::mul(a, b, result) : simd::store4(result, _mm_mul_ps(simd::load4(a), simd::load4(b)));
+    }
+    static FLY_SIMD_CONSTEXPR void div(const float* a, const float* b, float* result)
+    {
+      isConstantEvaluated() ? ScalarVectorOps<4, float>::div(a, b, result) : simd::store4(result, _mm_div_ps(simd::load4(a), simd::load4(b)));
+    }
+    // _mm_min_ps and _mm_max_ps return the second operand on NaN and equal values, (std::min)(a, b) returns a
+    static FLY_SIMD_CONSTEXPR void min(const float* a, const float* b, float* result)
+    {
+      isConstantEvaluated() ? ScalarVectorOps<4, float>::min(a, b, result) : simd::store4(result, _mm_min_ps(simd::load4(b), simd::load4(a)));
+    }
+    static FLY_SIMD_CONSTEXPR void max(const float* a, const float* b, float* result)
+    {
+      isConstantEvaluated() ? ScalarVectorOps<4, float>::max(a, b, result) : simd::store4(result, _mm_max_ps(simd::load4(b), simd::load4(a)));
+    }
+    static inline float dot(const float* a, const float* b) { return simd::dot<0xf1>(simd::load4(a), simd::load4(b)); }
+  };
+
+  template<>
+  struct VectorOps<3, float>
+  {
+    static FLY_SIMD_CONSTEXPR void add(const float* a, const float* b, float* result)
+    {
+      isConstantEvaluated() ? ScalarVectorOps<3, float>::add(a, b, result) : simd::store3(result, _mm_add_ps(simd::load3(a), simd::load3(b)));
+    }
+    static FLY_SIMD_CONSTEXPR void sub(const float* a, const float* b, float* result)
+    {
+      isConstantEvaluated() ? ScalarVectorOps<3, float>::sub(a, b, result) : simd::store3(result, _mm_sub_ps(simd::load3(a), simd::load3(b)));
+    }
+    static FLY_SIMD_CONSTEXPR void mul(const float* a, const float* b, float* result)
+    {
+      isConstantEvaluated() ? ScalarVectorOps<3, float>::mul(a, b, result) : simd::store3(result, _mm_mul_ps(simd::load3(a), simd::load3(b)));
+    }
+    static FLY_SIMD_CONSTEXPR void div(const float* a, const float* b, float* result)
+    {
+      isConstantEvaluated() ? ScalarVectorOps<3, float>::div(a, b, result) : simd::store3(result, _mm_div_ps(simd::load3(a), simd::load3(b)));
+    }
+    // _mm_min_ps and _mm_max_ps return the second operand on NaN and equal values, (std::min)(a, b) returns a
+    static FLY_SIMD_CONSTEXPR void min(const float* a, const float* b, float* result)
+    {
+      isConstantEvaluated() ? ScalarVectorOps<3, float>::min(a, b, result) : simd::store3(result, _mm_min_ps(simd::load3(b), simd::load3(a)));
+    }
+    static FLY_SIMD_CONSTEXPR void max(const float* a, const float* b, float* result)
+    {
+      isConstantEvaluated() ? ScalarVectorOps<3, float>::max(a, b, result) : simd::store3(result, _mm_max_ps(simd::load3(b), simd::load3(a)));
+    }
+    static inline float dot(const float* a, const float* b) { return simd::dot<0x71>(simd::load3(a), simd::load3(b)); }
+  };
+
+  template<>
+  struct MatrixOps<4, 4, 4, float>
+  {
+    static inline void mul(const float* a, const float* b, float* result)
+    {
+      for (unsigned j = 0; j < 4; j++) {
+        simd::store4(result + j * 4, simd::transform(a, simd::load4(b + j * 4)));
+      }
+    }
+  };
+
+  template<>
+  struct MatrixOps<4, 4, 1, float>
+  {
+    static inline void mul(const float* a, const float* b, float* result)
+    {
+      simd::store4(result, simd::transform(a, simd::load4(b)));
+    }
+  };
+#endif
+}
+
+#endif
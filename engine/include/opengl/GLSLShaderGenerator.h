@@ -20,7 +20,8 @@ namespace fly
       NORMAL_MAP = 2, 
       ALPHA_MAP = 4,
       PARALLAX_MAP = 8,
-      WIND = 16
+      WIND = 16,
+      COMPACT_VERTEX = 32 // Octahedral normals and tangents, see VertexFormat.h
     };
     enum CompositeFlag : unsigned
     {
@@ -7,6 +7,7 @@
 #include <renderer/RenderParams.h>
 #include <memory>
 #include <vector>
+#include <map>
 #include <unordered_map>
 #include <functional>
 #include <opengl/GLTexture.h>
@@ -114,18 +115,33 @@ namespace fly
         GLint _baseVertex; // Offset into the vertex buffer
         inline unsigned numTriangles() const {return static_cast<unsigned>(_count / 3);}
         GLenum _type;
+        unsigned _vertexFormat; // Combination of VertexFormatFlag values
+        const GLVertexArray* _vertexArray; // Vertex array of the vertex format
+        Mat4f _dequantization; // Maps quantized positions to model space, identity for float positions
       };
-      MeshGeometryStorage();
+      /**
+      * All vertex array binds go through api, so that its cache of the bound vertex array stays valid.
+      */
+      MeshGeometryStorage(const OpenGLAPI& api);
       ~MeshGeometryStorage();
       void bind() const;
       MeshData addMesh(const std::shared_ptr<Mesh>& mesh);
     private:
-      std::unique_ptr<GLVertexArray> _vao;
-      std::unique_ptr<GLAppendBuffer> _vboAppend;
+      /**
+      * Meshes with the same vertex format share a vertex buffer and a vertex array, the index buffer is shared by all formats.
+      */
+      struct VertexStorage
+      {
+        std::unique_ptr<GLVertexArray> _vao;
+        std::unique_ptr<GLAppendBuffer> _vboAppend;
+        size_t _baseVertex = 0;
+      };
+      const OpenGLAPI& _api;
+      std::map<unsigned, VertexStorage> _vertexStorage;
       std::unique_ptr<GLAppendBuffer> _iboAppend;
       SoftwareCache<std::shared_ptr<Mesh>, MeshData, const std::shared_ptr<Mesh>&> _meshDataCache;
       size_t _indices = 0;
-      size_t _baseVertex = 0;
+      void setupVertexArray(unsigned format, const VertexStorage& storage) const;
     };
     // Texture unit bindings
     static constexpr const int diffuseTexUnit() { return 0; }
@@ -166,7 +182,7 @@ namespace fly
       void setup(GLShaderProgram* shader) const;
       void setupDepth(GLShaderProgram* shader) const;
       using ShaderProgram = GLShaderProgram;
-      const std::shared_ptr<ShaderDesc>& getMeshShaderDesc(bool has_wind) const;
+      const std::shared_ptr<ShaderDesc>& getMeshShaderDesc(bool has_wind, unsigned vertex_format = 0) const;
       const std::shared_ptr<ShaderDesc>& getMeshShaderDescDepth(bool has_wind) const;
       const std::shared_ptr<Material>& getMaterial() const;
       const std::shared_ptr<GLTexture>& diffuseMap() const;
@@ -179,6 +195,8 @@ namespace fly
       std::vector<IMaterialSetup*> _materialSetupFuncsDepth;
       std::shared_ptr<ShaderDesc> _meshShaderDesc;
       std::shared_ptr<ShaderDesc> _meshShaderDescWind;
+      std::shared_ptr<ShaderDesc> _meshShaderDescCompact;
+      std::shared_ptr<ShaderDesc> _meshShaderDescWindCompact;
       std::shared_ptr<ShaderDesc> _meshShaderDescDepth;
       std::shared_ptr<ShaderDesc> _meshShaderDescWindDepth;
       std::shared_ptr<GLTexture> _diffuseMap;
@@ -216,6 +234,7 @@ namespace fly
     const std::shared_ptr<ShaderDesc>& getSkyboxShaderDesc() const;
   private:
     GLShaderProgram * _activeShader;
+    mutable const GLVertexArray* _activeVertexArray = nullptr;
     SoftwareCache<std::string, std::shared_ptr<GLTexture>, const std::string& > _textureCache;
     SoftwareCache<std::string, std::shared_ptr<GLShaderProgram>, const std::string&, const std::string&, const std::string&> _shaderCache;
     SoftwareCache<std::shared_ptr<Material>, std::shared_ptr<MaterialDesc>, const std::shared_ptr<Material>&, const GraphicsSettings&> _matDescCache;
@@ -235,6 +254,11 @@ namespace fly
 
     void checkFramebufferStatus();
     void setColorBuffers(const std::vector<RTT*>& rtts);
+    /**
+    * Skips the bind if vertex_array is already bound, nullptr binds no vertex array. Every vertex array bind in this API
+    * must go through here, otherwise the cached binding is stale.
+    */
+    void bindVertexArray(const GLVertexArray* vertex_array) const;
   };
 }
 
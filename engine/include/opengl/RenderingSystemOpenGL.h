@@ -10,12 +10,6 @@
 #include <Terrain.h>
 #include <Settings.h>
 
-#define NONE 0
-#define NORTH 1
-#define SOUTH 2
-#define WEST 4
-#define EAST 8
-
 #define PROFILE 0
 
 namespace fly
@@ -190,9 +184,10 @@ namespace fly
 
       std::shared_ptr<GLVertexArrayOld> _terrainVao;
       std::shared_ptr<GLBufferOld> _terrainVbo;
-      std::map<int, std::map<int, std::shared_ptr<GLBufferOld>>> _terrainIbo;
-      std::map<int, std::map<int, unsigned>> _terrainNumIndices;
-      void createIndexBuffer(int lod, int dir, const std::vector<unsigned>& indices);
+      /**
+      * All permutations of the terrain's index pool.
+      */
+      std::shared_ptr<GLBufferOld> _terrainIbo;
       std::array<std::shared_ptr<GLFramebufferOld>, 2> _impostorFb;
       void renderImpostor(const std::shared_ptr<Model>& tree_model, const std::shared_ptr<Model>& leaf_model, const glm::mat4& transform, RenderingSystemOpenGL* rs);
 
@@ -3,6 +3,7 @@
 
 #include <FixedTimestepSystem.h>
 #include <map>
+#include <vector>
 #include <physics/ParticleSystem.h>
 
 namespace fly
@@ -10,7 +11,7 @@ namespace fly
   class PhysicsSystem : public FixedTimestepSystem
   {
   public:
-    PhysicsSystem() = default;
+    PhysicsSystem();
     virtual ~PhysicsSystem() = default;
 
     virtual void onComponentsChanged(Entity* entity) override;
@@ -18,6 +19,7 @@ namespace fly
 
   private:
     std::map<Entity*, std::shared_ptr<ParticleSystem>> _particleSystems;
+    std::vector<ParticleSystem*> _particleSystemsFlat;
   };
 }
 
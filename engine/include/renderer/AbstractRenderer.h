@@ -49,7 +49,7 @@ namespace fly
     };
     const RendererStats& getStats() const { return _stats; }
 #endif
-    AbstractRenderer(const GraphicsSettings* gs) : _api(), _gs(gs)
+    AbstractRenderer(const GraphicsSettings* gs) : _api(), _gs(gs), _meshGeometryStorage(_api)
     {
       _pp._near = 0.1f;
       _pp._far = 10000.f;
@@ -108,39 +108,40 @@ namespace fly
     }
     virtual void onComponentsChanged(Entity* entity) override
     {
-      auto camera = entity->getComponent<Camera>();
-      auto dl = entity->getComponent<DirectionalLight>();
-      auto mr = entity->getComponent<fly::StaticMeshRenderable>();
-      auto dmr = entity->getComponent<fly::DynamicMeshRenderable>();
-      auto sbr = entity->getComponent<fly::SkydomeRenderable>();
-      if (mr) {
-        _staticMeshRenderables[entity] = mr->hasWind() ? 
-          std::make_shared<StaticMeshRenderableWind>(mr, _api.createMaterial(mr->getMaterial(), *_gs), _meshGeometryStorage.addMesh(mr->getMesh())) :
-          std::make_shared<StaticMeshRenderable>(mr, _api.createMaterial(mr->getMaterial(), *_gs), _meshGeometryStorage.addMesh(mr->getMesh()));
-        _sceneMin = minimum(_sceneMin, mr->getAABBWorld()->getMin());
-        _sceneMax = maximum(_sceneMax, mr->getAABBWorld()->getMax());
-      }
-      else {
-        auto it = _staticMeshRenderables.find(entity);
-        if (it != _staticMeshRenderables.end()) {
-          _bvh->removeElement(it->second.get());
-          _staticMeshRenderables.erase(it->first);
+      onComponentTypesChanged(entity, { typeid(Camera), typeid(DirectionalLight), typeid(fly::StaticMeshRenderable), typeid(fly::DynamicMeshRenderable), typeid(fly::SkydomeRenderable) });
+    }
+    virtual void onComponentTypesChanged(Entity* entity, const std::set<std::type_index>& changed_types) override
+    {
+      // Only the render relevant components are looked at, e.g. finished animations don't touch the renderer state.
+      if (changed_types.count(typeid(fly::StaticMeshRenderable))) {
+        staticMeshRenderableChanged(entity, entity->getComponent<fly::StaticMeshRenderable>());
+      }
+      if (changed_types.count(typeid(fly::DynamicMeshRenderable))) {
+        auto dmr = entity->getComponent<fly::DynamicMeshRenderable>();
+        if (dmr) {
+          _dynamicMeshRenderables[entity] = std::make_shared<DynamicMeshRenderable>(dmr, _api.createMaterial(dmr->getMaterial(), *_gs), _meshGeometryStorage.addMesh(dmr->getMesh()));
+        }
+        else {
+          _dynamicMeshRenderables.erase(entity);
         }
       }
-      if (dmr) {
-        _dynamicMeshRenderables[entity] = std::make_shared<DynamicMeshRenderable>(dmr, _api.createMaterial(dmr->getMaterial(), *_gs), _meshGeometryStorage.addMesh(dmr->getMesh()));
-      }
-      else {
-        _dynamicMeshRenderables.erase(entity);
-      }
-      if (camera) {
-        _camera = camera;
+      if (changed_types.count(typeid(Camera))) {
+        auto camera = entity->getComponent<Camera>();
+        if (camera) {
+          _camera = camera;
+        }
       }
-      if (dl) {
-        _directionalLight = dl;
+      if (changed_types.count(typeid(DirectionalLight))) {
+        auto dl = entity->getComponent<DirectionalLight>();
+        if (dl) {
+          _directionalLight = dl;
+        }
       }
-      if (sbr) {
-        _skydomeRenderable = std::make_shared<SkydomeRenderable>(_meshGeometryStorage.addMesh(sbr->getMesh()), _api.getSkyboxShaderDesc().get());
+      if (changed_types.count(typeid(fly::SkydomeRenderable))) {
+        auto sbr = entity->getComponent<fly::SkydomeRenderable>();
+        if (sbr) {
+          _skydomeRenderable = std::make_shared<SkydomeRenderable>(_meshGeometryStorage.addMesh(sbr->getMesh()), _api.getSkyboxShaderDesc().get());
+        }
       }
     }
     virtual void update(float time, float delta_time) override
@@ -267,8 +268,8 @@ namespace fly
       _viewPortSize = window_size;
       float aspect_ratio = _viewPortSize[0] / _viewPortSize[1];
       _gsp._projectionMatrix = _api.getZNearMapping() == ZNearMapping::ZERO ?
-        glm::perspectiveRH_ZO(glm::radians(_pp._fieldOfViewDegrees), aspect_ratio, _pp._near, _pp._far) :
-        glm::perspectiveRH_NO(glm::radians(_pp._fieldOfViewDegrees), aspect_ratio, _pp._near, _pp._far);
+        perspectiveZO(radians(_pp._fieldOfViewDegrees), aspect_ratio, _pp._near, _pp._far) :
+        perspectiveNO(radians(_pp._fieldOfViewDegrees), aspect_ratio, _pp._near, _pp._far);
 
       compositingChanged(_gs->exposureEnabled(), _gs->depthPrepassEnabled(), _gs->postProcessingEnabled());
     }
@@ -277,6 +278,23 @@ namespace fly
     const Vec3f& getSceneMin() const { return _sceneMin; }
     const Vec3f& getSceneMax() const { return _sceneMax; }
     std::vector<std::shared_ptr<Material>> getAllMaterials() { return _api.getAllMaterials(); }
+    /**
+    * Uses a prebuilt spatial index, e.g. from a SceneSnapshot, instead of building it on the first frame.
+    * The elements referenced by the nodes are entities that own a StaticMeshRenderable.
+    */
+    void setBVH(const QuadtreeFlatNode* nodes, const std::vector<Entity*>& elements)
+    {
+      std::vector<MeshRenderable*> renderables(elements.size());
+      for (size_t i = 0; i < elements.size(); i++) {
+        auto it = _staticMeshRenderables.find(elements[i]);
+        if (it == _staticMeshRenderables.end()) {
+          std::cout << "AbstractRenderer::setBVH() Element without static mesh renderable, the BVH is rebuilt instead." << std::endl;
+          return;
+        }
+        renderables[i] = it->second.get();
+      }
+      _bvh = std::make_unique<BVH>(nodes, renderables.data());
+    }
   private:
     API _api;
     ProjectionParams _pp;
@@ -316,7 +334,7 @@ namespace fly
       {}
       virtual void fetchShaderDescs()
       {
-        _shaderDesc = _materialDesc->getMeshShaderDesc(false).get();
+        _shaderDesc = _materialDesc->getMeshShaderDesc(false, _meshData._vertexFormat).get();
         _shaderDescDepth = _materialDesc->getMeshShaderDescDepth(false).get();
       }
       virtual AABB* getAABBWorld() const = 0;
@@ -371,6 +389,7 @@ namespace fly
         fetchShaderDescs();
       }
       virtual ~StaticMeshRenderable() = default;
+      virtual bool hasWind() const { return false; }
       virtual void render(const API& api) override
       {
         api.renderMesh(_meshData, _smr->getModelMatrix(), _smr->getModelMatrixInverse());
@@ -390,9 +409,10 @@ namespace fly
         fetchShaderDescs();
       }
       virtual ~StaticMeshRenderableWind() = default;
+      virtual bool hasWind() const override { return true; }
       virtual void fetchShaderDescs() override
       {
-        _shaderDesc = _materialDesc->getMeshShaderDesc(true).get();
+        _shaderDesc = _materialDesc->getMeshShaderDesc(true, _meshData._vertexFormat).get();
         _shaderDescDepth = _materialDesc->getMeshShaderDescDepth(true).get();
       }
       virtual void render(const API& api) override
@@ -467,7 +487,7 @@ namespace fly
     {
       std::vector<Mat4f> light_vps;
       auto vp_shadow_volume = _directionalLight->getViewProjectionMatrices(_viewPortSize[0] / _viewPortSize[1], _pp._near, _pp._fieldOfViewDegrees,
-        inverse(_gsp._viewMatrix), _directionalLight->getViewMatrix(), static_cast<float>(_gs->getShadowMapSize()), _gs->getFrustumSplits(), light_vps, _api.isDirectX());
+        inverseAffine(_gsp._viewMatrix), _directionalLight->getViewMatrix(), static_cast<float>(_gs->getShadowMapSize()), _gs->getFrustumSplits(), light_vps, _api.isDirectX());
 #if RENDERER_STATS
       Timing timing;
 #endif
@@ -522,6 +542,46 @@ namespace fly
         e.second->fetchShaderDescs();
       }
     }
+    /**
+    * Applies a changed static mesh renderable component. The wrapper is updated in place and material
+    * and geometry are only looked up again if they differ from the ones of the previous component.
+    */
+    void staticMeshRenderableChanged(Entity* entity, const std::shared_ptr<fly::StaticMeshRenderable>& mr)
+    {
+      auto it = _staticMeshRenderables.find(entity);
+      std::shared_ptr<StaticMeshRenderable> renderable = it != _staticMeshRenderables.end() ? it->second : nullptr;
+      if (renderable && _bvh) {
+        _bvh->removeElement(renderable.get());
+      }
+      if (!mr) {
+        if (renderable) {
+          _staticMeshRenderables.erase(it);
+        }
+        return;
+      }
+      if (!renderable || renderable->_smr != mr) {
+        auto material_desc = renderable && renderable->_smr->getMaterial() == mr->getMaterial() ? renderable->_materialDesc : _api.createMaterial(mr->getMaterial(), *_gs);
+        auto mesh_data = renderable && renderable->_smr->getMesh() == mr->getMesh() ? renderable->_meshData : _meshGeometryStorage.addMesh(mr->getMesh());
+        if (renderable && renderable->hasWind() == mr->hasWind()) {
+          renderable->_smr = mr;
+          renderable->_meshData = mesh_data;
+          if (renderable->_materialDesc != material_desc) {
+            renderable->_materialDesc = material_desc;
+            renderable->fetchShaderDescs();
+          }
+        }
+        else {
+          renderable = mr->hasWind() ? std::make_shared<StaticMeshRenderableWind>(mr, material_desc, mesh_data) :
+            std::make_shared<StaticMeshRenderable>(mr, material_desc, mesh_data);
+          _staticMeshRenderables[entity] = renderable;
+        }
+      }
+      _sceneMin = minimum(_sceneMin, mr->getAABBWorld()->getMin());
+      _sceneMax = maximum(_sceneMax, mr->getAABBWorld()->getMax());
+      if (_bvh) {
+        _bvh->insert(renderable.get());
+      }
+    }
     void buildBVH()
     {
       _bvh = std::make_unique<BVH>(_sceneMin, _sceneMax);
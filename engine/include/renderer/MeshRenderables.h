@@ -23,7 +23,7 @@ namespace fly
     {}
     virtual void fetchShaderDescs()
     {
-      _shaderDesc = _materialDesc->getMeshShaderDesc(false).get();
+      _shaderDesc = _materialDesc->getMeshShaderDesc(false, _meshData._vertexFormat).get();
       _shaderDescDepth = _materialDesc->getMeshShaderDescDepth(false).get();
     }
     virtual AABB* getAABBWorld() const = 0;
@@ -103,7 +103,7 @@ namespace fly
     virtual ~StaticMeshRenderableWindWrapper() = default;
     virtual void fetchShaderDescs() override
     {
-      _shaderDesc = _materialDesc->getMeshShaderDesc(true).get();
+      _shaderDesc = _materialDesc->getMeshShaderDesc(true, _meshData._vertexFormat).get();
       _shaderDescDepth = _materialDesc->getMeshShaderDescDepth(true).get();
     }
     virtual void render(const API& api) override
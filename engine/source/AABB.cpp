@@ -1,4 +1,5 @@
 #include <AABB.h>
+#include <math/Batch.h>
 
 namespace fly
 {
@@ -8,20 +9,9 @@ namespace fly
     _size(distance(_bbMin, _bbMax))
   {
   }
-  AABB::AABB(const AABB& aabb_local, const Mat4f & world_matrix) :
-    _bbMin(aabb_local._bbMin),
-    _bbMax(aabb_local._bbMax)
+  AABB::AABB(const AABB& aabb_local, const Mat4f & world_matrix)
   {
-    std::array<Vec3f, 8> vertices_world;
-    for (unsigned i = 0; i < 8; i++) {
-       vertices_world[i] = (world_matrix * Vec4f(getVertex(i), 1.f)).xyz();
-    }
-    _bbMin = Vec3f(std::numeric_limits<float>::max());
-    _bbMax = Vec3f(std::numeric_limits<float>::lowest());
-    for (unsigned i = 0; i < 8; i++) {
-      _bbMin = minimum(_bbMin, vertices_world[i]);
-      _bbMax = maximum(_bbMax, vertices_world[i]);
-    }
+    transformAABBs(world_matrix, &aabb_local._bbMin, &aabb_local._bbMax, 1, &_bbMin, &_bbMax);
     _size = distance(_bbMin, _bbMax);
   }
   const Vec3f& AABB::getMin() const
@@ -31,6 +31,14 @@ namespace fly
   {
     return _interpolator;
   }
+  void Animation::setThreadSafe(bool thread_safe)
+  {
+    _threadSafe = thread_safe;
+  }
+  bool Animation::isThreadSafe() const
+  {
+    return _threadSafe;
+  }
   float Animation::LinearInterpolator::getInterpolation(float t)
   {
     return t;
@@ -2,39 +2,68 @@
 #include "Entity.h"
 #include "Animation.h"
 #include "EntityManager.h"
+#include "Transform.h"
+#include "Light.h"
+#include <ParallelFor.h>
 #include <vector>
+#include <algorithm>
 
 namespace fly
 {
   AnimationSystem::AnimationSystem()
   {
+    writes<Animation>();
+    // Update functions are user defined and restricted to these components, see Animation
+    writes<Transform>();
+    writes<Light>();
   }
   AnimationSystem::~AnimationSystem()
   {
   }
   void AnimationSystem::onComponentsChanged(Entity* entity)
   {
+    auto it = std::find(_entities.begin(), _entities.end(), entity);
     if (entity->getComponent<Animation>()) {
-      _entities.insert(entity);
+      if (it == _entities.end()) {
+        _entities.push_back(entity);
+      }
     }
-    else {
-      _entities.erase(entity);
+    else if (it != _entities.end()) {
+      _entities.erase(it);
     }
   }
   void AnimationSystem::update(float time, float delta_time)
   {
-    std::vector<Entity*> to_delete;
-    for (auto& e : _entities) {
-      auto a = e->getComponent<Animation>();
+    _finished.assign(_entities.size(), false);
+    auto animate = [this, time](size_t i) {
+      auto a = _entities[i]->getComponent<Animation>();
       float progress;
       if (time >= a->getTimeEnd()) {
         progress = 1.f;
-        to_delete.push_back(e);
+        _finished[i] = true;
       }
       else {
         progress = a->getInterpolator()->getInterpolation((time - a->getTimeStart()) / (a->getTimeEnd() - a->getTimeStart()));
       }
       a->getUpdateFunction()(progress);
+    };
+    // Only animations that opted in are called concurrently, the others may share state between their update functions
+    _serial.clear();
+    _threadSafe.clear();
+    for (size_t i = 0; i < _entities.size(); i++) {
+      (_entities[i]->getComponent<Animation>()->isThreadSafe() ? _threadSafe : _serial).push_back(i);
+    }
+    parallelFor(0, _threadSafe.size(), [this, &animate](size_t i) {
+      animate(_threadSafe[i]);
+    });
+    for (auto i : _serial) {
+      animate(i);
+    }
+    std::vector<Entity*> to_delete;
+    for (size_t i = 0; i < _entities.size(); i++) {
+      if (_finished[i]) {
+        to_delete.push_back(_entities[i]);
+      }
     }
     for (auto& e : to_delete) {
       e->removeComponent<Animation>();
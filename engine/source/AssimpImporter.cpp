@@ -2,6 +2,9 @@
 #include <Model.h>
 #include <Vertex.h>
 #include <Mesh.h>
+#include <ParallelFor.h>
+#include <iostream>
+#include <algorithm>
 
 #define FLY_VEC2(vec) fly::Vec2f({vec.x, vec.y});
 #define FLY_VEC3(vec) fly::Vec3f({vec.x, vec.y, vec.z});
@@ -15,16 +18,29 @@ namespace fly
   {
     Assimp::Importer importer;
     auto scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_CalcTangentSpace | aiProcess_GenSmoothNormals | aiProcess_JoinIdenticalVertices | aiProcess_FlipUVs);
-    std::vector<std::shared_ptr<Mesh>> meshes(scene->mNumMeshes);
+    if (!scene) {
+      std::cout << "AssimpImporter::loadModel() Failed to import " << path << ": " << importer.GetErrorString() << std::endl;
+      return nullptr;
+    }
+    // Meshes and materials are converted independently, the conversion dominates for scenes with many submeshes
     std::vector<std::shared_ptr<Material>> materials(scene->mNumMaterials);
-    for (unsigned int i = 0; i < scene->mNumMaterials; i++) {
+    parallelFor(0, materials.size(), [this, scene, &materials, &path](size_t i) {
       materials[i] = processMaterial(scene->mMaterials[i], path);
-    }
-    for (unsigned int i = 0; i < scene->mNumMeshes; i++) {
+    }, 1);
+    std::vector<std::shared_ptr<Mesh>> meshes(scene->mNumMeshes);
+    parallelFor(0, meshes.size(), [this, scene, &meshes, &materials](size_t i) {
       meshes[i] = processMesh(scene->mMeshes[i], materials);
-    }
+    }, 1);
     return std::make_shared<Model>(meshes, materials);
   }
+  std::vector<std::shared_ptr<Model>> AssimpImporter::loadModels(const std::vector<std::string>& paths)
+  {
+    std::vector<std::shared_ptr<Model>> models(paths.size());
+    parallelFor(0, paths.size(), [this, &models, &paths](size_t i) {
+      models[i] = loadModel(paths[i]);
+    }, 1);
+    return models;
+  }
   std::shared_ptr<Mesh> AssimpImporter::processMesh(aiMesh * mesh, const std::vector<std::shared_ptr<Material>>& materials)
   {
     std::vector<Vertex> vertices(mesh->mNumVertices);
@@ -39,13 +55,16 @@ namespace fly
       }
     }
 
-    std::vector<unsigned int> indices;
+    size_t num_indices = 0;
     for (unsigned int i = 0; i < mesh->mNumFaces; i++) {
-      for (unsigned int j = 0; j < mesh->mFaces[i].mNumIndices; j++) {
-        indices.push_back(mesh->mFaces[i].mIndices[j]);
-      }
+      num_indices += mesh->mFaces[i].mNumIndices;
+    }
+    std::vector<unsigned int> indices(num_indices);
+    auto dst = indices.data();
+    for (unsigned int i = 0; i < mesh->mNumFaces; i++) {
+      dst = std::copy(mesh->mFaces[i].mIndices, mesh->mFaces[i].mIndices + mesh->mFaces[i].mNumIndices, dst);
     }
-    auto m = std::make_shared<Mesh>(vertices, indices, mesh->mMaterialIndex);
+    auto m = std::make_shared<Mesh>(std::move(vertices), std::move(indices), mesh->mMaterialIndex);
     m->setMaterial(materials[mesh->mMaterialIndex]);
     return m;
   }
@@ -0,0 +1,121 @@
+#include <CDLODQuadtree.h>
+#include <AABB.h>
+#include <limits>
+
+namespace fly
+{
+  namespace
+  {
+    AABB getAABB(const glm::ivec2& pos, int size, const MinMaxPyramid::MinMax& min_max)
+    {
+      return AABB(Vec3f(static_cast<float>(pos.x), min_max._min, static_cast<float>(pos.y)),
+        Vec3f(static_cast<float>(pos.x + size), min_max._max, static_cast<float>(pos.y + size)));
+    }
+  }
+
+  CDLODQuadtree::CDLODQuadtree(const std::shared_ptr<const MinMaxPyramid>& pyramid) :
+    CDLODQuadtree(pyramid, Settings())
+  {
+  }
+
+  CDLODQuadtree::CDLODQuadtree(const std::shared_ptr<const MinMaxPyramid>& pyramid, const Settings& settings) :
+    _pyramid(pyramid),
+    _settings(settings)
+  {
+    float prev_range = 0.f;
+    for (unsigned lod = 0; lod < _settings._numLods; lod++) {
+      float range = _settings._lod0Range * static_cast<float>(1u << lod);
+      _ranges.push_back(range);
+      _morphStarts.push_back(prev_range + (range - prev_range) * _settings._morphStartRatio);
+      prev_range = range;
+    }
+  }
+
+  const std::vector<CDLODQuadtree::Node>& CDLODQuadtree::select(const Vec3f& cam_pos, const Mat4f& mvp)
+  {
+    selectRoots(cam_pos, &mvp);
+    return _selection;
+  }
+
+  const std::vector<CDLODQuadtree::Node>& CDLODQuadtree::select(const Vec3f& cam_pos)
+  {
+    selectRoots(cam_pos, nullptr);
+    return _selection;
+  }
+
+  float CDLODQuadtree::getRange(unsigned lod) const
+  {
+    return _ranges[lod];
+  }
+
+  float CDLODQuadtree::getMorphStart(unsigned lod) const
+  {
+    return _morphStarts[lod];
+  }
+
+  int CDLODQuadtree::getGridResolution() const
+  {
+    return _settings._leafSize;
+  }
+
+  const CDLODQuadtree::Settings& CDLODQuadtree::getSettings() const
+  {
+    return _settings;
+  }
+
+  void CDLODQuadtree::selectRoots(const Vec3f& cam_pos, const Mat4f* mvp)
+  {
+    _selection.clear();
+    unsigned top_lod = _settings._numLods - 1;
+    int root_size = _settings._leafSize << top_lod;
+    const glm::ivec2& size = _pyramid->getLevelSize(0);
+    for (int z = 0; z < size.y; z += root_size) {
+      for (int x = 0; x < size.x; x += root_size) {
+        if (!selectNode(glm::ivec2(x, z), top_lod, cam_pos, mvp)) { // Beyond the range of the coarsest LOD, no parent can take over
+          addNode(glm::ivec2(x, z), root_size, top_lod, mvp);
+        }
+      }
+    }
+  }
+
+  void CDLODQuadtree::addNode(const glm::ivec2& pos, int size, unsigned lod, const Mat4f* mvp)
+  {
+    auto min_max = _pyramid->getMinMax(pos, size);
+    if (mvp && !getAABB(pos, size, min_max).intersectsFrustum<false>(*mvp)) {
+      return;
+    }
+    bool coarsest = lod + 1 == _settings._numLods; // Has nothing to morph to
+    _selection.push_back({ pos, size, lod, min_max._min, min_max._max,
+      coarsest ? std::numeric_limits<float>::max() : _morphStarts[lod], coarsest ? std::numeric_limits<float>::max() : _ranges[lod] });
+  }
+
+  bool CDLODQuadtree::selectNode(const glm::ivec2& pos, unsigned lod, const Vec3f& cam_pos, const Mat4f* mvp)
+  {
+    const glm::ivec2& size = _pyramid->getLevelSize(0);
+    if (pos.x >= size.x || pos.y >= size.y) { // Outside of the heightmap, nothing to draw
+      return true;
+    }
+    int node_size = _settings._leafSize << lod;
+    AABB aabb = getAABB(pos, node_size, _pyramid->getMinMax(pos, node_size));
+    float dist = distance(aabb.closestPoint(cam_pos), cam_pos);
+    if (dist > _ranges[lod]) {
+      return false;
+    }
+    if (mvp && !aabb.intersectsFrustum<false>(*mvp)) {
+      return true;
+    }
+    if (lod == 0 || dist > _ranges[lod - 1]) {
+      addNode(pos, node_size, lod, nullptr);
+      return true;
+    }
+    // Children beyond the finer range are drawn as quarters of this node with this node's LOD
+    int half = node_size / 2;
+    glm::ivec2 children[] = { pos, pos + glm::ivec2(half, 0), pos + glm::ivec2(0, half), pos + half };
+    for (const auto& c : children) {
+      if (!selectNode(c, lod - 1, cam_pos, mvp)) {
+        addNode(c, half, lod, mvp);
+      }
+    }
+    return true;
+  }
+}
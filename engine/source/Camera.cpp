@@ -19,6 +19,6 @@ namespace fly
 
     glm::vec3 target = pos + _direction;
 
-    return glm::lookAt(pos, target, _up);
+    return lookAt(Vec3f(pos), Vec3f(target), Vec3f(_up));
   }
 }
\ No newline at end of file
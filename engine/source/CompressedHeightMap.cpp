@@ -0,0 +1,265 @@
+#include <CompressedHeightMap.h>
+#include <MappedFile.h>
+#include <ParallelFor.h>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+
+namespace fly
+{
+  namespace
+  {
+    const char MAGIC[4] = { 'F', 'L', 'Y', 'H' };
+
+    struct EncodedTile
+    {
+      CompressedHeightMap::TileInfo _info;
+      std::vector<uint8_t> _data;
+    };
+
+    EncodedTile encodeTile(const float* heights, size_t row_stride, const glm::ivec2& extent, float max_error)
+    {
+      EncodedTile tile{};
+      float min = std::numeric_limits<float>::max();
+      float max = std::numeric_limits<float>::lowest();
+      for (int z = 0; z < extent.y; z++) {
+        for (int x = 0; x < extent.x; x++) {
+          min = (std::min)(min, heights[z * row_stride + x]);
+          max = (std::max)(max, heights[z * row_stride + x]);
+        }
+      }
+      float step = (std::max)((max - min) / 65535.f, max_error * 2.f);
+      tile._info._min = min;
+      tile._info._step = step > 0.f ? step : 1.f;
+      std::vector<uint16_t> quantized(extent.x * extent.y);
+      bool fits_delta8 = true;
+      for (int z = 0; z < extent.y; z++) {
+        for (int x = 0; x < extent.x; x++) {
+          float q = std::round((heights[z * row_stride + x] - min) / tile._info._step);
+          uint16_t& value = quantized[z * extent.x + x];
+          value = static_cast<uint16_t>((std::min)(q, 65535.f));
+          if (x) {
+            int delta = static_cast<int>(value) - static_cast<int>(quantized[z * extent.x + x - 1]);
+            fits_delta8 = fits_delta8 && delta >= -128 && delta <= 127;
+          }
+        }
+      }
+      if (!fits_delta8) {
+        tile._info._encoding = CompressedHeightMap::Encoding::Raw16;
+        tile._data.resize(CompressedHeightMap::getEncodedSize(tile._info._encoding, extent));
+        std::memcpy(tile._data.data(), quantized.data(), tile._data.size());
+        return tile;
+      }
+      tile._info._encoding = CompressedHeightMap::Encoding::Delta8;
+      tile._data.resize(CompressedHeightMap::getEncodedSize(tile._info._encoding, extent));
+      auto row_starts = reinterpret_cast<uint16_t*>(tile._data.data());
+      auto deltas = reinterpret_cast<int8_t*>(tile._data.data() + extent.y * sizeof(uint16_t));
+      for (int z = 0; z < extent.y; z++) {
+        const uint16_t* row = &quantized[z * extent.x];
+        row_starts[z] = row[0];
+        for (int x = 1; x < extent.x; x++) {
+          *deltas++ = static_cast<int8_t>(static_cast<int>(row[x]) - static_cast<int>(row[x - 1]));
+        }
+      }
+      return tile;
+    }
+  }
+
+  CompressedHeightMap::CompressedHeightMap(const float* heights, int width, int height, size_t row_stride, int tile_size, float max_error) :
+    _size(width, height),
+    _tileSize(tile_size),
+    _numTiles(tile_size > 0 ? glm::ivec2((width + tile_size - 1) / tile_size, (height + tile_size - 1) / tile_size) : glm::ivec2(0))
+  {
+    if (tile_size <= 0 || width <= 0 || height <= 0) {
+      throw std::invalid_argument("CompressedHeightMap: the tile size and the heightmap size must be positive");
+    }
+    std::vector<EncodedTile> encoded(_numTiles.x * _numTiles.y);
+    parallelFor(0, encoded.size(), [&](size_t i) {
+      int tile_x = static_cast<int>(i) % _numTiles.x;
+      int tile_z = static_cast<int>(i) / _numTiles.x;
+      const float* tile_heights = heights + tile_z * _tileSize * row_stride + tile_x * _tileSize;
+      encoded[i] = encodeTile(tile_heights, row_stride, getTileExtent(tile_x, tile_z), max_error);
+    });
+    size_t data_size = 0;
+    for (const auto& e : encoded) {
+      data_size += (e._data.size() + 1) & ~size_t(1);
+    }
+    _data.resize(data_size);
+    _tiles.reserve(encoded.size());
+    size_t offset = 0;
+    for (auto& e : encoded) {
+      e._info._offset = offset;
+      _tiles.push_back(e._info);
+      std::memcpy(_data.data() + offset, e._data.data(), e._data.size());
+      offset += (e._data.size() + 1) & ~size_t(1); // Keeps the 16 bit values of the next tile aligned
+    }
+  }
+
+  bool CompressedHeightMap::save(const std::string& path) const
+  {
+    std::ofstream os(path, std::ios::binary);
+    if (!os.good()) {
+      std::cout << "CompressedHeightMap::save() Failed to open " << path << std::endl;
+      return false;
+    }
+    Header header = {};
+    std::memcpy(header._magic, MAGIC, sizeof(MAGIC));
+    header._version = VERSION;
+    header._width = _size.x;
+    header._height = _size.y;
+    header._tileSize = _tileSize;
+    header._dataSize = _data.size();
+    os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    os.write(reinterpret_cast<const char*>(_tiles.data()), _tiles.size() * sizeof(_tiles.front()));
+    os.write(reinterpret_cast<const char*>(_data.data()), _data.size());
+    return os.good();
+  }
+
+  std::unique_ptr<CompressedHeightMap> CompressedHeightMap::load(const std::string& path)
+  {
+    MappedFile file(path);
+    if (!file.getData() || file.getSize() < sizeof(Header)) {
+      return nullptr;
+    }
+    auto header = reinterpret_cast<const Header*>(file.getData());
+    const uint32_t max_size = static_cast<uint32_t>(std::numeric_limits<int>::max());
+    bool valid = !std::memcmp(header->_magic, MAGIC, sizeof(MAGIC)) && header->_version == VERSION && header->_tileSize > 0 &&
+      header->_tileSize <= max_size && header->_width > 0 && header->_width <= max_size && header->_height > 0 && header->_height <= max_size;
+    size_t num_tiles = valid ? static_cast<size_t>((header->_width - 1) / header->_tileSize + 1) * ((header->_height - 1) / header->_tileSize + 1) : 0;
+    size_t remaining = file.getSize() - sizeof(Header);
+    if (!valid || num_tiles > remaining / sizeof(TileInfo) || header->_dataSize > remaining - num_tiles * sizeof(TileInfo)) {
+      std::cout << "CompressedHeightMap::load() " << path << " is not a valid heightmap of version " << VERSION << std::endl;
+      return nullptr;
+    }
+    std::unique_ptr<CompressedHeightMap> height_map(new CompressedHeightMap());
+    height_map->_size = glm::ivec2(header->_width, header->_height);
+    height_map->_tileSize = header->_tileSize;
+    height_map->_numTiles = (height_map->_size - 1) / height_map->_tileSize + 1;
+    height_map->_tiles.resize(num_tiles);
+    std::memcpy(height_map->_tiles.data(), file.getData() + sizeof(Header), num_tiles * sizeof(TileInfo));
+    // Validate all tiles once, so that decoding needs no further checks
+    for (int tile_z = 0; tile_z < height_map->_numTiles.y; tile_z++) {
+      for (int tile_x = 0; tile_x < height_map->_numTiles.x; tile_x++) {
+        const TileInfo& info = height_map->getTileInfo(tile_x, tile_z);
+        if ((info._encoding != Encoding::Raw16 && info._encoding != Encoding::Delta8) || info._offset % 2 || info._offset > header->_dataSize ||
+          getEncodedSize(info._encoding, height_map->getTileExtent(tile_x, tile_z)) > header->_dataSize - info._offset) {
+          std::cout << "CompressedHeightMap::load() " << path << " contains tiles outside of the data" << std::endl;
+          return nullptr;
+        }
+      }
+    }
+    height_map->_data.resize(header->_dataSize);
+    std::memcpy(height_map->_data.data(), file.getData() + sizeof(Header) + num_tiles * sizeof(TileInfo), header->_dataSize);
+    return height_map;
+  }
+
+  float CompressedHeightMap::getHeight(int x, int z) const
+  {
+    x = glm::clamp(x, 0, _size.x - 1);
+    z = glm::clamp(z, 0, _size.y - 1);
+    int tile_x = x / _tileSize;
+    int tile_z = z / _tileSize;
+    const TileInfo& info = _tiles[tile_z * _numTiles.x + tile_x];
+    glm::ivec2 extent = getTileExtent(tile_x, tile_z);
+    x -= tile_x * _tileSize;
+    z -= tile_z * _tileSize;
+    const uint8_t* data = _data.data() + info._offset;
+    if (info._encoding == Encoding::Raw16) {
+      return info._min + reinterpret_cast<const uint16_t*>(data)[z * extent.x + x] * info._step;
+    }
+    int value = reinterpret_cast<const uint16_t*>(data)[z];
+    auto deltas = reinterpret_cast<const int8_t*>(data + extent.y * sizeof(uint16_t)) + z * (extent.x - 1);
+    for (int i = 0; i < x; i++) {
+      value += deltas[i];
+    }
+    return info._min + value * info._step;
+  }
+
+  void CompressedHeightMap::decode(const glm::ivec2& pos, const glm::ivec2& size, float* dst, size_t row_stride) const
+  {
+    glm::ivec2 begin = glm::clamp(pos, glm::ivec2(0), _size);
+    glm::ivec2 end = glm::clamp(pos + size, glm::ivec2(0), _size);
+    if (begin.x >= end.x || begin.y >= end.y) {
+      return;
+    }
+    std::vector<float> row(_tileSize);
+    for (int tile_z = begin.y / _tileSize; tile_z <= (end.y - 1) / _tileSize; tile_z++) {
+      for (int tile_x = begin.x / _tileSize; tile_x <= (end.x - 1) / _tileSize; tile_x++) {
+        const TileInfo& info = _tiles[tile_z * _numTiles.x + tile_x];
+        glm::ivec2 extent = getTileExtent(tile_x, tile_z);
+        glm::ivec2 tile_pos = glm::ivec2(tile_x, tile_z) * _tileSize;
+        int x_begin = (std::max)(begin.x - tile_pos.x, 0);
+        int x_end = (std::min)(end.x - tile_pos.x, extent.x);
+        for (int z = (std::max)(begin.y - tile_pos.y, 0); z < (std::min)(end.y - tile_pos.y, extent.y); z++) {
+          decodeRow(info, extent, z, x_end - 1, row.data());
+          float* dst_row = dst + (tile_pos.y + z - pos.y) * row_stride + (tile_pos.x - pos.x);
+          std::copy(row.begin() + x_begin, row.begin() + x_end, dst_row + x_begin);
+        }
+      }
+    }
+  }
+
+  std::vector<float> CompressedHeightMap::decode() const
+  {
+    std::vector<float> heights(static_cast<size_t>(_size.x) * _size.y);
+    parallelFor(0, _tiles.size(), [this, &heights](size_t i) {
+      glm::ivec2 tile_pos = glm::ivec2(static_cast<int>(i) % _numTiles.x, static_cast<int>(i) / _numTiles.x) * _tileSize;
+      decode(tile_pos, glm::ivec2(_tileSize), heights.data() + tile_pos.y * _size.x + tile_pos.x, _size.x);
+    });
+    return heights;
+  }
+
+  const glm::ivec2& CompressedHeightMap::getSize() const
+  {
+    return _size;
+  }
+
+  int CompressedHeightMap::getTileSize() const
+  {
+    return _tileSize;
+  }
+
+  const CompressedHeightMap::TileInfo& CompressedHeightMap::getTileInfo(int tile_x, int tile_z) const
+  {
+    return _tiles[tile_z * _numTiles.x + tile_x];
+  }
+
+  size_t CompressedHeightMap::getMemorySize() const
+  {
+    return _tiles.size() * sizeof(TileInfo) + _data.size();
+  }
+
+  glm::ivec2 CompressedHeightMap::getTileExtent(int tile_x, int tile_z) const
+  {
+    return glm::min(_size - glm::ivec2(tile_x, tile_z) * _tileSize, glm::ivec2(_tileSize));
+  }
+
+  size_t CompressedHeightMap::getEncodedSize(Encoding encoding, const glm::ivec2& extent)
+  {
+    size_t num_rows = static_cast<size_t>(extent.y);
+    return encoding == Encoding::Raw16 ? num_rows * extent.x * sizeof(uint16_t) : num_rows * sizeof(uint16_t) + num_rows * (extent.x - 1);
+  }
+
+  void CompressedHeightMap::decodeRow(const TileInfo& info, const glm::ivec2& extent, int z, int x_end, float* dst) const
+  {
+    const uint8_t* data = _data.data() + info._offset;
+    if (info._encoding == Encoding::Raw16) {
+      const uint16_t* row = reinterpret_cast<const uint16_t*>(data) + z * extent.x;
+      for (int x = 0; x <= x_end; x++) {
+        dst[x] = info._min + row[x] * info._step;
+      }
+      return;
+    }
+    int value = reinterpret_cast<const uint16_t*>(data)[z];
+    auto deltas = reinterpret_cast<const int8_t*>(data + extent.y * sizeof(uint16_t)) + z * (extent.x - 1);
+    dst[0] = info._min + value * info._step;
+    for (int x = 1; x <= x_end; x++) {
+      value += deltas[x - 1];
+      dst[x] = info._min + value * info._step;
+    }
+  }
+}
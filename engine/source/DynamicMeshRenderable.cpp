@@ -35,7 +35,7 @@ namespace fly
   }
   const Mat3f& DynamicMeshRenderable::getModelMatrixInverse()
   {
-    _modelMatrixInverse = inverse(glm::mat3(_modelMatrix));
+    _modelMatrixInverse = inverse(upperLeft(_modelMatrix));
     return _modelMatrixInverse;
   }
   AABB* DynamicMeshRenderable::getAABBWorld()
@@ -1,24 +1,43 @@
 #include <Engine.h>
 #include <System.h>
+#include <TransformSystem.h>
+#include <Transform.h>
+#include <ThreadPool.h>
+#include <algorithm>
 
 namespace fly
 {
-  Engine::Engine()
+  Engine::Engine() : _transformSystem(std::make_shared<TransformSystem>()), _scheduler(std::make_unique<SystemScheduler>(ThreadPool::getShared()))
   {
+    addSystem(_transformSystem);
   }
   void Engine::addSystem(const std::shared_ptr<System>& system)
   {
-    _systems.insert(system);
+    if (std::find(_systems.begin(), _systems.end(), system) != _systems.end()) {
+      return;
+    }
+    if (system != _transformSystem && system->getWrites().count(typeid(Transform))) {
+      _systems.insert(std::find(_systems.begin(), _systems.end(), _transformSystem), system);
+    }
+    else {
+      _systems.push_back(system);
+    }
     _em->addListener(system);
+    _scheduler->setSystems(_systems);
   }
   void Engine::update(float time, float delta_time)
   {
-    for (auto& s : _systems) {
-      s->update(time, delta_time);
-    }
+    // Component changes made by systems running in parallel are forwarded to the listeners once all systems are done
+    _em->beginDeferredNotifications();
+    _scheduler->update(time, delta_time);
+    _em->endDeferredNotifications();
   }
   EntityManager* Engine::getEntityManager() const
   {
     return _em.get();
   }
+  const std::vector<SystemScheduler::SystemTiming>& Engine::getSystemTimings() const
+  {
+    return _scheduler->getTimings();
+  }
 }
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include "Entity.h"
 #include "EntityManager.h"
 #include "Component.h"
+#include <set>
 
 namespace fly
 {
@@ -9,7 +10,11 @@ namespace fly
   }
   Entity::~Entity()
   {
+    std::set<std::type_index> types;
+    for (const auto& c : _components) {
+      types.insert(c.first);
+    }
     _components.clear();
-    _em->notifyListeners(this);
+    _em->notifyListenersDestroyed(this, types);
   }
 }
\ No newline at end of file
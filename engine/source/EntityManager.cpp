@@ -3,9 +3,14 @@
 #include <vector>
 #include "System.h"
 #include <iostream>
+#include <algorithm>
 
 namespace fly
 {
+  EntityManager::~EntityManager()
+  {
+    _entities.clear(); // Entities notify the manager on destruction, so they have to go first
+  }
   std::shared_ptr<Entity> EntityManager::createEntity()
   {
     auto e = std::make_shared<Entity>(this);
@@ -16,18 +21,74 @@ namespace fly
   {
     _entities.erase(entity);
   }
+  std::vector<Entity*> EntityManager::getEntities() const
+  {
+    std::vector<Entity*> entities;
+    for (const auto& e : _entities) {
+      entities.push_back(e.first);
+    }
+    return entities;
+  }
   void EntityManager::addListener(const std::weak_ptr<System>& listener)
   {
     _listeners.insert(listener);
   }
-  void EntityManager::notifyListeners(Entity* entity)
+  void EntityManager::notifyListeners(Entity* entity, const std::type_index& changed_type)
+  {
+    if (_deferred) {
+      std::lock_guard<std::mutex> lock(_deferredMutex);
+      auto it = _deferredChanges.find(entity);
+      if (it == _deferredChanges.end()) {
+        _deferredEntities.push_back(entity);
+        _deferredChanges[entity] = { changed_type };
+      }
+      else {
+        it->second.insert(changed_type);
+      }
+      return;
+    }
+    notifyListenersImmediately(entity, { changed_type });
+  }
+  void EntityManager::notifyListenersDestroyed(Entity* entity, const std::set<std::type_index>& changed_types)
+  {
+    auto types = changed_types;
+    {
+      std::lock_guard<std::mutex> lock(_deferredMutex);
+      auto it = _deferredChanges.find(entity);
+      if (it != _deferredChanges.end()) {
+        types.insert(it->second.begin(), it->second.end());
+        _deferredChanges.erase(it);
+        _deferredEntities.erase(std::find(_deferredEntities.begin(), _deferredEntities.end(), entity));
+      }
+    }
+    notifyListenersImmediately(entity, types);
+  }
+  void EntityManager::beginDeferredNotifications()
+  {
+    _deferred = true;
+  }
+  void EntityManager::endDeferredNotifications()
+  {
+    _deferred = false;
+    std::vector<Entity*> entities;
+    std::map<Entity*, std::set<std::type_index>> changes;
+    {
+      std::lock_guard<std::mutex> lock(_deferredMutex);
+      entities.swap(_deferredEntities);
+      changes.swap(_deferredChanges);
+    }
+    for (auto e : entities) {
+      notifyListenersImmediately(e, changes[e]);
+    }
+  }
+  void EntityManager::notifyListenersImmediately(Entity* entity, const std::set<std::type_index>& changed_types)
   {
     std::vector<std::weak_ptr<System>> to_delete;
     if (_listeners.size()) {
       for (const auto& l : _listeners) {
         auto listener = l.lock();
         if (listener) {
-          listener->onComponentsChanged(entity);
+          listener->onComponentTypesChanged(entity, changed_types);
         }
         else {
           to_delete.push_back(l);
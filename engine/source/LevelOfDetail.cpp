@@ -1,6 +1,7 @@
 #include <LevelOfDetail.h>
 #include <Model.h>
 #include <Mesh.h>
+#include <ParallelFor.h>
 
 namespace fly
 {
@@ -33,4 +34,20 @@ namespace fly
 
     return ret;
   }
-}
\ No newline at end of file
+
+  std::vector<std::shared_ptr<Model>> LevelOfDetail::generateLODsWithSimplification(const std::shared_ptr<Model>& model, const std::vector<float>& triangle_ratios,
+    const MeshSimplifier::Settings& settings)
+  {
+    std::vector<std::shared_ptr<Model>> ret = { model };
+    const auto& source_meshes = model->getMeshes();
+    for (auto ratio : triangle_ratios) {
+      std::vector<std::shared_ptr<Mesh>> meshes(source_meshes.size());
+      parallelFor(0, meshes.size(), [&](size_t i) {
+        meshes[i] = MeshSimplifier::simplify(*source_meshes[i], ratio, settings);
+      });
+      ret.push_back(std::make_shared<Model>(meshes, model->getMaterials()));
+    }
+
+    return ret;
+  }
+}
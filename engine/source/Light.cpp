@@ -1,5 +1,6 @@
 #include "Light.h"
 #include "RenderingSystem.h"
+#include "GeometryGenerator.h"
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtx/transform.hpp>
@@ -30,10 +31,10 @@ namespace fly
 
   void SpotLight::getViewProjectionMatrix(glm::mat4& view_matrix, glm::mat4& projection_matrix)
   {
-    projection_matrix = glm::perspective(glm::radians(_umbraDegrees * 2.f), 1.f, _zNear, _zFar);
+    projection_matrix = perspectiveNO(radians(_umbraDegrees * 2.f), 1.f, _zNear, _zFar);
     glm::vec3 direction = normalize(_target - _pos);
     glm::vec3 up = cross(direction, normalize(direction + glm::vec3(1.f, 0.f, 0.f))); // arbitrary vector that is orthogonal to direction
-    view_matrix = glm::lookAt(glm::vec3(_pos), glm::vec3(_target), up);
+    view_matrix = lookAt(_pos, _target, Vec3f(up));
   }
 
   DirectionalLight::DirectionalLight(const Vec3f& color, const Vec3f& pos, const Vec3f& target) :
@@ -51,14 +52,15 @@ namespace fly
     Vec3f global_max(std::numeric_limits<float>::lowest());
     for (unsigned int i = 0; i < frustum_splits.size(); i++) {
       float near = i == 0 ? near_plane : frustum_splits[i - 1];
-      Mat4f projection_matrix = directx ? glm::perspectiveZO(glm::radians(fov_degrees), aspect_ratio, near, frustum_splits[i])
-        : glm::perspectiveNO(glm::radians(fov_degrees), aspect_ratio, near, frustum_splits[i]);
+      Mat4f projection_matrix = directx ? perspectiveZO(radians(fov_degrees), aspect_ratio, near, frustum_splits[i])
+        : perspectiveNO(radians(fov_degrees), aspect_ratio, near, frustum_splits[i]);
       Mat4f p_inverse = inverse(projection_matrix);
       auto vp_inverse_v_light = view_matrix_light * view_matrix_inverse * p_inverse;
 
-      float near_ndc = directx ? 0.f : (-1.f);
-      std::array<Vec3f, 8> cube_ndc = { Vec3f(-1.f, -1.f, near_ndc), Vec3f(1.f, -1.f, near_ndc), Vec3f(-1.f, 1.f, near_ndc), Vec3f(-1.f, -1.f, 1.f),
-        Vec3f(1.f, 1.f, near_ndc), Vec3f(1.f, -1.f, 1.f), Vec3f(-1.f, 1.f, 1.f), Vec3f(1.f, 1.f, 1.f) };
+      static constexpr std::array<Vec3f, 8> cube_ndc_gl = GeometryGenerator::getCubeVertices(-1.f);
+      static constexpr std::array<Vec3f, 8> cube_ndc_dx = GeometryGenerator::getCubeVertices(0.f);
+      static_assert((cube_ndc_gl[7] - cube_ndc_gl[0])[2] == 2.f && (cube_ndc_dx[7] - cube_ndc_dx[0])[2] == 1.f, "NDC depth is [-1, 1] for OpenGL and [0, 1] for DirectX");
+      const auto& cube_ndc = directx ? cube_ndc_dx : cube_ndc_gl;
 
       std::array<Vec3f, 8> cam_frustum_light_space, cam_frustum_view_space;
       Vec3f light_space_frustum_center(0.f);
@@ -89,21 +91,21 @@ namespace fly
       bb_min = floor(bb_min / units_per_texel) * units_per_texel;
       bb_max = ceil(bb_max / units_per_texel) * units_per_texel;
 
-      vp.push_back(Mat4f(directx ? glm::orthoZO(bb_min[0], bb_max[0], bb_min[1], bb_max[1], bb_min[2], bb_max[2])
-        : glm::orthoNO(bb_min[0], bb_max[0], bb_min[1], bb_max[1], bb_min[2], bb_max[2])) * view_matrix_light);
+      vp.push_back((directx ? orthoZO(bb_min[0], bb_max[0], bb_min[1], bb_max[1], bb_min[2], bb_max[2])
+        : orthoNO(bb_min[0], bb_max[0], bb_min[1], bb_max[1], bb_min[2], bb_max[2])) * view_matrix_light);
 
       global_min = minimum(global_min, bb_min);
       global_max = maximum(global_max, bb_max);
     }
 
-    return Mat4f(directx ? glm::orthoZO(global_min[0], global_max[0], global_min[1], global_max[1], global_min[2], global_max[2])
-      : glm::orthoNO(global_min[0], global_max[0], global_min[1], global_max[1], global_min[2], global_max[2])) * view_matrix_light;
+    return (directx ? orthoZO(global_min[0], global_max[0], global_min[1], global_max[1], global_min[2], global_max[2])
+      : orthoNO(global_min[0], global_max[0], global_min[1], global_max[1], global_min[2], global_max[2])) * view_matrix_light;
   }
 
   glm::mat4 DirectionalLight::getViewMatrix()
   {
     auto dir = normalize(_target - _pos);
-    return glm::lookAt(glm::vec3(_pos), glm::vec3(_target), normalize(glm::vec3(-dir[1], dir[0], 0.f)));
+    return lookAt(_pos, _target, normalize(Vec3f(-dir[1], dir[0], 0.f)));
   }
 
   PointLight::PointLight(const Vec3f& color, const Vec3f& pos, const Vec3f& target, float near, float far) : Light(color, pos, target), _zNear(near), _zFar(far)
@@ -112,13 +114,13 @@ namespace fly
   }
   void PointLight::getViewProjectionMatrices(std::vector<glm::mat4>& vp)
   {
-    auto projection_matrix = glm::perspective(glm::radians(90.f), 1.f, _zNear, _zFar);
-
-    vp.push_back(projection_matrix * glm::lookAt(glm::vec3(_pos), glm::vec3(_pos) + glm::vec3(1.f, 0.f, 0.f), glm::vec3(0.f, -1.f, 0.f)));
-    vp.push_back(projection_matrix * glm::lookAt(glm::vec3(_pos), glm::vec3(_pos) + glm::vec3(-1.f, 0.f, 0.f), glm::vec3(0.f, -1.f, 0.f)));
-    vp.push_back(projection_matrix * glm::lookAt(glm::vec3(_pos), glm::vec3(_pos) + glm::vec3(0.f, 1.f, 0.f), glm::vec3(0.f, 0.f, 1.f)));
-    vp.push_back(projection_matrix * glm::lookAt(glm::vec3(_pos), glm::vec3(_pos) + glm::vec3(0.f, -1.f, 0.f), glm::vec3(0.f, 0.f, -1.f)));
-    vp.push_back(projection_matrix * glm::lookAt(glm::vec3(_pos), glm::vec3(_pos) + glm::vec3(0.f, 0.f, 1.f), glm::vec3(0.f, -1.f, 0.f)));
-    vp.push_back(projection_matrix * glm::lookAt(glm::vec3(_pos), glm::vec3(_pos) + glm::vec3(0.f, 0.f, -1.f), glm::vec3(0.f, -1.f, 0.f)));
+    auto projection_matrix = perspectiveNO(radians(90.f), 1.f, _zNear, _zFar);
+
+    vp.push_back(projection_matrix * lookAt(_pos, _pos + Vec3f(1.f, 0.f, 0.f), Vec3f(0.f, -1.f, 0.f)));
+    vp.push_back(projection_matrix * lookAt(_pos, _pos + Vec3f(-1.f, 0.f, 0.f), Vec3f(0.f, -1.f, 0.f)));
+    vp.push_back(projection_matrix * lookAt(_pos, _pos + Vec3f(0.f, 1.f, 0.f), Vec3f(0.f, 0.f, 1.f)));
+    vp.push_back(projection_matrix * lookAt(_pos, _pos + Vec3f(0.f, -1.f, 0.f), Vec3f(0.f, 0.f, -1.f)));
+    vp.push_back(projection_matrix * lookAt(_pos, _pos + Vec3f(0.f, 0.f, 1.f), Vec3f(0.f, -1.f, 0.f)));
+    vp.push_back(projection_matrix * lookAt(_pos, _pos + Vec3f(0.f, 0.f, -1.f), Vec3f(0.f, -1.f, 0.f)));
   }
 }
\ No newline at end of file
@@ -0,0 +1,85 @@
+#include <MappedFile.h>
+#include <iostream>
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace fly
+{
+#ifdef _WIN32
+  MappedFile::MappedFile(const std::string& path)
+  {
+    _file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, nullptr);
+    if (_file == INVALID_HANDLE_VALUE) {
+      std::cout << "MappedFile::MappedFile() Failed to open " << path << std::endl;
+      return;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(_file, &size) || !size.QuadPart) {
+      return;
+    }
+    _mapping = CreateFileMappingA(_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (_mapping) {
+      _data = static_cast<const unsigned char*>(MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0));
+      _size = _data ? static_cast<size_t>(size.QuadPart) : 0;
+    }
+    if (!_data) {
+      std::cout << "MappedFile::MappedFile() Failed to map " << path << std::endl;
+    }
+  }
+  MappedFile::~MappedFile()
+  {
+    if (_data) {
+      UnmapViewOfFile(_data);
+    }
+    if (_mapping) {
+      CloseHandle(_mapping);
+    }
+    if (_file != INVALID_HANDLE_VALUE) {
+      CloseHandle(_file);
+    }
+  }
+#else
+  MappedFile::MappedFile(const std::string& path)
+  {
+    _file = open(path.c_str(), O_RDONLY);
+    if (_file < 0) {
+      std::cout << "MappedFile::MappedFile() Failed to open " << path << std::endl;
+      return;
+    }
+    struct stat st;
+    if (fstat(_file, &st) || !st.st_size) {
+      return;
+    }
+    void* data = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, _file, 0);
+    if (data == MAP_FAILED) {
+      std::cout << "MappedFile::MappedFile() Failed to map " << path << std::endl;
+      return;
+    }
+    _data = static_cast<const unsigned char*>(data);
+    _size = static_cast<size_t>(st.st_size);
+  }
+  MappedFile::~MappedFile()
+  {
+    if (_data) {
+      munmap(const_cast<unsigned char*>(_data), _size);
+    }
+    if (_file >= 0) {
+      close(_file);
+    }
+  }
+#endif
+  const unsigned char* MappedFile::getData() const
+  {
+    return _data;
+  }
+  size_t MappedFile::getSize() const
+  {
+    return _size;
+  }
+}
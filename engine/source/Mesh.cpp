@@ -6,6 +6,7 @@
 #include <glm/gtx/string_cast.hpp>
 #include <AABB.h>
 #include <math/FlyMath.h>
+#include <math/Batch.h>
 
 
 namespace fly
@@ -16,13 +17,16 @@ namespace fly
   Mesh::Mesh(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices, unsigned int material_index) :
     _vertices(vertices), _indices(indices), _materialIndex(material_index)
   {
-    Vec3f bb_min(std::numeric_limits<float>::max());
-    Vec3f bb_max(std::numeric_limits<float>::lowest());
-    for (auto& v : _vertices) {
-      bb_min = minimum(bb_min, v._position);
-      bb_max = maximum(bb_max, v._position);
-    }
-    _aabb = std::make_unique<AABB>(bb_min, bb_max);
+    computeAABB();
+  }
+  Mesh::Mesh(std::vector<Vertex>&& vertices, std::vector<unsigned int>&& indices, unsigned int material_index) :
+    _vertices(std::move(vertices)), _indices(std::move(indices)), _materialIndex(material_index)
+  {
+    computeAABB();
+  }
+  Mesh::Mesh(const Vertex* vertices, size_t num_vertices, const unsigned int* indices, size_t num_indices, unsigned int material_index, const AABB& aabb) :
+    _vertices(vertices, vertices + num_vertices), _indices(indices, indices + num_indices), _materialIndex(material_index), _aabb(std::make_unique<AABB>(aabb))
+  {
   }
   const std::vector<Vertex>& Mesh::getVertices() const
   {
@@ -61,4 +65,21 @@ namespace fly
   {
     return _material;
   }
-}
\ No newline at end of file
+  void Mesh::setVertexFormat(unsigned format)
+  {
+    _vertexFormat = format;
+  }
+  unsigned Mesh::getVertexFormat() const
+  {
+    return _vertexFormat;
+  }
+  void Mesh::computeAABB()
+  {
+    Vec3f bb_min(std::numeric_limits<float>::max());
+    Vec3f bb_max(std::numeric_limits<float>::lowest());
+    if (_vertices.size()) {
+      minMaxReduce(&_vertices[0]._position, _vertices.size(), sizeof(Vertex), bb_min, bb_max);
+    }
+    _aabb = std::make_unique<AABB>(bb_min, bb_max);
+  }
+}
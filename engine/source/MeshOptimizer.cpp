@@ -0,0 +1,221 @@
+#include <MeshOptimizer.h>
+#include <Mesh.h>
+#include <algorithm>
+#include <numeric>
+
+namespace fly
+{
+  namespace
+  {
+    /**
+    * Triangles adjacent to each vertex in compressed row form.
+    */
+    struct Adjacency
+    {
+      std::vector<unsigned> _offsets;
+      std::vector<unsigned> _triangles;
+      Adjacency(const std::vector<unsigned>& indices, size_t num_vertices) : _offsets(num_vertices + 1, 0), _triangles(indices.size())
+      {
+        for (auto i : indices) {
+          _offsets[i + 1]++;
+        }
+        std::partial_sum(_offsets.begin(), _offsets.end(), _offsets.begin());
+        std::vector<unsigned> fill(_offsets.begin(), _offsets.end() - 1);
+        for (size_t i = 0; i < indices.size(); i++) {
+          _triangles[fill[indices[i]]++] = static_cast<unsigned>(i / 3);
+        }
+      }
+    };
+  }
+
+  MeshOptimizer::CacheStats MeshOptimizer::analyzeVertexCache(const std::vector<unsigned>& indices, size_t num_vertices, unsigned cache_size)
+  {
+    // A vertex is in the FIFO cache if it was inserted less than cache_size misses ago
+    std::vector<size_t> inserted(num_vertices, 0);
+    std::vector<bool> referenced(num_vertices, false);
+    size_t misses = 0;
+    size_t num_referenced = 0;
+    for (auto i : indices) {
+      if (!inserted[i] || misses - inserted[i] >= cache_size) {
+        misses++;
+        inserted[i] = misses;
+      }
+      if (!referenced[i]) {
+        referenced[i] = true;
+        num_referenced++;
+      }
+    }
+    size_t num_triangles = indices.size() / 3;
+    return { num_triangles ? static_cast<float>(misses) / num_triangles : 0.f, num_referenced ? static_cast<float>(misses) / num_referenced : 0.f };
+  }
+
+  void MeshOptimizer::optimizeVertexCache(std::vector<unsigned>& indices, size_t num_vertices, unsigned cache_size)
+  {
+    size_t num_triangles = indices.size() / 3;
+    if (!num_triangles || !num_vertices) {
+      return;
+    }
+    Adjacency adjacency(indices, num_vertices);
+    std::vector<unsigned> live(num_vertices);
+    for (size_t v = 0; v < num_vertices; v++) {
+      live[v] = adjacency._offsets[v + 1] - adjacency._offsets[v];
+    }
+    std::vector<unsigned> cache_time(num_vertices, 0);
+    std::vector<bool> emitted(num_triangles, false);
+    std::vector<unsigned> dead_end;
+    std::vector<unsigned> candidates;
+    std::vector<unsigned> result;
+    result.reserve(num_triangles * 3);
+    unsigned time = cache_size + 1;
+    size_t cursor = 0;
+    int fanning = 0;
+    while (fanning >= 0) {
+      candidates.clear();
+      for (unsigned a = adjacency._offsets[fanning]; a < adjacency._offsets[fanning + 1]; a++) {
+        unsigned t = adjacency._triangles[a];
+        if (emitted[t]) {
+          continue;
+        }
+        emitted[t] = true;
+        for (unsigned j = 0; j < 3; j++) {
+          unsigned v = indices[t * 3 + j];
+          result.push_back(v);
+          dead_end.push_back(v);
+          candidates.push_back(v);
+          live[v]--;
+          if (time - cache_time[v] > cache_size) {
+            cache_time[v] = time++;
+          }
+        }
+      }
+      // Prefer the candidate that entered the cache first among those which stay in the cache while fanning
+      fanning = -1;
+      int best_priority = -1;
+      for (auto v : candidates) {
+        if (live[v]) {
+          int priority = 0;
+          if (time - cache_time[v] + 2 * live[v] <= cache_size) {
+            priority = time - cache_time[v];
+          }
+          if (priority > best_priority) {
+            best_priority = priority;
+            fanning = v;
+          }
+        }
+      }
+      while (fanning < 0 && dead_end.size()) {
+        unsigned v = dead_end.back();
+        dead_end.pop_back();
+        if (live[v]) {
+          fanning = v;
+        }
+      }
+      while (fanning < 0 && cursor < num_vertices) {
+        if (live[cursor]) {
+          fanning = static_cast<int>(cursor);
+        }
+        cursor++;
+      }
+    }
+    indices.swap(result);
+  }
+
+  void MeshOptimizer::optimizeOverdraw(std::vector<unsigned>& indices, const std::vector<Vertex>& vertices, unsigned cache_size)
+  {
+    size_t num_triangles = indices.size() / 3;
+    if (!num_triangles) {
+      return;
+    }
+    // Hard cluster boundaries: triangles whose vertices all miss the simulated cache
+    std::vector<unsigned> cluster_begins;
+    std::vector<size_t> inserted(vertices.size(), 0);
+    size_t misses = 0;
+    for (size_t t = 0; t < num_triangles; t++) {
+      unsigned triangle_misses = 0;
+      for (unsigned j = 0; j < 3; j++) {
+        unsigned v = indices[t * 3 + j];
+        if (!inserted[v] || misses - inserted[v] >= cache_size) {
+          misses++;
+          inserted[v] = misses;
+          triangle_misses++;
+        }
+      }
+      if (triangle_misses == 3 || t == 0) {
+        cluster_begins.push_back(static_cast<unsigned>(t));
+      }
+    }
+    cluster_begins.push_back(static_cast<unsigned>(num_triangles));
+
+    Vec3f mesh_center(0.f);
+    for (const auto& v : vertices) {
+      mesh_center += v._position;
+    }
+    mesh_center /= static_cast<float>((std::max)(vertices.size(), size_t(1)));
+    size_t num_clusters = cluster_begins.size() - 1;
+    std::vector<float> sort_keys(num_clusters);
+    for (size_t c = 0; c < num_clusters; c++) {
+      // Area weighted centroid and normal of the cluster
+      Vec3f center(0.f), normal(0.f);
+      float area = 0.f;
+      for (unsigned t = cluster_begins[c]; t < cluster_begins[c + 1]; t++) {
+        const Vec3f& p0 = vertices[indices[t * 3]]._position;
+        const Vec3f& p1 = vertices[indices[t * 3 + 1]]._position;
+        const Vec3f& p2 = vertices[indices[t * 3 + 2]]._position;
+        Vec3f n = cross(p1 - p0, p2 - p0);
+        float a = n.length();
+        center += (p0 + p1 + p2) * (a / 3.f);
+        normal += n;
+        area += a;
+      }
+      if (area > 0.f) {
+        center /= area;
+      }
+      float normal_length = normal.length();
+      sort_keys[c] = normal_length > 0.f ? dot(center - mesh_center, normal / normal_length) : 0.f;
+    }
+    std::vector<unsigned> order(num_clusters);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&sort_keys](unsigned a, unsigned b) {
+      return sort_keys[a] > sort_keys[b];
+    });
+    std::vector<unsigned> result;
+    result.reserve(indices.size());
+    for (auto c : order) {
+      result.insert(result.end(), indices.begin() + cluster_begins[c] * 3, indices.begin() + cluster_begins[c + 1] * 3);
+    }
+    indices.swap(result);
+  }
+
+  std::vector<unsigned> MeshOptimizer::optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<unsigned>& indices)
+  {
+    std::vector<unsigned> remap(vertices.size(), ~0u);
+    std::vector<Vertex> result;
+    result.reserve(vertices.size());
+    for (auto& i : indices) {
+      if (remap[i] == ~0u) {
+        remap[i] = static_cast<unsigned>(result.size());
+        result.push_back(vertices[i]);
+      }
+      i = remap[i];
+    }
+    vertices.swap(result);
+    return remap;
+  }
+
+  void MeshOptimizer::optimize(Mesh& mesh, unsigned cache_size, CacheStats* before, CacheStats* after)
+  {
+    auto vertices = mesh.getVertices();
+    auto indices = mesh.getIndices();
+    if (before) {
+      *before = analyzeVertexCache(indices, vertices.size(), cache_size);
+    }
+    optimizeVertexCache(indices, vertices.size(), cache_size);
+    optimizeOverdraw(indices, vertices, cache_size);
+    optimizeVertexFetch(vertices, indices);
+    if (after) {
+      *after = analyzeVertexCache(indices, vertices.size(), cache_size);
+    }
+    mesh.setVertices(vertices);
+    mesh.setIndices(indices);
+  }
+}
@@ -0,0 +1,346 @@
+#include <MeshSimplifier.h>
+#include <MeshOptimizer.h>
+#include <Mesh.h>
+#include <algorithm>
+#include <numeric>
+#include <cmath>
+#include <cstdint>
+
+namespace fly
+{
+  namespace
+  {
+    /**
+    * Symmetric 4x4 matrix of the summed squared distances to a set of planes.
+    */
+    struct Quadric
+    {
+      double _a2 = 0., _ab = 0., _ac = 0., _ad = 0., _b2 = 0., _bc = 0., _bd = 0., _c2 = 0., _cd = 0., _d2 = 0.;
+      Quadric() = default;
+      Quadric(const Vec3f& n, float d, float weight) :
+        _a2(weight * n[0] * n[0]), _ab(weight * n[0] * n[1]), _ac(weight * n[0] * n[2]), _ad(weight * n[0] * d),
+        _b2(weight * n[1] * n[1]), _bc(weight * n[1] * n[2]), _bd(weight * n[1] * d),
+        _c2(weight * n[2] * n[2]), _cd(weight * n[2] * d), _d2(weight * d * d)
+      {
+      }
+      Quadric& operator+=(const Quadric& other)
+      {
+        _a2 += other._a2; _ab += other._ab; _ac += other._ac; _ad += other._ad; _b2 += other._b2;
+        _bc += other._bc; _bd += other._bd; _c2 += other._c2; _cd += other._cd; _d2 += other._d2;
+        return *this;
+      }
+      Quadric operator+(const Quadric& other) const
+      {
+        Quadric q = *this;
+        return q += other;
+      }
+      double evaluate(const Vec3f& p) const
+      {
+        double x = p[0], y = p[1], z = p[2];
+        double e = _a2 * x * x + _b2 * y * y + _c2 * z * z + 2. * (_ab * x * y + _ac * x * z + _bc * y * z + _ad * x + _bd * y + _cd * z) + _d2;
+        return (std::max)(e, 0.);
+      }
+    };
+    Vec3f triangleNormal(const Vec3f& p0, const Vec3f& p1, const Vec3f& p2)
+    {
+      return cross(p1 - p0, p2 - p0);
+    }
+    uint64_t edgeKey(unsigned a, unsigned b)
+    {
+      return a < b ? (static_cast<uint64_t>(a) << 32) | b : (static_cast<uint64_t>(b) << 32) | a;
+    }
+    bool sameAttributes(const Vertex& a, const Vertex& b)
+    {
+      for (unsigned i = 0; i < 3; i++) {
+        if (a._normal[i] != b._normal[i] || a._tangent[i] != b._tangent[i] || a._bitangent[i] != b._bitangent[i] || (i < 2 && a._uv[i] != b._uv[i])) {
+          return false;
+        }
+      }
+      return true;
+    }
+    struct Collapse
+    {
+      float _cost;
+      unsigned _source;
+      unsigned _target;
+    };
+  }
+
+  std::vector<unsigned> MeshSimplifier::simplify(const std::vector<Vertex>& vertices, const std::vector<unsigned>& indices, size_t target_num_indices,
+    const Settings& settings, float* error)
+  {
+    std::vector<unsigned> result = indices;
+    if (error) {
+      *error = 0.f;
+    }
+    size_t num_vertices = vertices.size();
+    if (result.size() <= target_num_indices || !num_vertices) {
+      return result;
+    }
+
+    // Vertices at the same position share an id. Those with equal attributes as well are welded, the others
+    // split the position into wedges: two wedges lie on a UV or normal seam and move together, more are locked.
+    std::vector<unsigned> order(num_vertices);
+    std::iota(order.begin(), order.end(), 0);
+    auto less = [&vertices](unsigned a, unsigned b) {
+      const Vec3f& pa = vertices[a]._position;
+      const Vec3f& pb = vertices[b]._position;
+      return pa[0] != pb[0] ? pa[0] < pb[0] : (pa[1] != pb[1] ? pa[1] < pb[1] : pa[2] < pb[2]);
+    };
+    std::sort(order.begin(), order.end(), less);
+    std::vector<unsigned> position_id(num_vertices);
+    std::vector<unsigned> canonical(num_vertices);
+    std::vector<unsigned> partner(num_vertices);
+    std::vector<bool> locked(num_vertices, false);
+    std::vector<unsigned> wedges;
+    for (size_t begin = 0, end; begin < num_vertices; begin = end) {
+      for (end = begin + 1; end < num_vertices && !less(order[begin], order[end]); end++) {}
+      wedges.clear();
+      for (size_t i = begin; i < end; i++) {
+        unsigned v = order[i];
+        position_id[v] = order[begin];
+        auto wedge = std::find_if(wedges.begin(), wedges.end(), [&](unsigned w) {
+          return sameAttributes(vertices[v], vertices[w]);
+        });
+        canonical[v] = wedge == wedges.end() ? v : *wedge;
+        if (wedge == wedges.end()) {
+          wedges.push_back(v);
+        }
+      }
+      for (auto w : wedges) {
+        partner[w] = wedges.size() == 2 ? wedges[wedges[0] == w] : w;
+        locked[w] = wedges.size() > 2;
+      }
+    }
+    size_t num_welded = 0;
+    for (size_t i = 0; i + 2 < result.size(); i += 3) {
+      unsigned a = canonical[result[i]], b = canonical[result[i + 1]], c = canonical[result[i + 2]];
+      if (a != b && b != c && c != a) {
+        result[num_welded++] = a;
+        result[num_welded++] = b;
+        result[num_welded++] = c;
+      }
+    }
+    result.resize(num_welded);
+
+    std::vector<Quadric> quadrics(num_vertices);
+    for (size_t i = 0; i + 2 < result.size(); i += 3) {
+      const Vec3f& p0 = vertices[result[i]]._position;
+      Vec3f n = triangleNormal(p0, vertices[result[i + 1]]._position, vertices[result[i + 2]]._position);
+      float area = n.length();
+      if (area > 0.f) {
+        n /= area;
+        Quadric q(n, -dot(n, p0), area * 0.5f);
+        for (unsigned j = 0; j < 3; j++) {
+          quadrics[position_id[result[i + j]]] += q;
+        }
+      }
+    }
+
+    // Edges of a single triangle are open borders
+    struct Edge
+    {
+      uint64_t _key;
+      unsigned _triangle;
+      unsigned _corner;
+    };
+    std::vector<Edge> edges;
+    for (size_t i = 0; i + 2 < result.size(); i += 3) {
+      for (unsigned j = 0; j < 3; j++) {
+        edges.push_back({ edgeKey(position_id[result[i + j]], position_id[result[i + (j + 1) % 3]]), static_cast<unsigned>(i / 3), j });
+      }
+    }
+    std::sort(edges.begin(), edges.end(), [](const Edge& a, const Edge& b) {
+      return a._key < b._key;
+    });
+    std::vector<bool> border_position(num_vertices, false);
+    for (size_t begin = 0, end; begin < edges.size(); begin = end) {
+      for (end = begin + 1; end < edges.size() && edges[end]._key == edges[begin]._key; end++) {}
+      if (end - begin > 1) {
+        continue;
+      }
+      unsigned t = edges[begin]._triangle;
+      unsigned a = result[t * 3 + edges[begin]._corner];
+      unsigned b = result[t * 3 + (edges[begin]._corner + 1) % 3];
+      border_position[position_id[a]] = border_position[position_id[b]] = true;
+      if (!settings._lockBorders) {
+        const Vec3f& pa = vertices[a]._position;
+        Vec3f edge = vertices[b]._position - pa;
+        Vec3f n = cross(edge, triangleNormal(pa, vertices[b]._position, vertices[result[t * 3 + (edges[begin]._corner + 2) % 3]]._position));
+        float length = n.length();
+        if (length > 0.f) {
+          n /= length;
+          Quadric q(n, -dot(n, pa), dot(edge, edge) * 10.f); // Strong enough to keep the silhouette of the border
+          quadrics[position_id[a]] += q;
+          quadrics[position_id[b]] += q;
+        }
+      }
+    }
+    if (settings._lockBorders) {
+      for (size_t v = 0; v < num_vertices; v++) {
+        locked[v] = locked[v] || border_position[position_id[v]];
+      }
+    }
+
+    auto collapseCost = [&](unsigned source, unsigned target) {
+      const Vertex& s = vertices[source];
+      const Vertex& t = vertices[target];
+      double cost = (quadrics[position_id[source]] + quadrics[position_id[target]]).evaluate(t._position);
+      Vec3f d = t._position - s._position;
+      Vec3f dn = t._normal - s._normal;
+      Vec2f duv = t._uv - s._uv;
+      cost += dot(d, d) * (settings._normalWeight * dot(dn, dn) + settings._uvWeight * (duv[0] * duv[0] + duv[1] * duv[1]));
+      return static_cast<float>(cost);
+    };
+
+    float max_cost = settings._maxError < std::sqrt(std::numeric_limits<float>::max()) ? settings._maxError * settings._maxError : std::numeric_limits<float>::max();
+    float max_performed = 0.f;
+    std::vector<unsigned> adjacency_offsets(num_vertices + 1);
+    std::vector<unsigned> adjacency;
+    std::vector<uint64_t> keys;
+    std::vector<Collapse> collapses;
+    std::vector<bool> touched(num_vertices);
+    std::vector<unsigned> remap(num_vertices);
+    while (result.size() > target_num_indices) {
+      // Triangles around each vertex
+      std::fill(adjacency_offsets.begin(), adjacency_offsets.end(), 0);
+      for (auto i : result) {
+        adjacency_offsets[i + 1]++;
+      }
+      std::partial_sum(adjacency_offsets.begin(), adjacency_offsets.end(), adjacency_offsets.begin());
+      adjacency.resize(result.size());
+      std::vector<unsigned> fill(adjacency_offsets.begin(), adjacency_offsets.end() - 1);
+      for (size_t i = 0; i < result.size(); i++) {
+        adjacency[fill[result[i]]++] = static_cast<unsigned>(i / 3);
+      }
+
+      keys.clear();
+      for (size_t i = 0; i + 2 < result.size(); i += 3) {
+        for (unsigned j = 0; j < 3; j++) {
+          keys.push_back(edgeKey(result[i + j], result[i + (j + 1) % 3]));
+        }
+      }
+      std::sort(keys.begin(), keys.end());
+      keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+      // A seam vertex only moves along the seam, its partner moves along the other side of it to the partner of the target
+      auto canCollapse = [&](unsigned source, unsigned target) {
+        return !locked[source] && position_id[source] != position_id[target] && (partner[source] == source ||
+          (partner[target] != target && std::binary_search(keys.begin(), keys.end(), edgeKey(partner[source], partner[target]))));
+      };
+      auto cost = [&](unsigned source, unsigned target) {
+        if (!canCollapse(source, target)) {
+          return std::numeric_limits<float>::infinity();
+        }
+        return partner[source] == source ? collapseCost(source, target) : (std::max)(collapseCost(source, target), collapseCost(partner[source], partner[target]));
+      };
+      collapses.clear();
+      for (auto key : keys) {
+        unsigned a = static_cast<unsigned>(key >> 32);
+        unsigned b = static_cast<unsigned>(key & 0xffffffff);
+        if (locked[a] && locked[b]) {
+          continue;
+        }
+        float cost_ab = cost(a, b);
+        float cost_ba = cost(b, a);
+        if ((std::min)(cost_ab, cost_ba) <= max_cost) {
+          collapses.push_back(cost_ab <= cost_ba ? Collapse{ cost_ab, a, b } : Collapse{ cost_ba, b, a });
+        }
+      }
+      std::stable_sort(collapses.begin(), collapses.end(), [](const Collapse& a, const Collapse& b) {
+        return a._cost < b._cost;
+      });
+
+      // Collapse the cheapest edges whose neighborhoods don't overlap, so that every flip test sees final positions
+      std::fill(touched.begin(), touched.end(), false);
+      std::iota(remap.begin(), remap.end(), 0);
+      size_t triangles_to_remove = (result.size() - target_num_indices + 2) / 3;
+      size_t removed = 0;
+      auto isValid = [&](unsigned source, unsigned target, unsigned& shared) {
+        const Vec3f& target_pos = vertices[target]._position;
+        for (unsigned a = adjacency_offsets[source]; a < adjacency_offsets[source + 1]; a++) {
+          const unsigned* tri = &result[adjacency[a] * 3];
+          if (tri[0] == target || tri[1] == target || tri[2] == target) {
+            shared++;
+            continue;
+          }
+          Vec3f p[3], p_new[3];
+          for (unsigned j = 0; j < 3; j++) {
+            if (tri[j] != source && touched[tri[j]]) {
+              return false;
+            }
+            p[j] = vertices[tri[j]]._position;
+            p_new[j] = tri[j] == source ? target_pos : p[j];
+          }
+          // Rotating by more than about 80 degrees flips the triangle or folds it onto its neighbors
+          Vec3f n = triangleNormal(p[0], p[1], p[2]);
+          Vec3f n_new = triangleNormal(p_new[0], p_new[1], p_new[2]);
+          if (dot(n, n_new) <= 0.2f * n.length() * n_new.length()) {
+            return false;
+          }
+        }
+        return true;
+      };
+      auto touchNeighbors = [&](unsigned source) {
+        for (unsigned a = adjacency_offsets[source]; a < adjacency_offsets[source + 1]; a++) {
+          for (unsigned j = 0; j < 3; j++) {
+            touched[result[adjacency[a] * 3 + j]] = true;
+          }
+        }
+      };
+      for (const auto& c : collapses) {
+        if (removed >= triangles_to_remove) {
+          break;
+        }
+        unsigned seam_source = partner[c._source], seam_target = partner[c._target];
+        bool seam = seam_source != c._source;
+        if (touched[c._source] || touched[c._target] || (seam && (touched[seam_source] || touched[seam_target]))) {
+          continue;
+        }
+        unsigned shared = 0;
+        if (!isValid(c._source, c._target, shared) || (seam && !isValid(seam_source, seam_target, shared))) {
+          continue;
+        }
+        touchNeighbors(c._source);
+        remap[c._source] = c._target;
+        if (seam) {
+          touchNeighbors(seam_source);
+          remap[seam_source] = seam_target;
+        }
+        quadrics[position_id[c._target]] += quadrics[position_id[c._source]];
+        removed += shared;
+        max_performed = (std::max)(max_performed, c._cost);
+      }
+      if (!removed) {
+        break;
+      }
+      size_t num_indices = 0;
+      for (size_t i = 0; i + 2 < result.size(); i += 3) {
+        unsigned a = remap[result[i]], b = remap[result[i + 1]], c = remap[result[i + 2]];
+        if (a != b && b != c && c != a) {
+          result[num_indices++] = a;
+          result[num_indices++] = b;
+          result[num_indices++] = c;
+        }
+      }
+      result.resize(num_indices);
+    }
+    if (error) {
+      *error = std::sqrt(max_performed);
+    }
+    return result;
+  }
+
+  std::shared_ptr<Mesh> MeshSimplifier::simplify(const Mesh& mesh, float ratio, const Settings& settings, float* error)
+  {
+    size_t target_num_indices = static_cast<size_t>(mesh.getIndices().size() / 3 * ratio) * 3;
+    auto indices = simplify(mesh.getVertices(), mesh.getIndices(), target_num_indices, settings, error);
+    auto vertices = mesh.getVertices();
+    MeshOptimizer::optimizeVertexCache(indices, vertices.size());
+    MeshOptimizer::optimizeOverdraw(indices, vertices);
+    MeshOptimizer::optimizeVertexFetch(vertices, indices);
+    auto result = std::make_shared<Mesh>(std::move(vertices), std::move(indices), mesh.getMaterialIndex());
+    result->setMaterial(mesh.getMaterial());
+    result->setVertexFormat(mesh.getVertexFormat());
+    return result;
+  }
+}
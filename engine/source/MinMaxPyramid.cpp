@@ -0,0 +1,234 @@
+#include <MinMaxPyramid.h>
+#include <ParallelFor.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+namespace fly
+{
+  namespace
+  {
+    bool intersectTriangle(const glm::vec3& origin, const glm::vec3& dir, const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2, float& t)
+    {
+      glm::vec3 e1 = v1 - v0;
+      glm::vec3 e2 = v2 - v0;
+      glm::vec3 p = glm::cross(dir, e2);
+      float det = glm::dot(e1, p);
+      if (std::abs(det) < 1e-12f) {
+        return false;
+      }
+      float inv_det = 1.f / det;
+      glm::vec3 s = origin - v0;
+      float u = glm::dot(s, p) * inv_det;
+      if (u < 0.f || u > 1.f) {
+        return false;
+      }
+      glm::vec3 q = glm::cross(s, e1);
+      float v = glm::dot(dir, q) * inv_det;
+      if (v < 0.f || u + v > 1.f) {
+        return false;
+      }
+      t = glm::dot(e2, q) * inv_det;
+      return true;
+    }
+  }
+
+  MinMaxPyramid::MinMaxPyramid(const float* heights, int width, int height, size_t row_stride) :
+    _heights(heights),
+    _rowStride(row_stride)
+  {
+    glm::ivec2 size(width, height);
+    _levelSizes.push_back(size);
+    size_t num_cells = 0;
+    while (size.x > 1 || size.y > 1) {
+      size = (size + 1) / 2;
+      _levelOffsets.push_back(num_cells);
+      _levelSizes.push_back(size);
+      num_cells += static_cast<size_t>(size.x) * size.y;
+    }
+    _cells.resize(num_cells);
+    if (_levelSizes.size() < 2) {
+      return;
+    }
+
+    const glm::ivec2& size_1 = _levelSizes[1];
+    parallelFor(0, size_1.y, [this, width, height, &size_1](size_t z) {
+      const float* rows[3];
+      for (int i = 0; i < 3; i++) {
+        rows[i] = _heights + (std::min)(static_cast<int>(z) * 2 + i, height - 1) * _rowStride;
+      }
+      MinMax* cell = &_cells[z * size_1.x];
+      for (int x = 0; x < size_1.x; x++, cell++) {
+        cell->_min = std::numeric_limits<float>::max();
+        cell->_max = std::numeric_limits<float>::lowest();
+        for (int i = 0; i < 3; i++) {
+          for (int j = 0; j < 3; j++) {
+            float h = rows[i][(std::min)(x * 2 + j, width - 1)];
+            cell->_min = (std::min)(cell->_min, h);
+            cell->_max = (std::max)(cell->_max, h);
+          }
+        }
+      }
+    });
+    for (unsigned level = 2; level < _levelSizes.size(); level++) {
+      const glm::ivec2& child_size = _levelSizes[level - 1];
+      const glm::ivec2& level_size = _levelSizes[level];
+      const MinMax* children = &_cells[_levelOffsets[level - 2]];
+      MinMax* cells = &_cells[_levelOffsets[level - 1]];
+      parallelFor(0, level_size.y, [children, cells, &child_size, &level_size](size_t z) {
+        const MinMax* row = children + z * 2 * child_size.x;
+        const MinMax* row_next = children + (std::min)(static_cast<int>(z) * 2 + 1, child_size.y - 1) * child_size.x;
+        MinMax* cell = cells + z * level_size.x;
+        for (int x = 0; x < level_size.x; x++, cell++) {
+          int x0 = x * 2;
+          int x1 = (std::min)(x0 + 1, child_size.x - 1);
+          cell->_min = (std::min)((std::min)(row[x0]._min, row[x1]._min), (std::min)(row_next[x0]._min, row_next[x1]._min));
+          cell->_max = (std::max)((std::max)(row[x0]._max, row[x1]._max), (std::max)(row_next[x0]._max, row_next[x1]._max));
+        }
+      });
+    }
+  }
+
+  unsigned MinMaxPyramid::getNumLevels() const
+  {
+    return static_cast<unsigned>(_levelSizes.size());
+  }
+
+  const glm::ivec2& MinMaxPyramid::getLevelSize(unsigned level) const
+  {
+    return _levelSizes[level];
+  }
+
+  MinMaxPyramid::MinMax MinMaxPyramid::getMinMax(unsigned level, int x, int z) const
+  {
+    const glm::ivec2& size = _levelSizes[level];
+    x = glm::clamp(x, 0, size.x - 1);
+    z = glm::clamp(z, 0, size.y - 1);
+    if (level) {
+      return _cells[_levelOffsets[level - 1] + z * size.x + x];
+    }
+    const float* row = _heights + z * _rowStride;
+    const float* row_next = _heights + (std::min)(z + 1, size.y - 1) * _rowStride;
+    int x_next = (std::min)(x + 1, size.x - 1);
+    return { (std::min)((std::min)(row[x], row[x_next]), (std::min)(row_next[x], row_next[x_next])),
+      (std::max)((std::max)(row[x], row[x_next]), (std::max)(row_next[x], row_next[x_next])) };
+  }
+
+  MinMaxPyramid::MinMax MinMaxPyramid::getMinMax(const glm::ivec2& pos, int size) const
+  {
+    unsigned level = 0;
+    while (level + 1 < _levelSizes.size() && (2 << level) <= size) {
+      level++;
+    }
+    glm::ivec2 cell_begin, cell_end;
+    for (int i = 0; i < 2; i++) {
+      int begin = (std::max)(pos[i], 0);
+      int end = (std::max)(pos[i] + size, 0);
+      cell_begin[i] = begin >> level;
+      cell_end[i] = (std::max)(cell_begin[i], (end - 1) >> level);
+    }
+    MinMax result = getMinMax(level, cell_begin.x, cell_begin.y);
+    for (int z = cell_begin.y; z <= cell_end.y; z++) {
+      for (int x = cell_begin.x; x <= cell_end.x; x++) {
+        MinMax cell = getMinMax(level, x, z);
+        result._min = (std::min)(result._min, cell._min);
+        result._max = (std::max)(result._max, cell._max);
+      }
+    }
+    return result;
+  }
+
+  bool MinMaxPyramid::intersectRay(const glm::vec3& origin, const glm::vec3& dir, float max_t, float& t) const
+  {
+    unsigned top = getNumLevels() - 1;
+    float t_entry;
+    if (!intersectCellBounds(top, 0, 0, origin, dir, max_t, t_entry)) {
+      return false;
+    }
+    t = max_t;
+    return intersectCell(top, 0, 0, origin, dir, t);
+  }
+
+  bool MinMaxPyramid::intersectCell(unsigned level, int x, int z, const glm::vec3& origin, const glm::vec3& dir, float& t) const
+  {
+    if (level == 0) {
+      const glm::ivec2& size = _levelSizes[0];
+      int x_next = (std::min)(x + 1, size.x - 1);
+      int z_next = (std::min)(z + 1, size.y - 1);
+      if (x_next == x || z_next == z) {
+        return false;
+      }
+      auto vertex = [this](int vx, int vz) {
+        return glm::vec3(static_cast<float>(vx), _heights[vz * _rowStride + vx], static_cast<float>(vz));
+      };
+      glm::vec3 v00 = vertex(x, z), v01 = vertex(x, z_next), v10 = vertex(x_next, z), v11 = vertex(x_next, z_next);
+      bool hit = false;
+      float t_tri;
+      if (intersectTriangle(origin, dir, v00, v01, v10, t_tri) && t_tri >= 0.f && t_tri <= t) {
+        t = t_tri;
+        hit = true;
+      }
+      if (intersectTriangle(origin, dir, v10, v01, v11, t_tri) && t_tri >= 0.f && t_tri <= t) {
+        t = t_tri;
+        hit = true;
+      }
+      return hit;
+    }
+
+    struct Child
+    {
+      int _x, _z;
+      float _tEntry;
+    };
+    Child children[4];
+    unsigned num_children = 0;
+    const glm::ivec2& child_level_size = _levelSizes[level - 1];
+    for (int j = 0; j < 2; j++) {
+      for (int i = 0; i < 2; i++) {
+        Child c = { x * 2 + i, z * 2 + j, 0.f };
+        if (c._x < child_level_size.x && c._z < child_level_size.y && intersectCellBounds(level - 1, c._x, c._z, origin, dir, t, c._tEntry)) {
+          children[num_children++] = c;
+        }
+      }
+    }
+    std::sort(children, children + num_children, [](const Child& a, const Child& b) {
+      return a._tEntry < b._tEntry;
+    });
+    bool hit = false;
+    for (unsigned i = 0; i < num_children && children[i]._tEntry <= t; i++) {
+      hit = intersectCell(level - 1, children[i]._x, children[i]._z, origin, dir, t) || hit;
+    }
+    return hit;
+  }
+
+  bool MinMaxPyramid::intersectCellBounds(unsigned level, int x, int z, const glm::vec3& origin, const glm::vec3& dir, float max_t, float& t_entry) const
+  {
+    const glm::ivec2& size = _levelSizes[0];
+    MinMax min_max = getMinMax(level, x, z);
+    glm::vec3 bb_min(static_cast<float>(x << level), min_max._min, static_cast<float>(z << level));
+    glm::vec3 bb_max(static_cast<float>((std::min)((x + 1) << level, size.x - 1)), min_max._max, static_cast<float>((std::min)((z + 1) << level, size.y - 1)));
+    float t_min = 0.f, t_max = max_t;
+    for (int i = 0; i < 3; i++) {
+      if (dir[i] == 0.f) { // Parallel to the slab, inside or a miss
+        if (origin[i] < bb_min[i] || origin[i] > bb_max[i]) {
+          return false;
+        }
+        continue;
+      }
+      float inv_dir = 1.f / dir[i];
+      float t0 = (bb_min[i] - origin[i]) * inv_dir;
+      float t1 = (bb_max[i] - origin[i]) * inv_dir;
+      if (t0 > t1) {
+        std::swap(t0, t1);
+      }
+      t_min = (std::max)(t_min, t0);
+      t_max = (std::min)(t_max, t1);
+      if (t_min > t_max) {
+        return false;
+      }
+    }
+    t_entry = t_min;
+    return true;
+  }
+}
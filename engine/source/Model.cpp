@@ -1,6 +1,7 @@
 #define GLM_ENABLE_EXPERIMENTAL
 #include <Model.h>
 #include <Mesh.h>
+#include <MeshOptimizer.h>
 #include <map>
 
 namespace fly
@@ -77,6 +78,9 @@ namespace fly
         }
         base_vertex += m->getVertices().size();
       }
+      // The parts were ordered independently, reorder the triangles across part boundaries
+      MeshOptimizer::optimizeVertexCache(indices, vertices.size());
+      MeshOptimizer::optimizeOverdraw(indices, vertices);
       _meshes.push_back(std::make_shared<Mesh>(vertices, indices, e.first));
     }
   }
@@ -0,0 +1,284 @@
+#include <ModelPack.h>
+#include <MappedFile.h>
+#include <Model.h>
+#include <Mesh.h>
+#include <Material.h>
+#include <Vertex.h>
+#include <ParallelFor.h>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <cstring>
+
+namespace fly
+{
+  namespace
+  {
+    const char MAGIC[4] = { 'F', 'L', 'Y', 'M' };
+    /**
+    * Builds the file in memory, every section starts at a 16 byte boundary.
+    */
+    class Writer
+    {
+    public:
+      uint64_t append(const void* data, size_t size)
+      {
+        _data.resize((_data.size() + 15) & ~size_t(15));
+        uint64_t offset = _data.size();
+        _data.insert(_data.end(), static_cast<const unsigned char*>(data), static_cast<const unsigned char*>(data) + size);
+        return offset;
+      }
+      template<typename T>
+      uint64_t append(const std::vector<T>& elements)
+      {
+        return append(elements.data(), elements.size() * sizeof(T));
+      }
+      ModelPack::StringRef append(const std::string& str)
+      {
+        return { append(str.data(), str.size()), str.size() };
+      }
+      std::vector<unsigned char> _data;
+    };
+    template<typename T>
+    uint32_t getOrAddIndex(T* element, std::map<T*, uint32_t>& indices, std::vector<T*>& elements)
+    {
+      auto it = indices.find(element);
+      if (it != indices.end()) {
+        return it->second;
+      }
+      uint32_t index = static_cast<uint32_t>(elements.size());
+      indices[element] = index;
+      elements.push_back(element);
+      return index;
+    }
+  }
+
+  bool ModelPack::save(const std::string& path, const std::vector<std::shared_ptr<Model>>& lods)
+  {
+    std::map<Mesh*, uint32_t> mesh_indices;
+    std::map<Material*, uint32_t> material_indices;
+    std::vector<Mesh*> meshes;
+    std::vector<Material*> materials;
+    std::vector<LodRecord> lod_records(lods.size());
+    std::vector<uint32_t> refs;
+    for (uint32_t i = 0; i < lods.size(); i++) {
+      auto& r = lod_records[i];
+      r._firstMeshRef = static_cast<uint32_t>(refs.size());
+      r._numMeshes = static_cast<uint32_t>(lods[i]->getMeshes().size());
+      for (const auto& m : lods[i]->getMeshes()) {
+        refs.push_back(getOrAddIndex(m.get(), mesh_indices, meshes));
+      }
+      r._firstMaterialRef = static_cast<uint32_t>(refs.size());
+      r._numMaterials = static_cast<uint32_t>(lods[i]->getMaterials().size());
+      for (const auto& m : lods[i]->getMaterials()) {
+        refs.push_back(getOrAddIndex(m.get(), material_indices, materials));
+      }
+    }
+
+    Writer writer;
+    Header header = {};
+    writer.append(&header, sizeof(header));
+    std::vector<MeshRecord> mesh_records(meshes.size());
+    for (uint32_t i = 0; i < meshes.size(); i++) {
+      auto& r = mesh_records[i];
+      r._verticesOffset = writer.append(meshes[i]->getVertices());
+      r._indicesOffset = writer.append(meshes[i]->getIndices());
+      r._numVertices = static_cast<uint32_t>(meshes[i]->getVertices().size());
+      r._numIndices = static_cast<uint32_t>(meshes[i]->getIndices().size());
+      r._materialIndex = meshes[i]->getMaterialIndex();
+      r._material = meshes[i]->getMaterial() ? getOrAddIndex(meshes[i]->getMaterial().get(), material_indices, materials) : NO_INDEX;
+      r._aabbMin = meshes[i]->getAABB()->getMin();
+      r._aabbMax = meshes[i]->getAABB()->getMax();
+    }
+    std::vector<MaterialRecord> material_records(materials.size());
+    for (uint32_t i = 0; i < materials.size(); i++) {
+      auto m = materials[i];
+      auto& r = material_records[i];
+      r._diffusePath = writer.append(m->getDiffusePath());
+      r._normalPath = writer.append(m->getNormalPath());
+      r._opacityPath = writer.append(m->getOpacityPath());
+      r._heightPath = writer.append(m->getHeightPath());
+      r._diffuseColor = m->getDiffuseColor();
+      r._specularExponent = m->getSpecularExponent();
+      r._windStrength = m->getWindStrength();
+      r._windFrequency = m->getWindFrequency();
+      r._ka = m->getKa();
+      r._kd = m->getKd();
+      r._ks = m->getKs();
+      r._parallaxHeightScale = m->getParallaxHeightScale();
+      r._parallaxMinSteps = m->getParallaxMinSteps();
+      r._parallaxMaxSteps = m->getParallaxMaxSteps();
+      r._parallaxBinarySearchSteps = m->getParallaxBinarySearchSteps();
+      r._flags = (m->hasWindX() ? static_cast<uint32_t>(MATERIAL_WIND_X) : 0u) | (m->hasWindZ() ? static_cast<uint32_t>(MATERIAL_WIND_Z) : 0u)
+        | (m->isReflective() ? static_cast<uint32_t>(MATERIAL_REFLECTIVE) : 0u);
+    }
+
+    std::memcpy(header._magic, MAGIC, sizeof(MAGIC));
+    header._version = VERSION;
+    header._vertexSize = sizeof(Vertex);
+    header._numLods = static_cast<uint32_t>(lod_records.size());
+    header._numMeshes = static_cast<uint32_t>(mesh_records.size());
+    header._numMaterials = static_cast<uint32_t>(material_records.size());
+    header._numRefs = static_cast<uint32_t>(refs.size());
+    header._lodsOffset = writer.append(lod_records);
+    header._meshesOffset = writer.append(mesh_records);
+    header._materialsOffset = writer.append(material_records);
+    header._refsOffset = writer.append(refs);
+    header._fileSize = writer._data.size();
+    std::memcpy(writer._data.data(), &header, sizeof(header));
+
+    std::ofstream os(path, std::ios::binary);
+    os.write(reinterpret_cast<const char*>(writer._data.data()), writer._data.size());
+    if (!os) {
+      std::cout << "ModelPack::save() Failed to write " << path << std::endl;
+      return false;
+    }
+    return true;
+  }
+  std::unique_ptr<ModelPack> ModelPack::load(const std::string& path)
+  {
+    auto file = std::make_unique<MappedFile>(path);
+    if (!file->getData()) {
+      return nullptr;
+    }
+    std::unique_ptr<ModelPack> pack(new ModelPack(std::move(file)));
+    if (!pack->fixup()) {
+      std::cout << "ModelPack::load() " << path << " is not a valid model pack of version " << VERSION << std::endl;
+      return nullptr;
+    }
+    return pack;
+  }
+  ModelPack::ModelPack(std::unique_ptr<MappedFile>&& file) : _file(std::move(file))
+  {
+  }
+  ModelPack::~ModelPack()
+  {
+  }
+  template<typename T>
+  bool ModelPack::resolve(uint64_t offset, uint64_t count, const T*& ptr) const
+  {
+    if (offset % alignof(T) || offset > _file->getSize() || count > (_file->getSize() - offset) / sizeof(T)) {
+      return false;
+    }
+    ptr = reinterpret_cast<const T*>(_file->getData() + offset);
+    return true;
+  }
+  bool ModelPack::fixup()
+  {
+    if (!resolve(0, 1, _header) || std::memcmp(_header->_magic, MAGIC, sizeof(MAGIC)) || _header->_version != VERSION ||
+      _header->_vertexSize != sizeof(Vertex) || _header->_fileSize != _file->getSize()) {
+      return false;
+    }
+    if (!resolve(_header->_lodsOffset, _header->_numLods, _lods) ||
+      !resolve(_header->_meshesOffset, _header->_numMeshes, _meshes) ||
+      !resolve(_header->_materialsOffset, _header->_numMaterials, _materials) ||
+      !resolve(_header->_refsOffset, _header->_numRefs, _refs)) {
+      return false;
+    }
+    // Validate all references once, so that createModels() can use them without further checks
+    for (uint32_t i = 0; i < _header->_numLods; i++) {
+      const auto& l = _lods[i];
+      if (l._firstMeshRef > _header->_numRefs || l._numMeshes > _header->_numRefs - l._firstMeshRef ||
+        l._firstMaterialRef > _header->_numRefs || l._numMaterials > _header->_numRefs - l._firstMaterialRef) {
+        return false;
+      }
+      for (uint32_t j = 0; j < l._numMeshes; j++) {
+        if (_refs[l._firstMeshRef + j] >= _header->_numMeshes) {
+          return false;
+        }
+      }
+      for (uint32_t j = 0; j < l._numMaterials; j++) {
+        if (_refs[l._firstMaterialRef + j] >= _header->_numMaterials) {
+          return false;
+        }
+      }
+    }
+    for (uint32_t i = 0; i < _header->_numMeshes; i++) {
+      const Vertex* vertices;
+      const unsigned* indices;
+      if (!resolve(_meshes[i]._verticesOffset, _meshes[i]._numVertices, vertices) || !resolve(_meshes[i]._indicesOffset, _meshes[i]._numIndices, indices) ||
+        (_meshes[i]._material != NO_INDEX && _meshes[i]._material >= _header->_numMaterials)) {
+        return false;
+      }
+      for (uint32_t j = 0; j < _meshes[i]._numIndices; j++) {
+        if (indices[j] >= _meshes[i]._numVertices) {
+          return false;
+        }
+      }
+    }
+    for (uint32_t i = 0; i < _header->_numMaterials; i++) {
+      const char* str;
+      for (const auto& s : { _materials[i]._diffusePath, _materials[i]._normalPath, _materials[i]._opacityPath, _materials[i]._heightPath }) {
+        if (!resolve(s._offset, s._length, str)) {
+          return false;
+        }
+      }
+    }
+    return true;
+  }
+  std::string ModelPack::getString(const StringRef& str) const
+  {
+    return std::string(reinterpret_cast<const char*>(_file->getData() + str._offset), static_cast<size_t>(str._length));
+  }
+  unsigned ModelPack::getNumLods() const
+  {
+    return _header->_numLods;
+  }
+  std::vector<std::shared_ptr<Model>> ModelPack::createModels() const
+  {
+    std::vector<std::shared_ptr<Material>> materials(_header->_numMaterials);
+    for (uint32_t i = 0; i < materials.size(); i++) {
+      const auto& r = _materials[i];
+      materials[i] = std::make_shared<Material>(r._diffuseColor, r._specularExponent, getString(r._diffusePath), getString(r._normalPath), getString(r._opacityPath));
+      materials[i]->setHeightPath(getString(r._heightPath));
+      materials[i]->setHasWindX((r._flags & MATERIAL_WIND_X) != 0, r._windStrength, r._windFrequency);
+      materials[i]->setHasWindZ((r._flags & MATERIAL_WIND_Z) != 0, r._windStrength, r._windFrequency);
+      materials[i]->setIsReflective((r._flags & MATERIAL_REFLECTIVE) != 0);
+      materials[i]->setKa(r._ka);
+      materials[i]->setKd(r._kd);
+      materials[i]->setKs(r._ks);
+      materials[i]->setParallaxHeightScale(r._parallaxHeightScale);
+      materials[i]->setParallaxMinSteps(r._parallaxMinSteps);
+      materials[i]->setParallaxMaxSteps(r._parallaxMaxSteps);
+      materials[i]->setParallaxBinarySearchSteps(r._parallaxBinarySearchSteps);
+    }
+    std::vector<std::shared_ptr<Mesh>> meshes(_header->_numMeshes);
+    parallelFor(0, meshes.size(), [this, &meshes, &materials](size_t i) {
+      const auto& r = _meshes[i];
+      meshes[i] = std::make_shared<Mesh>(getVertices(r), r._numVertices, getIndices(r), r._numIndices, r._materialIndex, AABB(r._aabbMin, r._aabbMax));
+      if (r._material != NO_INDEX) {
+        meshes[i]->setMaterial(materials[r._material]);
+      }
+    }, 1);
+    std::vector<std::shared_ptr<Model>> models;
+    for (uint32_t i = 0; i < _header->_numLods; i++) {
+      const auto& l = _lods[i];
+      std::vector<std::shared_ptr<Mesh>> lod_meshes;
+      for (uint32_t j = 0; j < l._numMeshes; j++) {
+        lod_meshes.push_back(meshes[_refs[l._firstMeshRef + j]]);
+      }
+      std::vector<std::shared_ptr<Material>> lod_materials;
+      for (uint32_t j = 0; j < l._numMaterials; j++) {
+        lod_materials.push_back(materials[_refs[l._firstMaterialRef + j]]);
+      }
+      models.push_back(std::make_shared<Model>(lod_meshes, lod_materials));
+    }
+    return models;
+  }
+  const ModelPack::MeshRecord* ModelPack::getMeshRecords() const
+  {
+    return _meshes;
+  }
+  unsigned ModelPack::getNumMeshRecords() const
+  {
+    return _header->_numMeshes;
+  }
+  const Vertex* ModelPack::getVertices(const MeshRecord& mesh) const
+  {
+    return reinterpret_cast<const Vertex*>(_file->getData() + mesh._verticesOffset);
+  }
+  const unsigned* ModelPack::getIndices(const MeshRecord& mesh) const
+  {
+    return reinterpret_cast<const unsigned*>(_file->getData() + mesh._indicesOffset);
+  }
+}
@@ -3,9 +3,55 @@
 #include <random>
 #include <iostream>
 #include <glm/gtx/string_cast.hpp>
+#include <ParallelFor.h>
+#include <cmath>
+#include <utility>
 
 namespace fly
 {
+  namespace
+  {
+    // Gradients to the midpoints of the cube edges, the first 8 are also used in 2D
+    const float grad3[12][3] = { { 1.f, 1.f, 0.f }, { -1.f, 1.f, 0.f }, { 1.f, -1.f, 0.f }, { -1.f, -1.f, 0.f },
+      { 1.f, 0.f, 1.f }, { -1.f, 0.f, 1.f }, { 1.f, 0.f, -1.f }, { -1.f, 0.f, -1.f },
+      { 0.f, 1.f, 1.f }, { 0.f, -1.f, 1.f }, { 0.f, 1.f, -1.f }, { 0.f, -1.f, -1.f } };
+    const float grad2[8][2] = { { 1.f, 1.f }, { -1.f, 1.f }, { 1.f, -1.f }, { -1.f, -1.f },
+      { 1.f, 0.f }, { -1.f, 0.f }, { 0.f, 1.f }, { 0.f, -1.f } };
+
+    inline int fastFloor(float x)
+    {
+      int i = static_cast<int>(x);
+      return x < i ? i - 1 : i;
+    }
+    inline float fade(float t)
+    {
+      return t * t * t * (t * (t * 6.f - 15.f) + 10.f);
+    }
+    inline float lerp(float a, float b, float t)
+    {
+      return a + t * (b - a);
+    }
+    inline float dotGrad(unsigned h, float x, float y)
+    {
+      return grad2[h & 7][0] * x + grad2[h & 7][1] * y;
+    }
+    inline float dotGrad(unsigned h, float x, float y, float z)
+    {
+      const float* g = grad3[(h & 15) < 12 ? h & 15 : h & 3]; // 16 entries with the first 4 repeated, Perlin's improved noise
+      return g[0] * x + g[1] * y + g[2] * z;
+    }
+    /**
+    * splitmix32, used instead of the standard distributions, whose output differs between standard libraries.
+    */
+    inline uint32_t nextRandom(uint32_t& state)
+    {
+      uint32_t z = (state += 0x9e3779b9u);
+      z = (z ^ (z >> 16)) * 0x85ebca6bu;
+      z = (z ^ (z >> 13)) * 0xc2b2ae35u;
+      return z ^ (z >> 16);
+    }
+  }
+
   NoiseGen::NoiseGen(int grid_size, bool make_tileable) : _gridWidth(grid_size + 1)
   {
     std::mt19937 gen;
@@ -35,7 +81,7 @@ namespace fly
   NoiseGen::~NoiseGen()
   {
   }
-  float NoiseGen::getPerlin(const glm::vec2& pos)
+  float NoiseGen::getPerlin(const glm::vec2& pos) const
   {
     glm::ivec2 pos_start = glm::floor(pos);
     glm::ivec2 pos_end = pos_start + 1;
@@ -44,7 +90,7 @@ namespace fly
       glm::mix(dotGridGradient(glm::ivec2(pos_start.x, pos_end.y), pos), dotGridGradient(pos_end, pos), weights.x), weights.y);
   }
 
-  float NoiseGen::dotGridGradient(const glm::ivec2 & grid_pos, const glm::vec2 & pos)
+  float NoiseGen::dotGridGradient(const glm::ivec2 & grid_pos, const glm::vec2 & pos) const
   {
     glm::vec2 dist_vec = pos - glm::vec2(grid_pos);
     glm::ivec2 idx_2d(grid_pos.x % _gridWidth, grid_pos.y % _gridWidth);
@@ -52,8 +98,214 @@ namespace fly
     return glm::dot(dist_vec, _gradientVectors[idx]);
   }
 
-  glm::vec2 NoiseGen::smoothstep(const glm::vec2& t)
+  glm::vec2 NoiseGen::smoothstep(const glm::vec2& t) const
   {
     return t * t * t * (t * (t * 6.f - 15.f) + 10.f);
   }
-}
\ No newline at end of file
+
+  float NoiseGen::getFBm(const glm::vec2& pos, const FBmParams& params) const
+  {
+    float result = 0.f;
+    float amplitude = params._amplitude;
+    float frequency = params._frequency;
+    for (unsigned i = 0; i < params._octaves; i++, amplitude *= params._gain, frequency *= params._lacunarity) {
+      float n = getPerlin(pos * frequency);
+      result += amplitude * (params._ridged ? 1.f - std::abs(n) : n);
+    }
+    return result;
+  }
+
+  std::vector<float> NoiseGen::getFBm(unsigned width, unsigned height, const FBmParams& params, const Vec2f& origin, float step) const
+  {
+    std::vector<float> image(static_cast<size_t>(width) * height, 0.f);
+    parallelFor(0, height, [&](size_t y) {
+      float amplitude = params._amplitude;
+      float frequency = params._frequency;
+      for (unsigned i = 0; i < params._octaves; i++, amplitude *= params._gain, frequency *= params._lacunarity) {
+        accumulateRow(origin[1] + y * step, origin[0], step, width, frequency, amplitude, params._ridged, &image[y * width]);
+      }
+    });
+    return image;
+  }
+
+  void NoiseGen::accumulateRow(float y, float x_begin, float step, unsigned width, float frequency, float amplitude, bool ridged, float* row) const
+  {
+    // All samples of a row share the grid row and the vertical weight
+    float pos_y = y * frequency;
+    int grid_y = static_cast<int>(std::floor(pos_y));
+    float frac_y = pos_y - grid_y;
+    float weight_y = frac_y * frac_y * frac_y * (frac_y * (frac_y * 6.f - 15.f) + 10.f);
+    int row_0 = (grid_y % _gridWidth) * _gridWidth;
+    int row_1 = ((grid_y + 1) % _gridWidth) * _gridWidth;
+    unsigned x = 0;
+#ifdef FLY_SSE
+    const __m128 one = _mm_set1_ps(1.f);
+    const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    const __m128 frac_y_4 = _mm_set1_ps(frac_y);
+    const __m128 frac_y_minus_one = _mm_set1_ps(frac_y - 1.f);
+    const __m128 weight_y_4 = _mm_set1_ps(weight_y);
+    const __m128 amplitude_4 = _mm_set1_ps(amplitude);
+    for (; x + 4 <= width; x += 4) {
+      __m128 index = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), _mm_set_ps(3.f, 2.f, 1.f, 0.f));
+      __m128 pos_x = _mm_mul_ps(simd::madd(index, _mm_set1_ps(step), _mm_set1_ps(x_begin)), _mm_set1_ps(frequency));
+      __m128 floor_x = _mm_cvtepi32_ps(_mm_cvttps_epi32(pos_x));
+      floor_x = _mm_sub_ps(floor_x, _mm_and_ps(_mm_cmpgt_ps(floor_x, pos_x), one));
+      __m128 frac_x = _mm_sub_ps(pos_x, floor_x);
+      alignas(16) int grid_x[4];
+      _mm_store_si128(reinterpret_cast<__m128i*>(grid_x), _mm_cvttps_epi32(floor_x));
+      alignas(16) float g[8][4]; // x and y of the gradients at the corners 00, 10, 01, 11
+      for (unsigned lane = 0; lane < 4; lane++) {
+        int col_0 = grid_x[lane] % _gridWidth;
+        int col_1 = (grid_x[lane] + 1) % _gridWidth;
+        const glm::vec2* corners[4] = { &_gradientVectors[col_0 + row_0], &_gradientVectors[col_1 + row_0],
+          &_gradientVectors[col_0 + row_1], &_gradientVectors[col_1 + row_1] };
+        for (unsigned c = 0; c < 4; c++) {
+          g[c * 2][lane] = corners[c]->x;
+          g[c * 2 + 1][lane] = corners[c]->y;
+        }
+      }
+      __m128 frac_x_minus_one = _mm_sub_ps(frac_x, one);
+      __m128 d00 = simd::madd(_mm_load_ps(g[0]), frac_x, _mm_mul_ps(_mm_load_ps(g[1]), frac_y_4));
+      __m128 d10 = simd::madd(_mm_load_ps(g[2]), frac_x_minus_one, _mm_mul_ps(_mm_load_ps(g[3]), frac_y_4));
+      __m128 d01 = simd::madd(_mm_load_ps(g[4]), frac_x, _mm_mul_ps(_mm_load_ps(g[5]), frac_y_minus_one));
+      __m128 d11 = simd::madd(_mm_load_ps(g[6]), frac_x_minus_one, _mm_mul_ps(_mm_load_ps(g[7]), frac_y_minus_one));
+      __m128 weight_x = simd::madd(frac_x, _mm_set1_ps(6.f), _mm_set1_ps(-15.f));
+      weight_x = simd::madd(weight_x, frac_x, _mm_set1_ps(10.f));
+      weight_x = _mm_mul_ps(weight_x, _mm_mul_ps(frac_x, _mm_mul_ps(frac_x, frac_x)));
+      __m128 a = simd::madd(weight_x, _mm_sub_ps(d10, d00), d00);
+      __m128 b = simd::madd(weight_x, _mm_sub_ps(d11, d01), d01);
+      __m128 n = simd::madd(weight_y_4, _mm_sub_ps(b, a), a);
+      if (ridged) {
+        n = _mm_sub_ps(one, _mm_and_ps(n, abs_mask));
+      }
+      _mm_storeu_ps(row + x, simd::madd(amplitude_4, n, _mm_loadu_ps(row + x)));
+    }
+#endif
+    for (; x < width; x++) {
+      float n = getPerlin(glm::vec2(x_begin + x * step, y) * frequency);
+      row[x] += amplitude * (ridged ? 1.f - std::abs(n) : n);
+    }
+  }
+
+  HashNoiseGen::HashNoiseGen(uint32_t seed) : _seed(seed)
+  {
+    uint32_t state = seed;
+    for (unsigned i = 0; i < 256; i++) {
+      _perm[i] = static_cast<uint8_t>(i);
+    }
+    for (unsigned i = 255; i > 0; i--) {
+      std::swap(_perm[i], _perm[nextRandom(state) % (i + 1)]);
+    }
+    for (unsigned i = 0; i < 512; i++) {
+      _perm[i] = _perm[i & 255];
+      _permMod12[i] = _perm[i] % 12;
+    }
+    for (auto& v : _values) {
+      v = static_cast<float>(nextRandom(state) >> 8) / static_cast<float>(1u << 23) - 1.f; // Exact in float
+    }
+  }
+
+  float HashNoiseGen::getPerlin(const Vec2f& pos) const
+  {
+    int x = fastFloor(pos[0]), y = fastFloor(pos[1]);
+    float fx = pos[0] - x, fy = pos[1] - y;
+    float u = fade(fx), v = fade(fy);
+    return lerp(lerp(dotGrad(hash(x, y), fx, fy), dotGrad(hash(x + 1, y), fx - 1.f, fy), u),
+      lerp(dotGrad(hash(x, y + 1), fx, fy - 1.f), dotGrad(hash(x + 1, y + 1), fx - 1.f, fy - 1.f), u), v);
+  }
+
+  float HashNoiseGen::getPerlin(const Vec3f& pos) const
+  {
+    int x = fastFloor(pos[0]), y = fastFloor(pos[1]), z = fastFloor(pos[2]);
+    float fx = pos[0] - x, fy = pos[1] - y, fz = pos[2] - z;
+    float u = fade(fx), v = fade(fy), w = fade(fz);
+    float x0 = lerp(lerp(dotGrad(hash(x, y, z), fx, fy, fz), dotGrad(hash(x + 1, y, z), fx - 1.f, fy, fz), u),
+      lerp(dotGrad(hash(x, y + 1, z), fx, fy - 1.f, fz), dotGrad(hash(x + 1, y + 1, z), fx - 1.f, fy - 1.f, fz), u), v);
+    float x1 = lerp(lerp(dotGrad(hash(x, y, z + 1), fx, fy, fz - 1.f), dotGrad(hash(x + 1, y, z + 1), fx - 1.f, fy, fz - 1.f), u),
+      lerp(dotGrad(hash(x, y + 1, z + 1), fx, fy - 1.f, fz - 1.f), dotGrad(hash(x + 1, y + 1, z + 1), fx - 1.f, fy - 1.f, fz - 1.f), u), v);
+    return lerp(x0, x1, w);
+  }
+
+  float HashNoiseGen::getSimplex(const Vec2f& pos) const
+  {
+    const float F2 = 0.366025403784f; // (sqrt(3) - 1) / 2
+    const float G2 = 0.211324865405f; // (3 - sqrt(3)) / 6
+    float s = (pos[0] + pos[1]) * F2;
+    int i = fastFloor(pos[0] + s), j = fastFloor(pos[1] + s);
+    float t = (i + j) * G2;
+    float x0 = pos[0] - (i - t), y0 = pos[1] - (j - t);
+    int i1 = x0 > y0 ? 1 : 0;
+    int j1 = 1 - i1;
+    float x1 = x0 - i1 + G2, y1 = y0 - j1 + G2;
+    float x2 = x0 - 1.f + 2.f * G2, y2 = y0 - 1.f + 2.f * G2;
+    int ii = i & 255, jj = j & 255;
+    unsigned gi[3] = { _permMod12[ii + _perm[jj]], _permMod12[ii + i1 + _perm[jj + j1]], _permMod12[ii + 1 + _perm[jj + 1]] };
+    float corners[3][2] = { { x0, y0 }, { x1, y1 }, { x2, y2 } };
+    float n = 0.f;
+    for (unsigned c = 0; c < 3; c++) {
+      float t_c = 0.5f - corners[c][0] * corners[c][0] - corners[c][1] * corners[c][1];
+      if (t_c > 0.f) {
+        t_c *= t_c;
+        n += t_c * t_c * (grad3[gi[c]][0] * corners[c][0] + grad3[gi[c]][1] * corners[c][1]);
+      }
+    }
+    return 70.f * n;
+  }
+
+  float HashNoiseGen::getSimplex(const Vec3f& pos) const
+  {
+    const float F3 = 1.f / 3.f;
+    const float G3 = 1.f / 6.f;
+    float s = (pos[0] + pos[1] + pos[2]) * F3;
+    int i = fastFloor(pos[0] + s), j = fastFloor(pos[1] + s), k = fastFloor(pos[2] + s);
+    float t = (i + j + k) * G3;
+    float x0 = pos[0] - (i - t), y0 = pos[1] - (j - t), z0 = pos[2] - (k - t);
+    // Offsets of the second and third corner, determined by the simplex the point lies in
+    int i1, j1, k1, i2, j2, k2;
+    if (x0 >= y0) {
+      if (y0 >= z0) { i1 = 1; j1 = 0; k1 = 0; i2 = 1; j2 = 1; k2 = 0; }
+      else if (x0 >= z0) { i1 = 1; j1 = 0; k1 = 0; i2 = 1; j2 = 0; k2 = 1; }
+      else { i1 = 0; j1 = 0; k1 = 1; i2 = 1; j2 = 0; k2 = 1; }
+    }
+    else {
+      if (y0 < z0) { i1 = 0; j1 = 0; k1 = 1; i2 = 0; j2 = 1; k2 = 1; }
+      else if (x0 < z0) { i1 = 0; j1 = 1; k1 = 0; i2 = 0; j2 = 1; k2 = 1; }
+      else { i1 = 0; j1 = 1; k1 = 0; i2 = 1; j2 = 1; k2 = 0; }
+    }
+    float corners[4][3] = { { x0, y0, z0 }, { x0 - i1 + G3, y0 - j1 + G3, z0 - k1 + G3 },
+      { x0 - i2 + 2.f * G3, y0 - j2 + 2.f * G3, z0 - k2 + 2.f * G3 }, { x0 - 1.f + 3.f * G3, y0 - 1.f + 3.f * G3, z0 - 1.f + 3.f * G3 } };
+    int ii = i & 255, jj = j & 255, kk = k & 255;
+    unsigned gi[4] = { _permMod12[ii + _perm[jj + _perm[kk]]], _permMod12[ii + i1 + _perm[jj + j1 + _perm[kk + k1]]],
+      _permMod12[ii + i2 + _perm[jj + j2 + _perm[kk + k2]]], _permMod12[ii + 1 + _perm[jj + 1 + _perm[kk + 1]]] };
+    float n = 0.f;
+    for (unsigned c = 0; c < 4; c++) {
+      float t_c = 0.6f - corners[c][0] * corners[c][0] - corners[c][1] * corners[c][1] - corners[c][2] * corners[c][2];
+      if (t_c > 0.f) {
+        t_c *= t_c;
+        n += t_c * t_c * (grad3[gi[c]][0] * corners[c][0] + grad3[gi[c]][1] * corners[c][1] + grad3[gi[c]][2] * corners[c][2]);
+      }
+    }
+    return 32.f * n;
+  }
+
+  float HashNoiseGen::getValue(const Vec2f& pos) const
+  {
+    int x = fastFloor(pos[0]), y = fastFloor(pos[1]);
+    float u = fade(pos[0] - x), v = fade(pos[1] - y);
+    return lerp(lerp(_values[hash(x, y)], _values[hash(x + 1, y)], u), lerp(_values[hash(x, y + 1)], _values[hash(x + 1, y + 1)], u), v);
+  }
+
+  float HashNoiseGen::getValue(const Vec3f& pos) const
+  {
+    int x = fastFloor(pos[0]), y = fastFloor(pos[1]), z = fastFloor(pos[2]);
+    float u = fade(pos[0] - x), v = fade(pos[1] - y), w = fade(pos[2] - z);
+    float z0 = lerp(lerp(_values[hash(x, y, z)], _values[hash(x + 1, y, z)], u), lerp(_values[hash(x, y + 1, z)], _values[hash(x + 1, y + 1, z)], u), v);
+    float z1 = lerp(lerp(_values[hash(x, y, z + 1)], _values[hash(x + 1, y, z + 1)], u), lerp(_values[hash(x, y + 1, z + 1)], _values[hash(x + 1, y + 1, z + 1)], u), v);
+    return lerp(z0, z1, w);
+  }
+
+  uint32_t HashNoiseGen::getSeed() const
+  {
+    return _seed;
+  }
+}
@@ -0,0 +1,334 @@
+#include <SceneSnapshot.h>
+#include <MappedFile.h>
+#include <EntityManager.h>
+#include <Entity.h>
+#include <StaticMeshRenderable.h>
+#include <Transform.h>
+#include <Mesh.h>
+#include <Material.h>
+#include <ParallelFor.h>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <cstring>
+
+namespace fly
+{
+  namespace
+  {
+    const char MAGIC[4] = { 'F', 'L', 'Y', 'S' };
+    /**
+    * Builds the file in memory, every section starts at a 16 byte boundary.
+    */
+    class Writer
+    {
+    public:
+      uint64_t append(const void* data, size_t size)
+      {
+        _data.resize((_data.size() + 15) & ~size_t(15));
+        uint64_t offset = _data.size();
+        _data.insert(_data.end(), static_cast<const unsigned char*>(data), static_cast<const unsigned char*>(data) + size);
+        return offset;
+      }
+      template<typename T>
+      uint64_t append(const std::vector<T>& elements)
+      {
+        return append(elements.data(), elements.size() * sizeof(T));
+      }
+      SceneSnapshot::StringRef append(const std::string& str)
+      {
+        return { append(str.data(), str.size()), str.size() };
+      }
+      std::vector<unsigned char> _data;
+    };
+    template<typename T>
+    uint32_t getOrAddIndex(T* element, std::map<T*, uint32_t>& indices, std::vector<T*>& elements)
+    {
+      auto it = indices.find(element);
+      if (it != indices.end()) {
+        return it->second;
+      }
+      uint32_t index = static_cast<uint32_t>(elements.size());
+      indices[element] = index;
+      elements.push_back(element);
+      return index;
+    }
+  }
+
+  bool SceneSnapshot::save(const std::string& path, const EntityManager& em)
+  {
+    std::vector<Entity*> entities;
+    std::vector<StaticMeshRenderable*> renderables;
+    for (auto e : em.getEntities()) {
+      auto smr = e->getComponent<StaticMeshRenderable>();
+      if (smr) {
+        entities.push_back(e);
+        renderables.push_back(smr.get());
+      }
+    }
+    std::map<Mesh*, uint32_t> mesh_indices;
+    std::map<Material*, uint32_t> material_indices;
+    std::map<StaticMeshRenderable*, uint32_t> entity_indices;
+    std::vector<Mesh*> meshes;
+    std::vector<Material*> materials;
+    std::vector<EntityRecord> entity_records(entities.size());
+    Vec3f scene_min(std::numeric_limits<float>::max());
+    Vec3f scene_max(std::numeric_limits<float>::lowest());
+    for (uint32_t i = 0; i < entities.size(); i++) {
+      auto smr = renderables[i];
+      auto transform = entities[i]->getComponent<Transform>();
+      auto& r = entity_records[i];
+      r._modelMatrix = smr->getModelMatrix();
+      r._modelMatrixInverse = smr->getModelMatrixInverse();
+      r._aabbMin = smr->getAABBWorld()->getMin();
+      r._aabbMax = smr->getAABBWorld()->getMax();
+      r._translation = transform ? transform->getTranslation() : Vec3f(0.f);
+      r._scale = transform ? transform->getScale() : Vec3f(1.f);
+      r._degrees = transform ? transform->getDegrees() : Vec3f(0.f);
+      r._windParams = smr->getWindParams();
+      r._mesh = getOrAddIndex(smr->getMesh().get(), mesh_indices, meshes);
+      r._material = smr->getMaterial() ? getOrAddIndex(smr->getMaterial().get(), material_indices, materials) : NO_INDEX;
+      r._flags = (transform ? static_cast<uint32_t>(ENTITY_TRANSFORM) : 0u) | (smr->hasWind() ? static_cast<uint32_t>(ENTITY_WIND) : 0u);
+      entity_indices[smr] = i;
+      scene_min = minimum(scene_min, r._aabbMin);
+      scene_max = maximum(scene_max, r._aabbMax);
+    }
+
+    Writer writer;
+    Header header = {};
+    writer.append(&header, sizeof(header));
+    std::vector<MeshRecord> mesh_records(meshes.size());
+    for (uint32_t i = 0; i < meshes.size(); i++) {
+      auto& r = mesh_records[i];
+      r._verticesOffset = writer.append(meshes[i]->getVertices());
+      r._indicesOffset = writer.append(meshes[i]->getIndices());
+      r._numVertices = static_cast<uint32_t>(meshes[i]->getVertices().size());
+      r._numIndices = static_cast<uint32_t>(meshes[i]->getIndices().size());
+      r._materialIndex = meshes[i]->getMaterialIndex();
+      r._material = meshes[i]->getMaterial() ? getOrAddIndex(meshes[i]->getMaterial().get(), material_indices, materials) : NO_INDEX;
+      r._aabbMin = meshes[i]->getAABB()->getMin();
+      r._aabbMax = meshes[i]->getAABB()->getMax();
+    }
+    std::vector<MaterialRecord> material_records(materials.size());
+    for (uint32_t i = 0; i < materials.size(); i++) {
+      auto m = materials[i];
+      auto& r = material_records[i];
+      r._diffusePath = writer.append(m->getDiffusePath());
+      r._normalPath = writer.append(m->getNormalPath());
+      r._opacityPath = writer.append(m->getOpacityPath());
+      r._heightPath = writer.append(m->getHeightPath());
+      r._diffuseColor = m->getDiffuseColor();
+      r._specularExponent = m->getSpecularExponent();
+      r._windStrength = m->getWindStrength();
+      r._windFrequency = m->getWindFrequency();
+      r._ka = m->getKa();
+      r._kd = m->getKd();
+      r._ks = m->getKs();
+      r._parallaxHeightScale = m->getParallaxHeightScale();
+      r._parallaxMinSteps = m->getParallaxMinSteps();
+      r._parallaxMaxSteps = m->getParallaxMaxSteps();
+      r._parallaxBinarySearchSteps = m->getParallaxBinarySearchSteps();
+      r._flags = (m->hasWindX() ? static_cast<uint32_t>(MATERIAL_WIND_X) : 0u) | (m->hasWindZ() ? static_cast<uint32_t>(MATERIAL_WIND_Z) : 0u)
+        | (m->isReflective() ? static_cast<uint32_t>(MATERIAL_REFLECTIVE) : 0u);
+    }
+    std::vector<QuadtreeFlatNode> nodes;
+    std::vector<uint32_t> node_elements;
+    if (renderables.size()) {
+      Quadtree<StaticMeshRenderable> quadtree(scene_min, scene_max);
+      for (auto smr : renderables) {
+        quadtree.insert(smr);
+      }
+      std::vector<StaticMeshRenderable*> elements;
+      quadtree.flatten(nodes, elements);
+      for (auto e : elements) {
+        node_elements.push_back(entity_indices[e]);
+      }
+    }
+
+    std::memcpy(header._magic, MAGIC, sizeof(MAGIC));
+    header._version = VERSION;
+    header._vertexSize = sizeof(Vertex);
+    header._meshRecordSize = sizeof(MeshRecord);
+    header._materialRecordSize = sizeof(MaterialRecord);
+    header._entityRecordSize = sizeof(EntityRecord);
+    header._nodeSize = sizeof(QuadtreeFlatNode);
+    header._numMeshes = static_cast<uint32_t>(mesh_records.size());
+    header._numMaterials = static_cast<uint32_t>(material_records.size());
+    header._numEntities = static_cast<uint32_t>(entity_records.size());
+    header._numNodes = static_cast<uint32_t>(nodes.size());
+    header._numNodeElements = static_cast<uint32_t>(node_elements.size());
+    header._meshesOffset = writer.append(mesh_records);
+    header._materialsOffset = writer.append(material_records);
+    header._entitiesOffset = writer.append(entity_records);
+    header._nodesOffset = writer.append(nodes);
+    header._nodeElementsOffset = writer.append(node_elements);
+    header._fileSize = writer._data.size();
+    std::memcpy(writer._data.data(), &header, sizeof(header));
+
+    std::ofstream os(path, std::ios::binary);
+    os.write(reinterpret_cast<const char*>(writer._data.data()), writer._data.size());
+    if (!os) {
+      std::cout << "SceneSnapshot::save() Failed to write " << path << std::endl;
+      return false;
+    }
+    return true;
+  }
+  std::unique_ptr<SceneSnapshot> SceneSnapshot::load(const std::string& path)
+  {
+    auto file = std::make_unique<MappedFile>(path);
+    if (!file->getData()) {
+      return nullptr;
+    }
+    std::unique_ptr<SceneSnapshot> snapshot(new SceneSnapshot(std::move(file)));
+    if (!snapshot->fixup()) {
+      std::cout << "SceneSnapshot::load() " << path << " is not a valid snapshot of version " << VERSION << std::endl;
+      return nullptr;
+    }
+    return snapshot;
+  }
+  SceneSnapshot::SceneSnapshot(std::unique_ptr<MappedFile>&& file) : _file(std::move(file))
+  {
+  }
+  SceneSnapshot::~SceneSnapshot()
+  {
+  }
+  template<typename T>
+  bool SceneSnapshot::resolve(uint64_t offset, uint64_t count, const T*& ptr) const
+  {
+    if (offset % alignof(T) || offset > _file->getSize() || count > (_file->getSize() - offset) / sizeof(T)) {
+      return false;
+    }
+    ptr = reinterpret_cast<const T*>(_file->getData() + offset);
+    return true;
+  }
+  bool SceneSnapshot::fixup()
+  {
+    if (!resolve(0, 1, _header) || std::memcmp(_header->_magic, MAGIC, sizeof(MAGIC)) || _header->_version != VERSION ||
+      _header->_vertexSize != sizeof(Vertex) || _header->_meshRecordSize != sizeof(MeshRecord) || _header->_materialRecordSize != sizeof(MaterialRecord) ||
+      _header->_entityRecordSize != sizeof(EntityRecord) || _header->_nodeSize != sizeof(QuadtreeFlatNode) || _header->_fileSize != _file->getSize()) {
+      return false;
+    }
+    if (!resolve(_header->_meshesOffset, _header->_numMeshes, _meshes) ||
+      !resolve(_header->_materialsOffset, _header->_numMaterials, _materials) ||
+      !resolve(_header->_entitiesOffset, _header->_numEntities, _entities) ||
+      !resolve(_header->_nodesOffset, _header->_numNodes, _nodes) ||
+      !resolve(_header->_nodeElementsOffset, _header->_numNodeElements, _nodeElements)) {
+      return false;
+    }
+    // Validate all references once, so that instantiate() can use them without further checks
+    for (uint32_t i = 0; i < _header->_numMeshes; i++) {
+      const Vertex* vertices;
+      const unsigned* indices;
+      if (!resolve(_meshes[i]._verticesOffset, _meshes[i]._numVertices, vertices) || !resolve(_meshes[i]._indicesOffset, _meshes[i]._numIndices, indices) ||
+        (_meshes[i]._material != NO_INDEX && _meshes[i]._material >= _header->_numMaterials)) {
+        return false;
+      }
+      for (uint32_t j = 0; j < _meshes[i]._numIndices; j++) {
+        if (indices[j] >= _meshes[i]._numVertices) {
+          return false;
+        }
+      }
+    }
+    for (uint32_t i = 0; i < _header->_numMaterials; i++) {
+      const char* str;
+      for (const auto& s : { _materials[i]._diffusePath, _materials[i]._normalPath, _materials[i]._opacityPath, _materials[i]._heightPath }) {
+        if (!resolve(s._offset, s._length, str)) {
+          return false;
+        }
+      }
+    }
+    for (uint32_t i = 0; i < _header->_numEntities; i++) {
+      if (_entities[i]._mesh >= _header->_numMeshes || (_entities[i]._material != NO_INDEX && _entities[i]._material >= _header->_numMaterials)) {
+        return false;
+      }
+    }
+    // Children follow their parent, which rules out cycles, and have a single parent, which makes the nodes a tree
+    std::vector<bool> has_parent(_header->_numNodes, false);
+    for (uint32_t i = 0; i < _header->_numNodes; i++) {
+      for (auto c : _nodes[i]._children) {
+        if (c >= static_cast<int>(_header->_numNodes) || (c >= 0 && (c <= static_cast<int>(i) || has_parent[c]))) {
+          return false;
+        }
+        if (c >= 0) {
+          has_parent[c] = true;
+        }
+      }
+      if (_nodes[i]._firstElement > _header->_numNodeElements || _nodes[i]._numElements > _header->_numNodeElements - _nodes[i]._firstElement) {
+        return false;
+      }
+    }
+    for (uint32_t i = 0; i < _header->_numNodeElements; i++) {
+      if (_nodeElements[i] >= _header->_numEntities) {
+        return false;
+      }
+    }
+    return true;
+  }
+  std::string SceneSnapshot::getString(const StringRef& str) const
+  {
+    return std::string(reinterpret_cast<const char*>(_file->getData() + str._offset), static_cast<size_t>(str._length));
+  }
+  std::vector<std::shared_ptr<Entity>> SceneSnapshot::instantiate(EntityManager& em) const
+  {
+    std::vector<std::shared_ptr<Material>> materials(_header->_numMaterials);
+    for (uint32_t i = 0; i < materials.size(); i++) {
+      const auto& r = _materials[i];
+      materials[i] = std::make_shared<Material>(r._diffuseColor, r._specularExponent, getString(r._diffusePath), getString(r._normalPath), getString(r._opacityPath));
+      materials[i]->setHeightPath(getString(r._heightPath));
+      materials[i]->setHasWindX((r._flags & MATERIAL_WIND_X) != 0, r._windStrength, r._windFrequency);
+      materials[i]->setHasWindZ((r._flags & MATERIAL_WIND_Z) != 0, r._windStrength, r._windFrequency);
+      materials[i]->setIsReflective((r._flags & MATERIAL_REFLECTIVE) != 0);
+      materials[i]->setKa(r._ka);
+      materials[i]->setKd(r._kd);
+      materials[i]->setKs(r._ks);
+      materials[i]->setParallaxHeightScale(r._parallaxHeightScale);
+      materials[i]->setParallaxMinSteps(r._parallaxMinSteps);
+      materials[i]->setParallaxMaxSteps(r._parallaxMaxSteps);
+      materials[i]->setParallaxBinarySearchSteps(r._parallaxBinarySearchSteps);
+    }
+    // Copying the geometry out of the mapping is the bulk of the work, meshes are independent
+    std::vector<std::shared_ptr<Mesh>> meshes(_header->_numMeshes);
+    parallelFor(0, meshes.size(), [this, &meshes, &materials](size_t i) {
+      const auto& r = _meshes[i];
+      auto vertices = reinterpret_cast<const Vertex*>(_file->getData() + r._verticesOffset);
+      auto indices = reinterpret_cast<const unsigned*>(_file->getData() + r._indicesOffset);
+      meshes[i] = std::make_shared<Mesh>(vertices, r._numVertices, indices, r._numIndices, r._materialIndex, AABB(r._aabbMin, r._aabbMax));
+      if (r._material != NO_INDEX) {
+        meshes[i]->setMaterial(materials[r._material]);
+      }
+    }, 1);
+    std::vector<std::shared_ptr<Entity>> entities(_header->_numEntities);
+    for (uint32_t i = 0; i < entities.size(); i++) {
+      const auto& r = _entities[i];
+      entities[i] = em.createEntity();
+      if (r._flags & ENTITY_TRANSFORM) {
+        entities[i]->addComponent(std::make_shared<Transform>(r._translation, r._scale, r._degrees));
+      }
+      auto smr = std::make_shared<StaticMeshRenderable>(meshes[r._mesh], r._material != NO_INDEX ? materials[r._material] : nullptr,
+        r._modelMatrix, r._modelMatrixInverse, AABB(r._aabbMin, r._aabbMax), (r._flags & ENTITY_WIND) != 0);
+      smr->setWindParams(r._windParams);
+      entities[i]->addComponent(smr);
+    }
+    return entities;
+  }
+  const QuadtreeFlatNode* SceneSnapshot::getSpatialIndexNodes() const
+  {
+    return _nodes;
+  }
+  unsigned SceneSnapshot::getNumSpatialIndexNodes() const
+  {
+    return _header->_numNodes;
+  }
+  std::vector<Entity*> SceneSnapshot::getSpatialIndexElements(const std::vector<std::shared_ptr<Entity>>& entities) const
+  {
+    std::vector<Entity*> elements(_header->_numNodeElements);
+    for (uint32_t i = 0; i < elements.size(); i++) {
+      elements[i] = entities[_nodeElements[i]].get();
+    }
+    return elements;
+  }
+  unsigned SceneSnapshot::getNumEntities() const
+  {
+    return _header->_numEntities;
+  }
+}
@@ -1,22 +1,49 @@
 #include <StaticMeshRenderable.h>
 #include <Mesh.h>
+#include <Transform.h>
+#include <math/Batch.h>
 
 namespace fly
 {
   StaticMeshRenderable::StaticMeshRenderable(const std::shared_ptr<Mesh>& mesh, const std::shared_ptr<Material>& material, 
     const Mat4f & model_matrix, bool has_wind, const Vec3f& aabb_offset) :
+    _modelMatrix(model_matrix),
+    _modelMatrixInverse(inverse(upperLeft(model_matrix))),
+    _mesh(mesh),
+    _material(material),
+    _hasWind(has_wind)
+  {
+    computeAABBWorld(aabb_offset);
+  }
+  StaticMeshRenderable::StaticMeshRenderable(const std::shared_ptr<Mesh>& mesh, const std::shared_ptr<Material>& material,
+    const Transform& transform, bool has_wind, const Vec3f& aabb_offset) :
+    _modelMatrix(transform.getWorldMatrix()),
+    _modelMatrixInverse(transform.getNormalMatrix()),
     _mesh(mesh),
     _material(material),
+    _hasWind(has_wind)
+  {
+    computeAABBWorld(aabb_offset);
+  }
+  StaticMeshRenderable::StaticMeshRenderable(const std::shared_ptr<Mesh>& mesh, const std::shared_ptr<Material>& material,
+    const Mat4f& model_matrix, const Mat3f& model_matrix_inverse, const AABB& aabb_world, bool has_wind) :
     _modelMatrix(model_matrix),
-    _modelMatrixInverse(inverse(glm::mat3(model_matrix))),
+    _modelMatrixInverse(model_matrix_inverse),
+    _mesh(mesh),
+    _material(material),
+    _aabbWorld(std::make_unique<AABB>(aabb_world)),
     _hasWind(has_wind)
+  {
+    _windParams._pivotWorld = _aabbWorld->getMax()[1];
+    _windParams._bendFactorExponent = 2.5f;
+  }
+  void StaticMeshRenderable::computeAABBWorld(const Vec3f& aabb_offset)
   {
     Vec3f bb_min(std::numeric_limits<float>::max());
     Vec3f bb_max(std::numeric_limits<float>::lowest());
-    for (const auto& v : mesh->getVertices()) {
-      Vec3f v_world = (model_matrix * Vec4f(v._position, 1.f)).xyz();
-      bb_min = minimum(bb_min, v_world);
-      bb_max = maximum(bb_max, v_world);
+    const auto& vertices = _mesh->getVertices();
+    if (vertices.size()) {
+      minMaxReduce(_modelMatrix, &vertices[0]._position, vertices.size(), sizeof(Vertex), bb_min, bb_max);
     }
     bb_min -= aabb_offset;
     bb_max += aabb_offset;
@@ -6,7 +6,7 @@ namespace fly
 {
   StaticModelRenderable::StaticModelRenderable(const std::vector<std::shared_ptr<Model>>& lods, const std::shared_ptr<Transform>& transform, float lod_divisor) :
     _lods(lods),
-    _modelMatrix(transform->getModelMatrix()),
+    _modelMatrix(transform->getWorldMatrix()),
     _maxLod(lods.size() - 1),
     _lodMultiplier(1.f / lod_divisor)
   {
@@ -1,4 +1,8 @@
 #include "System.h"
+#if defined(__GNUG__)
+#include <cxxabi.h>
+#include <cstdlib>
+#endif
 
 namespace fly
 {
@@ -8,4 +12,56 @@ namespace fly
   System::~System()
   {
   }
-}
\ No newline at end of file
+  void System::onComponentTypesChanged(Entity* entity, const std::set<std::type_index>&)
+  {
+    onComponentsChanged(entity);
+  }
+  std::string System::getName() const
+  {
+    // Demangled class name without namespaces, MSVC names are already readable but prefixed with "class "
+    std::string name = typeid(*this).name();
+#if defined(__GNUG__)
+    int status = 0;
+    char* demangled = abi::__cxa_demangle(name.c_str(), nullptr, nullptr, &status);
+    if (demangled) {
+      name = demangled;
+      std::free(demangled);
+    }
+#endif
+    auto pos = name.rfind("::");
+    if (pos != std::string::npos) {
+      return name.substr(pos + 2);
+    }
+    pos = name.rfind(' ');
+    return pos != std::string::npos ? name.substr(pos + 1) : name;
+  }
+  bool System::declaresAccess() const
+  {
+    return _reads.size() || _writes.size();
+  }
+  const std::set<std::type_index>& System::getReads() const
+  {
+    return _reads;
+  }
+  const std::set<std::type_index>& System::getWrites() const
+  {
+    return _writes;
+  }
+  bool System::conflictsWith(const System& other) const
+  {
+    if (!declaresAccess() || !other.declaresAccess()) {
+      return true;
+    }
+    for (const auto& w : _writes) {
+      if (other._reads.count(w) || other._writes.count(w)) {
+        return true;
+      }
+    }
+    for (const auto& w : other._writes) {
+      if (_reads.count(w)) {
+        return true;
+      }
+    }
+    return false;
+  }
+}
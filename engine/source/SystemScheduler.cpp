@@ -0,0 +1,98 @@
+#include <SystemScheduler.h>
+#include <System.h>
+#include <ThreadPool.h>
+#include <Timing.h>
+#include <iostream>
+#include <mutex>
+#include <functional>
+
+namespace fly
+{
+  SystemScheduler::SystemScheduler(ThreadPool& pool) : _pool(pool)
+  {
+  }
+  void SystemScheduler::setSystems(const std::vector<std::shared_ptr<System>>& systems)
+  {
+    _nodes.clear();
+    _nodes.resize(systems.size());
+    _timings.resize(systems.size());
+    for (unsigned i = 0; i < systems.size(); i++) {
+      _nodes[i]._system = systems[i];
+      _nodes[i]._exclusive = !systems[i]->declaresAccess();
+      _timings[i]._name = systems[i]->getName();
+      _timings[i]._microSeconds = 0;
+      for (unsigned j = 0; j < i; j++) {
+        if (systems[j]->conflictsWith(*systems[i])) {
+          _nodes[j]._successors.push_back(i);
+          _nodes[i]._numPredecessors++;
+        }
+      }
+    }
+    _remaining = std::unique_ptr<std::atomic<unsigned>[]>(new std::atomic<unsigned>[systems.size()]);
+  }
+  void SystemScheduler::update(float time, float delta_time)
+  {
+    unsigned num_nodes = static_cast<unsigned>(_nodes.size());
+    _numFinished = 0;
+    for (unsigned i = 0; i < num_nodes; i++) {
+      _remaining[i] = _nodes[i]._numPredecessors;
+    }
+    ThreadPool::TaskGroup group;
+    std::mutex main_mutex;
+    std::vector<unsigned> main_queue;
+    std::function<void(unsigned)> dispatch;
+    auto run = [&](unsigned i) {
+      Timing timing;
+      _nodes[i]._system->update(time, delta_time);
+      _timings[i]._microSeconds = timing.duration<std::chrono::microseconds>();
+      for (auto s : _nodes[i]._successors) {
+        if (_remaining[s].fetch_sub(1, std::memory_order_acq_rel) == 1) {
+          dispatch(s);
+        }
+      }
+      _numFinished.fetch_add(1, std::memory_order_release);
+    };
+    dispatch = [&](unsigned i) {
+      if (_nodes[i]._exclusive) {
+        std::lock_guard<std::mutex> lock(main_mutex);
+        main_queue.push_back(i);
+      }
+      else {
+        _pool.submit(group, [&run, i]() { run(i); });
+      }
+    };
+    for (unsigned i = 0; i < num_nodes; i++) {
+      if (!_nodes[i]._numPredecessors) {
+        dispatch(i);
+      }
+    }
+    while (_numFinished.load(std::memory_order_acquire) < num_nodes) {
+      int next = -1;
+      {
+        std::lock_guard<std::mutex> lock(main_mutex);
+        if (main_queue.size()) {
+          next = main_queue.front();
+          main_queue.erase(main_queue.begin());
+        }
+      }
+      if (next >= 0) {
+        run(next);
+      }
+      else if (!_pool.tryRunPendingTask()) {
+        std::this_thread::yield();
+      }
+    }
+    _pool.wait(group);
+  }
+  const std::vector<SystemScheduler::SystemTiming>& SystemScheduler::getTimings() const
+  {
+    return _timings;
+  }
+  std::ostream& operator<<(std::ostream& os, const SystemScheduler& scheduler)
+  {
+    for (const auto& t : scheduler._timings) {
+      os << t._name << ": " << t._microSeconds << " us" << std::endl;
+    }
+    return os;
+  }
+}
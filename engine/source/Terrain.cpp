@@ -1,15 +1,68 @@
 #define GLM_ENABLE_EXPERIMENTAL
 #include <Terrain.h>
+#include <TerrainPager.h>
+#include <CompressedHeightMap.h>
+#include <ParallelFor.h>
 #include <iostream>
 #include <Model.h>
 #include <map>
+#include <cmath>
 #include <glm/gtx/string_cast.hpp>
 #include <glm/gtc/matrix_access.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/constants.hpp>
 
 #define USE_LOD_DISTANCE 1
 
 namespace fly
 {
+  namespace
+  {
+    AABB tileAABB(const glm::ivec2& pos, int size, const MinMaxPyramid& pyramid)
+    {
+      auto min_max = pyramid.getMinMax(pos, size);
+      return AABB(Vec3f(static_cast<float>(pos.x), min_max._min, static_cast<float>(pos.y)),
+        Vec3f(static_cast<float>(pos.x + size), min_max._max, static_cast<float>(pos.y + size)));
+    }
+    /**
+    * Level 0 of the pyramid is read from the heightmap, sharing the matrix keeps it alive as long as the pyramid.
+    */
+    struct PyramidWithHeights
+    {
+      PyramidWithHeights(const cv::Mat& heights) :
+        _heights(heights),
+        _pyramid(_heights.ptr<float>(), _heights.cols, _heights.rows, _heights.step1())
+      {
+      }
+      cv::Mat _heights;
+      MinMaxPyramid _pyramid;
+    };
+    /**
+    * Integer hash of a scatter grid cell, stream selects independent values of the same cell.
+    */
+    uint32_t hashCell(uint32_t seed, int x, int z, uint32_t stream)
+    {
+      uint32_t h = seed ^ (static_cast<uint32_t>(x) * 0x8da6b343u) ^ (static_cast<uint32_t>(z) * 0xd8163841u) ^ (stream * 0xcb1ab31fu);
+      h ^= h >> 16;
+      h *= 0x7feb352du;
+      h ^= h >> 15;
+      h *= 0x846ca68bu;
+      h ^= h >> 16;
+      return h;
+    }
+    /**
+    * Maps a hash to [0, 1).
+    */
+    float toUnit(uint32_t h)
+    {
+      return static_cast<float>(h >> 8) * (1.f / 16777216.f);
+    }
+    glm::vec2 scatterCandidate(uint32_t seed, int x, int z, float cell_size)
+    {
+      return glm::vec2(x + toUnit(hashCell(seed, x, z, 0)), z + toUnit(hashCell(seed, x, z, 1))) * cell_size;
+    }
+  }
+
   Terrain::Terrain(int tile_size, const WindParams& wind_params, float wind_strength, float grass_height, const glm::vec3& grass_color, const glm::vec3& terrain_col) :
     _tileSize(tile_size),
     _grassColor(grass_color),
@@ -26,10 +79,75 @@ namespace fly
 
   float Terrain::getHeight(int x, int z)
   {
+    if (_pager) {
+      return _pager->getHeight(x, z);
+    }
+    if (_compressedHeightMap) {
+      return _compressedHeightMap->getHeight(x, z);
+    }
     x = glm::clamp(x, 0, _heightMap.cols - 1);
     z = glm::clamp(z, 0, _heightMap.rows - 1);
     return _heightMap.at<float>(z, x);
   }
+
+  float Terrain::sampleHeight(float x, float z)
+  {
+    float x_floor = std::floor(x);
+    float z_floor = std::floor(z);
+    glm::vec2 weight(x - x_floor, z - z_floor);
+    int x0 = static_cast<int>(x_floor);
+    int z0 = static_cast<int>(z_floor);
+    float h00, h10, h01, h11;
+    if (_pager || _compressedHeightMap) {
+      h00 = getHeight(x0, z0);
+      h10 = getHeight(x0 + 1, z0);
+      h01 = getHeight(x0, z0 + 1);
+      h11 = getHeight(x0 + 1, z0 + 1);
+    }
+    else {
+      int x_max = _heightMap.cols - 1;
+      int z_max = _heightMap.rows - 1;
+      int x1 = glm::clamp(x0 + 1, 0, x_max);
+      int z1 = glm::clamp(z0 + 1, 0, z_max);
+      x0 = glm::clamp(x0, 0, x_max);
+      z0 = glm::clamp(z0, 0, z_max);
+      const float* row0 = _heightMap.ptr<float>(z0);
+      const float* row1 = _heightMap.ptr<float>(z1);
+      h00 = row0[x0];
+      h10 = row0[x1];
+      h01 = row1[x0];
+      h11 = row1[x1];
+    }
+    float h0 = h00 + (h10 - h00) * weight.x;
+    float h1 = h01 + (h11 - h01) * weight.x;
+    return h0 + (h1 - h0) * weight.y;
+  }
+
+  glm::vec3 Terrain::sampleNormal(float x, float z)
+  {
+    float left = sampleHeight(x - 1.f, z);
+    float right = sampleHeight(x + 1.f, z);
+    float down = sampleHeight(x, z - 1.f);
+    float up = sampleHeight(x, z + 1.f);
+    return glm::normalize(glm::vec3(left - right, 2.f, down - up));
+  }
+
+  void Terrain::sampleHeights(const glm::vec2* positions, size_t num_positions, float* heights)
+  {
+    parallelFor(0, num_positions, [this, positions, heights](size_t i) {
+      heights[i] = sampleHeight(positions[i].x, positions[i].y);
+    });
+  }
+
+  bool Terrain::rayCast(const glm::vec3& origin, const glm::vec3& dir, float max_t, glm::vec3& hit) const
+  {
+    float t;
+    if (!_minMaxPyramid || !_minMaxPyramid->intersectRay(origin, dir, max_t, t)) {
+      return false;
+    }
+    hit = origin + dir * t;
+    return true;
+  }
   cv::Mat& Terrain::getSplatMap()
   {
     return _splatMap;
@@ -44,33 +162,71 @@ namespace fly
   {
     return _tileSize;
   }
-  void Terrain::getTilesForRendering(std::map<int, std::map<int, int>>& lods, const glm::vec3 & cam_pos_model_space, const glm::mat4& mvp)
+  const std::vector<Terrain::RenderTile>& Terrain::getTilesForRendering(const glm::vec3 & cam_pos_model_space, const Mat4f& mvp, float pixels_per_unit)
   {
-    for (auto& e1 : _tiles) {
-      for (auto& e2 : e1.second) {
-        const auto& tile = e2.second;
-          int lod = glm::distance(glm::vec2(cam_pos_model_space.x, cam_pos_model_space.z), tile.center()) / _tileSize;
-          lod = glm::min(lod, _maxLOD);
-          lods[tile._pos.x][tile._pos.y] = lod;
+    _renderTiles.clear();
+    Vec3f cam_pos(cam_pos_model_space.x, cam_pos_model_space.y, cam_pos_model_space.z);
+    for (size_t i = 0; i < _tiles.size(); i++) {
+      const auto& tile = _tiles[i];
+      float max_error = _maxScreenSpaceError * distance(tile._aabb.closestPoint(cam_pos), cam_pos) / pixels_per_unit;
+      int lod = 0;
+      while (lod < _maxLOD && tile._lodErrors[lod + 1] <= max_error) {
+        lod++;
       }
+      _tileLods[i] = lod;
     }
 
-/*#if !USE_LOD_DISTANCE
-    glm::ivec2 nearest_tile = glm::ivec2(cam_pos_ms.x, cam_pos_ms.z);
-    nearest_tile -= glm::ivec2(nearest_tile.x % _tileSize, nearest_tile.y % _tileSize);
-#endif
-    for (int x = 0; x < _maxIndex; x += _tileSize) {
-      for (int z = 0; z < _maxIndex; z += _tileSize) {
-#if USE_LOD_DISTANCE
-        int lod = glm::distance(glm::vec2(cam_pos_ms.x, cam_pos_ms.z), glm::vec2(x, z) + _tileSize * 0.5f) / _tileSize;
-#else
-        glm::ivec2 dist = abs(glm::ivec2(x, z) - nearest_tile) / _tileSize;
-        int lod = glm::max(dist.x, dist.y);
-#endif
-        lod = glm::min(lod, _maxLOD);
-        lods[x][z] = lod;
+    // The stitched index buffers only bridge one LOD, refine tiles that are more than one LOD coarser than a neighbor
+    bool changed = true;
+    while (changed) {
+      changed = false;
+      for (int z = 0; z < _numTiles.y; z++) {
+        for (int x = 0; x < _numTiles.x; x++) {
+          int& lod = _tileLods[z * _numTiles.x + x];
+          int min_neighbor = std::min(std::min(getTileLod(x - 1, z, lod), getTileLod(x + 1, z, lod)),
+            std::min(getTileLod(x, z - 1, lod), getTileLod(x, z + 1, lod)));
+          if (lod > min_neighbor + 1) {
+            lod = min_neighbor + 1;
+            changed = true;
+          }
+        }
       }
-    }*/
+    }
+
+    for (int z = 0; z < _numTiles.y; z++) {
+      for (int x = 0; x < _numTiles.x; x++) {
+        const auto& tile = _tiles[z * _numTiles.x + x];
+        if (!tile._aabb.intersectsFrustum<false>(mvp)) {
+          continue;
+        }
+        int lod = _tileLods[z * _numTiles.x + x];
+        unsigned mask = 0;
+        if (lod < getTileLod(x, z + 1, lod)) {
+          mask |= GeometryGenerator::North;
+        }
+        if (lod < getTileLod(x + 1, z, lod)) {
+          mask |= GeometryGenerator::East;
+        }
+        if (lod < getTileLod(x, z - 1, lod)) {
+          mask |= GeometryGenerator::South;
+        }
+        if (lod < getTileLod(x - 1, z, lod)) {
+          mask |= GeometryGenerator::West;
+        }
+        _renderTiles.push_back({ tile._pos, lod, mask });
+      }
+    }
+    return _renderTiles;
+  }
+
+  void Terrain::setMaxScreenSpaceError(float pixels)
+  {
+    _maxScreenSpaceError = pixels;
+  }
+
+  float Terrain::getMaxScreenSpaceError() const
+  {
+    return _maxScreenSpaceError;
   }
 
   void Terrain::addTree(const glm::mat4 & transform, float scale)
@@ -83,160 +239,73 @@ namespace fly
     _rootNode->addCloudBillboard(pos, scale);
   }
 
-  std::vector<glm::vec2> Terrain::getTileVertices()
+  size_t Terrain::scatterTrees(const ScatterRules& rules, uint32_t seed, ThreadPool& pool)
   {
-    std::vector<glm::vec2> vertices;
-    for (int x = 0; x <= _tileSize; x++) {
-      for (int z = 0; z <= _tileSize; z++) {
-        _indexMap[x][z] = vertices.size();
-        vertices.push_back(glm::vec2(x, z));
+    if (!_rootNode || rules._minDistance <= 0.f) {
+      return 0;
+    }
+    std::vector<TreeNode*> leaves;
+    getLeafNodes(_rootNode.get(), leaves);
+    std::vector<ScatteredTrees> scattered(leaves.size());
+    float cell_size = rules._minDistance;
+    float min_normal_y = std::cos(rules._maxSlope);
+    glm::vec2 terrain_max(static_cast<float>(_heightMap.cols - 1), static_cast<float>(_heightMap.rows - 1));
+    parallelFor(0, leaves.size(), [&](size_t i) {
+      const TreeNode* leaf = leaves[i];
+      auto& result = scattered[i];
+      glm::ivec2 cell_begin(glm::floor(glm::vec2(leaf->_pos) / cell_size));
+      glm::ivec2 cell_end(glm::ceil(glm::vec2(leaf->_pos + leaf->_size) / cell_size));
+      for (int z = cell_begin.y; z < cell_end.y; z++) {
+        for (int x = cell_begin.x; x < cell_end.x; x++) {
+          glm::vec2 pos = scatterCandidate(seed, x, z, cell_size);
+          if (pos.x < leaf->_pos.x || pos.y < leaf->_pos.y || pos.x >= leaf->_pos.x + leaf->_size || pos.y >= leaf->_pos.y + leaf->_size ||
+            pos.x > terrain_max.x || pos.y > terrain_max.y) {
+            continue;
+          }
+          // Candidates closer than the cell size can only be in the adjacent cells
+          uint32_t priority = hashCell(seed, x, z, 2);
+          bool dominated = false;
+          for (int n_z = z - 1; n_z <= z + 1 && !dominated; n_z++) {
+            for (int n_x = x - 1; n_x <= x + 1 && !dominated; n_x++) {
+              if (n_x == x && n_z == z) {
+                continue;
+              }
+              uint32_t other_priority = hashCell(seed, n_x, n_z, 2);
+              bool higher = other_priority > priority || (other_priority == priority && (n_z < z || (n_z == z && n_x < x)));
+              dominated = higher && glm::distance(scatterCandidate(seed, n_x, n_z, cell_size), pos) < rules._minDistance;
+            }
+          }
+          if (dominated || toUnit(hashCell(seed, x, z, 3)) >= rules._density) {
+            continue;
+          }
+          float height = sampleHeight(pos.x, pos.y);
+          if (height < rules._minHeight || height > rules._maxHeight || sampleNormal(pos.x, pos.y).y < min_normal_y) {
+            continue;
+          }
+          float scale = glm::mix(rules._minScale, rules._maxScale, toUnit(hashCell(seed, x, z, 4)));
+          float angle = toUnit(hashCell(seed, x, z, 5)) * glm::two_pi<float>();
+          auto transform = glm::translate(glm::mat4(1.f), glm::vec3(pos.x, height + rules._heightOffset, pos.y));
+          transform = glm::rotate(transform, angle, glm::vec3(0.f, 1.f, 0.f));
+          result._transforms.push_back(glm::scale(transform, glm::vec3(scale)));
+          result._scales.push_back(scale);
+        }
       }
+    }, 1, pool);
+    size_t num_trees = 0;
+    for (const auto& s : scattered) {
+      num_trees += s._scales.size();
     }
-    return vertices;
-  }
-  std::vector<unsigned> Terrain::getTileIndices(int lod)
-  {
-    return getIndices(lod, glm::uvec2(0), glm::uvec2(0));
-  }
-  std::vector<unsigned> Terrain::getTileIndicesNorth(int lod)
-  {
-    auto indices = getIndices(lod, glm::uvec2(0, 0), glm::uvec2(0, 1));
-    auto skirt = skirtNorth(lod);
-    indices.insert(indices.end(), skirt.begin(), skirt.end());
-    return indices;
-  }
-  std::vector<unsigned> Terrain::getTileIndicesSouth(int lod)
-  {
-    auto indices = getIndices(lod, glm::uvec2(0, 1), glm::uvec2(0, 0));
-    auto skirt = skirtSouth(lod);
-    indices.insert(indices.end(), skirt.begin(), skirt.end());
-    return indices;
-  }
-  std::vector<unsigned> Terrain::getTileIndicesWest(int lod)
-  {
-    auto indices = getIndices(lod, glm::uvec2(1, 0), glm::uvec2(0, 0));
-    auto skirt = skirtWest(lod);
-    indices.insert(indices.end(), skirt.begin(), skirt.end());
-    return indices;
-  }
-  std::vector<unsigned> Terrain::getTileIndicesEast(int lod)
-  {
-    auto indices = getIndices(lod, glm::uvec2(0, 0), glm::uvec2(1, 0));
-    auto skirt = skirtEast(lod);
-    indices.insert(indices.end(), skirt.begin(), skirt.end());
-    return indices;
-  }
-  std::vector<unsigned> Terrain::getTileIndicesNorthSouth(int lod)
-  {
-    auto indices = getIndices(lod, glm::uvec2(0, 1), glm::uvec2(0, 1));
-    auto skirt = skirtSouth(lod);
-    indices.insert(indices.end(), skirt.begin(), skirt.end());
-    skirt = skirtNorth(lod);
-    indices.insert(indices.end(), skirt.begin(), skirt.end());
-    return indices;
-  }
-  std::vector<unsigned> Terrain::getTileIndicesEastWest(int lod)
-  {
-    auto indices = getIndices(lod, glm::uvec2(1, 0), glm::uvec2(1, 0));
-    auto skirt = skirtWest(lod);
-    indices.insert(indices.end(), skirt.begin(), skirt.end());
-    skirt = skirtEast(lod);
-    indices.insert(indices.end(), skirt.begin(), skirt.end());
-    return indices;
+    auto leaf = scattered.cbegin();
+    appendScatteredTrees(_rootNode.get(), leaf);
+    return num_trees;
   }
-  std::vector<unsigned> Terrain::getTileIndicesNorthEast(int lod)
-  {
-    auto indices = getIndices(lod, glm::uvec2(0, 0), glm::uvec2(1, 1));
-    auto skirt = skirtNorth(lod);
-    indices.insert(indices.end(), skirt.begin(), skirt.end() - 3);
-    skirt = skirtEast(lod);
-    indices.insert(indices.end(), skirt.begin(), skirt.end() - 3);
-    return indices;
-  }
-  std::vector<unsigned> Terrain::getTileIndicesNorthWest(int lod)
-  {
-    auto indices = getIndices(lod, glm::uvec2(1, 0), glm::uvec2(0, 1));
-    auto skirt = skirtNorth(lod);
-    indices.insert(indices.end(), skirt.begin() + 3, skirt.end());
-    skirt = skirtWest(lod);
-    indices.insert(indices.end(), skirt.begin(), skirt.end() - 3);
-    return indices;
-  }
-  std::vector<unsigned> Terrain::getTileIndicesSouthWest(int lod)
-  {
-    auto indices = getIndices(lod, glm::uvec2(1, 1), glm::uvec2(0, 0));
-    auto skirt = skirtSouth(lod);
-    indices.insert(indices.end(), skirt.begin() + 3, skirt.end());
-    skirt = skirtWest(lod);
-    indices.insert(indices.end(), skirt.begin() + 3, skirt.end());
-    return indices;
-  }
-  std::vector<unsigned> Terrain::getTileIndicesSouthEast(int lod)
-  {
-    auto indices = getIndices(lod, glm::uvec2(0, 1), glm::uvec2(1, 0));
-    auto skirt = skirtSouth(lod);
-    indices.insert(indices.end(), skirt.begin(), skirt.end() - 3);
-    skirt = skirtEast(lod);
-    indices.insert(indices.end(), skirt.begin() + 3, skirt.end());
-    return indices;
-  }
-  std::vector<unsigned> Terrain::getTileIndicesNorthEastSouth(int lod)
-  {
-    auto indices = getIndices(lod, glm::uvec2(0, 1), glm::uvec2(1, 1));
-    auto skirt = skirtNorth(lod);
-    indices.insert(indices.end(), skirt.begin(), skirt.end() - 3);
-    skirt = skirtEast(lod);
-    indices.insert(indices.end(), skirt.begin() + 3, skirt.end() - 3);
-    skirt = skirtSouth(lod);
-    indices.insert(indices.end(), skirt.begin(), skirt.end() - 3);
-    return indices;
-  }
-  std::vector<unsigned> Terrain::gettileIndicesEastSouthWest(int lod)
-  {
-    auto indices = getIndices(lod, glm::uvec2(1, 1), glm::uvec2(1, 0));
-    auto skirt = skirtEast(lod);
-    indices.insert(indices.end(), skirt.begin() + 3, skirt.end());
-    skirt = skirtSouth(lod);
-    indices.insert(indices.end(), skirt.begin() + 3, skirt.end() - 3);
-    skirt = skirtWest(lod);
-    indices.insert(indices.end(), skirt.begin() + 3, skirt.end());
-    return indices;
-  }
-  std::vector<unsigned> Terrain::getTileIndicesSouthWestNorth(int lod)
-  {
 
-    auto indices = getIndices(lod, glm::uvec2(1, 1), glm::uvec2(0, 1));
-    auto skirt = skirtSouth(lod);
-    indices.insert(indices.end(), skirt.begin() + 3, skirt.end());
-    skirt = skirtWest(lod);
-    indices.insert(indices.end(), skirt.begin() + 3, skirt.end() - 3);
-    skirt = skirtNorth(lod);
-    indices.insert(indices.end(), skirt.begin() + 3, skirt.end());
-    return indices;
-  }
-  std::vector<unsigned> Terrain::getTileIndicesWestNorthEast(int lod)
+  const TerrainIndexPool& Terrain::getIndexPool()
   {
-    auto indices = getIndices(lod, glm::uvec2(1, 0), glm::uvec2(1, 1));
-    auto skirt = skirtWest(lod);
-    indices.insert(indices.end(), skirt.begin(), skirt.end() - 3);
-    skirt = skirtNorth(lod);
-    indices.insert(indices.end(), skirt.begin() + 3, skirt.end() - 3);
-    skirt = skirtEast(lod);
-    indices.insert(indices.end(), skirt.begin(), skirt.end() - 3);
-    return indices;
-  }
-  std::vector<unsigned> Terrain::getTileIndicesNorthWestSouthEast(int lod)
-  {
-    auto indices = getIndices(lod, glm::uvec2(1, 1), glm::uvec2(1, 1));
-    auto skirt = skirtNorth(lod);
-    indices.insert(indices.end(), skirt.begin() + 3, skirt.end() - 3);
-    skirt = skirtWest(lod);
-    indices.insert(indices.end(), skirt.begin() + 3, skirt.end() - 3);
-    skirt = skirtSouth(lod);
-    indices.insert(indices.end(), skirt.begin() + 3, skirt.end() - 3);
-    skirt = skirtEast(lod);
-    indices.insert(indices.end(), skirt.begin() + 3, skirt.end() - 3);
-    return indices;
+    if (!_indexPool) {
+      _indexPool = std::make_unique<TerrainIndexPool>(_tileSize, _maxLOD + 1);
+    }
+    return *_indexPool;
   }
   int Terrain::getMaxLOD()
   {
@@ -246,6 +315,8 @@ namespace fly
   void Terrain::setHeightMap(const cv::Mat & height_map)
   {
     _heightMap = height_map;
+    auto pyramid = std::make_shared<PyramidWithHeights>(_heightMap);
+    _minMaxPyramid = std::shared_ptr<const MinMaxPyramid>(pyramid, &pyramid->_pyramid);
     _rootNode = std::unique_ptr<TreeNode>(new TreeNode(glm::ivec2(0), height_map.cols));
     buildQuadtree(_rootNode.get());
   }
@@ -257,11 +328,12 @@ namespace fly
 
   std::vector<unsigned> Terrain::getPointIndices(int lod)
   {
+    static_assert(stepFromLOD(0) == 1 && stepFromLOD(1) == 2 && stepFromLOD(5) == 32, "Each lod halves the resolution");
     std::vector<unsigned> indices;
     auto step = stepFromLOD(lod);
     for (int x = 0; x <= _tileSize; x += step) {
       for (int z = 0; z <= _tileSize; z += step) {
-        indices.push_back(_indexMap[x][z]);
+        indices.push_back(z * (_tileSize + 1) + x);
       }
     }
     return indices;
@@ -309,21 +381,61 @@ namespace fly
 
   void Terrain::getAllNodes(std::vector<TreeNode*>& nodes)
   {
+    if (_pager) {
+      std::vector<const TerrainPager::Page*> pages;
+      _pager->getResidentPages(pages);
+      for (auto p : pages) {
+        getAllNodes(p->_rootNode.get(), nodes);
+      }
+      return;
+    }
     getAllNodes(_rootNode.get(), nodes);
   }
 
   void Terrain::getTreeNodesForRendering(const glm::vec3 & cam_pos_model_space, std::vector<TreeNode*>& nodes, const Mat4f& mvp, DirectionalLight* dl, const Mat4f& light_mvp)
   {
+    if (_pager) {
+      std::vector<const TerrainPager::Page*> pages;
+      _pager->getResidentPages(pages);
+      for (auto p : pages) {
+        getTreeNodesForRendering(p->_rootNode.get(), cam_pos_model_space, nodes, mvp, dl, light_mvp);
+      }
+      return;
+    }
     getTreeNodesForRendering(_rootNode.get(), cam_pos_model_space, nodes, mvp, dl, light_mvp);
   }
 
+  void Terrain::setPager(const std::shared_ptr<TerrainPager>& pager)
+  {
+    _pager = pager;
+  }
+
+  const std::shared_ptr<TerrainPager>& Terrain::getPager() const
+  {
+    return _pager;
+  }
+
+  void Terrain::setCompressedHeightMap(const std::shared_ptr<const CompressedHeightMap>& height_map)
+  {
+    _compressedHeightMap = height_map;
+  }
+
+  const std::shared_ptr<const CompressedHeightMap>& Terrain::getCompressedHeightMap() const
+  {
+    return _compressedHeightMap;
+  }
+
   void Terrain::generateTiles()
   {
-    for (int x = 0; x < _heightMap.cols; x += _tileSize) {
-      for (int z = 0; z < _heightMap.rows; z += _tileSize) {
-        _tiles[x].insert(std::make_pair(z, Tile(glm::ivec2(x, z), this)));
+    _numTiles = glm::ivec2((_heightMap.cols + _tileSize - 1) / _tileSize, (_heightMap.rows + _tileSize - 1) / _tileSize);
+    _tiles.clear();
+    _tiles.reserve(_numTiles.x * _numTiles.y);
+    for (int z = 0; z < _numTiles.y; z++) {
+      for (int x = 0; x < _numTiles.x; x++) {
+        _tiles.push_back(Tile(glm::ivec2(x, z) * _tileSize, _tileSize, _maxLOD + 1, *_minMaxPyramid));
       }
     }
+    _tileLods.resize(_tiles.size());
   }
 
   float Terrain::getGrassHeight()
@@ -338,24 +450,30 @@ namespace fly
 
   void Terrain::build()
   {
+    if (_pager || !_minMaxPyramid) { // Pages compute their bounds while loading
+      return;
+    }
+
     std::vector<TreeNode*> nodes;
     getAllNodes(nodes);
 
-    for (auto& n : nodes) {
-      n->_maxHeight = std::numeric_limits<float>::lowest();
-      n->_minHeight = std::numeric_limits<float>::max();
-      for (int x = n->_pos.x; x <= n->_pos.x + n->_size; x++) {
-        for (int y = n->_pos.y; y <= n->_pos.y + n->_size; y++) {
-          n->_maxHeight = std::max(n->_maxHeight, getHeight(x, y));
-          n->_minHeight = std::min(n->_minHeight, getHeight(x, y));
-        }
-      }
+    parallelFor(0, nodes.size(), [this, &nodes](size_t i) {
+      auto n = nodes[i];
+      auto min_max = _minMaxPyramid->getMinMax(n->_pos, n->_size);
+      n->_minHeight = min_max._min;
+      n->_maxHeight = min_max._max;
 
-      Vec3f bb_min({ static_cast<float>(n->_pos.x),static_cast<float>(n->_minHeight), static_cast<float>(n->_pos.y) });
-      Vec3f bb_max({ static_cast<float>(n->_pos.x + n->_size), static_cast<float>(n->_maxHeight), static_cast<float>(n->_pos.y + n->_size) });
+      Vec3f bb_min(static_cast<float>(n->_pos.x), n->_minHeight, static_cast<float>(n->_pos.y));
+      Vec3f bb_max(static_cast<float>(n->_pos.x + n->_size), n->_maxHeight, static_cast<float>(n->_pos.y + n->_size));
 
+      delete n->_aabb;
       n->_aabb = new AABB(bb_min, bb_max);
-    }
+    });
+  }
+
+  const std::shared_ptr<const MinMaxPyramid>& Terrain::getMinMaxPyramid() const
+  {
+    return _minMaxPyramid;
   }
 
   void Terrain::getAllNodes(TreeNode * node, std::vector<TreeNode*>& nodes)
@@ -395,108 +513,6 @@ namespace fly
     }
   }
 
-  std::vector<unsigned int> Terrain::getIndices(int lod, const glm::uvec2& low_offs, const glm::uvec2& up_offs)
-  {
-    auto step = stepFromLOD(lod);
-    std::vector<unsigned> indices;
-    glm::ivec2 from = glm::ivec2(low_offs) * step;
-    glm::ivec2 to = _tileSize - glm::ivec2(up_offs) * step;
-    for (int x = from.x; x + step <= to.x; x += step) {
-      for (int z = from.y; z + step <= to.y; z += step) {
-        indices.push_back(_indexMap[x][z]);
-        indices.push_back(_indexMap[x][z + step]);
-        indices.push_back(_indexMap[x + step][z]);
-        indices.push_back(_indexMap[x + step][z + step]);
-        indices.push_back(_indexMap[x + step][z]);
-        indices.push_back(_indexMap[x][z + step]);
-      }
-    }
-    return indices;
-  }
-  std::vector<unsigned> Terrain::skirtNorth(int lod)
-  {
-    auto step = stepFromLOD(lod);
-    std::vector<unsigned> indices;
-    for (int x = 0; x + step * 2 <= _tileSize; x += step * 2) {
-      int z = _tileSize - step;
-      indices.push_back(_indexMap[x][z]);
-      indices.push_back(_indexMap[x][z + step]);
-      indices.push_back(_indexMap[x + step][z]);
-
-      indices.push_back(_indexMap[x][z + step]);
-      indices.push_back(_indexMap[x + step * 2][z + step]);
-      indices.push_back(_indexMap[x + step][z]);
-
-      indices.push_back(_indexMap[x + step][z]);
-      indices.push_back(_indexMap[x + step * 2][z + step]);
-      indices.push_back(_indexMap[x + step * 2][z]);
-    }
-    return indices;
-  }
-  std::vector<unsigned> Terrain::skirtEast(int lod)
-  {
-    auto step = stepFromLOD(lod);
-    std::vector<unsigned> indices;
-    for (int z = 0; z + step * 2 <= _tileSize; z += step * 2) {
-      int x = _tileSize - step;
-      indices.push_back(_indexMap[x][z]);
-      indices.push_back(_indexMap[x][step + z]);
-      indices.push_back(_indexMap[x + step][z]);
-
-      indices.push_back(_indexMap[x + step][z]);
-      indices.push_back(_indexMap[x][z + step]);
-      indices.push_back(_indexMap[x + step][z + step * 2]);
-
-      indices.push_back(_indexMap[x][z + step]);
-      indices.push_back(_indexMap[x][z + step * 2]);
-      indices.push_back(_indexMap[x + step][z + step * 2]);
-    }
-    return indices;
-  }
-  std::vector<unsigned> Terrain::skirtWest(int lod)
-  {
-    auto step = stepFromLOD(lod); {}
-    std::vector<unsigned> indices;
-    for (int z = 0; z + step * 2 <= _tileSize; z += step * 2) {
-      int x = 0;
-      indices.push_back(_indexMap[x][z]);
-      indices.push_back(_indexMap[x + step][z + step]);
-      indices.push_back(_indexMap[x + step][z]);
-
-      indices.push_back(_indexMap[x][z]);
-      indices.push_back(_indexMap[x][z + step * 2]);
-      indices.push_back(_indexMap[x + step][z + step]);
-
-      indices.push_back(_indexMap[x][z + step * 2]);
-      indices.push_back(_indexMap[x + step][z + step * 2]);
-      indices.push_back(_indexMap[x + step][z + step]);
-    }
-    return indices;
-  }
-  std::vector<unsigned> Terrain::skirtSouth(int lod)
-  {
-    auto step = stepFromLOD(lod);
-    std::vector<unsigned> indices;
-    for (int x = 0; x + step * 2 <= _tileSize; x += step * 2) {
-      int z = step;
-      indices.push_back(_indexMap[x][z]);
-      indices.push_back(_indexMap[x + step][z]);
-      indices.push_back(_indexMap[x][z - step]);
-
-      indices.push_back(_indexMap[x][z - step]);
-      indices.push_back(_indexMap[x + step][z]);
-      indices.push_back(_indexMap[x + step * 2][z - step]);
-
-      indices.push_back(_indexMap[x + step][z]);
-      indices.push_back(_indexMap[x + step * 2][z]);
-      indices.push_back(_indexMap[x + step * 2][z - step]);
-    }
-    return indices;
-  }
-  int Terrain::stepFromLOD(int lod)
-  {
-    return pow(2, lod);
-  }
   void Terrain::buildQuadtree(TreeNode * node)
   {
     int new_size = node->_size / 2;
@@ -512,6 +528,34 @@ namespace fly
     }
   }
 
+  void Terrain::getLeafNodes(TreeNode* node, std::vector<TreeNode*>& leaves)
+  {
+    if (!node->_southWest) {
+      leaves.push_back(node);
+      return;
+    }
+    getLeafNodes(node->_southWest, leaves);
+    getLeafNodes(node->_southEast, leaves);
+    getLeafNodes(node->_northWest, leaves);
+    getLeafNodes(node->_northEast, leaves);
+  }
+
+  void Terrain::appendScatteredTrees(TreeNode* node, std::vector<ScatteredTrees>::const_iterator& leaf)
+  {
+    if (!node->_southWest) {
+      node->_transforms.insert(node->_transforms.end(), leaf->_transforms.begin(), leaf->_transforms.end());
+      node->_scales.insert(node->_scales.end(), leaf->_scales.begin(), leaf->_scales.end());
+      ++leaf;
+      return;
+    }
+    for (auto child : { node->_southWest, node->_southEast, node->_northWest, node->_northEast }) {
+      size_t begin = child->_transforms.size();
+      appendScatteredTrees(child, leaf);
+      node->_transforms.insert(node->_transforms.end(), child->_transforms.begin() + begin, child->_transforms.end());
+      node->_scales.insert(node->_scales.end(), child->_scales.begin() + begin, child->_scales.end());
+    }
+  }
+
   Terrain::TreeNode::TreeNode(const glm::ivec2 & pos, int size) : _pos(pos), _size(size)
   {
   /*  for (unsigned int i = 0; i < all_transforms.size(); i++) {
@@ -580,49 +624,30 @@ namespace fly
     return glm::vec3(grid_center.x, (_minHeight + _maxHeight) * 0.5f, grid_center.y);
   }
 
-  Terrain::Tile::Tile(const glm::ivec2 & pos, Terrain * g) : _pos(pos), _size(g->_tileSize)
+  Terrain::Tile::Tile(const glm::ivec2 & pos, int size, int num_lods, const MinMaxPyramid& pyramid) : _pos(pos), _size(size),
+    _aabb(tileAABB(pos, size, pyramid))
   {
-    float min_height = std::numeric_limits<float>::max();
-    float max_height = std::numeric_limits<float>::lowest();
-    for (int x = pos.x; x <= pos.x + g->_tileSize; x++) {
-      for (int z = pos.y; z <= pos.y + g->_tileSize; z++) {
-        float height = g->getHeight(x, z);
-        min_height = std::min(min_height, height);
-        max_height = std::max(max_height, height);
+    _lodErrors.push_back(0.f);
+    for (int lod = 1; lod < num_lods; lod++) {
+      if (lod >= static_cast<int>(pyramid.getNumLevels())) { // Cells larger than the heightmap
+        _lodErrors.push_back(_aabb.getMax()[1] - _aabb.getMin()[1]);
+        continue;
+      }
+      float error = 0.f;
+      int num_cells = size >> lod;
+      for (int z = 0; z < num_cells; z++) {
+        for (int x = 0; x < num_cells; x++) {
+          auto min_max = pyramid.getMinMax(lod, (pos.x >> lod) + x, (pos.y >> lod) + z);
+          error = std::max(error, min_max._max - min_max._min);
+        }
       }
+      _lodErrors.push_back(error);
     }
-
-    glm::vec3 bb_min(pos.x, min_height, pos.y);
-    glm::vec3 bb_max(pos.x + g->_tileSize + 1, max_height, pos.y + g->_tileSize + 1);
-
-    _aabb[0] = glm::vec3(bb_min.x, bb_min.y, bb_min.z);
-    _aabb[1] = glm::vec3(bb_max.x, bb_min.y, bb_min.z);
-    _aabb[2] = glm::vec3(bb_min.x, bb_max.y, bb_min.z);
-    _aabb[3] = glm::vec3(bb_min.x, bb_min.y, bb_max.z);
-    _aabb[4] = glm::vec3(bb_max.x, bb_max.y, bb_min.z);
-    _aabb[5] = glm::vec3(bb_min.x, bb_max.y, bb_max.z);
-    _aabb[6] = glm::vec3(bb_max.x, bb_min.y, bb_max.z);
-    _aabb[7] = glm::vec3(bb_max.x, bb_max.y, bb_max.z);
   }
   glm::vec2 Terrain::Tile::center() const
   {
     return glm::vec2(_pos) + _size * 0.5f;
   }
-  bool Terrain::Tile::isVisible(const glm::mat4& mvp) const
-  {
-    bool inside_left = false, inside_right = false, inside_bottom = false, inside_top = false, inside_near = false, inside_far = false;
-    for (unsigned int i = 0; i < 8; i++) {
-      auto p = mvp * glm::vec4(_aabb[i], 1.f);
-      inside_left = inside_left || p.x >= -p.w;
-      inside_right = inside_right || p.x <= p.w;
-      inside_bottom = inside_bottom || p.y >= -p.w;
-      inside_top = inside_top || p.y <= p.w;
-      inside_near = inside_near || p.z >= -p.w;
-      inside_far = inside_far || p.z <= p.w;
-    }
-    bool inside = inside_left && inside_right && inside_bottom && inside_top && inside_near && inside_far;
-    return inside;
-  }
   Terrain::WindParams::WindParams(const glm::vec2 & dir, float strength, float frequency) : _dir(dir), _strength(strength), _frequency(frequency)
   {
   }
@@ -0,0 +1,195 @@
+#include <TerrainIndexPool.h>
+#include <MappedFile.h>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+namespace fly
+{
+  namespace
+  {
+    const char MAGIC[4] = { 'F', 'L', 'Y', 'I' };
+  }
+
+  TerrainIndexPool::TerrainIndexPool(int tile_size, unsigned num_lods, unsigned cache_size) :
+    _tileSize(tile_size),
+    _numLods(num_lods)
+  {
+    generateVertices();
+    _infos.resize(num_lods * NUM_MASKS);
+    for (unsigned lod = 0; lod < num_lods; lod++) {
+      for (unsigned mask = 0; mask < NUM_MASKS; mask++) {
+        generateIndices(lod, mask, cache_size);
+      }
+    }
+  }
+
+  bool TerrainIndexPool::save(const std::string& path) const
+  {
+    std::ofstream os(path, std::ios::binary);
+    if (!os.good()) {
+      std::cout << "TerrainIndexPool::save() Failed to open " << path << std::endl;
+      return false;
+    }
+    Header header = {};
+    std::memcpy(header._magic, MAGIC, sizeof(MAGIC));
+    header._version = VERSION;
+    header._tileSize = _tileSize;
+    header._numLods = _numLods;
+    header._numIndices = static_cast<uint32_t>(_indices.size());
+    os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    os.write(reinterpret_cast<const char*>(_infos.data()), _infos.size() * sizeof(_infos.front()));
+    os.write(reinterpret_cast<const char*>(_indices.data()), _indices.size() * sizeof(_indices.front()));
+    return os.good();
+  }
+
+  std::unique_ptr<TerrainIndexPool> TerrainIndexPool::load(const std::string& path)
+  {
+    MappedFile file(path);
+    if (!file.getData() || file.getSize() < sizeof(Header)) {
+      return nullptr;
+    }
+    auto header = reinterpret_cast<const Header*>(file.getData());
+    size_t infos_size = static_cast<size_t>(header->_numLods) * NUM_MASKS * sizeof(GeometryGenerator::IndexBufferInfo);
+    size_t indices_size = static_cast<size_t>(header->_numIndices) * sizeof(unsigned);
+    // The tile size is limited so that the (tile size + 1)^2 vertices can be indexed with 32 bits
+    if (std::memcmp(header->_magic, MAGIC, sizeof(MAGIC)) || header->_version != VERSION || !header->_tileSize || header->_tileSize >= 65535u ||
+      header->_numLods > header->_tileSize || file.getSize() < sizeof(Header) + infos_size + indices_size) {
+      std::cout << "TerrainIndexPool::load() " << path << " is not a valid index pool of version " << VERSION << std::endl;
+      return nullptr;
+    }
+    std::unique_ptr<TerrainIndexPool> pool(new TerrainIndexPool());
+    pool->_tileSize = header->_tileSize;
+    pool->_numLods = header->_numLods;
+    pool->generateVertices();
+    pool->_infos.resize(header->_numLods * NUM_MASKS);
+    std::memcpy(pool->_infos.data(), file.getData() + sizeof(Header), infos_size);
+    pool->_indices.resize(header->_numIndices);
+    std::memcpy(pool->_indices.data(), file.getData() + sizeof(Header) + infos_size, indices_size);
+    // Validate all permutations once, so that rendering can use them without further checks
+    bool valid = true;
+    for (const auto& info : pool->_infos) {
+      valid = valid && info._offset <= header->_numIndices && info._numIndices <= header->_numIndices - info._offset;
+    }
+    size_t num_vertices = pool->_vertices.size();
+    valid = valid && std::all_of(pool->_indices.begin(), pool->_indices.end(), [num_vertices](unsigned i) {
+      return i < num_vertices;
+    });
+    if (!valid) {
+      std::cout << "TerrainIndexPool::load() " << path << " contains indices outside of the tile" << std::endl;
+      return nullptr;
+    }
+    return pool;
+  }
+
+  const std::vector<glm::vec2>& TerrainIndexPool::getVertices() const
+  {
+    return _vertices;
+  }
+
+  const std::vector<unsigned>& TerrainIndexPool::getIndices() const
+  {
+    return _indices;
+  }
+
+  int TerrainIndexPool::getTileSize() const
+  {
+    return _tileSize;
+  }
+
+  unsigned TerrainIndexPool::getNumLods() const
+  {
+    return _numLods;
+  }
+
+  void TerrainIndexPool::generateVertices()
+  {
+    _vertices.clear();
+    for (int z = 0; z <= _tileSize; z++) {
+      for (int x = 0; x <= _tileSize; x++) {
+        _vertices.push_back(glm::vec2(x, z));
+      }
+    }
+  }
+
+  void TerrainIndexPool::generateIndices(unsigned lod, unsigned mask, unsigned cache_size)
+  {
+    int size = _tileSize;
+    int step = 1 << lod;
+    auto getIndex = [size](int x, int z) {
+      return static_cast<unsigned>(z * (size + 1) + x);
+    };
+    unsigned offset = static_cast<unsigned>(_indices.size());
+
+    // Interior cells in stripes of stripe_width cells, the vertices shared with the previous row stay in the cache
+    glm::ivec2 begin((mask & GeometryGenerator::West) ? step : 0, (mask & GeometryGenerator::South) ? step : 0);
+    glm::ivec2 end(size - ((mask & GeometryGenerator::East) ? step : 0), size - ((mask & GeometryGenerator::North) ? step : 0));
+    int stripe_width = (std::max)(static_cast<int>(cache_size) / 2 - 1, 1) * step;
+    for (int stripe = begin.x; stripe + step <= end.x; stripe += stripe_width) {
+      int stripe_end = (std::min)(stripe + stripe_width, end.x);
+      for (int z = begin.y; z + step <= end.y; z += step) {
+        for (int x = stripe; x + step <= stripe_end; x += step) {
+          unsigned quad[] = { getIndex(x, z), getIndex(x, z + step), getIndex(x + step, z),
+            getIndex(x + step, z), getIndex(x, z + step), getIndex(x + step, z + step) };
+          _indices.insert(_indices.end(), quad, quad + 6);
+        }
+      }
+    }
+
+    // Stitched edges, three triangles per two cells. If the adjacent edge at a corner is stitched as well,
+    // the corner triangle of this edge is dropped since the other edge covers it.
+    auto addSkirt = [this, mask](const std::vector<unsigned>& skirt, unsigned begin_flag, unsigned end_flag) {
+      if (skirt.size() < 6) {
+        _indices.insert(_indices.end(), skirt.begin(), skirt.end());
+        return;
+      }
+      _indices.insert(_indices.end(), skirt.begin() + ((mask & begin_flag) ? 3 : 0), skirt.end() - ((mask & end_flag) ? 3 : 0));
+    };
+    auto genSkirtHorizontal = [size, getIndex, step](int z, int z_dir, bool swap) {
+      std::vector<unsigned> indices;
+      for (int x = 0; x + step * 2 <= size; x += step * 2) {
+        unsigned tris[] = { getIndex(x, z), getIndex(x, z + step * z_dir), getIndex(x + step, z),
+          getIndex(x, z + step * z_dir), getIndex(x + 2 * step, z + step * z_dir), getIndex(x + step, z),
+          getIndex(x + step, z), getIndex(x + 2 * step, z + step * z_dir), getIndex(x + 2 * step, z) };
+        if (swap) {
+          std::swap(tris[0], tris[1]);
+          std::swap(tris[3], tris[4]);
+          std::swap(tris[6], tris[7]);
+        }
+        indices.insert(indices.end(), tris, tris + 9);
+      }
+      return indices;
+    };
+    auto genSkirtVertical = [size, getIndex, step](int x, int x_dir, bool swap) {
+      std::vector<unsigned> indices;
+      for (int z = 0; z + step * 2 <= size; z += step * 2) {
+        unsigned tris[] = { getIndex(x, z), getIndex(x + step * x_dir, z), getIndex(x, z + step),
+          getIndex(x, z + step), getIndex(x + step * x_dir, z), getIndex(x + step * x_dir, z + step * 2),
+          getIndex(x, z + step), getIndex(x + step * x_dir, z + step * 2), getIndex(x, z + step * 2) };
+        if (swap) {
+          std::swap(tris[0], tris[1]);
+          std::swap(tris[3], tris[4]);
+          std::swap(tris[6], tris[7]);
+        }
+        indices.insert(indices.end(), tris, tris + 9);
+      }
+      return indices;
+    };
+    if (mask & GeometryGenerator::North) {
+      addSkirt(genSkirtHorizontal(size - step, 1, false), GeometryGenerator::West, GeometryGenerator::East);
+    }
+    if (mask & GeometryGenerator::East) {
+      addSkirt(genSkirtVertical(size - step, 1, true), GeometryGenerator::South, GeometryGenerator::North);
+    }
+    if (mask & GeometryGenerator::South) {
+      addSkirt(genSkirtHorizontal(step, -1, true), GeometryGenerator::West, GeometryGenerator::East);
+    }
+    if (mask & GeometryGenerator::West) {
+      addSkirt(genSkirtVertical(step, -1, false), GeometryGenerator::South, GeometryGenerator::North);
+    }
+
+    _infos[lod * NUM_MASKS + mask] = { static_cast<unsigned>(_indices.size()) - offset, offset };
+  }
+}
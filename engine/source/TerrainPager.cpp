@@ -0,0 +1,265 @@
+#include <TerrainPager.h>
+#include <MappedFile.h>
+#include <fstream>
+#include <iostream>
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+
+namespace fly
+{
+  namespace
+  {
+    const char MAGIC[4] = { 'F', 'L', 'Y', 'T' };
+    size_t pageBytes(unsigned page_size)
+    {
+      return static_cast<size_t>(page_size + 1) * (page_size + 1) * sizeof(float);
+    }
+    bool isPowerOfTwo(unsigned value)
+    {
+      return value && !(value & (value - 1));
+    }
+  }
+
+  bool TerrainPager::save(const std::string& path, unsigned width, unsigned height, unsigned page_size, const std::function<float(int, int)>& height_func)
+  {
+    if (!width || !height || !isPowerOfTwo(page_size)) {
+      std::cout << "TerrainPager::save() Invalid size, the page size must be a power of two" << std::endl;
+      return false;
+    }
+    std::ofstream os(path, std::ios::binary);
+    if (!os.good()) {
+      std::cout << "TerrainPager::save() Failed to open " << path << std::endl;
+      return false;
+    }
+    Header header = {};
+    std::memcpy(header._magic, MAGIC, sizeof(MAGIC));
+    header._version = VERSION;
+    header._pageSize = page_size;
+    header._numPagesX = (width + page_size - 1) / page_size;
+    header._numPagesZ = (height + page_size - 1) / page_size;
+    header._width = width;
+    header._height = height;
+    os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    std::vector<float> heights((page_size + 1) * (page_size + 1));
+    for (unsigned page_z = 0; page_z < header._numPagesZ; page_z++) {
+      for (unsigned page_x = 0; page_x < header._numPagesX; page_x++) {
+        for (unsigned z = 0; z <= page_size; z++) {
+          for (unsigned x = 0; x <= page_size; x++) {
+            int x_clamped = static_cast<int>((std::min)(page_x * page_size + x, width - 1));
+            int z_clamped = static_cast<int>((std::min)(page_z * page_size + z, height - 1));
+            heights[z * (page_size + 1) + x] = height_func(x_clamped, z_clamped);
+          }
+        }
+        os.write(reinterpret_cast<const char*>(heights.data()), heights.size() * sizeof(float));
+      }
+    }
+    return os.good();
+  }
+
+  bool TerrainPager::save(const std::string& path, const cv::Mat& height_map, unsigned page_size)
+  {
+    return save(path, height_map.cols, height_map.rows, page_size, [&height_map](int x, int z) {
+      return height_map.at<float>(z, x);
+    });
+  }
+
+  std::unique_ptr<TerrainPager> TerrainPager::load(const std::string& path, size_t max_resident_pages, int load_radius, int min_node_size, ThreadPool& pool)
+  {
+    // Pages within the load radius are never evicted, all of them must fit into the budget
+    if (load_radius < 0 || static_cast<size_t>(2 * load_radius + 1) * (2 * load_radius + 1) > max_resident_pages) {
+      std::cout << "TerrainPager::load() " << max_resident_pages << " resident pages can't hold a load radius of " << load_radius << std::endl;
+      return nullptr;
+    }
+    auto file = std::make_unique<MappedFile>(path);
+    if (!file->getData() || file->getSize() < sizeof(Header)) {
+      return nullptr;
+    }
+    auto header = reinterpret_cast<const Header*>(file->getData());
+    if (std::memcmp(header->_magic, MAGIC, sizeof(MAGIC)) || header->_version != VERSION || !isPowerOfTwo(header->_pageSize) ||
+      (file->getSize() - sizeof(Header)) / pageBytes(header->_pageSize) < static_cast<size_t>(header->_numPagesX) * header->_numPagesZ) {
+      std::cout << "TerrainPager::load() " << path << " is not a valid page file of version " << VERSION << std::endl;
+      return nullptr;
+    }
+    return std::unique_ptr<TerrainPager>(new TerrainPager(std::move(file), max_resident_pages, load_radius, min_node_size, pool));
+  }
+
+  TerrainPager::TerrainPager(std::unique_ptr<MappedFile>&& file, size_t max_resident_pages, int load_radius, int min_node_size, ThreadPool& pool) :
+    _file(std::move(file)),
+    _header(reinterpret_cast<const Header*>(_file->getData())),
+    _maxResidentPages(max_resident_pages),
+    _loadRadius(load_radius),
+    _minNodeSize((std::max)(min_node_size, 1)),
+    _pool(pool)
+  {
+  }
+
+  TerrainPager::~TerrainPager()
+  {
+    for (auto& p : _pendingLoads) {
+      _pool.wait(*p.second._group);
+    }
+  }
+
+  bool TerrainPager::update(const glm::vec3& cam_pos_model_space)
+  {
+    bool changed = false;
+    for (auto it = _pendingLoads.begin(); it != _pendingLoads.end();) {
+      if (it->second._group->done()) {
+        _lru.push_front(it->first);
+        _pages[it->first] = { std::move(it->second._page), _lru.begin() };
+        it = _pendingLoads.erase(it);
+        changed = true;
+      }
+      else {
+        it++;
+      }
+    }
+
+    glm::ivec2 cam_page(static_cast<int>(std::floor(cam_pos_model_space.x / _header->_pageSize)),
+      static_cast<int>(std::floor(cam_pos_model_space.z / _header->_pageSize)));
+    std::vector<std::pair<int, glm::ivec2>> missing;
+    for (int z = cam_page.y - _loadRadius; z <= cam_page.y + _loadRadius; z++) {
+      for (int x = cam_page.x - _loadRadius; x <= cam_page.x + _loadRadius; x++) {
+        if (x < 0 || z < 0 || x >= static_cast<int>(_header->_numPagesX) || z >= static_cast<int>(_header->_numPagesZ)) {
+          continue;
+        }
+        unsigned k = key(x, z);
+        auto it = _pages.find(k);
+        if (it != _pages.end()) {
+          _lru.splice(_lru.begin(), _lru, it->second._lruPos);
+        }
+        else if (!_pendingLoads.count(k)) {
+          glm::ivec2 delta = glm::ivec2(x, z) - cam_page;
+          missing.push_back({ delta.x * delta.x + delta.y * delta.y, glm::ivec2(x, z) });
+        }
+      }
+    }
+    std::sort(missing.begin(), missing.end(), [](const std::pair<int, glm::ivec2>& a, const std::pair<int, glm::ivec2>& b) {
+      return a.first < b.first;
+    });
+    for (const auto& m : missing) {
+      if (_pendingLoads.size() >= _maxPendingLoads) {
+        break;
+      }
+      glm::ivec2 index = m.second;
+      auto& pending = _pendingLoads[key(index.x, index.y)];
+      pending._group = std::make_unique<ThreadPool::TaskGroup>();
+      auto page = &pending._page; // Map nodes don't move
+      _pool.submit(*pending._group, [this, index, page]() {
+        *page = loadPage(index);
+      });
+    }
+
+    auto it = _lru.end();
+    while (_pages.size() > _maxResidentPages && it != _lru.begin()) {
+      it--;
+      if (!isInLoadRadius(*it, cam_page)) {
+        _pages.erase(*it);
+        it = _lru.erase(it);
+        changed = true;
+      }
+    }
+    return changed;
+  }
+
+  const TerrainPager::Page* TerrainPager::getPage(int page_x, int page_z)
+  {
+    if (page_x < 0 || page_z < 0 || page_x >= static_cast<int>(_header->_numPagesX) || page_z >= static_cast<int>(_header->_numPagesZ)) {
+      return nullptr;
+    }
+    auto it = _pages.find(key(page_x, page_z));
+    if (it == _pages.end()) {
+      return nullptr;
+    }
+    _lru.splice(_lru.begin(), _lru, it->second._lruPos);
+    return it->second._page.get();
+  }
+
+  float TerrainPager::getHeight(int x, int z, float default_height)
+  {
+    x = glm::clamp(x, 0, static_cast<int>(_header->_width) - 1);
+    z = glm::clamp(z, 0, static_cast<int>(_header->_height) - 1);
+    int page_size = static_cast<int>(_header->_pageSize);
+    auto it = _pages.find(key(x / page_size, z / page_size));
+    if (it == _pages.end()) {
+      return default_height;
+    }
+    return it->second._page->_heights[(z % page_size) * (page_size + 1) + x % page_size];
+  }
+
+  void TerrainPager::getResidentPages(std::vector<const Page*>& pages) const
+  {
+    for (const auto& p : _pages) {
+      pages.push_back(p.second._page.get());
+    }
+  }
+
+  unsigned TerrainPager::getPageSize() const
+  {
+    return _header->_pageSize;
+  }
+
+  glm::ivec2 TerrainPager::getNumPages() const
+  {
+    return glm::ivec2(_header->_numPagesX, _header->_numPagesZ);
+  }
+
+  glm::ivec2 TerrainPager::getSize() const
+  {
+    return glm::ivec2(_header->_width, _header->_height);
+  }
+
+  size_t TerrainPager::getNumPendingLoads() const
+  {
+    return _pendingLoads.size();
+  }
+
+  void TerrainPager::setMaxPendingLoads(unsigned max_pending_loads)
+  {
+    _maxPendingLoads = (std::max)(max_pending_loads, 1u);
+  }
+
+  unsigned TerrainPager::getMaxPendingLoads() const
+  {
+    return _maxPendingLoads;
+  }
+
+  std::unique_ptr<TerrainPager::Page> TerrainPager::loadPage(const glm::ivec2& index) const
+  {
+    auto page = std::make_unique<Page>();
+    page->_index = index;
+    page->_heights.resize((_header->_pageSize + 1) * (_header->_pageSize + 1));
+    size_t offset = sizeof(Header) + static_cast<size_t>(key(index.x, index.y)) * pageBytes(_header->_pageSize);
+    std::memcpy(page->_heights.data(), _file->getData() + offset, pageBytes(_header->_pageSize));
+    page->_rootNode = std::make_unique<Terrain::TreeNode>(index * static_cast<int>(_header->_pageSize), _header->_pageSize);
+    MinMaxPyramid pyramid(page->_heights.data(), _header->_pageSize + 1, _header->_pageSize + 1, _header->_pageSize + 1);
+    buildNode(page->_rootNode.get(), index * static_cast<int>(_header->_pageSize), pyramid);
+    return page;
+  }
+
+  void TerrainPager::buildNode(Terrain::TreeNode* node, const glm::ivec2& page_origin, const MinMaxPyramid& pyramid) const
+  {
+    auto min_max = pyramid.getMinMax(node->_pos - page_origin, node->_size);
+    node->_minHeight = min_max._min;
+    node->_maxHeight = min_max._max;
+    node->_aabb = new AABB(Vec3f(static_cast<float>(node->_pos.x), node->_minHeight, static_cast<float>(node->_pos.y)),
+      Vec3f(static_cast<float>(node->_pos.x + node->_size), node->_maxHeight, static_cast<float>(node->_pos.y + node->_size)));
+    int new_size = node->_size / 2;
+    if (new_size >= _minNodeSize) {
+      node->_southWest = new Terrain::TreeNode(node->_pos, new_size);
+      node->_southEast = new Terrain::TreeNode(node->_pos + glm::ivec2(new_size, 0), new_size);
+      node->_northWest = new Terrain::TreeNode(node->_pos + glm::ivec2(0, new_size), new_size);
+      node->_northEast = new Terrain::TreeNode(node->_pos + new_size, new_size);
+      for (auto c : { node->_southWest, node->_southEast, node->_northWest, node->_northEast }) {
+        buildNode(c, page_origin, pyramid);
+      }
+    }
+  }
+
+  bool TerrainPager::isInLoadRadius(unsigned key, const glm::ivec2& cam_page) const
+  {
+    glm::ivec2 index(key % _header->_numPagesX, key / _header->_numPagesX);
+    return std::abs(index.x - cam_page.x) <= _loadRadius && std::abs(index.y - cam_page.y) <= _loadRadius;
+  }
+}
@@ -0,0 +1,139 @@
+#include <ThreadPool.h>
+#include <algorithm>
+
+namespace fly
+{
+  namespace
+  {
+    thread_local const ThreadPool* currentPool = nullptr;
+    thread_local unsigned currentIndex = 0;
+  }
+
+  ThreadPool::ThreadPool(unsigned num_workers)
+  {
+    // There is always at least one queue so that tasks can be submitted to a pool without workers, they are executed by the waiting thread.
+    for (unsigned i = 0; i < (std::max)(num_workers, 1u); i++) {
+      _queues.push_back(std::make_unique<Queue>());
+    }
+    for (unsigned i = 0; i < num_workers; i++) {
+      _workers.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+  }
+  ThreadPool::~ThreadPool()
+  {
+    {
+      std::lock_guard<std::mutex> lock(_sleepMutex);
+      _stop = true;
+    }
+    _wakeUp.notify_all();
+    for (auto& w : _workers) {
+      w.join();
+    }
+  }
+  void ThreadPool::submit(TaskGroup& group, const std::function<void()>& task)
+  {
+    group._pending.fetch_add(1, std::memory_order_relaxed);
+    int worker = currentWorkerIndex();
+    unsigned index = worker >= 0 ? static_cast<unsigned>(worker) : _nextQueue.fetch_add(1, std::memory_order_relaxed) % _queues.size();
+    {
+      std::lock_guard<std::mutex> lock(_queues[index]->_mutex);
+      _queues[index]->_tasks.push_back({ task, &group });
+    }
+    _numQueued.fetch_add(1, std::memory_order_release);
+    {
+      std::lock_guard<std::mutex> lock(_sleepMutex); // Prevents lost wake ups of workers that are about to sleep
+    }
+    _wakeUp.notify_one();
+  }
+  void ThreadPool::wait(TaskGroup& group)
+  {
+    while (!group.done()) {
+      if (!tryRunPendingTask()) {
+        std::this_thread::yield();
+      }
+    }
+  }
+  bool ThreadPool::tryRunPendingTask()
+  {
+    int worker = currentWorkerIndex();
+    unsigned index = worker >= 0 ? static_cast<unsigned>(worker) : 0u;
+    Task task;
+    if ((worker >= 0 && popTask(index, task)) || stealTask(index, task)) {
+      execute(task);
+      return true;
+    }
+    return false;
+  }
+  unsigned ThreadPool::getNumWorkers() const
+  {
+    return static_cast<unsigned>(_workers.size());
+  }
+  unsigned ThreadPool::getConcurrency() const
+  {
+    return getNumWorkers() + 1;
+  }
+  ThreadPool& ThreadPool::getShared()
+  {
+    static ThreadPool pool;
+    return pool;
+  }
+  unsigned ThreadPool::defaultNumWorkers()
+  {
+    unsigned hw = std::thread::hardware_concurrency();
+    return hw > 1 ? hw - 1 : 0;
+  }
+  void ThreadPool::workerLoop(unsigned index)
+  {
+    currentPool = this;
+    currentIndex = index;
+    while (true) {
+      Task task;
+      if (popTask(index, task) || stealTask(index, task)) {
+        execute(task);
+        continue;
+      }
+      std::unique_lock<std::mutex> lock(_sleepMutex);
+      _wakeUp.wait(lock, [this]() {
+        return _stop || _numQueued.load(std::memory_order_acquire) > 0;
+      });
+      if (_stop) {
+        return;
+      }
+    }
+  }
+  bool ThreadPool::popTask(unsigned index, Task& task)
+  {
+    auto& queue = *_queues[index];
+    std::lock_guard<std::mutex> lock(queue._mutex);
+    if (queue._tasks.empty()) {
+      return false;
+    }
+    task = std::move(queue._tasks.back()); // Newest task first, its data is most likely still in the cache
+    queue._tasks.pop_back();
+    _numQueued.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+  }
+  bool ThreadPool::stealTask(unsigned index, Task& task)
+  {
+    for (unsigned i = 1; i <= _queues.size(); i++) {
+      auto& queue = *_queues[(index + i) % _queues.size()];
+      std::lock_guard<std::mutex> lock(queue._mutex);
+      if (!queue._tasks.empty()) {
+        task = std::move(queue._tasks.front()); // Oldest task first, it usually represents the largest chunk of work
+        queue._tasks.pop_front();
+        _numQueued.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+      }
+    }
+    return false;
+  }
+  void ThreadPool::execute(Task& task)
+  {
+    task._func();
+    task._group->_pending.fetch_sub(1, std::memory_order_acq_rel);
+  }
+  int ThreadPool::currentWorkerIndex() const
+  {
+    return currentPool == this ? static_cast<int>(currentIndex) : -1;
+  }
+}
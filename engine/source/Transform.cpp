@@ -1,34 +1,40 @@
 #include <Transform.h>
-#define GLM_ENABLE_EXPERIMENTAL
-#include <glm/gtc/matrix_transform.hpp>
-#include <glm/gtx/transform.hpp>
+#include <cmath>
 
 namespace fly
 {
   Transform::Transform(const Vec3f & translation, const Vec3f & scale, const Vec3f & degrees) : _translation(translation), _scale(scale), _degrees(degrees)
   {
+    updateFromParent();
   }
   Mat4f Transform::getModelMatrix() const
   {
-    auto translation_matrix = translate<4, float>(_translation);
-    auto scale_matrix = scale<4, float>(_scale);
-    Mat4f rotation_matrix_x = glm::rotate(glm::radians(_degrees[0]), glm::vec3(1.f, 0.f, 0.f));
-    Mat4f rotation_matrix_y = glm::rotate(glm::radians(_degrees[1]), glm::vec3(0.f, 1.f, 0.f));
-    Mat4f rotation_matrix_z = glm::rotate(glm::radians(_degrees[2]), glm::vec3(0.f, 0.f, 1.f));
-
-    return translation_matrix * rotation_matrix_x * rotation_matrix_z * rotation_matrix_y * scale_matrix;
+    // Rotation x * rotation z * rotation y in closed form, the columns are scaled afterwards
+    const float to_radians = 3.14159265358979f / 180.f;
+    float sx = std::sin(_degrees[0] * to_radians), cx = std::cos(_degrees[0] * to_radians);
+    float sy = std::sin(_degrees[1] * to_radians), cy = std::cos(_degrees[1] * to_radians);
+    float sz = std::sin(_degrees[2] * to_radians), cz = std::cos(_degrees[2] * to_radians);
+    Mat4f m;
+    m[0] = Vec4f(cz * cy, cx * sz * cy + sx * sy, sx * sz * cy - cx * sy, 0.f) * _scale[0];
+    m[1] = Vec4f(-sz, cx * cz, sx * cz, 0.f) * _scale[1];
+    m[2] = Vec4f(cz * sy, cx * sz * sy - sx * cy, sx * sz * sy + cx * cy, 0.f) * _scale[2];
+    m[3] = Vec4f(_translation, 1.f);
+    return m;
   }
   void Transform::setTranslation(const Vec3f & translation)
   {
     _translation = translation;
+    _dirty = true;
   }
   void Transform::setScale(const Vec3f & scale)
   {
-    _scale = _scale;
+    _scale = scale;
+    _dirty = true;
   }
   void Transform::setDegrees(const Vec3f & degrees)
   {
     _degrees = degrees;
+    _dirty = true;
   }
   const Vec3f& Transform::getTranslation() const
   {
@@ -42,4 +48,54 @@ namespace fly
   {
     return _degrees;
   }
-}
\ No newline at end of file
+  void Transform::setParent(const std::shared_ptr<Transform>& parent)
+  {
+    _parent = parent;
+    _dirty = true;
+  }
+  const std::shared_ptr<Transform>& Transform::getParent() const
+  {
+    return _parent;
+  }
+  const Mat4f & Transform::getWorldMatrix() const
+  {
+    return _worldMatrix;
+  }
+  const Mat3f & Transform::getNormalMatrix() const
+  {
+    return _normalMatrix;
+  }
+  void Transform::updateWorldMatrix()
+  {
+    if (_parent) {
+      _parent->updateWorldMatrix();
+    }
+    updateFromParent();
+  }
+  void Transform::updateFromParent()
+  {
+    if (!_dirty && (!_parent || _parentVersion == _parent->_version)) {
+      return;
+    }
+    auto local = getModelMatrix();
+    // (R * S)^-1 = S^-1 * R^T, no general inversion needed. Scale is applied to the columns of the local matrix.
+    Mat3f local_normal;
+    for (unsigned i = 0; i < 3; i++) {
+      float inv_scale_sq = 1.f / (_scale[i] * _scale[i]);
+      for (unsigned j = 0; j < 3; j++) {
+        local_normal[j][i] = local[i][j] * inv_scale_sq;
+      }
+    }
+    if (_parent) {
+      _worldMatrix = _parent->_worldMatrix * local;
+      _normalMatrix = local_normal * _parent->_normalMatrix;
+      _parentVersion = _parent->_version;
+    }
+    else {
+      _worldMatrix = local;
+      _normalMatrix = local_normal;
+    }
+    _dirty = false;
+    _version++;
+  }
+}
@@ -0,0 +1,70 @@
+#include <TransformSystem.h>
+#include <Transform.h>
+#include <Entity.h>
+#include <ParallelFor.h>
+#include <algorithm>
+
+namespace fly
+{
+  TransformSystem::TransformSystem()
+  {
+    writes<Transform>();
+  }
+  void TransformSystem::onComponentsChanged(Entity* entity)
+  {
+    auto transform = entity->getComponent<Transform>();
+    if (transform) {
+      _transforms[entity] = transform;
+    }
+    else {
+      _transforms.erase(entity);
+    }
+    _sortingDirty = true;
+  }
+  void TransformSystem::update(float time, float delta_time)
+  {
+    // Parents can be changed at any time without notification, which is detected by comparing against the last sort
+    for (size_t i = 0; !_sortingDirty && i < _sorted.size(); i++) {
+      _sortingDirty = _sorted[i]->getParent().get() != _sortedParents[i];
+    }
+    if (_sortingDirty) {
+      sort();
+    }
+    for (size_t level = 0; level + 1 < _levels.size(); level++) {
+      parallelFor(_levels[level], _levels[level + 1], [this](size_t i) {
+        _sorted[i]->updateFromParent();
+      }, 256);
+    }
+  }
+  void TransformSystem::sort()
+  {
+    // Ancestors that aren't owned by an entity are part of the array as well, children rely on up to date parents.
+    std::map<Transform*, std::shared_ptr<Transform>> all;
+    for (const auto& t : _transforms) {
+      for (auto p = t.second; p && all.insert({ p.get(), p }).second; p = p->getParent());
+    }
+    std::vector<std::pair<unsigned, std::shared_ptr<Transform>>> sorted;
+    for (const auto& t : all) {
+      unsigned depth = 0;
+      for (auto p = t.first->getParent().get(); p; p = p->getParent().get()) {
+        depth++;
+      }
+      sorted.push_back({ depth, t.second });
+    }
+    std::stable_sort(sorted.begin(), sorted.end(), [](const std::pair<unsigned, std::shared_ptr<Transform>>& a, const std::pair<unsigned, std::shared_ptr<Transform>>& b) {
+      return a.first < b.first;
+    });
+    _sorted.resize(sorted.size());
+    _sortedParents.resize(sorted.size());
+    _levels.clear();
+    for (size_t i = 0; i < sorted.size(); i++) {
+      _sorted[i] = sorted[i].second;
+      _sortedParents[i] = _sorted[i]->getParent().get();
+      while (_levels.size() <= sorted[i].first) {
+        _levels.push_back(i);
+      }
+    }
+    _levels.push_back(sorted.size());
+    _sortingDirty = false;
+  }
+}
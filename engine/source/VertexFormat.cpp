@@ -0,0 +1,106 @@
+#include <VertexFormat.h>
+#include <AABB.h>
+#include <math/Packing.h>
+
+namespace fly
+{
+  namespace
+  {
+    template<typename T>
+    void encodeAttributes(const Vertex& v, unsigned format, T& out)
+    {
+      auto n = octEncode(v._normal);
+      out._normal[0] = packSnorm16(n[0]);
+      out._normal[1] = packSnorm16(n[1]);
+      float sign = dot(cross(v._normal, v._tangent), v._bitangent) < 0.f ? -1.f : 1.f;
+      auto t = octEncode(v._tangent);
+      out._tangent = packSnorm2101010(Vec4f(t[0], t[1], 0.f, sign));
+      for (unsigned i = 0; i < 2; i++) {
+        out._uv[i] = format & VF_UNORM_UV ? packUnorm16(v._uv[i]) : floatToHalf(v._uv[i]);
+      }
+    }
+    template<typename T>
+    void decodeAttributes(const T& in, unsigned format, Vertex& v)
+    {
+      v._normal = octDecode(Vec2f(unpackSnorm16(in._normal[0]), unpackSnorm16(in._normal[1])));
+      auto tangent = unpackSnorm2101010(in._tangent);
+      v._tangent = octDecode(Vec2f(tangent[0], tangent[1]));
+      v._bitangent = cross(v._normal, v._tangent) * tangent[3];
+      for (unsigned i = 0; i < 2; i++) {
+        v._uv[i] = format & VF_UNORM_UV ? unpackUnorm16(in._uv[i]) : halfToFloat(in._uv[i]);
+      }
+    }
+    Vec3f quantizationScale(const AABB& aabb)
+    {
+      Vec3f extent = aabb.getMax() - aabb.getMin();
+      for (unsigned i = 0; i < 3; i++) {
+        extent[i] = extent[i] > 0.f ? extent[i] : 1.f;
+      }
+      return extent;
+    }
+  }
+
+  size_t vertexSize(unsigned format)
+  {
+    if (!(format & VF_COMPACT)) {
+      return sizeof(Vertex);
+    }
+    return format & VF_QUANTIZED_POSITION ? sizeof(QuantizedVertex) : sizeof(CompactVertex);
+  }
+
+  std::vector<uint8_t> encodeVertices(const std::vector<Vertex>& vertices, unsigned format, const AABB& aabb)
+  {
+    std::vector<uint8_t> data(vertices.size() * vertexSize(format));
+    if (!(format & VF_COMPACT)) {
+      if (vertices.size()) {
+        std::memcpy(data.data(), vertices.data(), data.size());
+      }
+    }
+    else if (format & VF_QUANTIZED_POSITION) {
+      auto out = reinterpret_cast<QuantizedVertex*>(data.data());
+      Vec3f scale_inv = Vec3f(1.f) / quantizationScale(aabb);
+      for (size_t i = 0; i < vertices.size(); i++) {
+        auto p = (vertices[i]._position - aabb.getMin()) * scale_inv;
+        for (unsigned j = 0; j < 3; j++) {
+          out[i]._position[j] = packUnorm16(p[j]);
+        }
+        out[i]._position[3] = 0;
+        encodeAttributes(vertices[i], format, out[i]);
+      }
+    }
+    else {
+      auto out = reinterpret_cast<CompactVertex*>(data.data());
+      for (size_t i = 0; i < vertices.size(); i++) {
+        out[i]._position = vertices[i]._position;
+        encodeAttributes(vertices[i], format, out[i]);
+      }
+    }
+    return data;
+  }
+
+  Vertex decodeVertex(const uint8_t* data, unsigned format, const AABB& aabb)
+  {
+    Vertex v;
+    if (!(format & VF_COMPACT)) {
+      std::memcpy(&v, data, sizeof v);
+    }
+    else if (format & VF_QUANTIZED_POSITION) {
+      QuantizedVertex in;
+      std::memcpy(&in, data, sizeof in);
+      v._position = aabb.getMin() + Vec3f(unpackUnorm16(in._position[0]), unpackUnorm16(in._position[1]), unpackUnorm16(in._position[2])) * quantizationScale(aabb);
+      decodeAttributes(in, format, v);
+    }
+    else {
+      CompactVertex in;
+      std::memcpy(&in, data, sizeof in);
+      v._position = in._position;
+      decodeAttributes(in, format, v);
+    }
+    return v;
+  }
+
+  Mat4f dequantizationMatrix(const AABB& aabb)
+  {
+    return translate<4, float>(aabb.getMin()) * scale<4, float>(quantizationScale(aabb));
+  }
+}
@@ -137,8 +137,8 @@ namespace fly
   {
     _viewportSize = size;
     _aspectRatio = static_cast<float>(size[0]) / size[1];
-    _projectionMatrix = glm::perspectiveZO(glm::radians(_fov), _aspectRatio, _near, _far);
-    _PInverse = glm::inverse(glm::mat4(_projectionMatrix));
+    _projectionMatrix = perspectiveZO(radians(_fov), _aspectRatio, _near, _far);
+    _PInverse = inverse(_projectionMatrix);
     HR(_fxP->SetMatrixTranspose(_projectionMatrix.ptr()));
     HR(_fxPInverse->SetMatrixTranspose(_PInverse.ptr()));
     //   HR(_fxPInverseTerrain->SetMatrixTranspose(&_PInverse[0][0]));
@@ -697,7 +697,7 @@ namespace fly
           _context->IASetVertexBuffers(0, 1, &model_data->_vertexBuffer.p, &stride, &offset);
           _context->IASetIndexBuffer(model_data->_indexBuffer, DXGI_FORMAT::DXGI_FORMAT_R32_UINT, 0);
           std::vector<Mat4f> matrices;
-          auto mvp = _VP * Mat4f(p.first->getComponent<Transform>()->getModelMatrix());
+          auto mvp = _VP * Mat4f(p.first->getComponent<Transform>()->getWorldMatrix());
           for (const auto& m : particle_transforms) {
             matrices.push_back(mvp * m);
           }
@@ -725,7 +725,7 @@ namespace fly
           std::vector<Vec3f> particle_positions;
           std::vector<float> fades;
           for (const auto& p : particles) {
-            particle_positions.push_back(Vec3f(p._position) * transform->getScale() + transform->getTranslation());
+            particle_positions.push_back((transform->getWorldMatrix() * Vec4f(Vec3f(p._position), 1.f)).xyz());
             fades.push_back(pow(glm::smoothstep(0.f, 0.2f, p._age) * (1.f - glm::smoothstep(0.8f, 1.f, p._age)), 2.f));
           }
           HR(_fxBillboardPosWorld->SetFloatVectorArray(particle_positions.front().ptr(), 0u, static_cast<unsigned>(particle_positions.size())));
@@ -954,7 +954,7 @@ namespace fly
   /* RenderingSystemDX11::DX11StaticModelRenderable::DX11StaticModelRenderable(const std::shared_ptr<Model>& model,
      const std::shared_ptr<Transform>& transform, RenderingSystemDX11* rs)
      : _model(model),
-     _modelMatrix(transform->getModelMatrix()),
+     _modelMatrix(transform->getWorldMatrix()),
      _modelData(std::make_unique<ModelData>(model, rs))
    {
    }*/
@@ -30,6 +30,9 @@ uniform vec3 " + std::string(bbMax()) + "; // AABB max xz\n" + std::string(noise
     if (flags & MeshRenderFlag::WIND) {
       fname += "_wind";
     }
+    if (flags & MeshRenderFlag::COMPACT_VERTEX) {
+      fname += "_compact";
+    }
     fname += ".glsl";
     for (const auto& n : _fnamesVertex) {
       if (n == fname) { // File already created
@@ -143,11 +146,24 @@ uniform vec3 " + std::string(bbMax()) + "; // AABB max xz\n" + std::string(noise
     std::string shader_src;
     shader_src += "#version 330\n\
 layout(location = 0) in vec3 position;\n\
-layout(location = 1) in vec3 normal;\n\
-layout(location = 2) in vec2 uv;\n\
+layout(location = 2) in vec2 uv;\n";
+    if (flags & MeshRenderFlag::COMPACT_VERTEX) {
+      shader_src += "layout(location = 1) in vec2 normal_oct;\n\
+layout(location = 3) in vec4 tangent_oct; // Bitangent sign in w\n\
+vec3 octDecode(vec2 e)\n\
+{\n\
+  vec3 n = vec3(e, 1.f - abs(e.x) - abs(e.y));\n\
+  float t = max(-n.z, 0.f);\n\
+  n.xy += vec2(n.x >= 0.f ? -t : t, n.y >= 0.f ? -t : t);\n\
+  return normalize(n);\n\
+}\n";
+    }
+    else {
+      shader_src += "layout(location = 1) in vec3 normal;\n\
 layout(location = 3) in vec3 tangent;\n\
-layout(location = 4) in vec3 bitangent;\n\
-// Shader constant\n\
+layout(location = 4) in vec3 bitangent;\n";
+    }
+    shader_src += "// Shader constant\n\
 uniform mat4 VP; \n\
 // Model constants\n\
 uniform mat4 M;\n\
@@ -169,6 +185,11 @@ out vec3 bitangent_world;\n";
     if (flags & MeshRenderFlag::WIND) {
       shader_src += _windCodeString;
     }
+    if (flags & MeshRenderFlag::COMPACT_VERTEX) {
+      shader_src += "  vec3 normal = octDecode(normal_oct);\n\
+  vec3 tangent = octDecode(tangent_oct.xy);\n\
+  vec3 bitangent = cross(normal, tangent) * tangent_oct.w;\n";
+    }
     shader_src += "  gl_Position = VP * vec4(pos_world, 1.f);\n\
   normal_world = normalize(M_i * normal);\n\
   uv_out = uv;\n\
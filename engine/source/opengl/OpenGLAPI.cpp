@@ -5,6 +5,7 @@
 #include <Model.h>
 #include <Vertex.h>
 #include <Mesh.h>
+#include <VertexFormat.h>
 #include <opengl/GLWrappers.h>
 #include <Timing.h>
 #include <StaticModelRenderable.h>
@@ -60,7 +61,7 @@ namespace fly
       std::cout << "OpenGLAPI::OpenGLAPI() Failed to initialized GLEW: " << glewGetErrorString(result) << std::endl;
     }
     _vaoAABB = std::make_shared<GLVertexArray>();
-    _vaoAABB->bind();
+    bindVertexArray(_vaoAABB.get());
     _vboAABB = std::make_shared<GLBuffer>(GL_ARRAY_BUFFER);
     _vboAABB->bind();
     for (unsigned i = 0; i < 2; i++) {
@@ -96,6 +97,7 @@ namespace fly
   }
   void OpenGLAPI::beginFrame() const
   {
+    _activeVertexArray = nullptr;
     if (_anisotropy > 1) {
       for (unsigned i = 0; i <= heightTexUnit(); i++) {
         _samplerAnisotropic->bind(i);
@@ -117,13 +119,27 @@ namespace fly
     GL_CHECK(glActiveTexture(GL_TEXTURE0 + shadowTexUnit()));
     shadowmap.bind();
   }
+  void OpenGLAPI::bindVertexArray(const GLVertexArray* vertex_array) const
+  {
+    if (_activeVertexArray != vertex_array) {
+      if (vertex_array) {
+        vertex_array->bind();
+      }
+      else {
+        GL_CHECK(glBindVertexArray(0));
+      }
+      _activeVertexArray = vertex_array;
+    }
+  }
   void OpenGLAPI::renderMesh(const MeshGeometryStorage::MeshData & mesh_data) const
   {
+    bindVertexArray(mesh_data._vertexArray);
     GL_CHECK(glDrawElementsBaseVertex(GL_TRIANGLES, mesh_data._count, mesh_data._type, mesh_data._indices, mesh_data._baseVertex));
   }
   void OpenGLAPI::renderMesh(const MeshGeometryStorage::MeshData & mesh_data, const Mat4f & model_matrix) const
   {
-    setMatrix(_activeShader->uniformLocation(GLSLShaderGenerator::modelMatrix()), model_matrix);
+    setMatrix(_activeShader->uniformLocation(GLSLShaderGenerator::modelMatrix()), mesh_data._vertexFormat & VF_QUANTIZED_POSITION ?
+      model_matrix * mesh_data._dequantization : model_matrix);
     renderMesh(mesh_data);
   }
   void OpenGLAPI::renderMesh(const MeshGeometryStorage::MeshData& mesh_data, const Mat4f& model_matrix, const Mat3f& model_matrix_inverse) const
@@ -147,12 +163,14 @@ namespace fly
 
   void OpenGLAPI::renderMeshMVP(const MeshGeometryStorage::MeshData & mesh_data, const Mat4f & mvp) const
   {
-    setMatrix(_activeShader->uniformLocation(GLSLShaderGenerator::modelViewProjectionMatrix()), mvp);
+    bindVertexArray(mesh_data._vertexArray);
+    setMatrix(_activeShader->uniformLocation(GLSLShaderGenerator::modelViewProjectionMatrix()), mesh_data._vertexFormat & VF_QUANTIZED_POSITION ?
+      mvp * mesh_data._dequantization : mvp);
     GL_CHECK(glDrawElementsBaseVertex(GL_TRIANGLES, mesh_data._count, mesh_data._type, mesh_data._indices, mesh_data._baseVertex));
   }
   void OpenGLAPI::renderAABBs(const std::vector<AABB*>& aabbs, const Mat4f& transform, const Vec3f& col)
   {
-    _vaoAABB->bind();
+    bindVertexArray(_vaoAABB.get());
     bindShader(_aabbShader.get());
     setMatrix(_activeShader->uniformLocation(GLSLShaderGenerator::viewProjectionMatrix()), transform);
     setVector(_activeShader->uniformLocation("c"), col);
@@ -319,17 +337,32 @@ namespace fly
     }
     GL_CHECK(glDrawBuffers(static_cast<GLsizei>(draw_buffers.size()), draw_buffers.data()));
   }
-  OpenGLAPI::MeshGeometryStorage::MeshGeometryStorage() :
-    _vboAppend(std::make_unique<GLAppendBuffer>(GL_ARRAY_BUFFER)),
+  OpenGLAPI::MeshGeometryStorage::MeshGeometryStorage(const OpenGLAPI& api) :
+    _api(api),
     _iboAppend(std::make_unique<GLAppendBuffer>(GL_ELEMENT_ARRAY_BUFFER)),
     _meshDataCache(SoftwareCache<std::shared_ptr<Mesh>, MeshData, const std::shared_ptr<Mesh>&>([this](
       const std::shared_ptr<Mesh>& mesh) {
+    unsigned format = mesh->getVertexFormat() & VF_COMPACT ? mesh->getVertexFormat() : VF_FULL;
+    auto& storage = _vertexStorage[format];
+    if (!storage._vao) {
+      storage._vao = std::make_unique<GLVertexArray>();
+      storage._vboAppend = std::make_unique<GLAppendBuffer>(GL_ARRAY_BUFFER);
+    }
     MeshData mesh_data;
     mesh_data._count = static_cast<GLsizei>(mesh->getIndices().size());
-    mesh_data._baseVertex = static_cast<GLint>(_baseVertex);
+    mesh_data._baseVertex = static_cast<GLint>(storage._baseVertex);
     mesh_data._indices = reinterpret_cast<GLvoid*>(_indices);
-    _baseVertex += mesh->getVertices().size();
-    _vboAppend->appendData(mesh->getVertices().data(), mesh->getVertices().size());
+    mesh_data._vertexFormat = format;
+    mesh_data._vertexArray = storage._vao.get();
+    mesh_data._dequantization = format & VF_QUANTIZED_POSITION ? dequantizationMatrix(*mesh->getAABB()) : identity<4, float>();
+    storage._baseVertex += mesh->getVertices().size();
+    if (format == VF_FULL) {
+      storage._vboAppend->appendData(mesh->getVertices().data(), mesh->getVertices().size());
+    }
+    else {
+      auto vertices = encodeVertices(mesh->getVertices(), format, *mesh->getAABB());
+      storage._vboAppend->appendData(vertices.data(), vertices.size());
+    }
     if (mesh->getVertices().size() - 1 <= static_cast<size_t>(std::numeric_limits<unsigned short>::max())) {
       std::vector<unsigned short> indices;
       for (const auto& i : mesh->getIndices()) {
@@ -344,19 +377,11 @@ namespace fly
       _iboAppend->appendData(mesh->getIndices().data(), mesh->getIndices().size());
       mesh_data._type = GL_UNSIGNED_INT;
     }
-    _vao = std::make_unique<GLVertexArray>();
-    _vao->bind();
-    _vboAppend->getBuffer()->bind();
-    _iboAppend->getBuffer()->bind();
-    for (unsigned i = 0; i < 5; i++) {
-      GL_CHECK(glEnableVertexAttribArray(i));
+    // Appending reallocates the buffers, so every vertex array has to point to the new index buffer.
+    for (const auto& s : _vertexStorage) {
+      setupVertexArray(s.first, s.second);
     }
-    GL_CHECK(glVertexAttribPointer(0, 3, GL_FLOAT, false, sizeof(Vertex), reinterpret_cast<const void*>(offsetof(Vertex, _position))));
-    GL_CHECK(glVertexAttribPointer(1, 3, GL_FLOAT, false, sizeof(Vertex), reinterpret_cast<const void*>(offsetof(Vertex, _normal))));
-    GL_CHECK(glVertexAttribPointer(2, 2, GL_FLOAT, false, sizeof(Vertex), reinterpret_cast<const void*>(offsetof(Vertex, _uv))));
-    GL_CHECK(glVertexAttribPointer(3, 3, GL_FLOAT, false, sizeof(Vertex), reinterpret_cast<const void*>(offsetof(Vertex, _tangent))));
-    GL_CHECK(glVertexAttribPointer(4, 3, GL_FLOAT, false, sizeof(Vertex), reinterpret_cast<const void*>(offsetof(Vertex, _bitangent))));
-    GL_CHECK(glBindVertexArray(0));
+    _api.bindVertexArray(nullptr);
     return mesh_data;
   }))
   {
@@ -366,7 +391,47 @@ namespace fly
   }
   void OpenGLAPI::MeshGeometryStorage::bind() const
   {
-    _vao->bind();
+    auto it = _vertexStorage.find(VF_FULL);
+    if (it != _vertexStorage.end()) {
+      _api.bindVertexArray(it->second._vao.get());
+    }
+  }
+  void OpenGLAPI::MeshGeometryStorage::setupVertexArray(unsigned format, const VertexStorage& storage) const
+  {
+    _api.bindVertexArray(storage._vao.get());
+    storage._vboAppend->getBuffer()->bind();
+    _iboAppend->getBuffer()->bind();
+    if (format == VF_FULL) {
+      for (unsigned i = 0; i < 5; i++) {
+        GL_CHECK(glEnableVertexAttribArray(i));
+      }
+      GL_CHECK(glVertexAttribPointer(0, 3, GL_FLOAT, false, sizeof(Vertex), reinterpret_cast<const void*>(offsetof(Vertex, _position))));
+      GL_CHECK(glVertexAttribPointer(1, 3, GL_FLOAT, false, sizeof(Vertex), reinterpret_cast<const void*>(offsetof(Vertex, _normal))));
+      GL_CHECK(glVertexAttribPointer(2, 2, GL_FLOAT, false, sizeof(Vertex), reinterpret_cast<const void*>(offsetof(Vertex, _uv))));
+      GL_CHECK(glVertexAttribPointer(3, 3, GL_FLOAT, false, sizeof(Vertex), reinterpret_cast<const void*>(offsetof(Vertex, _tangent))));
+      GL_CHECK(glVertexAttribPointer(4, 3, GL_FLOAT, false, sizeof(Vertex), reinterpret_cast<const void*>(offsetof(Vertex, _bitangent))));
+      return;
+    }
+    // Compact formats have no bitangent attribute, the shader reconstructs it from the sign in the tangent's w component.
+    for (unsigned i = 0; i < 4; i++) {
+      GL_CHECK(glEnableVertexAttribArray(i));
+    }
+    GL_CHECK(glDisableVertexAttribArray(4));
+    auto stride = static_cast<GLsizei>(vertexSize(format));
+    GLenum uv_type = format & VF_UNORM_UV ? GL_UNSIGNED_SHORT : GL_HALF_FLOAT;
+    bool uv_normalized = (format & VF_UNORM_UV) != 0;
+    if (format & VF_QUANTIZED_POSITION) {
+      GL_CHECK(glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, true, stride, reinterpret_cast<const void*>(offsetof(QuantizedVertex, _position))));
+      GL_CHECK(glVertexAttribPointer(1, 2, GL_SHORT, true, stride, reinterpret_cast<const void*>(offsetof(QuantizedVertex, _normal))));
+      GL_CHECK(glVertexAttribPointer(2, 2, uv_type, uv_normalized, stride, reinterpret_cast<const void*>(offsetof(QuantizedVertex, _uv))));
+      GL_CHECK(glVertexAttribPointer(3, 4, GL_INT_2_10_10_10_REV, true, stride, reinterpret_cast<const void*>(offsetof(QuantizedVertex, _tangent))));
+    }
+    else {
+      GL_CHECK(glVertexAttribPointer(0, 3, GL_FLOAT, false, stride, reinterpret_cast<const void*>(offsetof(CompactVertex, _position))));
+      GL_CHECK(glVertexAttribPointer(1, 2, GL_SHORT, true, stride, reinterpret_cast<const void*>(offsetof(CompactVertex, _normal))));
+      GL_CHECK(glVertexAttribPointer(2, 2, uv_type, uv_normalized, stride, reinterpret_cast<const void*>(offsetof(CompactVertex, _uv))));
+      GL_CHECK(glVertexAttribPointer(3, 4, GL_INT_2_10_10_10_REV, true, stride, reinterpret_cast<const void*>(offsetof(CompactVertex, _tangent))));
+    }
   }
   OpenGLAPI::MeshGeometryStorage::MeshData OpenGLAPI::MeshGeometryStorage::addMesh(const std::shared_ptr<Mesh>& mesh)
   {
@@ -420,11 +485,15 @@ namespace fly
       ss_flags |= ShaderSetupFlags::SHADOWS;
     }
     _meshShaderDesc = api->createShaderDesc(api->createShader(vertex_file, fragment_file), ss_flags);
+    vertex_file = api->_shaderGenerator->createMeshVertexShaderFile(flag | FLAG::COMPACT_VERTEX, settings);
+    _meshShaderDescCompact = api->createShaderDesc(api->createShader(vertex_file, fragment_file), ss_flags);
     vertex_file = api->_shaderGenerator->createMeshVertexShaderFile(flag | FLAG::WIND, settings);
     if (settings.getWindAnimations()) {
       ss_flags |= ShaderSetupFlags::WIND | ShaderSetupFlags::TIME;
     }
     _meshShaderDescWind = api->createShaderDesc(api->createShader(vertex_file, fragment_file), ss_flags);
+    vertex_file = api->_shaderGenerator->createMeshVertexShaderFile(flag | FLAG::WIND | FLAG::COMPACT_VERTEX, settings);
+    _meshShaderDescWindCompact = api->createShaderDesc(api->createShader(vertex_file, fragment_file), ss_flags);
 
     auto vertex_shadow_file = api->_shaderGenerator->createMeshVertexShaderFileDepth(flag, settings);
     auto vertex_shadow_file_wind = api->_shaderGenerator->createMeshVertexShaderFileDepth(flag | FLAG::WIND, settings);
@@ -453,8 +522,11 @@ namespace fly
       f->setup(shader, *this);
     }
   }
-  const std::shared_ptr<OpenGLAPI::ShaderDesc>& OpenGLAPI::MaterialDesc::getMeshShaderDesc(bool has_wind) const
+  const std::shared_ptr<OpenGLAPI::ShaderDesc>& OpenGLAPI::MaterialDesc::getMeshShaderDesc(bool has_wind, unsigned vertex_format) const
   {
+    if (vertex_format & VF_COMPACT) {
+      return has_wind ? _meshShaderDescWindCompact : _meshShaderDescCompact;
+    }
     return has_wind ? _meshShaderDescWind : _meshShaderDesc;
   }
   const std::shared_ptr<OpenGLAPI::ShaderDesc>& OpenGLAPI::MaterialDesc::getMeshShaderDescDepth(bool has_wind) const
@@ -9,6 +9,7 @@
 #include <glm/gtx/transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <random>
+#include <limits>
 #include <Model.h>
 #include "Entity.h"
 #include "SOIL/SOIL.h"
@@ -21,6 +22,7 @@
 #include <Material.h>
 #include <Billboard.h>
 #include <Terrain.h>
+#include <math/FastMath.h>
 
 namespace fly
 {
@@ -168,7 +170,7 @@ namespace fly
 
      for (auto& m : _models) {
        auto model = m->getComponent<Model>();
-       auto model_matrix = m->getComponent<Transform>()->getModelMatrix();
+       auto model_matrix = m->getComponent<Transform>()->getWorldMatrix();
        auto mvp = _projectionMatrix * _viewMatrix * model_matrix;
        GL_CHECK(glUniformMatrix4fv(shader->uniformLocation("MVP"), 1, false, &mvp[0][0]));
        auto indices = model->getMeshes()[0]->getAABBLineIndices();
@@ -223,7 +225,7 @@ namespace fly
       GL_CHECK(glUniform1i(shader->uniformLocation("gBufferSampler"), 1));
       GL_CHECK(glUniform1f(shader->uniformLocation("time"), _time));
       for (auto& t : _terrainRenderables) {
-        auto model_matrix = t.second->_transform->getModelMatrix();
+        auto model_matrix = t.second->_transform->getWorldMatrix();
         auto model_view = Mat4f(_viewMatrix) * model_matrix;
         GL_CHECK(glUniformMatrix4fv(shader->uniformLocation("MV"), 1, false, &model_view[0][0]));
         GL_CHECK(glUniformMatrix4fv(shader->uniformLocation("P"), 1, false, &_projectionMatrix[0][0]));
@@ -240,7 +242,7 @@ namespace fly
          GL_CHECK(glActiveTexture(GL_TEXTURE0));
          bindTextureOrLoadAsync(billboard->getTexturePath());
          auto transform = b->getComponent<Transform>();
-         auto model_view = _viewMatrix * transform->getModelMatrix();
+         auto model_view = _viewMatrix * transform->getWorldMatrix();
          auto scale = transform->getScale();
          model_view[0][0] = scale.x;
          model_view[0][1] = 0.f;
@@ -315,7 +317,7 @@ namespace fly
 
      for (auto& m : _models) {
        auto model = m->getComponent<Model>();
-       auto model_matrix = m->getComponent<Transform>()->getModelMatrix();
+       auto model_matrix = m->getComponent<Transform>()->getWorldMatrix();
        auto mvp = _projectionMatrix * _viewMatrix * model_matrix;
 
        auto shader = _aabbShader;
@@ -373,7 +375,7 @@ namespace fly
       const auto& tr = t.second;
       const auto& transform = tr->_transform;
       const auto& terrain = tr->_terrain;
-      auto model_matrix = transform->getModelMatrix();
+      auto model_matrix = transform->getWorldMatrix();
       auto tree_model_lod0 = terrain->getTreeModelLod0();
       auto tree_mesh_lod0 = tree_model_lod0->getMeshes()[0];
       auto tree_model_lod1 = terrain->getTreeModelLod1();
@@ -539,7 +541,7 @@ namespace fly
         const auto& transform = t.second->_transform;
         for (auto& n : t.second->_visibleNodes) {
           if (n->_transforms.size()) {
-            auto model_matrix = glm::mat4(transform->getModelMatrix()) * n->_transforms[0];
+            auto model_matrix = glm::mat4(transform->getWorldMatrix()) * n->_transforms[0];
             t.second->renderImpostor(terrain->getTreeModelLod1(), terrain->getLeavesModel(), model_matrix, this);
             break;
           }
@@ -836,7 +838,7 @@ namespace fly
     for (auto& t : _terrainRenderables) {
       t.second->_visibleNodes.clear();
       t.second->_visibleNodesShadowMap.clear();
-      auto model_matrix = t.second->_transform->getModelMatrix();
+      auto model_matrix = t.second->_transform->getWorldMatrix();
       t.second->_terrain->getTreeNodesForRendering(glm::inverse(glm::mat4(model_matrix)) * glm::vec4(_camPos, 1.f), t.second->_visibleNodes, _VP * glm::mat4(model_matrix), nullptr);
       t.second->_terrain->getTreeNodesForRendering(glm::inverse(glm::mat4(model_matrix)) * glm::vec4(_camPos, 1.f), t.second->_visibleNodesShadowMap, _VP * glm::mat4(model_matrix), (*_directionalLights.begin())->getComponent<DirectionalLight>().get(), light_volume * model_matrix);
     }
@@ -1062,7 +1064,7 @@ namespace fly
     }), models.end());
     for (auto& m : models) {
       auto transform = m->getComponent<Transform>();
-      auto model_matrix = m->getComponent<Transform>()->getModelMatrix();
+      auto model_matrix = m->getComponent<Transform>()->getWorldMatrix();
       auto model_view = Mat4f(_viewMatrix) * model_matrix;
       GL_CHECK(glUniformMatrix4fv(shader->uniformLocation("MV"), 1, false, &model_view[0][0]));
       GL_CHECK(glUniformMatrix4fv(shader->uniformLocation("MVInverseTranspose"), 1, true, &inverse(glm::mat4(model_view))[0][0]));
@@ -1142,7 +1144,7 @@ namespace fly
     }
     for (auto& t : _terrainRenderables) {
       auto terrain_renderable = t.second;
-      auto model_matrix = terrain_renderable->_transform->getModelMatrix();
+      auto model_matrix = terrain_renderable->_transform->getWorldMatrix();
       auto model_view = _viewMatrix * model_matrix;
       if (mode != TerrainRenderMode::WIREFRAME) {
         GL_CHECK(glUniformMatrix4fv(shader->uniformLocation("MV"), 1, false, &model_view[0][0]));
@@ -1230,9 +1232,9 @@ namespace fly
       }
       else {
         terrain_renderable->_terrainVao->bind();
-        std::map<int, std::map<int, int>> lods;
         auto cam_pos_model_space = inverse(glm::mat4(model_matrix)) * glm::vec4(_camPos, 1.f);
-        terrain->getTilesForRendering(lods, cam_pos_model_space, glm::mat4(_projectionMatrix * model_view));
+        float pixels_per_unit = _viewportSize.y * 0.5f * _projectionMatrix[1][1];
+        auto& tiles = terrain->getTilesForRendering(glm::vec3(cam_pos_model_space), Mat4f(_projectionMatrix) * model_view, pixels_per_unit);
         GL_CHECK(glUniform1f(shader->uniformLocation("scale"), 1.f));
         GL_CHECK(glActiveTexture(GL_TEXTURE0 + tex));
         bindTextureOrLoadAsync("assets/mountainslab01.dds");
@@ -1258,38 +1260,12 @@ namespace fly
         bindTextureOrLoadAsync("assets/road01_n.dds");
         GL_CHECK(glUniform1i(shader->uniformLocation("roadNormalSampler"), tex));
         tex++;
-        for (auto& e1 : lods) {
-          for (auto& e2 : e1.second) {
-            GL_CHECK(glUniform2f(shader->uniformLocation("pos"), e1.first, e2.first));
-            int lod = e2.second;
-            int dir = NONE;
-            {
-              int north_z = e2.first + terrain->getTileSize();
-              if (e1.second.count(north_z) && lod < e1.second[north_z]) {
-                dir |= NORTH;
-              }
-            }
-            {
-              int south_z = e2.first - terrain->getTileSize();
-              if (e1.second.count(south_z) && lod < e1.second[south_z]) {
-                dir |= SOUTH;
-              }
-            }
-            {
-              int west_x = e1.first - terrain->getTileSize();
-              if (lods.count(west_x) && lod < lods[west_x][e2.first]) {
-                dir |= WEST;
-              }
-            }
-            {
-              int east_x = e1.first + terrain->getTileSize();
-              if (lods.count(east_x) && lod < lods[east_x][e2.first]) {
-                dir |= EAST;
-              }
-            }
-            terrain_renderable->_terrainIbo[lod][dir]->bind();
-            GL_CHECK(glDrawElements(GL_TRIANGLES, terrain_renderable->_terrainNumIndices[lod][dir], GL_UNSIGNED_INT, nullptr));
-          }
+        terrain_renderable->_terrainIbo->bind();
+        auto& index_pool = terrain->getIndexPool();
+        for (const auto& t : tiles) {
+          GL_CHECK(glUniform2f(shader->uniformLocation("pos"), t._pos.x, t._pos.y));
+          auto& info = index_pool.getInfo(t._lod, t._mask);
+          GL_CHECK(glDrawElements(GL_TRIANGLES, info._numIndices, GL_UNSIGNED_INT, reinterpret_cast<const GLvoid*>(info._offset * sizeof(unsigned))));
         }
       }
     }
@@ -1918,7 +1894,7 @@ namespace fly
       if (m == entity) { // Don't render the light itself to the shadow map
         continue;
       }
-      auto model_matrix = m->getComponent<Transform>()->getModelMatrix();
+      auto model_matrix = m->getComponent<Transform>()->getWorldMatrix();
       GL_CHECK(glUniformMatrix4fv(shader->uniformLocation("M"), 1, false, &model_matrix[0][0]));
       auto model = m->getComponent<Model>();
       auto& meshes = model->getMeshes();
@@ -1962,7 +1938,7 @@ namespace fly
 
     for (auto& m : _models) {
       if (m != entity) { // Don't render the light itself to the shadow map
-        auto model_matrix = m->getComponent<Transform>()->getModelMatrix();
+        auto model_matrix = m->getComponent<Transform>()->getWorldMatrix();
         auto mvp = vp * model_matrix;
         GL_CHECK(glUniformMatrix4fv(shader->uniformLocation("MVP"), 1, false, &mvp[0][0]));
         auto model = m->getComponent<Model>();
@@ -2012,7 +1988,7 @@ namespace fly
 
     for (auto& m : _models) {
       if (m != entity) { // Don't render the light itself to the shadow map
-        auto model_matrix = m->getComponent<Transform>()->getModelMatrix();
+        auto model_matrix = m->getComponent<Transform>()->getWorldMatrix();
         GL_CHECK(glUniformMatrix4fv(shader->uniformLocation("M"), 1, false, &model_matrix[0][0]));
         auto model = m->getComponent<Model>();
         auto& materials = model->getMaterials();
@@ -2156,7 +2132,10 @@ namespace fly
   void RenderingSystemOpenGL::GrassQuadTree::build(Node* node)
   {
     glm::vec2 cam_pos_quadtree(_size * 0.5f);
-    float error = node->_size / glm::distance(cam_pos_quadtree, node->center());
+    auto dir = node->center() - cam_pos_quadtree;
+    float dist_sqr = glm::dot(dir, dir);
+    // rsqrt is undefined for zero and denormals, the nodes around the camera must always be refined
+    float error = dist_sqr >= std::numeric_limits<float>::min() ? node->_size * fastmath::rsqrt(dist_sqr) : std::numeric_limits<float>::max();
     int new_size = node->_size / 2;
     if (error > _errorThreshold && new_size >= _minSize) {
       auto south_west = new Node(node->_pos, new_size);
@@ -2185,7 +2164,7 @@ namespace fly
 
   RenderingSystemOpenGL::BloomStage::BloomStage(const glm::ivec2& view_port_size, unsigned int level) : _level(level)
   {
-    auto size = view_port_size / static_cast<int>(pow(2, level + 1));
+    auto size = view_port_size / (1 << (level + 1));
     for (int i = 0; i < 2; i++) {
       _fb[i] = std::make_shared<GLFramebufferOld>();
       _fb[i]->create(size.x, size.y);
@@ -2329,28 +2308,14 @@ namespace fly
     _terrainVbo = std::make_shared<GLBufferOld>();
     _terrainVbo->create();
     _terrainVbo->bind();
-    auto vertices = _terrain->getTileVertices();
-    _terrainVbo->setData(&vertices.front(), vertices.size() * sizeof(vertices.front()));
+    auto& index_pool = _terrain->getIndexPool();
+    _terrainVbo->setData(&index_pool.getVertices().front(), index_pool.getVertices().size() * sizeof(index_pool.getVertices().front()));
     GL_CHECK(glVertexAttribPointer(0, 2, GL_FLOAT, false, 0, nullptr));
 
-    for (int lod = 0; lod <= _terrain->getMaxLOD(); lod++) {
-      createIndexBuffer(lod, NONE, _terrain->getTileIndices(lod));
-      createIndexBuffer(lod, EAST, _terrain->getTileIndicesEast(lod));
-      createIndexBuffer(lod, WEST, _terrain->getTileIndicesWest(lod));
-      createIndexBuffer(lod, NORTH, _terrain->getTileIndicesNorth(lod));
-      createIndexBuffer(lod, SOUTH, _terrain->getTileIndicesSouth(lod));
-      createIndexBuffer(lod, NORTH | EAST, _terrain->getTileIndicesNorthEast(lod));
-      createIndexBuffer(lod, EAST | SOUTH, _terrain->getTileIndicesSouthEast(lod));
-      createIndexBuffer(lod, SOUTH | WEST, _terrain->getTileIndicesSouthWest(lod));
-      createIndexBuffer(lod, WEST | NORTH, _terrain->getTileIndicesNorthWest(lod));
-      createIndexBuffer(lod, NORTH | SOUTH, _terrain->getTileIndicesNorthSouth(lod));
-      createIndexBuffer(lod, EAST | WEST, _terrain->getTileIndicesEastWest(lod));
-      createIndexBuffer(lod, NORTH | EAST | SOUTH, _terrain->getTileIndicesNorthEastSouth(lod));
-      createIndexBuffer(lod, EAST | SOUTH | WEST, _terrain->gettileIndicesEastSouthWest(lod));
-      createIndexBuffer(lod, SOUTH | WEST | NORTH, _terrain->getTileIndicesSouthWestNorth(lod));
-      createIndexBuffer(lod, WEST | NORTH | EAST, _terrain->getTileIndicesWestNorthEast(lod));
-      createIndexBuffer(lod, NORTH | EAST | SOUTH | WEST, _terrain->getTileIndicesNorthWestSouthEast(lod));
-    }
+    _terrainIbo = std::make_shared<GLBufferOld>();
+    _terrainIbo->create(GL_ELEMENT_ARRAY_BUFFER);
+    _terrainIbo->bind();
+    _terrainIbo->setData(&index_pool.getIndices().front(), index_pool.getIndices().size() * sizeof(index_pool.getIndices().front()));
 
     for (unsigned int i = 0; i < 2; i++) {
       _impostorFb[i] = std::make_shared<GLFramebufferOld>();
@@ -2560,15 +2525,6 @@ namespace fly
     }
   }
 
-  void RenderingSystemOpenGL::TerrainRenderable::createIndexBuffer(int lod, int dir, const std::vector<unsigned>& indices)
-  {
-    _terrainIbo[lod][dir] = std::make_shared<GLBufferOld>();
-    _terrainIbo[lod][dir]->create(GL_ELEMENT_ARRAY_BUFFER);
-    _terrainIbo[lod][dir]->bind();
-    _terrainIbo[lod][dir]->setData(&indices[0], indices.size() * sizeof(indices[0]));
-    _terrainNumIndices[lod][dir] = indices.size();
-  }
-
   void RenderingSystemOpenGL::TerrainRenderable::renderImpostor(const std::shared_ptr<Model>& tree_model, const std::shared_ptr<Model>& leaf_model, const glm::mat4 & transform, RenderingSystemOpenGL * rs)
   {
     std::swap(_impostorFb[0], _impostorFb[1]);
@@ -2634,7 +2590,7 @@ namespace fly
 
   Mat4f RenderingSystemOpenGL::TerrainRenderable::getWaterModelMatrix()
   {
-    return _transform->getModelMatrix() * scale<4, float>(Vec3f(static_cast<float>(_terrain->getHeightMap().cols))) * translate<4, float>(Vec3f( 0.f, 0.00015f, 0.f ));
+    return _transform->getWorldMatrix() * scale<4, float>(Vec3f(static_cast<float>(_terrain->getHeightMap().cols))) * translate<4, float>(Vec3f( 0.f, 0.00015f, 0.f ));
   }
 
   RenderingSystemOpenGL::~RenderingSystemOpenGL()
@@ -2754,6 +2710,10 @@ namespace fly
 
   void RenderingSystemOpenGL::onTerrainAdded(Entity * entity)
   {
+    if (entity->getComponent<Terrain>()->getPager()) { // The renderable uploads the whole heightmap, pages only serve queries so far
+      std::cout << "RenderingSystemOpenGL::onTerrainAdded() Paged terrains can't be rendered" << std::endl;
+      return;
+    }
     _terrainRenderables[entity] = (std::make_shared<TerrainRenderable>(entity, this));
   }
 
@@ -13,6 +13,7 @@ namespace fly
     _world(std::make_unique<btDiscreteDynamicsWorld>(_collisionDispatcher.get(), _iBroadphase.get(), _solver.get(), _collisionConfig.get()))
   {
     _world->setGravity(btVector3(0.f, -10.f, 0.f));
+    writes<RigidBody>();
   }
   void Bullet3PhysicsSystem::setSimulationSubsteps(int steps)
   {
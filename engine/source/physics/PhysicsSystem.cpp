@@ -1,8 +1,13 @@
 #include <physics/PhysicsSystem.h>
 #include <Entity.h>
+#include <ParallelFor.h>
 
 namespace fly
 {
+  PhysicsSystem::PhysicsSystem()
+  {
+    writes<ParticleSystem>();
+  }
   void PhysicsSystem::onComponentsChanged(Entity * entity)
   {
     auto ps = entity->getComponent<ParticleSystem>();
@@ -12,12 +17,16 @@ namespace fly
     else {
       _particleSystems.erase(entity);
     }
+    _particleSystemsFlat.clear();
+    for (const auto& ps : _particleSystems) {
+      _particleSystemsFlat.push_back(ps.second.get());
+    }
   }
   void PhysicsSystem::updateSystem(float time, float delta_time)
   {
-    for (auto& ps : _particleSystems) {
-      ps.second->update(time, delta_time);
-    }
+    parallelForEach(_particleSystemsFlat, [time, delta_time](ParticleSystem* ps) {
+      ps->update(time, delta_time);
+    }, 1);
     /*  float max_delta = 1.f / 300.f;
       float delta = delta_time;
       while (delta > 0.f) {
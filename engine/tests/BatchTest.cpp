@@ -0,0 +1,99 @@
+#include <math/Batch.h>
+#include "TestHelpers.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+using namespace fly;
+
+namespace
+{
+  float maxDifference(const Vec3f& a, const Vec3f& b)
+  {
+    return (std::max)(std::abs(a[0] - b[0]), (std::max)(std::abs(a[1] - b[1]), std::abs(a[2] - b[2])));
+  }
+  bool equal(const Vec3f& a, const Vec3f& b)
+  {
+    return a[0] == b[0] && a[1] == b[1] && a[2] == b[2];
+  }
+}
+
+int main()
+{
+  // minimum and maximum behave like (std::min)(a, b) and (std::max)(a, b): a is kept on NaN and equal values
+  const float nan = std::numeric_limits<float>::quiet_NaN();
+  FLY_CHECK(minimum(Vec3f(1.f), Vec3f(nan))[0] == 1.f);
+  FLY_CHECK(maximum(Vec3f(1.f), Vec3f(nan))[1] == 1.f);
+  FLY_CHECK(std::isnan(minimum(Vec3f(nan), Vec3f(1.f))[2]));
+  FLY_CHECK(std::signbit(minimum(Vec3f(-0.f), Vec3f(0.f))[0]));
+  FLY_CHECK(!std::signbit(maximum(Vec3f(0.f), Vec3f(-0.f))[0]));
+
+  // 23 points, not a multiple of four, so that the scalar tails run too
+  std::mt19937 gen(5);
+  std::uniform_real_distribution<float> dist(-100.f, 100.f);
+  std::vector<Vec3f> points(23);
+  for (auto& p : points) {
+    p = Vec3f(dist(gen), dist(gen), dist(gen));
+  }
+  // NaN coordinates don't change the box, neither in the SIMD loop nor in the tail
+  auto with_nan = points;
+  with_nan[2][0] = nan;
+  with_nan[9][1] = nan;
+  with_nan.push_back(Vec3f(nan));
+  Vec3f bb_min(std::numeric_limits<float>::max()), bb_max(std::numeric_limits<float>::lowest());
+  minMaxReduce(with_nan.data(), with_nan.size(), sizeof(Vec3f), bb_min, bb_max);
+  Vec3f expected_min(std::numeric_limits<float>::max()), expected_max(std::numeric_limits<float>::lowest());
+  for (unsigned j = 0; j < 3; j++) {
+    for (size_t i = 0; i < with_nan.size(); i++) {
+      if (!std::isnan(with_nan[i][j])) {
+        expected_min[j] = (std::min)(expected_min[j], with_nan[i][j]);
+        expected_max[j] = (std::max)(expected_max[j], with_nan[i][j]);
+      }
+    }
+  }
+  FLY_CHECK(equal(bb_min, expected_min));
+  FLY_CHECK(equal(bb_max, expected_max));
+
+  // Transformed points and boxes against the matrix vector product
+  Mat4f rot_y = identity<4, float>();
+  rot_y[0][0] = std::cos(0.7f); rot_y[0][2] = -std::sin(0.7f); rot_y[2][0] = std::sin(0.7f); rot_y[2][2] = std::cos(0.7f);
+  Mat4f m = translate<4, float>(Vec3f(3.f, -7.f, 11.f)) * rot_y * fly::scale<4, float>(Vec3f(0.5f, 2.f, 1.5f));
+  std::vector<Vec3f> transformed(points.size());
+  transformPoints(m, points.data(), points.size(), sizeof(Vec3f), transformed.data());
+  float max_error = 0.f;
+  Vec3f ref_transformed_min(std::numeric_limits<float>::max()), ref_transformed_max(std::numeric_limits<float>::lowest());
+  for (size_t i = 0; i < points.size(); i++) {
+    Vec3f ref = (m * Vec4f(points[i], 1.f)).xyz();
+    max_error = (std::max)(max_error, maxDifference(transformed[i], ref));
+    ref_transformed_min = minimum(ref_transformed_min, ref);
+    ref_transformed_max = maximum(ref_transformed_max, ref);
+  }
+  FLY_CHECK(max_error < 1e-4f);
+  bb_min = Vec3f(std::numeric_limits<float>::max());
+  bb_max = Vec3f(std::numeric_limits<float>::lowest());
+  minMaxReduce(m, with_nan.data(), points.size(), sizeof(Vec3f), bb_min, bb_max);
+  Vec3f clean_min(std::numeric_limits<float>::max()), clean_max(std::numeric_limits<float>::lowest());
+  minMaxReduce(m, points.data(), points.size(), sizeof(Vec3f), clean_min, clean_max);
+  FLY_CHECK(maxDifference(clean_min, ref_transformed_min) < 1e-4f && maxDifference(clean_max, ref_transformed_max) < 1e-4f);
+  // A NaN coordinate makes the whole transformed point NaN, so points 2 and 9 are skipped entirely
+  bool nan_skipped = true;
+  for (unsigned j = 0; j < 3; j++) {
+    nan_skipped = nan_skipped && !std::isnan(bb_min[j]) && !std::isnan(bb_max[j]) && bb_min[j] >= clean_min[j] && bb_max[j] <= clean_max[j];
+  }
+  FLY_CHECK(nan_skipped);
+
+  Vec3f box_min(-1.f, -2.f, -3.f), box_max(4.f, 5.f, 6.f), out_min, out_max;
+  transformAABBs(m, &box_min, &box_max, 1, &out_min, &out_max);
+  Vec3f corners_min(std::numeric_limits<float>::max()), corners_max(std::numeric_limits<float>::lowest());
+  for (unsigned c = 0; c < 8; c++) {
+    Vec3f corner(c & 1 ? box_max[0] : box_min[0], c & 2 ? box_max[1] : box_min[1], c & 4 ? box_max[2] : box_min[2]);
+    Vec3f p = (m * Vec4f(corner, 1.f)).xyz();
+    corners_min = minimum(corners_min, p);
+    corners_max = maximum(corners_max, p);
+  }
+  FLY_CHECK(maxDifference(out_min, corners_min) < 1e-4f && maxDifference(out_max, corners_max) < 1e-4f);
+
+  return test::failures();
+}
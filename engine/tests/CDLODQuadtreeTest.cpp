@@ -0,0 +1,108 @@
+#include <CDLODQuadtree.h>
+#include "TestHelpers.h"
+#include <array>
+#include <cmath>
+#include <vector>
+
+using namespace fly;
+
+namespace
+{
+  /**
+  * Number of selected nodes per LOD.
+  */
+  std::array<unsigned, 6> countPerLod(const std::vector<CDLODQuadtree::Node>& nodes)
+  {
+    std::array<unsigned, 6> counts = {};
+    for (const auto& n : nodes) {
+      counts[n._lod]++;
+    }
+    return counts;
+  }
+  /**
+  * True if the nodes cover every texel of a size x size heightmap exactly once.
+  */
+  bool coversExactlyOnce(const std::vector<CDLODQuadtree::Node>& nodes, int size)
+  {
+    std::vector<unsigned char> covered(size * size, 0);
+    for (const auto& n : nodes) {
+      for (int z = n._pos.y; z < n._pos.y + n._size; z++) {
+        for (int x = n._pos.x; x < n._pos.x + n._size; x++) {
+          if (x >= size || z >= size || covered[z * size + x]++) {
+            return false;
+          }
+        }
+      }
+    }
+    for (auto c : covered) {
+      if (!c) {
+        return false;
+      }
+    }
+    return true;
+  }
+}
+
+int main()
+{
+  // Flat 2048^2 heightmap with the default settings: leaves of 32 texels, 6 LODs with ranges 128 * 2^i
+  const int size = 2048;
+  std::vector<float> heights(size * size, 0.f);
+  auto pyramid = std::make_shared<const MinMaxPyramid>(heights.data(), size, size, size);
+  CDLODQuadtree quadtree(pyramid);
+  FLY_CHECK(quadtree.getGridResolution() == 32);
+  FLY_CHECK(quadtree.getRange(5) == 4096.f);
+
+  // Beyond the range of LOD 4 everywhere: the four roots of size 1024
+  auto nodes = quadtree.select(Vec3f(1024.f, 5000.f, 1024.f));
+  FLY_CHECK(nodes.size() == 4);
+  FLY_CHECK(countPerLod(nodes)[5] == 4);
+
+  // 1500 units above the center, every node is within the range of LOD 4 and beyond the range of LOD 3,
+  // so each root is split into its four children of size 512
+  nodes = quadtree.select(Vec3f(1024.f, 1500.f, 1024.f));
+  FLY_CHECK(nodes.size() == 16);
+  FLY_CHECK(countPerLod(nodes)[4] == 16);
+  FLY_CHECK(coversExactlyOnce(nodes, size));
+
+  // On the ground at the center: reference counts per LOD. LOD 0 gets the 32 texel cells within 128 units,
+  // 15 per quadrant since the diagonal cell at (96, 96) is 136 units away.
+  nodes = quadtree.select(Vec3f(1024.f, 1.f, 1024.f));
+  auto counts = countPerLod(nodes);
+  std::cout << "Nodes per LOD:";
+  for (auto c : counts) {
+    std::cout << " " << c;
+  }
+  std::cout << std::endl;
+  const std::array<unsigned, 6> reference = { 60, 48, 48, 48, 4, 0 };
+  FLY_CHECK(counts == reference);
+  FLY_CHECK(coversExactlyOnce(nodes, size));
+  bool ranges_valid = true;
+  for (const auto& n : nodes) {
+    Vec3f closest(glm::clamp(1024.f, static_cast<float>(n._pos.x), static_cast<float>(n._pos.x + n._size)), 0.f,
+      glm::clamp(1024.f, static_cast<float>(n._pos.y), static_cast<float>(n._pos.y + n._size)));
+    float dist = distance(closest, Vec3f(1024.f, 1.f, 1024.f));
+    // Within the range of the node's LOD and, unless it is a quarter node, beyond the range of the finer LOD
+    ranges_valid = ranges_valid && dist <= quadtree.getRange(n._lod) && n._morphEnd == quadtree.getRange(n._lod) &&
+      n._morphStart == quadtree.getMorphStart(n._lod) && (n._lod == 0 || n._size < (32 << n._lod) || dist > quadtree.getRange(n._lod - 1));
+  }
+  FLY_CHECK(ranges_valid);
+
+  // Deterministic, and frustum culling only removes nodes
+  std::vector<CDLODQuadtree::Node> first = quadtree.select(Vec3f(700.f, 40.f, 1300.f));
+  const auto& second = quadtree.select(Vec3f(700.f, 40.f, 1300.f));
+  bool equal = first.size() == second.size();
+  for (size_t i = 0; equal && i < first.size(); i++) {
+    equal = first[i]._pos == second[i]._pos && first[i]._size == second[i]._size && first[i]._lod == second[i]._lod;
+  }
+  FLY_CHECK(equal);
+  Mat4f mvp = perspectiveZO(radians(60.f), 1.f, 0.1f, 10000.f) * lookAt(Vec3f(700.f, 40.f, 1300.f), Vec3f(1700.f, 0.f, 1300.f), Vec3f(0.f, 1.f, 0.f));
+  auto culled = quadtree.select(Vec3f(700.f, 40.f, 1300.f), mvp).size();
+  FLY_CHECK(culled > 0 && culled < first.size());
+
+  // The quadtree shares the pyramid, it stays valid when the caller drops its reference
+  pyramid.reset();
+  FLY_CHECK(quadtree.select(Vec3f(1024.f, 1500.f, 1024.f)).size() == 16);
+
+  return test::failures();
+}
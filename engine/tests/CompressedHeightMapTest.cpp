@@ -0,0 +1,145 @@
+#include <CompressedHeightMap.h>
+#include "TestHelpers.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+using namespace fly;
+
+namespace
+{
+  bool rejected(int width, int height, int tile_size)
+  {
+    std::vector<float> heights(16, 0.f);
+    try {
+      CompressedHeightMap(heights.data(), width, height, 4, tile_size);
+    }
+    catch (const std::invalid_argument&) {
+      return true;
+    }
+    return false;
+  }
+  /**
+  * Largest error of the decoded heights relative to the bound of their tile: half the step of the tile's height
+  * range / 65535 or 2 * max_error, whichever is larger.
+  */
+  float maxRelativeError(const CompressedHeightMap& chm, const std::vector<float>& heights, size_t row_stride, float max_error, const std::vector<float>& decoded)
+  {
+    const int tile_size = chm.getTileSize();
+    float max_relative_error = 0.f;
+    for (int tile_z = 0; tile_z * tile_size < chm.getSize().y; tile_z++) {
+      for (int tile_x = 0; tile_x * tile_size < chm.getSize().x; tile_x++) {
+        int x_end = (std::min)((tile_x + 1) * tile_size, chm.getSize().x);
+        int z_end = (std::min)((tile_z + 1) * tile_size, chm.getSize().y);
+        float min = heights[tile_z * tile_size * row_stride + tile_x * tile_size], max = min;
+        for (int z = tile_z * tile_size; z < z_end; z++) {
+          for (int x = tile_x * tile_size; x < x_end; x++) {
+            min = (std::min)(min, heights[z * row_stride + x]);
+            max = (std::max)(max, heights[z * row_stride + x]);
+          }
+        }
+        float bound = (std::max)((max - min) / 65535.f, max_error * 2.f) * 0.5f + 1e-5f;
+        for (int z = tile_z * tile_size; z < z_end; z++) {
+          for (int x = tile_x * tile_size; x < x_end; x++) {
+            max_relative_error = (std::max)(max_relative_error, std::abs(decoded[z * chm.getSize().x + x] - heights[z * row_stride + x]) / bound);
+          }
+        }
+      }
+    }
+    return max_relative_error;
+  }
+}
+
+int main()
+{
+  // Not a multiple of the tile size, rows padded. Smooth hills with a noisy corner, so that both encodings are used
+  const int width = 300, height = 200;
+  const size_t row_stride = 310;
+  std::vector<float> heights(row_stride * height, 1e30f);
+  std::mt19937 gen(3);
+  std::uniform_real_distribution<float> noise(-50.f, 50.f);
+  for (int z = 0; z < height; z++) {
+    for (int x = 0; x < width; x++) {
+      heights[z * row_stride + x] = std::sin(x * 0.05f) * 20.f + std::cos(z * 0.07f) * 10.f + (x < 64 && z < 64 ? noise(gen) : 0.f);
+    }
+  }
+
+  FLY_CHECK(rejected(4, 4, 0));
+  FLY_CHECK(rejected(4, 4, -32));
+  FLY_CHECK(rejected(0, 4, 32));
+  FLY_CHECK(!rejected(4, 4, 32));
+
+  for (float max_error : { 0.f, 0.05f }) {
+    CompressedHeightMap chm(heights.data(), width, height, row_stride, 32, max_error);
+    unsigned num_delta8 = 0, num_raw16 = 0;
+    for (int tile_z = 0; tile_z < (height + 31) / 32; tile_z++) {
+      for (int tile_x = 0; tile_x < (width + 31) / 32; tile_x++) {
+        const auto& info = chm.getTileInfo(tile_x, tile_z);
+        num_delta8 += info._encoding == CompressedHeightMap::Encoding::Delta8;
+        num_raw16 += info._encoding == CompressedHeightMap::Encoding::Raw16;
+      }
+    }
+    std::cout << "Max error " << max_error << ": " << num_delta8 << " delta8 tiles, " << num_raw16 << " raw16 tiles, " << chm.getMemorySize() << " bytes" << std::endl;
+    FLY_CHECK(num_raw16 > 0);
+    FLY_CHECK(max_error == 0.f || num_delta8 > 0);
+    // 16 bit per texel at most, the delta tiles shrink it further
+    size_t raw16_size = static_cast<size_t>(width) * height * sizeof(uint16_t) + (num_delta8 + num_raw16) * sizeof(CompressedHeightMap::TileInfo);
+    FLY_CHECK(chm.getMemorySize() <= raw16_size);
+    FLY_CHECK(max_error == 0.f || chm.getMemorySize() < raw16_size * 3 / 4);
+
+    // Random access, full decode and region decode all stay within half a step
+    std::vector<float> single(width * height);
+    for (int z = 0; z < height; z++) {
+      for (int x = 0; x < width; x++) {
+        single[z * width + x] = chm.getHeight(x, z);
+      }
+    }
+    auto decoded = chm.decode();
+    FLY_CHECK(decoded.size() == single.size());
+    FLY_CHECK(decoded == single);
+    FLY_CHECK(maxRelativeError(chm, heights, row_stride, max_error, decoded) <= 1.f);
+    FLY_CHECK(chm.getHeight(-5, -5) == decoded[0] && chm.getHeight(width + 5, height + 5) == decoded.back());
+
+    // A region that crosses tile borders and sticks out of the heightmap, texels outside stay untouched
+    const glm::ivec2 pos(250, -7), size(70, 40);
+    std::vector<float> region(size.x * size.y, -1.f);
+    chm.decode(pos, size, region.data(), size.x);
+    bool region_exact = true;
+    for (int z = 0; z < size.y; z++) {
+      for (int x = 0; x < size.x; x++) {
+        glm::ivec2 p = pos + glm::ivec2(x, z);
+        bool inside = p.x >= 0 && p.y >= 0 && p.x < width && p.y < height;
+        region_exact = region_exact && region[z * size.x + x] == (inside ? decoded[p.y * width + p.x] : -1.f);
+      }
+    }
+    FLY_CHECK(region_exact);
+
+    // Save and load reproduce the same heights, truncated files are rejected
+    const char* path = "CompressedHeightMapTest.chm";
+    FLY_CHECK(chm.save(path));
+    auto loaded = CompressedHeightMap::load(path);
+    FLY_CHECK(loaded != nullptr);
+    if (loaded) {
+      FLY_CHECK(loaded->getSize() == chm.getSize() && loaded->getTileSize() == 32 && loaded->getMemorySize() == chm.getMemorySize());
+      FLY_CHECK(loaded->decode() == decoded);
+    }
+    std::vector<char> data;
+    {
+      std::ifstream is(path, std::ios::binary);
+      data.assign(std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>());
+    }
+    {
+      std::ofstream os(path, std::ios::binary);
+      os.write(data.data(), data.size() - 1);
+    }
+    FLY_CHECK(CompressedHeightMap::load(path) == nullptr);
+    std::remove(path);
+  }
+
+  return test::failures();
+}
@@ -0,0 +1,50 @@
+#include <math/FlyMath.h>
+#include <GeometryGenerator.h>
+#include "TestHelpers.h"
+
+using namespace fly;
+
+namespace
+{
+  constexpr Vec3f a(1.f, -2.f, 3.5f), b(0.25f, 4.f, -1.f);
+  constexpr Mat4f m = translate<4, float>(Vec3f(3.f, -7.f, 11.f)) * fly::scale<4, float>(Vec3f(0.5f, 2.f, 1.5f)) * orthoZO(-2.f, 2.f, -1.f, 1.f, 0.5f, 8.f);
+  constexpr Vec4f p = m * Vec4f(a, 1.f);
+
+  // Vector arithmetic, dot products and matrix products are constant expressions with and without SIMD
+  static_assert((a + b)[0] == 1.25f && (a - b)[1] == -6.f && (a * b)[2] == -3.5f && (a / b)[0] == 4.f, "Vector arithmetic");
+  static_assert(dot(a, b) == -11.25f && dot(Vec4f(a, 2.f), Vec4f(b, 3.f)) == -5.25f, "Dot product");
+  static_assert(minimum(a, b)[0] == 0.25f && maximum(a, b)[1] == 4.f, "Minimum and maximum");
+  static_assert(m[3][0] == 3.f && (identity<4, float>() * m)[2][2] == m[2][2], "Matrix product");
+  constexpr std::array<Vec3f, 8> cube = GeometryGenerator::getCubeVertices(0.f);
+  static_assert((cube[7] - cube[0])[0] == 2.f && (cube[7] - cube[0])[2] == 1.f, "Cube table");
+
+  float maxDifference(const Mat4f& x, const Mat4f& y)
+  {
+    float diff = 0.f;
+    for (unsigned c = 0; c < 4; c++) {
+      for (unsigned r = 0; r < 4; r++) {
+        diff = (std::max)(diff, std::abs(x[c][r] - y[c][r]));
+      }
+    }
+    return diff;
+  }
+}
+
+int main()
+{
+  // The runtime paths give the same results as constant evaluation, up to fused multiply adds
+  volatile float volatile_one = 1.f;
+  const float one = volatile_one;
+  Vec3f a_rt = a * Vec3f(one), b_rt = b * Vec3f(one);
+  FLY_CHECK(dot(a_rt, b_rt) == dot(a, b));
+  Vec3f sum = a_rt + b_rt;
+  FLY_CHECK(sum[0] == (a + b)[0] && sum[1] == (a + b)[1] && sum[2] == (a + b)[2]);
+  Mat4f m_rt = translate<4, float>(Vec3f(3.f, -7.f, 11.f) * Vec3f(one)) * fly::scale<4, float>(Vec3f(0.5f, 2.f, 1.5f)) * orthoZO(-2.f, 2.f, -1.f, 1.f, 0.5f, 8.f * one);
+  FLY_CHECK(maxDifference(m_rt, m) < 1e-6f);
+  Vec4f p_rt = m_rt * Vec4f(a_rt, one);
+  for (unsigned i = 0; i < 4; i++) {
+    FLY_CHECK(std::abs(p_rt[i] - p[i]) < 1e-5f);
+  }
+
+  return test::failures();
+}
@@ -0,0 +1,71 @@
+#include <math/FastMath.h>
+#include "TestHelpers.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <vector>
+
+using namespace fly;
+
+namespace
+{
+  std::vector<float> getRange(float min, float max, size_t count)
+  {
+    std::vector<float> x(count);
+    for (size_t i = 0; i < count; i++) {
+      x[i] = min + (max - min) * static_cast<float>(i) / static_cast<float>(count - 1);
+    }
+    return x;
+  }
+  /**
+  * Largest error of the scalar and bulk versions against the double precision reference. Errors are relative
+  * where the reference is larger than abs_below in magnitude and absolute otherwise.
+  */
+  double getMaxError(const std::vector<float>& x, float(*scalar)(float), void(*bulk)(const float*, float*, size_t),
+    const std::function<double(double)>& reference, double abs_below)
+  {
+    std::vector<float> bulk_result(x.size());
+    bulk(x.data(), bulk_result.data(), x.size());
+    double max_error = 0.;
+    for (size_t i = 0; i < x.size(); i++) {
+      double ref = reference(x[i]);
+      double scale = std::abs(ref) > abs_below ? std::abs(ref) : 1.;
+      max_error = (std::max)(max_error, std::abs(scalar(x[i]) - ref) / scale);
+      max_error = (std::max)(max_error, std::abs(bulk_result[i] - ref) / scale);
+    }
+    return max_error;
+  }
+}
+
+int main()
+{
+  const size_t count = 1000003; // Not a multiple of the SIMD width, so that the scalar tail of the bulk versions runs too
+  auto angles = getRange(-8192.f, 8192.f, count);
+  auto small_angles = getRange(-10.f, 10.f, count);
+  double sin_error = (std::max)(getMaxError(angles, fastmath::sin, fastmath::sin, [](double x) { return std::sin(x); }, 1e30),
+    getMaxError(small_angles, fastmath::sin, fastmath::sin, [](double x) { return std::sin(x); }, 1e30));
+  double cos_error = (std::max)(getMaxError(angles, fastmath::cos, fastmath::cos, [](double x) { return std::cos(x); }, 1e30),
+    getMaxError(small_angles, fastmath::cos, fastmath::cos, [](double x) { return std::cos(x); }, 1e30));
+  double exp2_error = getMaxError(getRange(-126.f, 127.f, count), fastmath::exp2, fastmath::exp2, [](double x) { return std::exp2(x); }, 0.);
+  double log2_error = (std::max)(getMaxError(getRange(0.5f, 2.f, count), fastmath::log2, fastmath::log2, [](double x) { return std::log2(x); }, 1e30),
+    getMaxError(getRange(2.f, 1e6f, count), fastmath::log2, fastmath::log2, [](double x) { return std::log2(x); }, 0.));
+  double rsqrt_error = getMaxError(getRange(1e-6f, 1e6f, count), fastmath::rsqrt, fastmath::rsqrt, [](double x) { return 1. / std::sqrt(x); }, 0.);
+  std::cout << "Max errors: sin " << sin_error << " cos " << cos_error << " exp2 " << exp2_error << " log2 " << log2_error
+    << " rsqrt " << rsqrt_error << std::endl;
+
+  // Documented bounds in FastMath.h
+  FLY_CHECK(sin_error < 1e-7);
+  FLY_CHECK(cos_error < 1e-7);
+  FLY_CHECK(exp2_error < 1e-7);
+  FLY_CHECK(log2_error < 1e-7);
+#ifdef FLY_SSE
+  FLY_CHECK(rsqrt_error < 3e-7);
+#else
+  FLY_CHECK(rsqrt_error < 5e-6);
+#endif
+
+  float pow_ref = static_cast<float>(std::pow(3.7, 2.3));
+  FLY_CHECK(std::abs(fastmath::pow(3.7f, 2.3f) - pow_ref) < pow_ref * 1e-6f);
+
+  return test::failures();
+}
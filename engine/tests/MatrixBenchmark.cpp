@@ -0,0 +1,111 @@
+#include <math/FlyMath.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include "TestHelpers.h"
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace fly;
+
+namespace
+{
+  float maxDifference(const Mat4f& a, const Mat4f& b)
+  {
+    float diff = 0.f;
+    for (unsigned i = 0; i < 4; i++) {
+      for (unsigned j = 0; j < 4; j++) {
+        diff = (std::max)(diff, std::abs(a[i][j] - b[i][j]));
+      }
+    }
+    return diff;
+  }
+  /**
+  * Nanoseconds per call of func over all matrices, the results are accumulated so that nothing is optimized away.
+  */
+  template<typename Func>
+  double measure(const std::vector<Mat4f>& matrices, float& sink, Func func)
+  {
+    const unsigned repetitions = 20;
+    auto begin = std::chrono::high_resolution_clock::now();
+    for (unsigned r = 0; r < repetitions; r++) {
+      for (const auto& m : matrices) {
+        sink += func(m)[3][0];
+      }
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::nano>(end - begin).count() / (matrices.size() * repetitions);
+  }
+}
+
+int main()
+{
+  // Model matrices with rotation, non uniform scale and translation, like Transform produces
+  std::mt19937 gen(7);
+  std::uniform_real_distribution<float> angle(-3.14f, 3.14f), scale(0.2f, 5.f), translation(-1000.f, 1000.f);
+  std::vector<Mat4f> model_matrices(100000);
+  for (auto& m : model_matrices) {
+    float sx = std::sin(angle(gen)), cx = std::cos(angle(gen));
+    float sy = std::sin(angle(gen)), cy = std::cos(angle(gen));
+    Mat4f rot_x = identity<4, float>(), rot_y = identity<4, float>();
+    rot_x[1][1] = cx; rot_x[1][2] = sx; rot_x[2][1] = -sx; rot_x[2][2] = cx;
+    rot_y[0][0] = cy; rot_y[0][2] = -sy; rot_y[2][0] = sy; rot_y[2][2] = cy;
+    m = translate<4, float>(Vec3f(translation(gen), translation(gen), translation(gen))) * rot_x * rot_y
+      * fly::scale<4, float>(Vec3f(scale(gen), scale(gen), scale(gen)));
+  }
+  // General matrices: view projection matrices of cameras around the origin. The perspective divide makes these
+  // badly conditioned, so the camera positions are kept in a range where float inversion is meaningful.
+  std::vector<Mat4f> vp_matrices(model_matrices.size());
+  auto projection = perspectiveNO(radians(45.f), 16.f / 9.f, 0.1f, 1000.f);
+  std::uniform_real_distribution<float> camera_pos(-50.f, 50.f);
+  for (auto& vp : vp_matrices) {
+    Vec3f eye(camera_pos(gen), camera_pos(gen), camera_pos(gen));
+    vp = projection * lookAt(eye, eye + Vec3f(angle(gen), angle(gen) * 0.3f, angle(gen)), Vec3f(0.f, 1.f, 0.f));
+  }
+
+  // Accuracy: M * M^-1 = I, and agreement with glm
+  float max_error_inverse = 0.f, max_error_affine = 0.f, max_error_vp = 0.f, max_diff_glm = 0.f;
+  for (size_t i = 0; i < model_matrices.size(); i += 97) {
+    const auto& m = model_matrices[i];
+    max_error_inverse = (std::max)(max_error_inverse, maxDifference(m * inverse(m), identity<4, float>()));
+    max_error_affine = (std::max)(max_error_affine, maxDifference(m * inverseAffine(m), identity<4, float>()));
+    max_error_vp = (std::max)(max_error_vp, maxDifference(vp_matrices[i] * inverse(vp_matrices[i]), identity<4, float>()));
+    Mat4f glm_inverse = glm::inverse(static_cast<glm::mat4>(vp_matrices[i]));
+    Mat4f fly_inverse = inverse(vp_matrices[i]);
+    float magnitude = 0.f;
+    for (unsigned c = 0; c < 4; c++) {
+      magnitude = (std::max)(magnitude, fly_inverse[c].length());
+    }
+    max_diff_glm = (std::max)(max_diff_glm, maxDifference(fly_inverse, glm_inverse) / magnitude);
+  }
+  std::cout << "Max errors: inverse " << max_error_inverse << " inverseAffine " << max_error_affine << " view projection inverse " << max_error_vp
+    << " relative difference to glm " << max_diff_glm << std::endl;
+  FLY_CHECK(max_error_inverse < 1e-3f);
+  FLY_CHECK(max_error_affine < 1e-3f);
+  FLY_CHECK(max_error_vp < 1e-3f);
+  FLY_CHECK(max_diff_glm < 1e-4f);
+
+  Vec3f eye(3.f, 7.f, -2.f), target(-1.f, 0.5f, 4.f), up(0.f, 1.f, 0.f);
+  FLY_CHECK(maxDifference(lookAt(eye, target, up), Mat4f(glm::lookAtRH(glm::vec3(eye), glm::vec3(target), glm::vec3(up)))) < 1e-5f);
+  FLY_CHECK(maxDifference(perspectiveZO(1.2f, 1.5f, 0.1f, 500.f), Mat4f(glm::perspectiveRH_ZO(1.2f, 1.5f, 0.1f, 500.f))) < 1e-5f);
+  FLY_CHECK(maxDifference(perspectiveNO(1.2f, 1.5f, 0.1f, 500.f), Mat4f(glm::perspectiveRH_NO(1.2f, 1.5f, 0.1f, 500.f))) < 1e-5f);
+  FLY_CHECK(maxDifference(orthoZO(-3.f, 5.f, -2.f, 4.f, 0.5f, 80.f), Mat4f(glm::orthoRH_ZO(-3.f, 5.f, -2.f, 4.f, 0.5f, 80.f))) < 1e-6f);
+  FLY_CHECK(maxDifference(orthoNO(-3.f, 5.f, -2.f, 4.f, 0.5f, 80.f), Mat4f(glm::orthoRH_NO(-3.f, 5.f, -2.f, 4.f, 0.5f, 80.f))) < 1e-6f);
+
+  float sink = 0.f;
+  double fly_inverse = measure(vp_matrices, sink, [](const Mat4f& m) { return inverse(m); });
+  double fly_affine = measure(model_matrices, sink, [](const Mat4f& m) { return inverseAffine(m); });
+  double glm_inverse = measure(vp_matrices, sink, [](const Mat4f& m) { return Mat4f(glm::inverse(static_cast<glm::mat4>(m))); });
+  double fly_look_at = measure(model_matrices, sink, [](const Mat4f& m) { return lookAt(m[3].xyz(), m[0].xyz(), Vec3f(0.f, 1.f, 0.f)); });
+  double glm_look_at = measure(model_matrices, sink, [](const Mat4f& m) {
+    return Mat4f(glm::lookAtRH(glm::vec3(m[3].xyz()), glm::vec3(m[0].xyz()), glm::vec3(0.f, 1.f, 0.f)));
+  });
+  double fly_perspective = measure(model_matrices, sink, [](const Mat4f& m) { return perspectiveZO(m[0][0] + 1.f, 1.5f, 0.1f, 500.f); });
+  double glm_perspective = measure(model_matrices, sink, [](const Mat4f& m) { return Mat4f(glm::perspectiveRH_ZO(m[0][0] + 1.f, 1.5f, 0.1f, 500.f)); });
+  std::cout << "ns per call: inverse fly " << fly_inverse << " glm " << glm_inverse << ", inverseAffine fly " << fly_affine
+    << ", lookAt fly " << fly_look_at << " glm " << glm_look_at << ", perspective fly " << fly_perspective << " glm " << glm_perspective
+    << " (" << sink << ")" << std::endl;
+
+  return test::failures();
+}
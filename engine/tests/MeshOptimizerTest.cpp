@@ -0,0 +1,166 @@
+#include <MeshOptimizer.h>
+#include <Mesh.h>
+#include "TestHelpers.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <random>
+#include <set>
+#include <tuple>
+
+using namespace fly;
+
+namespace
+{
+  /**
+  * Wavy n x n quad grid with shuffled triangles, the worst case for the vertex cache.
+  */
+  void createShuffledGrid(unsigned n, std::vector<Vertex>& vertices, std::vector<unsigned>& indices)
+  {
+    vertices.resize((n + 1) * (n + 1));
+    for (unsigned z = 0; z <= n; z++) {
+      for (unsigned x = 0; x <= n; x++) {
+        vertices[z * (n + 1) + x]._position = Vec3f(static_cast<float>(x), std::sin(x * 0.1f + z * 0.2f), static_cast<float>(z));
+      }
+    }
+    std::vector<std::array<unsigned, 3>> triangles;
+    for (unsigned z = 0; z < n; z++) {
+      for (unsigned x = 0; x < n; x++) {
+        unsigned a = z * (n + 1) + x, b = a + 1, c = a + n + 1, d = c + 1;
+        triangles.push_back({ a, c, b });
+        triangles.push_back({ b, c, d });
+      }
+    }
+    std::shuffle(triangles.begin(), triangles.end(), std::mt19937(1));
+    indices.clear();
+    for (const auto& t : triangles) {
+      indices.insert(indices.end(), t.begin(), t.end());
+    }
+  }
+  /**
+  * Closed shell between two spheres with shuffled triangles: the outer sphere faces outward, the inner one
+  * faces inward towards the center, like the inside of a hollow ball.
+  */
+  void createHollowSphere(unsigned rings, unsigned segments, std::vector<Vertex>& vertices, std::vector<unsigned>& indices)
+  {
+    vertices.clear();
+    std::vector<std::array<unsigned, 3>> triangles;
+    for (float radius : { 2.f, 1.f }) {
+      unsigned first = static_cast<unsigned>(vertices.size());
+      for (unsigned r = 0; r <= rings; r++) {
+        float theta = 3.14159265f * r / rings;
+        for (unsigned s = 0; s < segments; s++) {
+          float phi = 2.f * 3.14159265f * s / segments;
+          Vertex v = {};
+          v._position = Vec3f(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi)) * radius;
+          vertices.push_back(v);
+        }
+      }
+      for (unsigned r = 0; r < rings; r++) {
+        for (unsigned s = 0; s < segments; s++) {
+          unsigned a = first + r * segments + s, b = first + r * segments + (s + 1) % segments;
+          unsigned c = a + segments, d = b + segments;
+          for (auto t : { std::array<unsigned, 3>{ a, b, c }, std::array<unsigned, 3>{ b, d, c } }) {
+            const Vec3f& p0 = vertices[t[0]]._position;
+            Vec3f n = cross(vertices[t[1]]._position - p0, vertices[t[2]]._position - p0);
+            if (n.length() < 1e-6f) {
+              continue; // Collapsed at the poles
+            }
+            if ((dot(n, p0) > 0.f) != (radius > 1.5f)) {
+              std::swap(t[1], t[2]);
+            }
+            triangles.push_back(t);
+          }
+        }
+      }
+    }
+    std::shuffle(triangles.begin(), triangles.end(), std::mt19937(2));
+    indices.clear();
+    for (const auto& t : triangles) {
+      indices.insert(indices.end(), t.begin(), t.end());
+    }
+  }
+  /**
+  * Triangles by their vertex positions, rotated so that the winding is kept but the first vertex doesn't matter.
+  */
+  std::multiset<std::array<std::tuple<float, float, float>, 3>> getTriangles(const std::vector<Vertex>& vertices, const std::vector<unsigned>& indices)
+  {
+    std::multiset<std::array<std::tuple<float, float, float>, 3>> triangles;
+    for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+      std::array<std::tuple<float, float, float>, 3> t;
+      for (unsigned j = 0; j < 3; j++) {
+        const Vec3f& p = vertices[indices[i + j]]._position;
+        t[j] = std::make_tuple(p[0], p[1], p[2]);
+      }
+      std::rotate(t.begin(), std::min_element(t.begin(), t.end()), t.end());
+      triangles.insert(t);
+    }
+    return triangles;
+  }
+}
+
+int main()
+{
+  std::vector<Vertex> vertices;
+  std::vector<unsigned> indices;
+  createShuffledGrid(64, vertices, indices);
+  auto triangles = getTriangles(vertices, indices);
+  auto before = MeshOptimizer::analyzeVertexCache(indices, vertices.size());
+
+  auto optimized = indices;
+  MeshOptimizer::optimizeVertexCache(optimized, vertices.size());
+  FLY_CHECK(getTriangles(vertices, optimized) == triangles);
+  auto after = MeshOptimizer::analyzeVertexCache(optimized, vertices.size());
+  std::cout << "ACMR " << before._acmr << " -> " << after._acmr << ", ATVR " << before._atvr << " -> " << after._atvr << std::endl;
+  FLY_CHECK(after._acmr < before._acmr * 0.5f);
+  FLY_CHECK(after._acmr < 0.8f);
+
+  MeshOptimizer::optimizeOverdraw(optimized, vertices);
+  FLY_CHECK(getTriangles(vertices, optimized) == triangles);
+  FLY_CHECK(MeshOptimizer::analyzeVertexCache(optimized, vertices.size())._acmr < before._acmr * 0.5f);
+
+  auto fetch_vertices = vertices;
+  auto fetch_indices = optimized;
+  fetch_vertices.push_back(Vertex()); // Unreferenced, must be removed
+  auto remap = MeshOptimizer::optimizeVertexFetch(fetch_vertices, fetch_indices);
+  FLY_CHECK(fetch_vertices.size() == vertices.size());
+  FLY_CHECK(remap.back() == ~0u);
+  FLY_CHECK(getTriangles(fetch_vertices, fetch_indices) == triangles);
+  bool remap_valid = true;
+  for (size_t i = 0; i < optimized.size(); i++) {
+    remap_valid = remap_valid && remap[optimized[i]] == fetch_indices[i];
+  }
+  FLY_CHECK(remap_valid);
+  // Vertices are ordered by their first use
+  unsigned next = 0;
+  bool ordered = true;
+  for (auto i : fetch_indices) {
+    ordered = ordered && i <= next;
+    next = (std::max)(next, i + 1);
+  }
+  FLY_CHECK(ordered);
+
+  // All clusters of the outer sphere face away from the center and are drawn before the ones of the inner sphere
+  createHollowSphere(32, 64, vertices, indices);
+  auto sphere_triangles = getTriangles(vertices, indices);
+  auto sphere = indices;
+  MeshOptimizer::optimizeVertexCache(sphere, vertices.size());
+  MeshOptimizer::optimizeOverdraw(sphere, vertices);
+  FLY_CHECK(getTriangles(vertices, sphere) == sphere_triangles);
+  bool inner_reached = false, outer_first = true;
+  for (size_t i = 0; i < sphere.size(); i += 3) {
+    bool outer = vertices[sphere[i]]._position.length() > 1.5f;
+    outer_first = outer_first && !(outer && inner_reached);
+    inner_reached = inner_reached || !outer;
+  }
+  FLY_CHECK(outer_first);
+
+  createShuffledGrid(64, vertices, indices);
+  Mesh mesh(vertices, indices, 0);
+  MeshOptimizer::CacheStats mesh_before, mesh_after;
+  MeshOptimizer::optimize(mesh, 16, &mesh_before, &mesh_after);
+  FLY_CHECK(mesh_after._acmr < mesh_before._acmr);
+  FLY_CHECK(getTriangles(mesh.getVertices(), mesh.getIndices()) == triangles);
+
+  return test::failures();
+}
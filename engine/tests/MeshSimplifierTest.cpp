@@ -0,0 +1,188 @@
+#include <MeshSimplifier.h>
+#include "TestHelpers.h"
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <utility>
+#include <vector>
+
+using namespace fly;
+
+namespace
+{
+  Vertex createVertex(unsigned x, unsigned z, unsigned n, float u_offset)
+  {
+    Vertex v = {};
+    v._position = Vec3f(static_cast<float>(x), std::sin(x * 0.3f) * std::cos(z * 0.2f), static_cast<float>(z));
+    v._normal = Vec3f(0.f, 1.f, 0.f);
+    v._uv = Vec2f(static_cast<float>(x) / n + u_offset, static_cast<float>(z) / n);
+    return v;
+  }
+  /**
+  * Wavy n x n quad grid facing up. If split, every quad has its own four vertices like exporters write
+  * flat shaded meshes. Otherwise the vertices at x = seam_x are duplicated with their u shifted by one on the
+  * right side, which forms a UV seam.
+  */
+  void createGrid(unsigned n, bool split, unsigned seam_x, std::vector<Vertex>& vertices, std::vector<unsigned>& indices)
+  {
+    vertices.clear();
+    indices.clear();
+    if (split) {
+      for (unsigned z = 0; z < n; z++) {
+        for (unsigned x = 0; x < n; x++) {
+          unsigned a = static_cast<unsigned>(vertices.size());
+          vertices.push_back(createVertex(x, z, n, 0.f));
+          vertices.push_back(createVertex(x + 1, z, n, 0.f));
+          vertices.push_back(createVertex(x, z + 1, n, 0.f));
+          vertices.push_back(createVertex(x + 1, z + 1, n, 0.f));
+          indices.insert(indices.end(), { a, a + 2, a + 1, a + 1, a + 2, a + 3 });
+        }
+      }
+      return;
+    }
+    std::vector<unsigned> left((n + 1) * (n + 1)), right((n + 1) * (n + 1));
+    for (unsigned z = 0; z <= n; z++) {
+      for (unsigned x = 0; x <= n; x++) {
+        left[z * (n + 1) + x] = right[z * (n + 1) + x] = static_cast<unsigned>(vertices.size());
+        vertices.push_back(createVertex(x, z, n, x > seam_x ? 1.f : 0.f));
+        if (x == seam_x) {
+          right[z * (n + 1) + x] = static_cast<unsigned>(vertices.size());
+          vertices.push_back(createVertex(x, z, n, 1.f));
+        }
+      }
+    }
+    for (unsigned z = 0; z < n; z++) {
+      for (unsigned x = 0; x < n; x++) {
+        const auto& ids = x < seam_x ? left : right;
+        unsigned a = ids[z * (n + 1) + x], b = ids[z * (n + 1) + x + 1], c = ids[(z + 1) * (n + 1) + x], d = ids[(z + 1) * (n + 1) + x + 1];
+        indices.insert(indices.end(), { a, c, b, b, c, d });
+      }
+    }
+  }
+  /**
+  * True if no triangle was flipped to face down.
+  */
+  bool noneFlipped(const std::vector<Vertex>& vertices, const std::vector<unsigned>& indices)
+  {
+    for (size_t i = 0; i < indices.size(); i += 3) {
+      const Vec3f& p0 = vertices[indices[i]]._position;
+      if (cross(vertices[indices[i + 1]]._position - p0, vertices[indices[i + 2]]._position - p0)[1] < 0.f) {
+        return false;
+      }
+    }
+    return true;
+  }
+  /**
+  * True if every edge used by a single triangle lies on the outer border of the n x n grid, i.e. no hole
+  * opened up, no matter which of the vertices at a position the triangles reference.
+  */
+  bool closedInside(const std::vector<Vertex>& vertices, const std::vector<unsigned>& indices, unsigned n)
+  {
+    std::map<std::pair<std::pair<float, float>, std::pair<float, float>>, unsigned> edges;
+    for (size_t i = 0; i < indices.size(); i++) {
+      const Vec3f& a = vertices[indices[i]]._position;
+      const Vec3f& b = vertices[indices[i % 3 == 2 ? i - 2 : i + 1]]._position;
+      auto pa = std::make_pair(a[0], a[2]), pb = std::make_pair(b[0], b[2]);
+      edges[std::make_pair((std::min)(pa, pb), (std::max)(pa, pb))]++;
+    }
+    float max = static_cast<float>(n);
+    for (const auto& e : edges) {
+      const auto& a = e.first.first;
+      const auto& b = e.first.second;
+      bool on_border = (a.first == b.first && (a.first == 0.f || a.first == max)) || (a.second == b.second && (a.second == 0.f || a.second == max));
+      if (e.second == 1 && !on_border) {
+        return false;
+      }
+    }
+    return true;
+  }
+}
+
+int main()
+{
+  const unsigned n = 100;
+  std::vector<Vertex> vertices;
+  std::vector<unsigned> indices;
+  MeshSimplifier::Settings settings;
+
+  // Split vertices with equal attributes don't hold the simplification back
+  createGrid(n, true, 0, vertices, indices);
+  FLY_CHECK(indices.size() / 3 == 20000);
+  auto result = MeshSimplifier::simplify(vertices, indices, indices.size() / 4, settings);
+  std::cout << "Split grid: " << indices.size() / 3 << " -> " << result.size() / 3 << " triangles" << std::endl;
+  FLY_CHECK(result.size() <= indices.size() / 4);
+  FLY_CHECK(result.size() >= indices.size() / 4 * 9 / 10);
+  FLY_CHECK(noneFlipped(vertices, result));
+  FLY_CHECK(closedInside(vertices, result, n));
+  // The corners are kept by the border constraints
+  float min_x = 1e10f, max_x = -1e10f, min_z = 1e10f, max_z = -1e10f;
+  for (auto i : result) {
+    min_x = (std::min)(min_x, vertices[i]._position[0]);
+    max_x = (std::max)(max_x, vertices[i]._position[0]);
+    min_z = (std::min)(min_z, vertices[i]._position[2]);
+    max_z = (std::max)(max_z, vertices[i]._position[2]);
+  }
+  FLY_CHECK(min_x == 0.f && max_x == n && min_z == 0.f && max_z == n);
+
+  // The seam collapses along itself, both sides keep their own uvs and no gap opens between them
+  createGrid(n, false, n / 2, vertices, indices);
+  result = MeshSimplifier::simplify(vertices, indices, indices.size() / 4, settings);
+  std::cout << "Seam grid: " << indices.size() / 3 << " -> " << result.size() / 3 << " triangles" << std::endl;
+  FLY_CHECK(result.size() <= indices.size() / 4);
+  FLY_CHECK(noneFlipped(vertices, result));
+  FLY_CHECK(closedInside(vertices, result, n));
+  bool single_side = true;
+  std::vector<bool> on_seam(vertices.size(), false);
+  for (size_t i = 0; i < result.size(); i += 3) {
+    unsigned right = 0;
+    for (unsigned j = 0; j < 3; j++) {
+      const Vertex& v = vertices[result[i + j]];
+      right += v._uv[0] >= 1.f;
+      on_seam[result[i + j]] = v._position[0] == n / 2;
+    }
+    single_side = single_side && (right == 0 || right == 3);
+  }
+  FLY_CHECK(single_side);
+  // Both sides of the seam were reduced to the same vertices
+  auto num_on_seam = std::count(on_seam.begin(), on_seam.end(), true);
+  FLY_CHECK(num_on_seam % 2 == 0 && num_on_seam < 2 * (n + 1));
+
+  // Leaf cards, separate quads that are all border, are reduced as well
+  vertices.clear();
+  indices.clear();
+  for (unsigned i = 0; i < 1000; i++) {
+    unsigned a = static_cast<unsigned>(vertices.size());
+    for (unsigned j = 0; j < 4; j++) {
+      vertices.push_back(createVertex(i * 2 + j % 2, j / 2, 1, 0.f));
+    }
+    indices.insert(indices.end(), { a, a + 2, a + 1, a + 1, a + 2, a + 3 });
+  }
+  result = MeshSimplifier::simplify(vertices, indices, indices.size() / 2, settings);
+  FLY_CHECK(result.size() <= indices.size() / 2);
+  FLY_CHECK(noneFlipped(vertices, result));
+
+  // Locked borders keep every border vertex
+  settings._lockBorders = true;
+  createGrid(20, false, 10, vertices, indices);
+  result = MeshSimplifier::simplify(vertices, indices, indices.size() / 4, settings);
+  std::vector<bool> referenced(vertices.size(), false);
+  for (auto i : result) {
+    referenced[i] = true;
+  }
+  bool borders_kept = true;
+  for (size_t i = 0; i < vertices.size(); i++) {
+    const Vec3f& p = vertices[i]._position;
+    if (p[0] == 0.f || p[0] == 20.f || p[2] == 0.f || p[2] == 20.f) {
+      bool found = referenced[i];
+      for (size_t j = 0; j < vertices.size() && !found; j++) {
+        found = referenced[j] && vertices[j]._position[0] == p[0] && vertices[j]._position[2] == p[2];
+      }
+      borders_kept = borders_kept && found;
+    }
+  }
+  FLY_CHECK(borders_kept);
+  FLY_CHECK(result.size() < indices.size());
+  FLY_CHECK(closedInside(vertices, result, 20));
+
+  return test::failures();
+}
@@ -0,0 +1,121 @@
+#include <ModelPack.h>
+#include <Model.h>
+#include <Mesh.h>
+#include <Material.h>
+#include <AABB.h>
+#include "TestHelpers.h"
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+using namespace fly;
+
+namespace
+{
+  std::shared_ptr<Mesh> createMesh(unsigned n, float offset, unsigned material_index)
+  {
+    std::vector<Vertex> vertices;
+    std::vector<unsigned> indices;
+    for (unsigned i = 0; i < n; i++) {
+      Vertex v = {};
+      v._position = Vec3f(static_cast<float>(i) + offset, static_cast<float>(i % 3), offset);
+      v._normal = Vec3f(0.f, 1.f, 0.f);
+      v._uv = Vec2f(static_cast<float>(i) / n, offset);
+      vertices.push_back(v);
+    }
+    for (unsigned i = 0; i + 2 < n; i++) {
+      indices.insert(indices.end(), { i, i + 1, i + 2 });
+    }
+    return std::make_shared<Mesh>(vertices, indices, material_index);
+  }
+  bool equal(const Vec3f& a, const Vec3f& b)
+  {
+    return a[0] == b[0] && a[1] == b[1] && a[2] == b[2];
+  }
+  bool sameGeometry(const Mesh& a, const Mesh& b)
+  {
+    bool same = a.getVertices().size() == b.getVertices().size() && a.getIndices() == b.getIndices() && a.getMaterialIndex() == b.getMaterialIndex();
+    for (size_t i = 0; same && i < a.getVertices().size(); i++) {
+      const auto& va = a.getVertices()[i];
+      const auto& vb = b.getVertices()[i];
+      same = same && equal(va._position, vb._position) && equal(va._normal, vb._normal) && va._uv[0] == vb._uv[0] && va._uv[1] == vb._uv[1];
+    }
+    return same;
+  }
+  std::vector<char> readFile(const char* path)
+  {
+    std::ifstream is(path, std::ios::binary);
+    return std::vector<char>(std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>());
+  }
+  void writeFile(const char* path, const std::vector<char>& data)
+  {
+    std::ofstream os(path, std::ios::binary);
+    os.write(data.data(), data.size());
+  }
+}
+
+int main()
+{
+  const char* path = "ModelPackTest.pack";
+  auto bark = std::make_shared<Material>(Vec3f(0.4f, 0.3f, 0.2f), 32.f, "bark.png", "bark_normal.png");
+  auto leaves = std::make_shared<Material>(Vec3f(0.1f, 0.6f, 0.1f), 8.f, "leaves.png", "", "leaves_opacity.png");
+  leaves->setHasWindX(true, 0.5f, 2.f);
+  leaves->setIsReflective(true);
+  auto trunk = createMesh(40, 0.f, 0);
+  auto crown = createMesh(60, 5.f, 1);
+  auto crown_lod = createMesh(20, 5.f, 1);
+  trunk->setMaterial(bark);
+  crown->setMaterial(leaves);
+  crown_lod->setMaterial(leaves);
+  // The trunk and both materials are shared between the lods and stored once
+  std::vector<std::shared_ptr<Model>> lods = {
+    std::make_shared<Model>(std::vector<std::shared_ptr<Mesh>>{ trunk, crown }, std::vector<std::shared_ptr<Material>>{ bark, leaves }),
+    std::make_shared<Model>(std::vector<std::shared_ptr<Mesh>>{ trunk, crown_lod }, std::vector<std::shared_ptr<Material>>{ bark, leaves })
+  };
+  FLY_CHECK(ModelPack::save(path, lods));
+  auto pack = ModelPack::load(path);
+  FLY_CHECK(pack != nullptr);
+  if (pack) {
+    FLY_CHECK(pack->getNumLods() == 2 && pack->getNumMeshRecords() == 3);
+    auto models = pack->createModels();
+    FLY_CHECK(models.size() == 2);
+    bool same = models.size() == lods.size();
+    for (size_t i = 0; same && i < lods.size(); i++) {
+      const auto& meshes = models[i]->getMeshes();
+      same = meshes.size() == lods[i]->getMeshes().size() && models[i]->getMaterials().size() == lods[i]->getMaterials().size();
+      for (size_t j = 0; same && j < meshes.size(); j++) {
+        const auto& m = lods[i]->getMeshes()[j];
+        same = sameGeometry(*meshes[j], *m) && equal(meshes[j]->getAABB()->getMin(), m->getAABB()->getMin()) && equal(meshes[j]->getAABB()->getMax(), m->getAABB()->getMax());
+        same = same && meshes[j]->getMaterial() == models[i]->getMaterials()[m->getMaterial() == bark ? 0 : 1];
+      }
+    }
+    FLY_CHECK(same);
+    if (same) {
+      // Sharing survives the round trip
+      const auto& mesh_0 = models[0]->getMeshes();
+      const auto& mesh_1 = models[1]->getMeshes();
+      FLY_CHECK(mesh_0[1] == mesh_1[1] && mesh_0[0] != mesh_1[0]);
+      FLY_CHECK(models[0]->getMaterials()[0] == models[1]->getMaterials()[0] && models[0]->getMaterials()[1] == models[1]->getMaterials()[1]);
+      auto& m = *models[0]->getMaterials()[1];
+      FLY_CHECK(m.getDiffusePath() == "leaves.png" && m.getNormalPath().empty() && m.getOpacityPath() == "leaves_opacity.png");
+      FLY_CHECK(equal(m.getDiffuseColor(), leaves->getDiffuseColor()) && m.getSpecularExponent() == 8.f);
+      FLY_CHECK(m.hasWindX() && !m.hasWindZ() && m.getWindStrength() == 0.5f && m.getWindFrequency() == 2.f && m.isReflective());
+    }
+  }
+  pack = nullptr;
+
+  // Truncated files and files with an index past the vertices of its mesh are rejected
+  auto data = readFile(path);
+  writeFile(path, std::vector<char>(data.begin(), data.begin() + data.size() / 2));
+  FLY_CHECK(ModelPack::load(path) == nullptr);
+  auto broken = createMesh(10, 0.f, 0);
+  auto indices = broken->getIndices();
+  indices.back() = static_cast<unsigned>(broken->getVertices().size());
+  FLY_CHECK(ModelPack::save(path, { std::make_shared<Model>(std::vector<std::shared_ptr<Mesh>>{ std::make_shared<Mesh>(broken->getVertices(), indices, 0) },
+    std::vector<std::shared_ptr<Material>>{}) }));
+  FLY_CHECK(ModelPack::load(path) == nullptr);
+  std::remove(path);
+
+  return test::failures();
+}
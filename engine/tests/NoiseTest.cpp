@@ -0,0 +1,61 @@
+#include <NoiseGen.h>
+#include "TestHelpers.h"
+#include <cmath>
+
+using namespace fly;
+
+namespace
+{
+  /**
+  * Reference values of HashNoiseGen, produced by an x64 build without contracted multiply-adds. They must match
+  * exactly on every platform, otherwise seeded terrain differs between server and client.
+  */
+  struct Reference
+  {
+    uint32_t _seed;
+    float _pos[3];
+    float _perlin2, _simplex2, _value2;
+    float _perlin3, _simplex3, _value3;
+  };
+  const Reference references[] = {
+    { 0u, { 0.5f, 0.25f, 0.75f }, 0.560302734f, 0.643643677f, 0.494101197f, -0.765163422f, -0.386749893f, 0.321109444f },
+    { 0u, { 17.3f, -4.7f, 2.2f }, 0.269692034f, 0.426835597f, 0.41483295f, 0.285162598f, -0.00052948005f, -0.470247f },
+    { 0u, { 300.125f, 71.9f, -33.3f }, 0.225359917f, -0.632020533f, 0.380354524f, 0.00302888453f, 0.323823899f, -0.512669683f },
+    { 1337u, { 0.5f, 0.25f, 0.75f }, -0.0603027344f, 0.0222569667f, -0.0839072242f, 0.218763351f, -0.502934396f, 0.298116267f },
+    { 1337u, { 17.3f, -4.7f, 2.2f }, 0.329689622f, 0.213415802f, 0.368394971f, -0.255028933f, -0.537108183f, -0.377665043f },
+    { 1337u, { 300.125f, 71.9f, -33.3f }, 0.211496949f, 0.0153826363f, 0.405550718f, -0.108629227f, -0.331225872f, 0.0304567963f }
+  };
+}
+
+int main()
+{
+  for (const auto& r : references) {
+    HashNoiseGen noise(r._seed);
+    Vec2f pos_2d(r._pos[0], r._pos[1]);
+    Vec3f pos_3d(r._pos[0], r._pos[1], r._pos[2]);
+    FLY_CHECK(noise.getPerlin(pos_2d) == r._perlin2);
+    FLY_CHECK(noise.getSimplex(pos_2d) == r._simplex2);
+    FLY_CHECK(noise.getValue(pos_2d) == r._value2);
+    FLY_CHECK(noise.getPerlin(pos_3d) == r._perlin3);
+    FLY_CHECK(noise.getSimplex(pos_3d) == r._simplex3);
+    FLY_CHECK(noise.getValue(pos_3d) == r._value3);
+  }
+
+  // Same seed gives the same noise, the noise repeats every 256 units and stays in about [-1, 1]
+  HashNoiseGen a(42u), b(42u);
+  bool equal = true, periodic = true, in_range = true;
+  for (unsigned i = 0; i < 10000; i++) {
+    Vec3f pos(i * 0.37f, i * 0.11f, i * 0.053f);
+    float value = a.getSimplex(pos);
+    equal = equal && value == b.getSimplex(pos) && a.getPerlin(Vec2f(pos[0], pos[1])) == b.getPerlin(Vec2f(pos[0], pos[1]));
+    Vec2f lattice(static_cast<float>(i % 97), static_cast<float>(i / 97));
+    periodic = periodic && a.getValue(lattice) == a.getValue(lattice + Vec2f(256.f, 0.f));
+    in_range = in_range && std::abs(value) <= 1.01f && std::abs(a.getPerlin(pos)) <= 1.01f;
+  }
+  FLY_CHECK(equal);
+  FLY_CHECK(periodic);
+  FLY_CHECK(in_range);
+  FLY_CHECK(HashNoiseGen(1u).getPerlin(Vec2f(0.5f, 0.25f)) != HashNoiseGen(2u).getPerlin(Vec2f(0.5f, 0.25f)));
+
+  return test::failures();
+}
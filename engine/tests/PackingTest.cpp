@@ -0,0 +1,116 @@
+#include <math/Packing.h>
+#include <VertexFormat.h>
+#include <AABB.h>
+#include "TestHelpers.h"
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace fly;
+
+namespace
+{
+  float maxDifference(const Vec3f& a, const Vec3f& b)
+  {
+    return (std::max)(std::abs(a[0] - b[0]), (std::max)(std::abs(a[1] - b[1]), std::abs(a[2] - b[2])));
+  }
+}
+
+int main()
+{
+  // Every 16 bit value survives the round trip, values outside the range are clamped
+  bool snorm_exact = true, unorm_exact = true;
+  for (int i = -32767; i <= 32767; i++) {
+    snorm_exact = snorm_exact && packSnorm16(unpackSnorm16(static_cast<int16_t>(i))) == i;
+  }
+  for (unsigned i = 0; i <= 65535; i++) {
+    unorm_exact = unorm_exact && packUnorm16(unpackUnorm16(static_cast<uint16_t>(i))) == i;
+  }
+  FLY_CHECK(snorm_exact);
+  FLY_CHECK(unorm_exact);
+  FLY_CHECK(packSnorm16(-3.f) == -32767 && packSnorm16(2.f) == 32767);
+  FLY_CHECK(packUnorm16(-1.f) == 0 && packUnorm16(1.5f) == 65535);
+  FLY_CHECK(unpackSnorm16(-32768) == -1.f);
+  Vec4f v2101010 = unpackSnorm2101010(packSnorm2101010(Vec4f(0.25f, -0.5f, 1.f, -1.f)));
+  FLY_CHECK(std::abs(v2101010[0] - 0.25f) < 1e-3f && std::abs(v2101010[1] + 0.5f) < 1e-3f && v2101010[2] == 1.f && v2101010[3] == -1.f);
+
+  // Every half except NaN converts to float and back exactly, NaN stays NaN
+  bool half_exact = true;
+  for (unsigned h = 0; h <= 0xffff; h++) {
+    float f = halfToFloat(static_cast<uint16_t>(h));
+    bool nan = (h & 0x7c00) == 0x7c00 && (h & 0x3ff);
+    half_exact = half_exact && (nan ? std::isnan(f) && std::isnan(halfToFloat(floatToHalf(f))) : floatToHalf(f) == h);
+  }
+  FLY_CHECK(half_exact);
+  // Round to nearest even between 1 and the next half, overflow becomes infinity
+  FLY_CHECK(floatToHalf(1.f + std::ldexp(1.f, -11)) == 0x3c00);
+  FLY_CHECK(floatToHalf(1.f + 3.f * std::ldexp(1.f, -11)) == 0x3c02);
+  FLY_CHECK(floatToHalf(70000.f) == 0x7c00 && floatToHalf(-70000.f) == 0xfc00);
+  FLY_CHECK(halfToFloat(floatToHalf(std::ldexp(1.f, -24))) == std::ldexp(1.f, -24));
+
+  // Octahedral normals with 16 bit components, including the folded lower hemisphere and the axes
+  std::mt19937 gen(11);
+  std::uniform_real_distribution<float> dist(-1.f, 1.f);
+  std::vector<Vec3f> normals = { Vec3f(1.f, 0.f, 0.f), Vec3f(0.f, -1.f, 0.f), Vec3f(0.f, 0.f, 1.f), Vec3f(0.f, 0.f, -1.f) };
+  while (normals.size() < 10000) {
+    Vec3f n(dist(gen), dist(gen), dist(gen));
+    if (n.length() > 0.1f) {
+      normals.push_back(normalize(n));
+    }
+  }
+  float oct_error = 0.f;
+  for (const auto& n : normals) {
+    Vec2f e = octEncode(n);
+    oct_error = (std::max)(oct_error, maxDifference(n, octDecode(Vec2f(unpackSnorm16(packSnorm16(e[0])), unpackSnorm16(packSnorm16(e[1]))))));
+  }
+  std::cout << "Octahedral snorm16 max error " << oct_error << std::endl;
+  FLY_CHECK(oct_error < 1e-4f);
+
+  // Vertex formats: random vertices inside the box, uvs in [0, 1] so that VF_UNORM_UV applies
+  AABB aabb(Vec3f(-10.f, 0.f, 5.f), Vec3f(30.f, 4.f, 6.f));
+  std::uniform_real_distribution<float> unit(0.f, 1.f);
+  std::vector<Vertex> vertices(1000);
+  for (size_t i = 0; i < vertices.size(); i++) {
+    auto& v = vertices[i];
+    v._position = aabb.getMin() + Vec3f(unit(gen), unit(gen), unit(gen)) * (aabb.getMax() - aabb.getMin());
+    v._normal = normals[i];
+    v._tangent = normalize(cross(v._normal, std::abs(v._normal[1]) < 0.9f ? Vec3f(0.f, 1.f, 0.f) : Vec3f(1.f, 0.f, 0.f)));
+    v._bitangent = cross(v._normal, v._tangent) * (i % 2 ? -1.f : 1.f);
+    v._uv = Vec2f(unit(gen), unit(gen));
+  }
+  FLY_CHECK(vertexSize(VF_FULL) == sizeof(Vertex));
+  FLY_CHECK(vertexSize(VF_COMPACT) == 24 && vertexSize(VF_COMPACT | VF_UNORM_UV) == 24);
+  FLY_CHECK(vertexSize(VF_COMPACT | VF_QUANTIZED_POSITION) == 20);
+  FLY_CHECK(vertexSize(VF_QUANTIZED_POSITION) == sizeof(Vertex)); // No effect without VF_COMPACT
+  for (unsigned format : { static_cast<unsigned>(VF_FULL), static_cast<unsigned>(VF_COMPACT), VF_COMPACT | VF_UNORM_UV, VF_COMPACT | VF_QUANTIZED_POSITION, VF_COMPACT | VF_UNORM_UV | VF_QUANTIZED_POSITION }) {
+    auto data = encodeVertices(vertices, format, aabb);
+    FLY_CHECK(data.size() == vertices.size() * vertexSize(format));
+    float position_error = 0.f, normal_error = 0.f, tangent_error = 0.f, uv_error = 0.f;
+    bool bitangent_sign = true;
+    for (size_t i = 0; i < vertices.size(); i++) {
+      const Vertex& v = vertices[i];
+      Vertex d = decodeVertex(&data[i * vertexSize(format)], format, aabb);
+      position_error = (std::max)(position_error, maxDifference(v._position, d._position));
+      normal_error = (std::max)(normal_error, maxDifference(v._normal, d._normal));
+      tangent_error = (std::max)(tangent_error, maxDifference(v._tangent, d._tangent));
+      uv_error = (std::max)(uv_error, (std::max)(std::abs(v._uv[0] - d._uv[0]), std::abs(v._uv[1] - d._uv[1])));
+      bitangent_sign = bitangent_sign && dot(v._bitangent, d._bitangent) > 0.9f;
+    }
+    std::cout << "Format " << format << ": position " << position_error << " normal " << normal_error << " tangent " << tangent_error
+      << " uv " << uv_error << std::endl;
+    if (format == VF_FULL) {
+      FLY_CHECK(position_error == 0.f && normal_error == 0.f && tangent_error == 0.f && uv_error == 0.f);
+      continue;
+    }
+    // Half a quantization step of the box extent, 40 units in x
+    FLY_CHECK(position_error <= (format & VF_QUANTIZED_POSITION ? 40.f / 65535.f * 0.5f + 1e-5f : 0.f));
+    FLY_CHECK(normal_error < 1e-4f);
+    FLY_CHECK(tangent_error < 5e-3f);
+    // Half floats have 11 significant bits, unorm16 steps are 1 / 65535
+    FLY_CHECK(uv_error <= (format & VF_UNORM_UV ? 0.5f / 65535.f + 1e-7f : std::ldexp(1.f, -12)));
+    FLY_CHECK(bitangent_sign);
+  }
+
+  return test::failures();
+}
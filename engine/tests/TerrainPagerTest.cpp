@@ -0,0 +1,110 @@
+#include <TerrainPager.h>
+#include "TestHelpers.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+using namespace fly;
+
+namespace
+{
+  const int width = 200, height = 130, page_size = 64;
+  float heightAt(int x, int z)
+  {
+    return x * 0.5f + z * 0.25f + std::sin(x * 0.3f) * 4.f;
+  }
+  /**
+  * Updates until no loads are pending, the number of resident pages is checked against the budget after every update.
+  */
+  bool updateUntilLoaded(TerrainPager& pager, const glm::vec3& cam_pos, size_t max_resident_pages, bool& within_budget)
+  {
+    for (unsigned i = 0; i < 2000; i++) {
+      pager.update(cam_pos);
+      std::vector<const TerrainPager::Page*> pages;
+      pager.getResidentPages(pages);
+      within_budget = within_budget && pages.size() <= max_resident_pages && pager.getNumPendingLoads() <= pager.getMaxPendingLoads();
+      if (!pager.getNumPendingLoads()) {
+        return true;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return false;
+  }
+  bool resident(TerrainPager& pager, int page_x, int page_z)
+  {
+    return pager.getPage(page_x, page_z) != nullptr;
+  }
+}
+
+int main()
+{
+  const char* path = "TerrainPagerTest.pages";
+  FLY_CHECK(!TerrainPager::save(path, width, height, 0, heightAt));
+  FLY_CHECK(!TerrainPager::save(path, width, height, 48, heightAt));
+  FLY_CHECK(TerrainPager::save(path, width, height, page_size, heightAt));
+
+  // The 3 x 3 pages around the camera must fit into the budget
+  ThreadPool pool(2);
+  FLY_CHECK(TerrainPager::load(path, 8, 1, 16, pool) == nullptr);
+  FLY_CHECK(TerrainPager::load(path, 9, -1, 16, pool) == nullptr);
+  auto pager = TerrainPager::load(path, 9, 1, 16, pool);
+  FLY_CHECK(pager != nullptr);
+  if (!pager) {
+    return test::failures();
+  }
+  FLY_CHECK(pager->getNumPages() == glm::ivec2(4, 3) && pager->getSize() == glm::ivec2(width, height));
+  pager->setMaxPendingLoads(0);
+  FLY_CHECK(pager->getMaxPendingLoads() == 1);
+  pager->setMaxPendingLoads(2);
+
+  // All pages around page (1, 1) are loaded with their heights, including the shared borders, and node bounds
+  bool within_budget = true;
+  FLY_CHECK(updateUntilLoaded(*pager, glm::vec3(96.f, 0.f, 96.f), 9, within_budget));
+  bool all_resident = true, heights_match = true, bounds_match = true;
+  for (int page_z = 0; page_z < 3; page_z++) {
+    for (int page_x = 0; page_x < 3; page_x++) {
+      auto page = pager->getPage(page_x, page_z);
+      all_resident = all_resident && page;
+      if (!page) {
+        continue;
+      }
+      float min_height = heightAt(page_x * page_size, page_z * page_size), max_height = min_height;
+      for (int z = 0; z <= page_size; z++) {
+        for (int x = 0; x <= page_size; x++) {
+          int x_clamped = (std::min)(page_x * page_size + x, width - 1), z_clamped = (std::min)(page_z * page_size + z, height - 1);
+          float h = heightAt(x_clamped, z_clamped);
+          heights_match = heights_match && page->_heights[z * (page_size + 1) + x] == h;
+          // Texels on the border to page column 3, which isn't resident, are answered by that page
+          heights_match = heights_match && pager->getHeight(x_clamped, z_clamped, -1.f) == (x_clamped / page_size < 3 ? h : -1.f);
+          min_height = (std::min)(min_height, h);
+          max_height = (std::max)(max_height, h);
+        }
+      }
+      bounds_match = bounds_match && page->_rootNode->_minHeight == min_height && page->_rootNode->_maxHeight == max_height &&
+        page->_rootNode->_southWest && page->_rootNode->_southWest->_southWest && !page->_rootNode->_southWest->_southWest->_southWest;
+    }
+  }
+  FLY_CHECK(all_resident);
+  FLY_CHECK(heights_match);
+  FLY_CHECK(bounds_match);
+  FLY_CHECK(!resident(*pager, 3, 0) && pager->getHeight(195, 10, -1.f) == -1.f);
+
+  // Moving to the corner loads the new pages and evicts the least recently used ones outside of the radius
+  FLY_CHECK(updateUntilLoaded(*pager, glm::vec3(199.f, 0.f, 129.f), 9, within_budget));
+  FLY_CHECK(resident(*pager, 2, 1) && resident(*pager, 3, 1) && resident(*pager, 2, 2) && resident(*pager, 3, 2));
+  std::vector<const TerrainPager::Page*> pages;
+  pager->getResidentPages(pages);
+  FLY_CHECK(pages.size() == 9);
+  FLY_CHECK(!resident(*pager, 0, 0) && !resident(*pager, 1, 0));
+  FLY_CHECK(within_budget);
+
+  // Destroying the pager with loads in flight waits for them
+  pager->update(glm::vec3(0.f));
+  pager = nullptr;
+  std::remove(path);
+
+  return test::failures();
+}
@@ -0,0 +1,134 @@
+#include <Terrain.h>
+#include <MinMaxPyramid.h>
+#include "TestHelpers.h"
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <random>
+#include <vector>
+
+using namespace fly;
+
+namespace
+{
+  /**
+  * Closest hit of the ray with the two triangles of every heightmap cell, the split runs from (x + 1, z) to
+  * (x, z + 1) like in MinMaxPyramid. Returns false on a miss.
+  */
+  bool rayCastBruteForce(const std::vector<float>& heights, int width, int height, const glm::vec3& origin, const glm::vec3& dir, float& t_min)
+  {
+    auto intersectTriangle = [&origin, &dir](const glm::vec3& a, const glm::vec3& b, const glm::vec3& c, float& t) {
+      glm::vec3 e1 = b - a, e2 = c - a, p = glm::cross(dir, e2);
+      float det = glm::dot(e1, p);
+      if (std::abs(det) < 1e-12f) {
+        return false;
+      }
+      glm::vec3 s = origin - a, q = glm::cross(s, e1);
+      float u = glm::dot(s, p) / det, v = glm::dot(dir, q) / det;
+      t = glm::dot(e2, q) / det;
+      return u >= 0.f && v >= 0.f && u + v <= 1.f && t >= 0.f;
+    };
+    auto vertex = [&heights, width](int x, int z) {
+      return glm::vec3(static_cast<float>(x), heights[z * width + x], static_cast<float>(z));
+    };
+    bool hit = false;
+    t_min = std::numeric_limits<float>::max();
+    for (int z = 0; z + 1 < height; z++) {
+      for (int x = 0; x + 1 < width; x++) {
+        float t;
+        if (intersectTriangle(vertex(x, z), vertex(x, z + 1), vertex(x + 1, z), t) && t < t_min) {
+          t_min = t;
+          hit = true;
+        }
+        if (intersectTriangle(vertex(x + 1, z), vertex(x, z + 1), vertex(x + 1, z + 1), t) && t < t_min) {
+          t_min = t;
+          hit = true;
+        }
+      }
+    }
+    return hit;
+  }
+  /**
+  * Rate of num_queries queries issued by a single call of func.
+  */
+  template<typename Func>
+  double queriesPerSecond(size_t num_queries, Func func)
+  {
+    auto begin = std::chrono::high_resolution_clock::now();
+    func();
+    auto end = std::chrono::high_resolution_clock::now();
+    return num_queries / std::chrono::duration<double>(end - begin).count();
+  }
+}
+
+int main()
+{
+  const int size = 513;
+  std::vector<float> heights(size * size);
+  for (int z = 0; z < size; z++) {
+    for (int x = 0; x < size; x++) {
+      heights[z * size + x] = std::sin(x * 0.05f) * 20.f + std::cos(z * 0.07f) * 10.f + static_cast<float>(x * z % 7);
+    }
+  }
+  Terrain terrain(32);
+  terrain.setHeightMap(cv::Mat(size, size, CV_32FC1, heights.data()));
+
+  // Heights at texels are exact, in between they are interpolated
+  FLY_CHECK(terrain.sampleHeight(10.f, 20.f) == heights[20 * size + 10]);
+  float h00 = heights[20 * size + 10], h10 = heights[20 * size + 11], h01 = heights[21 * size + 10], h11 = heights[21 * size + 11];
+  FLY_CHECK(std::abs(terrain.sampleHeight(10.5f, 20.5f) - (h00 + h10 + h01 + h11) * 0.25f) < 1e-4f);
+  FLY_CHECK(terrain.sampleHeight(-5.f, 20.f) == heights[20 * size]);
+
+  std::mt19937 gen(3);
+  std::uniform_real_distribution<float> dist(0.f, 1.f);
+  std::vector<glm::vec2> positions(1 << 20);
+  for (auto& p : positions) {
+    p = glm::vec2(dist(gen), dist(gen)) * static_cast<float>(size - 1);
+  }
+  std::vector<float> sampled(positions.size());
+  float sink = 0.f;
+  double sample_rate = queriesPerSecond(positions.size(), [&]() {
+    for (const auto& p : positions) {
+      sink += terrain.sampleHeight(p.x, p.y);
+    }
+  });
+  double batch_rate = queriesPerSecond(positions.size(), [&]() {
+    terrain.sampleHeights(positions.data(), positions.size(), sampled.data());
+  });
+  bool batch_equal = true;
+  for (size_t i = 0; i < positions.size(); i += 101) {
+    batch_equal = batch_equal && sampled[i] == terrain.sampleHeight(positions[i].x, positions[i].y);
+  }
+  FLY_CHECK(batch_equal);
+
+  // Ray casts from above the terrain, against every triangle
+  unsigned mismatches = 0, hits = 0;
+  for (unsigned i = 0; i < 30; i++) {
+    glm::vec3 origin(dist(gen) * size, 40.f + dist(gen) * 20.f, dist(gen) * size);
+    glm::vec3 dir(dist(gen) - 0.5f, -dist(gen) * 0.3f, dist(gen) - 0.5f);
+    glm::vec3 hit;
+    float t_ref;
+    bool hit_ref = rayCastBruteForce(heights, size, size, origin, dir, t_ref);
+    bool hit_terrain = terrain.rayCast(origin, dir, std::numeric_limits<float>::max(), hit);
+    mismatches += hit_ref != hit_terrain || (hit_ref && glm::distance(hit, origin + dir * t_ref) > 1e-3f * t_ref * glm::length(dir));
+    hits += hit_terrain;
+  }
+  FLY_CHECK(mismatches == 0);
+  FLY_CHECK(hits > 0);
+
+  std::vector<std::pair<glm::vec3, glm::vec3>> rays(200000);
+  for (auto& r : rays) {
+    r = { glm::vec3(dist(gen) * size, 60.f, dist(gen) * size), glm::vec3(dist(gen) - 0.5f, -0.2f, dist(gen) - 0.5f) };
+  }
+  double ray_rate = queriesPerSecond(rays.size(), [&]() {
+    for (const auto& r : rays) {
+      glm::vec3 hit;
+      sink += terrain.rayCast(r.first, r.second, std::numeric_limits<float>::max(), hit) ? hit.y : 0.f;
+    }
+  });
+
+  std::cout << "Queries per second: sampleHeight " << sample_rate << " sampleHeights " << batch_rate << " rayCast " << ray_rate
+    << " (" << sink << ")" << std::endl;
+
+  return test::failures();
+}
@@ -0,0 +1,30 @@
+#ifndef TESTHELPERS_H
+#define TESTHELPERS_H
+
+#include <iostream>
+
+namespace fly
+{
+  namespace test
+  {
+    /**
+    * Number of failed checks of the test executable, main() returns it so that ctest reports the failure.
+    */
+    inline int& failures()
+    {
+      static int failures = 0;
+      return failures;
+    }
+    inline void check(bool condition, const char* expression, const char* file, int line)
+    {
+      if (!condition) {
+        std::cout << file << ":" << line << ": check failed: " << expression << std::endl;
+        failures()++;
+      }
+    }
+  }
+}
+
+#define FLY_CHECK(condition) fly::test::check(condition, #condition, __FILE__, __LINE__)
+
+#endif
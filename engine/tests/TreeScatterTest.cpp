@@ -0,0 +1,76 @@
+#include <Terrain.h>
+#include "TestHelpers.h"
+#include <cmath>
+#include <vector>
+
+using namespace fly;
+
+namespace
+{
+  /**
+  * Scatters on a fresh terrain and returns the transforms collected at the root, which holds all trees.
+  */
+  std::vector<glm::mat4> scatter(const cv::Mat& height_map, const Terrain::ScatterRules& rules, uint32_t seed, ThreadPool& pool, size_t& num_trees)
+  {
+    Terrain terrain(32);
+    terrain.setHeightMap(height_map);
+    num_trees = terrain.scatterTrees(rules, seed, pool);
+    std::vector<Terrain::TreeNode*> nodes;
+    terrain.getAllNodes(nodes);
+    return nodes.front()->_transforms;
+  }
+  bool equal(const std::vector<glm::mat4>& a, const std::vector<glm::mat4>& b)
+  {
+    bool same = a.size() == b.size();
+    for (size_t i = 0; same && i < a.size(); i++) {
+      for (int c = 0; c < 4; c++) {
+        for (int r = 0; r < 4; r++) {
+          same = same && a[i][c][r] == b[i][c][r];
+        }
+      }
+    }
+    return same;
+  }
+}
+
+int main()
+{
+  const int size = 257;
+  std::vector<float> heights(size * size);
+  for (int z = 0; z < size; z++) {
+    for (int x = 0; x < size; x++) {
+      heights[z * size + x] = std::sin(x * 0.04f) * 15.f + std::cos(z * 0.03f) * 10.f;
+    }
+  }
+  cv::Mat height_map(size, size, CV_32FC1, heights.data());
+  Terrain::ScatterRules rules;
+  rules._minDistance = 3.f;
+  rules._density = 0.8f;
+  rules._maxHeight = 18.f;
+
+  // Identical for repeated runs and any number of threads, the order included
+  ThreadPool serial(0), single(1), many(7);
+  size_t num_trees, num_trees_other;
+  auto reference = scatter(height_map, rules, 42u, serial, num_trees);
+  FLY_CHECK(num_trees == reference.size() && num_trees > 1000);
+  FLY_CHECK(equal(scatter(height_map, rules, 42u, serial, num_trees_other), reference));
+  FLY_CHECK(equal(scatter(height_map, rules, 42u, single, num_trees_other), reference));
+  FLY_CHECK(equal(scatter(height_map, rules, 42u, many, num_trees_other), reference));
+  FLY_CHECK(equal(scatter(height_map, rules, 42u, ThreadPool::getShared(), num_trees_other), reference));
+  FLY_CHECK(!equal(scatter(height_map, rules, 43u, many, num_trees_other), reference));
+
+  // No two trees closer than the minimum distance, all of them inside the terrain and below the maximum height
+  bool min_distance_kept = true, inside = true;
+  for (size_t i = 0; i < reference.size(); i++) {
+    glm::vec3 p(reference[i][3]);
+    inside = inside && p.x >= 0.f && p.z >= 0.f && p.x <= size - 1 && p.z <= size - 1 && p.y - rules._heightOffset <= rules._maxHeight;
+    for (size_t j = i + 1; j < reference.size(); j++) {
+      glm::vec3 q(reference[j][3]);
+      min_distance_kept = min_distance_kept && glm::distance(glm::vec2(p.x, p.z), glm::vec2(q.x, q.z)) >= rules._minDistance;
+    }
+  }
+  FLY_CHECK(min_distance_kept);
+  FLY_CHECK(inside);
+
+  return test::failures();
+}
@@ -268,7 +268,11 @@ void DX11App::initGame()
   sponza_model->getMeshes()[sponza_model->getMeshes().size() - 28]->setMaterialIndex(sponza_model->getMaterials().size() - 1);
   sponza_model->getMaterials()[10]->setIsReflective(true);
   sponza_model->sortMeshesByMaterial();
-  auto sponza_lods = fly::LevelOfDetail().generateLODsWithDetailCulling(sponza_model, 7);
+  std::vector<float> triangle_ratios;
+  for (unsigned i = 1; i < 7; i++) {
+    triangle_ratios.push_back(1.f / static_cast<float>(1u << i));
+  }
+  auto sponza_lods = fly::LevelOfDetail().generateLODsWithSimplification(sponza_model, triangle_ratios, fly::MeshSimplifier::Settings());
 #if SPONZA_LARGE
   int width = 100;
   int height = 100;
@@ -96,21 +96,15 @@ void GLWidget::initializeGL()
 //  auto splat_map = generateSplatMap(image_size);
   int num_cells = image_size / grid_size;
   auto noise_gen = fly::NoiseGen(grid_size);
-  cv::Mat height_map(image_size, image_size, CV_32FC1, cv::Scalar(0));
 
   auto start = std::chrono::high_resolution_clock::now();
-  float gain = 0.4f;
-  unsigned int octaves = 8;
-  for (int x = 0; x < image_size; x++) {
-    for (int y = 0; y < image_size; y++) {
-      glm::vec2 coord = glm::vec2(x, y) / static_cast<float>(num_cells);
-      float amplitude = 1.f;
-      float frequency = 0.03f;
-      for (unsigned int i = 0; i < octaves; i++, amplitude *= gain, frequency *= 2.f) {
-        height_map.at<float>(y, x) += amplitude * (1.f - abs(noise_gen.getPerlin(coord * frequency)));
-      }
-    }
-  }
+  fly::NoiseGen::FBmParams fbm_params;
+  fbm_params._octaves = 8;
+  fbm_params._gain = 0.4f;
+  fbm_params._frequency = 0.03f;
+  fbm_params._ridged = true;
+  auto noise = noise_gen.getFBm(image_size, image_size, fbm_params, fly::Vec2f(0.f), 1.f / num_cells);
+  cv::Mat height_map = cv::Mat(image_size, image_size, CV_32FC1, noise.data()).clone();
   auto end = std::chrono::high_resolution_clock::now();
   std::cout << "Noise generation took " << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count() << " ms" << std::endl;
 
@@ -849,7 +843,7 @@ void GLWidget::handleKeyEvents()
   }
 #if !SPONZA
   auto geo_mip_map = _geoMipMapEntity->getComponent<fly::Terrain>();
-  auto g_model_mat = _geoMipMapEntity->getComponent<fly::Transform>()->getModelMatrix();
+  auto g_model_mat = _geoMipMapEntity->getComponent<fly::Transform>()->getWorldMatrix();
   auto cam_pos_terrain = glm::mat4(inverse(g_model_mat)) * glm::vec4(cam->_pos, 1.f);
   if (cam_pos_terrain.x >= 0.f && cam_pos_terrain.x <= geo_mip_map->getHeightMap().cols && cam_pos_terrain.z >= 0.f && cam_pos_terrain.z <= geo_mip_map->getHeightMap().rows) {
     float height = geo_mip_map->getHeight(cam_pos_terrain.x, cam_pos_terrain.z);
@@ -184,7 +184,7 @@ void GLWidget::initGame()
     for (unsigned j = 0; j < 100; j++) {
       for (const auto& m : tree_model->getMeshes()) {
         auto entity = _engine->getEntityManager()->createEntity();
-        entity->addComponent(std::make_shared<fly::StaticMeshRenderable>(m, tree_model->getMaterials()[m->getMaterialIndex()], fly::Transform(fly::Vec3f(i * 5.f, 0.f, j * 5.f), fly::Vec3f(0.01f)).getModelMatrix(), false));
+        entity->addComponent(std::make_shared<fly::StaticMeshRenderable>(m, tree_model->getMaterials()[m->getMaterialIndex()], fly::Transform(fly::Vec3f(i * 5.f, 0.f, j * 5.f), fly::Vec3f(0.01f)), false));
       }
     }
   }
@@ -227,7 +227,7 @@ void GLWidget::initGame()
     for (int y = 0; y < NUM_TOWERS; y++) {
       auto tower = _engine->getEntityManager()->createEntity();
       float scale = scale_dist(gen);
-      tower->addComponent(std::make_shared<fly::StaticMeshRenderable>(tower_model->getMeshes().front(), tower_model->getMeshes().front()->getMaterial() , fly::Transform(fly::Vec3f(x * 350.f, scale, y * 350.f), fly::Vec3f(scale / 3.f, scale, scale / 3.f)).getModelMatrix(), false));
+      tower->addComponent(std::make_shared<fly::StaticMeshRenderable>(tower_model->getMeshes().front(), tower_model->getMeshes().front()->getMaterial() , fly::Transform(fly::Vec3f(x * 350.f, scale, y * 350.f), fly::Vec3f(scale / 3.f, scale, scale / 3.f)), false));
       towers.push_back(tower->getComponent<fly::StaticMeshRenderable>());
     }
   }
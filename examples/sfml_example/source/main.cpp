@@ -73,7 +73,7 @@ int main()
   auto sponza_model = importer->loadModel("assets/sponza/sponza.obj");
   for (const auto& m : sponza_model->getMeshes()) {
     auto sponza_entity = engine->getEntityManager()->createEntity();
-    sponza_entity->addComponent(std::make_shared<fly::StaticMeshRenderable>(m, sponza_model->getMaterials()[m->getMaterialIndex()], fly::Transform(0.f, fly::Vec3f(0.01f)).getModelMatrix(), false));
+    sponza_entity->addComponent(std::make_shared<fly::StaticMeshRenderable>(m, sponza_model->getMaterials()[m->getMaterialIndex()], fly::Transform(0.f, fly::Vec3f(0.01f)), false));
   }
   fly::GameTimer timer;
   std::set<sf::Keyboard::Key> keys_pressed;
@@ -0,0 +1,125 @@
+#include <AssimpImporter.h>
+#include <LevelOfDetail.h>
+#include <ModelPack.h>
+#include <MeshOptimizer.h>
+#include <ParallelFor.h>
+#include <Model.h>
+#include <Mesh.h>
+#include <iostream>
+#include <chrono>
+#include <string>
+#include <stdexcept>
+#include <vector>
+
+namespace
+{
+  int printUsage()
+  {
+    std::cout << "Usage: asset_cooker <input model> <output pack> [number of lods]" << std::endl;
+    return 1;
+  }
+  size_t countTriangles(const fly::Model& model)
+  {
+    size_t num_triangles = 0;
+    for (const auto& m : model.getMeshes()) {
+      num_triangles += m->getIndices().size() / 3;
+    }
+    return num_triangles;
+  }
+}
+
+/**
+* Imports a model through Assimp once, optimizes the meshes for the vertex cache, overdraw and vertex fetch
+* and writes them together with the LOD chain to a model pack, which ModelPack::load() maps without any parsing.
+* Each lod is simplified to half the triangles of the previous one:
+* asset_cooker <input model> <output pack> [number of lods]
+*/
+int main(int argc, char* argv[])
+{
+  if (argc < 3) {
+    return printUsage();
+  }
+  unsigned long num_lods = 1;
+  if (argc > 3) {
+    try {
+      num_lods = std::stoul(argv[3]);
+    }
+    catch (const std::logic_error&) { // Not a number or out of range
+      return printUsage();
+    }
+    if (!num_lods || num_lods > 31) { // LOD i keeps 2^-i of the triangles
+      return printUsage();
+    }
+  }
+
+  auto begin = std::chrono::high_resolution_clock::now();
+  auto model = fly::AssimpImporter().loadModel(argv[1]);
+  auto imported = std::chrono::high_resolution_clock::now();
+  if (!model) {
+    std::cout << "Failed to import " << argv[1] << std::endl;
+    return 1;
+  }
+  std::vector<float> triangle_ratios;
+  for (unsigned i = 1; i < num_lods; i++) {
+    triangle_ratios.push_back(1.f / static_cast<float>(1u << i));
+  }
+  auto lods = fly::LevelOfDetail().generateLODsWithSimplification(model, triangle_ratios, fly::MeshSimplifier::Settings());
+  // Locked vertices and the flip test can keep the simplifier from reaching the requested ratio, allow some slack for rounding
+  size_t source_triangles = countTriangles(*lods[0]);
+  for (size_t i = 1; i < lods.size(); i++) {
+    size_t num_triangles = countTriangles(*lods[i]);
+    if (num_triangles > source_triangles * triangle_ratios[i - 1] * 1.1f + lods[i]->getMeshes().size()) {
+      std::cout << "Warning: lod " << i << " has " << num_triangles << " triangles, the target was " << source_triangles * triangle_ratios[i - 1]
+        << " (" << triangle_ratios[i - 1] << " of " << source_triangles << ")" << std::endl;
+    }
+  }
+
+  // The simplified lods are optimized by MeshSimplifier already
+  const auto& meshes = model->getMeshes();
+  std::vector<fly::MeshOptimizer::CacheStats> before(meshes.size()), after(meshes.size());
+  std::vector<size_t> referenced(meshes.size(), 0);
+  fly::parallelFor(0, meshes.size(), [&](size_t i) {
+    // Counted before the optimization removes the unreferenced vertices, the referenced ones stay the same
+    std::vector<bool> used(meshes[i]->getVertices().size(), false);
+    for (auto index : meshes[i]->getIndices()) {
+      referenced[i] += !used[index];
+      used[index] = true;
+    }
+    fly::MeshOptimizer::optimize(*meshes[i], 16, &before[i], &after[i]);
+  }, 1);
+  // Statistics over the source meshes, weighted by the number of triangles and referenced vertices
+  double num_triangles = 0., num_referenced = 0., misses_before = 0., misses_after = 0.;
+  for (size_t i = 0; i < meshes.size(); i++) {
+    double triangles = meshes[i]->getIndices().size() / 3;
+    num_triangles += triangles;
+    num_referenced += referenced[i];
+    misses_before += before[i]._acmr * triangles;
+    misses_after += after[i]._acmr * triangles;
+  }
+  if (num_triangles > 0.) {
+    std::cout << "ACMR " << misses_before / num_triangles << " -> " << misses_after / num_triangles << ", ATVR "
+      << misses_before / num_referenced << " -> " << misses_after / num_referenced << std::endl;
+  }
+  if (!fly::ModelPack::save(argv[2], lods)) {
+    return 1;
+  }
+
+  // The pack was just written, so its pages are still in the page cache and the time excludes disk reads
+  auto loaded_begin = std::chrono::high_resolution_clock::now();
+  auto pack = fly::ModelPack::load(argv[2]);
+  if (!pack) {
+    return 1;
+  }
+  auto models = pack->createModels();
+  auto loaded = std::chrono::high_resolution_clock::now();
+  size_t num_vertices = 0, num_indices = 0;
+  for (const auto& m : models[0]->getMeshes()) {
+    num_vertices += m->getVertices().size();
+    num_indices += m->getIndices().size();
+  }
+  std::cout << "Wrote " << argv[2] << ": " << models.size() << " lods, " << models[0]->getMeshes().size() << " meshes, "
+    << num_vertices << " vertices, " << num_indices << " indices" << std::endl;
+  std::cout << "Import " << std::chrono::duration<double, std::milli>(imported - begin).count() << " ms, pack load "
+    << std::chrono::duration<double, std::milli>(loaded - loaded_begin).count() << " ms (hot page cache)" << std::endl;
+  return 0;
+}